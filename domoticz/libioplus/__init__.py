@@ -5,225 +5,544 @@ import struct
 
 DEVICE_ADDRESS = 0x28  # 7 bit address (will be left shifted to add the read write bit)
 
+RELAY_VAL_ADD = 0
+RELAY_SET_ADD = 1
+RELAY_CLR_ADD = 2
+OPTO_IN_ADD = 3
+GPIO_VAL_ADD = 4
+GPIO_SET_ADD = 5
+GPIO_CLR_ADD = 6
+GPIO_DIR_ADD = 7
+ADC_VAL_RAW_ADD = 8
+ADC_VAL_MV_ADD = 24
+DAC_VAL_MV_ADD = 40
+OD_PWM_VAL_RAW_ADD = 48
+I2C_MEM_OPTO_IT_RISING_ADD = 56
+I2C_MEM_OPTO_IT_FALLING_ADD = 57
+I2C_MEM_OPTO_CNT_RST_ADD = 60
+I2C_MEM_DIAG_TEMPERATURE_ADD = 62
+I2C_MEM_OPTO_ENC_ENABLE_ADD = 70
+I2C_MEM_OPTO_ENC_CNT_RST_ADD = 72
+I2C_MEM_OPTO_EDGE_COUNT_ADD = 128
+I2C_MEM_GPIO_EDGE_COUNT_ADD = 171
+I2C_MEM_OPTO_ENC_COUNT_ADD = 187
+I2C_MEM_GPIO_ENC_COUNT_ADD = 203
+I2C_MEM_1WB_DEV = 211
+I2C_MEM_1WB_ROM_CODE_IDX = 212
+I2C_MEM_1WB_ROM_CODE = 213
+I2C_MEM_1WB_START_SEARCH = 221
+I2C_MEM_1WB_T1 = 222
 
-def getAdcV(stack, channel):
-    data = 0
+ADC_CH_NO = 8
+DAC_CH_NO = 4
+OD_CH_NO = 4
+OPTO_CH_NO = 8
+GPIO_CH_NO = 4
+OWB_SENS_CNT = 8
+
+SPURIOUS_RETRY = 10
+SMBUS_BLOCK_MAX = 32
+
+# Snapshot layout: two block reads cover every input and output register
+# 0..64: relays, opto, gpio, adc raw/mV, dac, od pwm, edges, diagnostics
+# 128..237: edge counters, encoders and one wire bus temperatures
+_SNAP_LOW_ADD = RELAY_VAL_ADD
+_SNAP_LOW_FMT = '<BBBBBBBB8H8H4H4HBBBBBBBH'
+_SNAP_LOW_SIZE = struct.calcsize(_SNAP_LOW_FMT)
+_SNAP_HIGH_ADD = I2C_MEM_OPTO_EDGE_COUNT_ADD
+_SNAP_HIGH_SIZE = I2C_MEM_1WB_T1 + 2 * OWB_SENS_CNT - I2C_MEM_OPTO_EDGE_COUNT_ADD
+_COUNTERS_FMT = '<8I'
+_COUNTERS_SIZE = I2C_MEM_1WB_DEV - I2C_MEM_OPTO_EDGE_COUNT_ADD
+
+
+def _check_stack(stack):
     if stack < 0 or stack > 7:
         raise ValueError('Invalid stack level')
-    if channel < 1 or channel > 8:
+
+
+def _check_channel(channel, max_ch):
+    if channel < 1 or channel > max_ch:
         raise ValueError('Invalid channel number')
-    ADC_VAL_MV_ADD = 24
-    bus = smbus2.SMBus(1)
-    try:
-        data = bus.read_word_data(DEVICE_ADDRESS + stack, ADC_VAL_MV_ADD + 2 * (channel - 1));
-        val = data / 1000.0;
-    except Exception as e:
-        val = -1
-    bus.close()
-    return val
+
+
+def _decode_counters(buff):
+    opto = list(struct.unpack_from('<8I', buff, 0))
+    gpio = list(struct.unpack_from('<4I', buff, I2C_MEM_GPIO_EDGE_COUNT_ADD - I2C_MEM_OPTO_EDGE_COUNT_ADD))
+    opto_enc = list(struct.unpack_from('<4i', buff, I2C_MEM_OPTO_ENC_COUNT_ADD - I2C_MEM_OPTO_EDGE_COUNT_ADD))
+    gpio_enc = list(struct.unpack_from('<2i', buff, I2C_MEM_GPIO_ENC_COUNT_ADD - I2C_MEM_OPTO_EDGE_COUNT_ADD))
+    return {'opto': opto, 'gpio': gpio, 'opto_encoder': opto_enc, 'gpio_encoder': gpio_enc}
+
+
+class Board:
+    """One IO-PLUS card on a persistent SMBus connection.
+
+    Keep the object alive between calls to avoid opening /dev/i2c-x on every
+    access; the bulk readers fetch whole register groups in one transfer.
+    Pass an already opened smbus2.SMBus as `bus` to share it between cards.
+    """
+
+    def __init__(self, stack=0, i2c=1, bus=None):
+        _check_stack(stack)
+        self.stack = stack
+        self.address = DEVICE_ADDRESS + stack
+        self._own_bus = bus is None
+        self.bus = smbus2.SMBus(i2c) if bus is None else bus
+
+    def close(self):
+        if self._own_bus and self.bus is not None:
+            self.bus.close()
+        self.bus = None
+
+    def __enter__(self):
+        return self
+
+    def __exit__(self, exc_type, exc_value, traceback):
+        self.close()
+
+    # ---------------------------------------------------------------- low level
+    def read_block(self, add, size):
+        if size <= SMBUS_BLOCK_MAX:
+            return bytes(self.bus.read_i2c_block_data(self.address, add, size))
+        wr = smbus2.i2c_msg.write(self.address, [add])
+        rd = smbus2.i2c_msg.read(self.address, size)
+        self.bus.i2c_rdwr(wr, rd)
+        return bytes(rd)
+
+    def _read_byte_as(self, add):
+        valA = 257
+        val = 258
+        retry = SPURIOUS_RETRY
+        while valA != val and retry > 0:
+            valA = val
+            retry -= 1
+            val = self.bus.read_byte_data(self.address, add)
+        if retry == 0:
+            raise Exception('Spurious read detected')
+        return val
+
+    def _read_words_as(self, add, count, signed=False, mask=0xfffc):
+        # every word must read the same (low bits masked) in two consecutive
+        # block reads, only the words still unstable keep the loop going
+        fmt = '<%d%s' % (count, 'h' if signed else 'H')
+        size = 2 * count
+        result = [None] * count
+        pending = count
+        prev = None
+        retry = SPURIOUS_RETRY
+        while pending > 0 and retry > 0:
+            retry -= 1
+            vals = struct.unpack(fmt, self.read_block(add, size))
+            if prev is not None:
+                for i in range(count):
+                    if result[i] is None and (vals[i] & mask) == (prev[i] & mask):
+                        result[i] = vals[i]
+                        pending -= 1
+            prev = vals
+        if pending > 0:
+            raise Exception('Spurious read detected')
+        return result
+
+    # ---------------------------------------------------------------- bulk access
+    def read_all_adc(self):
+        return [v / 1000.0 for v in self._read_words_as(ADC_VAL_MV_ADD, ADC_CH_NO)]
+
+    def read_all_adc_raw(self):
+        return self._read_words_as(ADC_VAL_RAW_ADD, ADC_CH_NO)
+
+    def read_counters(self):
+        return _decode_counters(self.read_block(I2C_MEM_OPTO_EDGE_COUNT_ADD, _COUNTERS_SIZE))
+
+    def read_temperatures(self):
+        high = self.read_block(I2C_MEM_1WB_DEV, I2C_MEM_1WB_T1 + 2 * OWB_SENS_CNT - I2C_MEM_1WB_DEV)
+        nr = min(high[0], OWB_SENS_CNT)
+        temps = struct.unpack_from('<%dh' % OWB_SENS_CNT, high, I2C_MEM_1WB_T1 - I2C_MEM_1WB_DEV)
+        return [t / 100.0 for t in temps[:nr]]
+
+    def read_snapshot(self):
+        """Read every input and output of the card with two block transfers.
+
+        Values are read once (no anti-spurious re-read), use the per-channel
+        methods when a single value must be double checked.
+        """
+        low = struct.unpack(_SNAP_LOW_FMT, self.read_block(_SNAP_LOW_ADD, _SNAP_LOW_SIZE))
+        high = self.read_block(_SNAP_HIGH_ADD, _SNAP_HIGH_SIZE)
+        owb_off = I2C_MEM_1WB_DEV - I2C_MEM_OPTO_EDGE_COUNT_ADD
+        t_off = I2C_MEM_1WB_T1 - I2C_MEM_OPTO_EDGE_COUNT_ADD
+        owb_nr = min(high[owb_off], OWB_SENS_CNT)
+        temps = struct.unpack_from('<%dh' % OWB_SENS_CNT, high, t_off)
+        return {
+            'relays': low[0],
+            'opto': low[3],
+            'gpio': low[4],
+            'gpio_dir': low[7],
+            'adc_raw': list(low[8:16]),
+            'adc': [v / 1000.0 for v in low[16:24]],
+            'dac': [v / 1000.0 for v in low[24:28]],
+            'od_pwm': list(low[28:32]),
+            'opto_rising': low[32],
+            'opto_falling': low[33],
+            'gpio_rising': low[34],
+            'gpio_falling': low[35],
+            'cpu_temp': low[38],
+            'v3v3': low[39] / 1000.0,
+            'counters': _decode_counters(high),
+            'owb_count': owb_nr,
+            'owb_temp': [t / 100.0 for t in temps[:owb_nr]],
+        }
+
+    # ---------------------------------------------------------------- analog
+    def get_adc_v(self, channel):
+        _check_channel(channel, ADC_CH_NO)
+        return self._read_words_as(ADC_VAL_MV_ADD + 2 * (channel - 1), 1)[0] / 1000.0
+
+    def get_adc_raw(self, channel):
+        _check_channel(channel, ADC_CH_NO)
+        return self._read_words_as(ADC_VAL_RAW_ADD + 2 * (channel - 1), 1)[0]
+
+    def set_dac_v(self, channel, value):
+        _check_channel(channel, DAC_CH_NO)
+        if value < 0:
+            value = 0
+        if value > 10:
+            value = 10
+        self.bus.write_word_data(self.address, DAC_VAL_MV_ADD + 2 * (channel - 1), int(value * 1000))
+        return 1
+
+    def get_dac_v(self, channel):
+        _check_channel(channel, DAC_CH_NO)
+        return float(self.bus.read_word_data(self.address, DAC_VAL_MV_ADD + 2 * (channel - 1))) / 1000
+
+    def set_od_pwm(self, channel, value):
+        _check_channel(channel, OD_CH_NO)
+        if value < 0:
+            value = 0
+        if value > 10000:
+            value = 10000
+        self.bus.write_word_data(self.address, OD_PWM_VAL_RAW_ADD + 2 * (channel - 1), value)
+        return 1
+
+    def get_od_pwm(self, channel):
+        _check_channel(channel, OD_CH_NO)
+        return self.bus.read_word_data(self.address, OD_PWM_VAL_RAW_ADD + 2 * (channel - 1))
+
+    # ---------------------------------------------------------------- relays
+    def set_relay_ch(self, channel, value):
+        _check_channel(channel, 8)
+        if value == 0:
+            self.bus.write_byte_data(self.address, RELAY_CLR_ADD, channel)
+        else:
+            self.bus.write_byte_data(self.address, RELAY_SET_ADD, channel)
+        return 1
+
+    def set_relays(self, value):
+        if value < 0 or value > 255:
+            raise ValueError('Invalid relays value')
+        self.bus.write_byte_data(self.address, RELAY_VAL_ADD, value)
+
+    def get_relays(self):
+        return self._read_byte_as(RELAY_VAL_ADD)
+
+    # ---------------------------------------------------------------- digital inputs
+    def get_opto(self):
+        return self._read_byte_as(OPTO_IN_ADD)
+
+    def set_gpio_dir(self, dir):
+        if dir < 0 or dir > 15:
+            raise ValueError('Invalid channel direction register value (allow 0..15)')
+        self.bus.write_byte_data(self.address, GPIO_DIR_ADD, dir)
+        return 1
+
+    def get_gpio(self):
+        return self._read_byte_as(GPIO_VAL_ADD)
+
+    def set_gpio_pin(self, pin, val):
+        if pin < 1 or pin > GPIO_CH_NO:
+            raise ValueError('Invalid pin number')
+        if val == 0:
+            self.bus.write_byte_data(self.address, GPIO_CLR_ADD, pin)
+        else:
+            self.bus.write_byte_data(self.address, GPIO_SET_ADD, pin)
+        return 1
+
+    def cfg_opto_edge_count(self, channel, state):
+        _check_channel(channel, OPTO_CH_NO)
+        EDGE_NONE = 0
+        EDGE_FALLING = 2
+        EDGE_RISING = 1
+        if state < EDGE_NONE or state > EDGE_FALLING + EDGE_RISING:
+            raise ValueError('Invalid edge type 0-none, 1-rising, 2-falling, 3-both')
+        rising, falling = self.bus.read_i2c_block_data(self.address, I2C_MEM_OPTO_IT_RISING_ADD, 2)
+        if state & EDGE_FALLING:
+            falling |= 1 << (channel - 1)
+        else:
+            falling &= ~(1 << (channel - 1))
+        if state & EDGE_RISING:
+            rising |= 1 << (channel - 1)
+        else:
+            rising &= ~(1 << (channel - 1))
+        self.bus.write_i2c_block_data(self.address, I2C_MEM_OPTO_IT_RISING_ADD, [rising, falling])
+        return 1
+
+    def get_opto_count(self, channel):
+        _check_channel(channel, OPTO_CH_NO)
+        buff = self.read_block(I2C_MEM_OPTO_EDGE_COUNT_ADD + 4 * (channel - 1), 4)
+        return struct.unpack('<I', buff)[0]
+
+    def rst_opto_count(self, channel):
+        _check_channel(channel, OPTO_CH_NO)
+        self.bus.write_byte_data(self.address, I2C_MEM_OPTO_CNT_RST_ADD, channel)
+        return 1
+
+    def cfg_opto_encoder(self, channel, state):
+        _check_channel(channel, 4)
+        if state < 0 or state > 1:
+            raise ValueError('Invalid state value 0-off, 1-on')
+        encoders = self.bus.read_byte_data(self.address, I2C_MEM_OPTO_ENC_ENABLE_ADD)
+        if state == 1:
+            encoders |= 1 << (channel - 1)
+        else:
+            encoders &= ~(1 << (channel - 1))
+        self.bus.write_byte_data(self.address, I2C_MEM_OPTO_ENC_ENABLE_ADD, encoders)
+        return 1
+
+    def get_opto_encoder_count(self, channel):
+        _check_channel(channel, 4)
+        buff = self.read_block(I2C_MEM_OPTO_ENC_COUNT_ADD + 4 * (channel - 1), 4)
+        return struct.unpack('<i', buff)[0]
+
+    def reset_opto_encoder_count(self, channel):
+        _check_channel(channel, 4)
+        self.bus.write_byte_data(self.address, I2C_MEM_OPTO_ENC_CNT_RST_ADD, channel)
+        return 1
+
+    # ---------------------------------------------------------------- one wire bus
+    def owb_get_sns_no(self):
+        return self.bus.read_byte_data(self.address, I2C_MEM_1WB_DEV)
+
+    def owb_get_temp(self, channel):
+        nr = self.owb_get_sns_no()
+        if channel > nr or channel < 1:
+            raise ValueError('Invalid channel number')
+        data = self.bus.read_word_data(self.address, I2C_MEM_1WB_T1 + 2 * (channel - 1))
+        if data > 0x7fff:
+            data -= 0x10000
+        return data / 100
+
+    def owb_scan(self):
+        self.bus.write_byte_data(self.address, I2C_MEM_1WB_START_SEARCH, 1)
+        return 1
+
+    def owb_get_sns_id(self, channel):
+        nr = self.owb_get_sns_no()
+        if channel > nr or channel < 1:
+            raise ValueError('Invalid channel number')
+        self.bus.write_byte_data(self.address, I2C_MEM_1WB_ROM_CODE_IDX, channel - 1)
+        return self.bus.read_i2c_block_data(self.address, I2C_MEM_1WB_ROM_CODE, 8)
+
+
+# Module level API, every call opens the bus for one access.
+# Use a Board object to keep the bus open and read several channels at once.
+
+def getAdcV(stack, channel):
+    _check_stack(stack)
+    _check_channel(channel, ADC_CH_NO)
+    with Board(stack) as board:
+        return board.get_adc_v(channel)
 
 
 def getAdcRaw(stack, channel):
-    data = 0
-    if stack < 0 or stack > 7:
-        raise ValueError('Invalid stack level')
-    if channel < 1 or channel > 8:
-        raise ValueError('Invalid channel number')
-    ADC_VAL_RAW_ADD = 8
-    bus = smbus2.SMBus(1)
-    try:
-        data = bus.read_word_data(DEVICE_ADDRESS + stack, ADC_VAL_RAW_ADD + 2 * (channel - 1));
-        val = data;
-    except Exception as e:
-        val = -1
-    bus.close()
-    return val
+    _check_stack(stack)
+    _check_channel(channel, ADC_CH_NO)
+    with Board(stack) as board:
+        return board.get_adc_raw(channel)
 
 
 def setDacV(stack, channel, value):
-    if stack < 0 or stack > 7:
-        raise ValueError('Invalid stack level')
-    if channel < 1 or channel > 4:
-        raise ValueError('Invalid channel number')
-    if value < 0:
-        value = 0;
+    _check_stack(stack)
+    _check_channel(channel, DAC_CH_NO)
+    with Board(stack) as board:
+        return board.set_dac_v(channel, value)
 
-    if value > 10:
-        value = 10;
 
-    raw = int(value * 1000)
-    bus = smbus2.SMBus(1)
-    DAC_VAL_MV_ADD = 40
-
-    try:
-        bus.write_word_data(DEVICE_ADDRESS + stack, DAC_VAL_MV_ADD + 2 * (channel - 1), raw)
-    except Exception as e:
-        print(e)
-        bus.close()
-        return -1
-    bus.close()
-    return 1
+def getDacV(stack, channel):
+    _check_stack(stack)
+    _check_channel(channel, DAC_CH_NO)
+    with Board(stack) as board:
+        return board.get_dac_v(channel)
 
 
 def setOdPwm(stack, channel, value):
-    if stack < 0 or stack > 7:
-        raise ValueError('Invalid stack level')
-    if channel < 1 or channel > 4:
-        raise ValueError('Invalid channel number')
-    bus = smbus2.SMBus(1)
-    if value < 0:
-        value = 0
-    if value > 10000:
-        value = 10000
-    OD_PWM_VAL_RAW_ADD = 48
-    try:
-        bus.write_word_data(DEVICE_ADDRESS + stack, OD_PWM_VAL_RAW_ADD + 2 * (channel - 1), value)
-    except Exception as e:
-        bus.close()
-        return -1
-    bus.close()
-    return 1
+    _check_stack(stack)
+    _check_channel(channel, OD_CH_NO)
+    with Board(stack) as board:
+        return board.set_od_pwm(channel, value)
+
+
+def getOdPwm(stack, channel):
+    _check_stack(stack)
+    _check_channel(channel, OD_CH_NO)
+    with Board(stack) as board:
+        # TODO: doesn't need transformation?
+        return board.get_od_pwm(channel)
+
+def _fixed_setOdPwm(stack, channel, value):
+    return setOdPwm(stack, channel, int(value * 100))
+
+def _fixed_getOdPwm(stack, channel):
+    raw = getOdPwm(stack, channel)
+    return float(raw) / 100
 
 
 def setRelayCh(stack, channel, value):
-    if stack < 0 or stack > 7:
-        raise ValueError('Invalid stack level')
-    if channel < 1 or channel > 8:
-        raise ValueError('Invalid channel number')
-    bus = smbus2.SMBus(1)
-    RELAY_SET_ADD = 1
-    RELAY_CLR_ADD = 2
-    if value == 0:
-        try:
-            bus.write_byte_data(DEVICE_ADDRESS + stack, RELAY_CLR_ADD, channel)
-        except Exception as e:
-            bus.close()
-            return -1
-    else:
-        try:
-            bus.write_byte_data(DEVICE_ADDRESS + stack, RELAY_SET_ADD, channel)
-        except Exception as e:
-            bus.close()
-            return -1
-    bus.close()
-    return 1
+    _check_stack(stack)
+    _check_channel(channel, 8)
+    try:
+        with Board(stack) as board:
+            return board.set_relay_ch(channel, value)
+    except Exception as e:
+        return -1
 
 
 def setRelays(stack, value):
-    if stack < 0 or stack > 7:
-        raise ValueError('Invalid stack level')
+    _check_stack(stack)
     if value < 0 or value > 255:
         raise ValueError('Invalid relays value')
-    bus = smbus2.SMBus(1)
-    RELAY_VAL_ADD = 0;
-    try:
-        bus.write_byte_data(DEVICE_ADDRESS + stack, RELAY_VAL_ADD, value)
-    except Exception as e:
-        bus.close()
-        return -1
-    bus.close()
+    with Board(stack) as board:
+        board.set_relays(value)
+
 
 def getRelays(stack):
-    if stack < 0 or stack > 7:
-        raise ValueError('Invalid stack level')
-    bus = smbus2.SMBus(1)
-    RELAY_VAL_ADD = 0;
-    try:
-        val = bus.read_word_data(DEVICE_ADDRESS + stack, RELAY_VAL_ADD)
-    except Exception as e:
-        bus.close()
-        return -1
-    bus.close()
-    return val
+    _check_stack(stack)
+    with Board(stack) as board:
+        return board.get_relays()
+
 
 def getRelayCh(stack, channel):
-    if stack < 0 or stack > 7:
-        raise ValueError('Invalid stack level')
-    if channel < 1 or channel > 8:
-        raise ValueError('Invalid channel number')
-    val=getRelays(stack)
-    if val<0:
+    _check_stack(stack)
+    _check_channel(channel, 8)
+    val = getRelays(stack)
+    if val < 0:
         return -1
-    return (val>>(channel-1)) & 1
+    return (val >> (channel - 1)) & 1
+
 
 def getOptoCh(stack, channel):
-    if stack < 0 or stack > 7:
-        raise ValueError('Invalid stack level')
-    if channel < 1 or channel > 8:
-        raise ValueError('Invalid channel number')
-    bus = smbus2.SMBus(1)
-    OPTO_IN_ADD = 3
-    try:
-        val = bus.read_byte_data(DEVICE_ADDRESS + stack, OPTO_IN_ADD)
-    except Exception as e:
-        bus.close()
-        return -1
-    bus.close()
-    if val & (1 << channel):
+    _check_stack(stack)
+    _check_channel(channel, OPTO_CH_NO)
+    val = getOpto(stack)
+    if val & (1 << (channel - 1)):
         return 1
     else:
         return 0
 
 
 def getOpto(stack):
-    if stack < 0 or stack > 7:
-        raise ValueError('Invalid stack level')
-    bus = smbus2.SMBus(1)
-    OPTO_IN_ADD = 3
-    try:
-        val = bus.read_byte_data(DEVICE_ADDRESS + stack, OPTO_IN_ADD)
-    except Exception as e:
-        bus.close()
-        return -1
-    bus.close()
-    return val
+    _check_stack(stack)
+    with Board(stack) as board:
+        return board.get_opto()
 
 
 def setGpioDir(stack, dir):
-    if stack < 0 or stack > 7:
-        raise ValueError('Invalid stack level')
+    _check_stack(stack)
     if dir < 0 or dir > 15:
         raise ValueError('Invalid channel direction register value (allow 0..15)')
-    bus = smbus2.SMBus(1)
-    GPIO_DIR_ADD = 7
+    with Board(stack) as board:
+        return board.set_gpio_dir(dir)
+
+
+def getGpio(stack):
+    _check_stack(stack)
+    with Board(stack) as board:
+        return board.get_gpio()
+
+
+def setGpioPin(stack, pin, val):
+    _check_stack(stack)
+    if pin < 1 or pin > 4:
+        raise ValueError('Invalid pin number')
     try:
-        bus.write_byte_data(DEVICE_ADDRESS + stack, GPIO_DIR_ADD, dir)
+        with Board(stack) as board:
+            return board.set_gpio_pin(pin, val)
     except Exception as e:
-        bus.close()
         return -1
-    bus.close()
-    return 1
 
+def cfgOptoEdgeCount(stack, channel, state):
+    _check_stack(stack)
+    _check_channel(channel, OPTO_CH_NO)
+    if state < 0 or state > 3:
+        raise ValueError('Invalid edge type 0-none, 1-rising, 2-falling, 3-both')
+    try:
+        with Board(stack) as board:
+            return board.cfg_opto_edge_count(channel, state)
+    except Exception as e:
+        return -1
 
-def getGpio(stack):
-    if stack < 0 or stack > 7:
-        raise ValueError('Invalid stack level')
-    bus = smbus2.SMBus(1)
-    GPIO_VAL_ADD = 4
+def getOptoCount(stack, channel):
+    _check_stack(stack)
+    _check_channel(channel, OPTO_CH_NO)
     try:
-        val = bus.read_byte_data(DEVICE_ADDRESS + stack, GPIO_VAL_ADD)
+        with Board(stack) as board:
+            return board.get_opto_count(channel)
     except Exception as e:
-        bus.close()
         return -1
-    bus.close()
-    return val
 
+def rstOptoCount(stack, channel):
+    _check_stack(stack)
+    _check_channel(channel, OPTO_CH_NO)
+    try:
+        with Board(stack) as board:
+            return board.rst_opto_count(channel)
+    except Exception as e:
+        return -1
 
-def setGpioPin(stack, pin, val):
-    if stack < 0 or stack > 7:
-        raise ValueError('Invalid stack level')
-    if pin < 1 or pin > 4:
-        raise ValueError('Invalid pin number')
-    bus = smbus2.SMBus(1)
-    GPIO_SET_ADD = 5
-    GPIO_CLR_ADD = 6
+def cfgOptoEncoder(stack, channel, state):
+    _check_stack(stack)
+    _check_channel(channel, 4)
+    if state < 0 or state > 1:
+        raise ValueError('Invalid state value 0-off, 1-on')
     try:
-        if val == 0:
-            bus.write_byte_data(DEVICE_ADDRESS + stack, GPIO_CLR_ADD, pin)
-        else:
-            bus.write_byte_data(DEVICE_ADDRESS + stack, GPIO_SET_ADD, pin)
+        with Board(stack) as board:
+            return board.cfg_opto_encoder(channel, state)
     except Exception as e:
-        bus.close()
         return -1
-    bus.close()
-    return 1
+
+def getOptoEncoderCount(stack, channel):
+    _check_stack(stack)
+    _check_channel(channel, 4)
+    with Board(stack) as board:
+        # kept as a tuple for compatibility with previous releases
+        return (board.get_opto_encoder_count(channel),)
+
+def resetOptoEncoderCount(stack, channel):
+    _check_stack(stack)
+    _check_channel(channel, 4)
+    with Board(stack) as board:
+        return board.reset_opto_encoder_count(channel)
+
+
+def owbGetTemp(stack, channel):
+    _check_stack(stack)
+    with Board(stack) as board:
+        return board.owb_get_temp(channel)
+
+def owbGetSnsNo(stack):
+    _check_stack(stack)
+    with Board(stack) as board:
+        return board.owb_get_sns_no()
+
+def owbScan(stack):
+    _check_stack(stack)
+    with Board(stack) as board:
+        return board.owb_scan()
+
+def owbGetSnsId(stack, channel):
+    _check_stack(stack)
+    with Board(stack) as board:
+        return board.owb_get_sns_id(channel)
+
+
+# native accessors over libioplus.so (see "Native module" in README.md), None when not built
+try:
+    from ._ioplus import Board as NativeBoard
+except ImportError:
+    NativeBoard = None
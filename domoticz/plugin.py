@@ -10,6 +10,7 @@
     </description>
     <params>
         <param field="Mode1" label="board number" width="75px" default="0"/>
+        <param field="Mode2" label="heartbeat (s)" width="75px" default="3"/>
         <param field="Mode6" label="Debug" width="75px">
           <options>
               <option label="True" value="Debug"/>
@@ -23,39 +24,86 @@
 
 # units 1-8 are  relays
 # units 9-16 are inputs
+# units 17-24 are analog inputs (0-10V)
+# units 25-32 are opto input counters
+# units 33-40 are one wire bus temperatures, created for the sensors found at start
 
 import Domoticz
 import libioplus as ioplus
 
+RELAY_UNIT = 1
+OPTO_UNIT = 9
+ADC_UNIT = 17
+COUNTER_UNIT = 25
+TEMP_UNIT = 33
+
 class BasePlugin:
     board = 0
     running = 0
     debug = 0
+    card = None
    
-    def set_relay(self,Unit, val):
-        if self.debug: Domoticz.Log("set_relay "+str(Unit)+" to "+str(val))
-        ioplus.setRelayCh(self.board, Unit, int(val))
-    
     def __init__(self):
+        # last (nValue, sValue) pushed to every unit, Update() is called only on change
+        self.last = {}
         return
 
     def connection(self):
-        return 
-      
+        # one bus handle kept open between heartbeats, dropped after an I2C error
+        if self.card is None:
+            self.card = ioplus.Board(self.board)
+        return self.card
+
+    def disconnect(self):
+        if self.card is not None:
+            try:
+                self.card.close()
+            except Exception:
+                pass
+            self.card = None
+
+    def set_relay(self,Unit, val):
+        if self.debug: Domoticz.Log("set_relay "+str(Unit)+" to "+str(val))
+        self.connection().set_relay_ch(Unit, int(val))
+
+    def update(self, Unit, nValue, sValue):
+        if Unit not in Devices:
+            return
+        if self.last.get(Unit) == (nValue, sValue):
+            return
+        Devices[Unit].Update(nValue=nValue, sValue=sValue)
+        self.last[Unit] = (nValue, sValue)
+
     def onStart(self):        
         self.board=int(Parameters["Mode1"])
         self.debug=Parameters["Mode6"]=="Debug"
         Domoticz.Log("onStart - Plugin is starting, debug="+str(self.debug))
+        try:
+            owb=self.connection().owb_get_sns_no()
+        except Exception as e:
+            Domoticz.Error("IOplus board "+str(self.board)+" not responding: "+str(e))
+            self.disconnect()
+            owb=0
         for x in range(1, 9):
-            if (x not in Devices): Domoticz.Device(Name="Relay_"+str(x), Unit=x, TypeName="Switch", Used=1).Create()
-            if (x+8 not in Devices): Domoticz.Device(Name="Input_"+str(x), Unit=x+8, TypeName="Switch", Used=1).Create()
-            self.set_relay(x, Devices[x].nValue)
-        Domoticz.Heartbeat(3)
+            if (x not in Devices): Domoticz.Device(Name="Relay_"+str(x), Unit=RELAY_UNIT+x-1, TypeName="Switch", Used=1).Create()
+            if (x+8 not in Devices): Domoticz.Device(Name="Input_"+str(x), Unit=OPTO_UNIT+x-1, TypeName="Switch", Used=1).Create()
+            if (ADC_UNIT+x-1 not in Devices): Domoticz.Device(Name="Analog_"+str(x), Unit=ADC_UNIT+x-1, TypeName="Voltage", Used=0).Create()
+            if (COUNTER_UNIT+x-1 not in Devices): Domoticz.Device(Name="Counter_"+str(x), Unit=COUNTER_UNIT+x-1, TypeName="Counter", Used=0).Create()
+            if (x <= owb and TEMP_UNIT+x-1 not in Devices): Domoticz.Device(Name="Temp_"+str(x), Unit=TEMP_UNIT+x-1, TypeName="Temperature", Used=1).Create()
+            try:
+                self.set_relay(x, Devices[x].nValue)
+            except Exception as e:
+                Domoticz.Error("set_relay "+str(x)+" failed: "+str(e))
+                self.disconnect()
+        beat=int(Parameters["Mode2"] or 3)
+        Domoticz.Heartbeat(min(max(beat, 1), 30))
         self.running=1
 
 
     def onStop(self):
         Domoticz.Log("onStop - Plugin is stopping.")
+        self.running=0
+        self.disconnect()
 
     def onConnect(self, Connection, Status, Description):
         return
@@ -66,22 +114,39 @@ class BasePlugin:
     def onCommand(self, Unit, Command, Level, Hue):
         val=Command=="On" and "1" or "0"
         if (Unit in range(1,9)): 
-          self.set_relay(Unit, Command=="On")
-          Devices[Unit].Update(int(val),val)
+          try:
+            self.set_relay(Unit, Command=="On")
+          except Exception as e:
+            Domoticz.Error("set_relay "+str(Unit)+" failed: "+str(e))
+            self.disconnect()
+            return
+          self.update(Unit, int(val), val)
 
     def onDisconnect(self, Connection):
         unused=0
 
     def onHeartbeat(self):
-        if self.running:
-          val=ioplus.getRelays(self.board)
-          inp=ioplus.getOpto(self.board)
-          if (self.debug): Domoticz.Log("read relays -> %02x, inputs -> %02x" % (val,inp))
-          for Unit in range(1,9):
-            val1=(val >> (Unit-1)) & 1
-            inp1=(inp >> (Unit-1)) & 1
-            if (Unit in Devices): Devices[Unit].Update(int(val1),str(val1))
-            if (Unit+8 in Devices): Devices[Unit+8].Update(int(inp1),str(val1))
+        if not self.running:
+          return
+        # every value of the card in two block reads over the open bus
+        try:
+          snap=self.connection().read_snapshot()
+        except Exception as e:
+          Domoticz.Error("IOplus board "+str(self.board)+" read failed: "+str(e))
+          self.disconnect()
+          return
+        val=snap['relays']
+        inp=snap['opto']
+        if (self.debug): Domoticz.Log("read relays -> %02x, inputs -> %02x" % (val,inp))
+        for x in range(1,9):
+          val1=(val >> (x-1)) & 1
+          inp1=(inp >> (x-1)) & 1
+          self.update(RELAY_UNIT+x-1, val1, str(val1))
+          self.update(OPTO_UNIT+x-1, inp1, str(inp1))
+          self.update(ADC_UNIT+x-1, 0, "%.3f" % snap['adc'][x-1])
+          self.update(COUNTER_UNIT+x-1, 0, str(snap['counters']['opto'][x-1]))
+        for x in range(1, snap['owb_count']+1):
+          self.update(TEMP_UNIT+x-1, 0, "%.2f" % snap['owb_temp'][x-1])
 
 
 global _plugin
@@ -0,0 +1,230 @@
+/*
+ * Shared I2C adapter access for the ioplus nodes.
+ *
+ * One BusQueue per adapter number owns the i2c-bus port and runs one
+ * transaction at a time. Writes go before reads, and reads of the same card
+ * waiting in the queue are merged into one block read of the register map
+ * when they fit in a single SMBus block, the result is then sliced back to
+ * every requester.
+ */
+"use strict";
+
+const SMBUS_BLOCK_MAX = 32;
+const PRIO_WRITE = 0;
+const PRIO_READ = 1;
+
+var buses = {};
+
+function BusQueue(busNo, port) {
+    this.busNo = busNo;
+    this.port = port;
+    this.refs = 0;
+    this.jobs = [];
+    this.pendingReads = {}; // hwAdd -> read batches not yet started
+    this.seq = 0;
+    this.busy = false;
+    this.scheduled = false;
+    this.closing = false;
+    this.stats = {transactions: 0, reads: 0, coalesced: 0, writes: 0, errors: 0};
+}
+
+BusQueue.prototype._push = function(job) {
+    var i = this.jobs.length;
+
+    job.seq = this.seq++;
+    // keep the queue sorted on priority, FIFO inside the same priority
+    while (i > 0 && this.jobs[i - 1].prio > job.prio) {
+        i--;
+    }
+    this.jobs.splice(i, 0, job);
+    this._kick();
+};
+
+BusQueue.prototype._kick = function() {
+    var self = this;
+
+    if (self.busy || self.scheduled) {
+        return;
+    }
+    self.scheduled = true;
+    // let the requests issued in the same tick reach the queue before dispatch
+    setImmediate(function() {
+        self.scheduled = false;
+        self._next();
+    });
+};
+
+BusQueue.prototype._next = function() {
+    var self = this;
+    var job = self.jobs.shift();
+
+    if (job === undefined) {
+        if (self.closing) {
+            self._close();
+        }
+        return;
+    }
+    if (job.hwAdd !== undefined && job.prio == PRIO_READ) {
+        var list = self.pendingReads[job.hwAdd];
+        list.splice(list.indexOf(job), 1);
+        if (list.length == 0) {
+            delete self.pendingReads[job.hwAdd];
+        }
+    }
+    self.busy = true;
+    self.stats.transactions++;
+    job.run(self.port, function() {
+        self.busy = false;
+        self._kick();
+    });
+};
+
+BusQueue.prototype._close = function() {
+    if (this.port) {
+        try {
+            this.port.closeSync();
+        } catch (err) {
+            // already closed
+        }
+        this.port = null;
+    }
+};
+
+/*
+ * Read len bytes of the card at hwAdd starting with register add,
+ * callback(err, buffer)
+ */
+BusQueue.prototype.read = function(hwAdd, add, len, callback) {
+    var self = this;
+    var list = self.pendingReads[hwAdd];
+    var req = {add: add, len: len, callback: callback};
+    var i;
+
+    self.stats.reads++;
+    if (list === undefined) {
+        list = self.pendingReads[hwAdd] = [];
+    }
+    for (i = 0; i < list.length; i++) {
+        var batch = list[i];
+        var start = Math.min(batch.start, add);
+        var end = Math.max(batch.end, add + len);
+        if (end - start <= SMBUS_BLOCK_MAX) {
+            batch.start = start;
+            batch.end = end;
+            batch.reqs.push(req);
+            self.stats.coalesced++;
+            return;
+        }
+    }
+    var job = {prio: PRIO_READ, hwAdd: hwAdd, start: add, end: add + len, reqs: [req]};
+    job.run = function(port, done) {
+        var size = job.end - job.start;
+        var buffer = Buffer.alloc(size);
+
+        port.readI2cBlock(hwAdd, job.start, size, buffer, function(err, bytesRead, res) {
+            if (!err && bytesRead != size) {
+                err = new Error("I2C short read " + bytesRead + " of " + size + " bytes");
+            }
+            if (err) {
+                self.stats.errors++;
+            }
+            done();
+            job.reqs.forEach(function(r) {
+                if (err) {
+                    r.callback(err);
+                } else {
+                    r.callback(null, res.slice(r.add - job.start, r.add - job.start + r.len));
+                }
+            });
+        });
+    };
+    list.push(job);
+    self._push(job);
+};
+
+BusQueue.prototype.readByte = function(hwAdd, add, callback) {
+    this.read(hwAdd, add, 1, function(err, res) {
+        if (err) {
+            callback(err);
+        } else {
+            callback(null, res[0]);
+        }
+    });
+};
+
+BusQueue.prototype._write = function(op, hwAdd, add, val, callback) {
+    var self = this;
+
+    self.stats.writes++;
+    self._push({prio: PRIO_WRITE, run: function(port, done) {
+        function complete(err) {
+            if (err) {
+                self.stats.errors++;
+            }
+            done();
+            if (callback) {
+                callback(err);
+            }
+        }
+        if (op == "block") {
+            port.writeI2cBlock(hwAdd, add, val.length, val, complete);
+        } else if (op == "word") {
+            port.writeWord(hwAdd, add, val, complete);
+        } else {
+            port.writeByte(hwAdd, add, val, complete);
+        }
+    }});
+};
+
+BusQueue.prototype.writeByte = function(hwAdd, add, val, callback) {
+    this._write("byte", hwAdd, add, val, callback);
+};
+
+BusQueue.prototype.writeWord = function(hwAdd, add, val, callback) {
+    this._write("word", hwAdd, add, val, callback);
+};
+
+BusQueue.prototype.writeBlock = function(hwAdd, add, buffer, callback) {
+    this._write("block", hwAdd, add, buffer, callback);
+};
+
+/*
+ * Get the shared queue of an I2C adapter, the port is opened by the first
+ * user and closed when the last one releases it and the queue is empty.
+ * The optional opener(busNo) returns an i2c-bus compatible port.
+ */
+function acquire(busNo, opener) {
+    var bus = buses[busNo];
+
+    if (bus === undefined) {
+        if (opener === undefined) {
+            opener = require("i2c-bus").openSync;
+        }
+        bus = buses[busNo] = new BusQueue(busNo, opener(busNo));
+    }
+    bus.refs++;
+    bus.closing = false;
+    return bus;
+}
+
+function release(busNo) {
+    var bus = buses[busNo];
+
+    if (bus === undefined) {
+        return;
+    }
+    bus.refs--;
+    if (bus.refs <= 0) {
+        delete buses[busNo];
+        bus.closing = true;
+        if (!bus.busy && bus.jobs.length == 0) {
+            bus._close();
+        }
+    }
+}
+
+module.exports = {
+    BusQueue: BusQueue,
+    acquire: acquire,
+    release: release
+};
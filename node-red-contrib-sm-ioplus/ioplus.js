@@ -1,19 +1,38 @@
 module.exports = function(RED) {
     "use strict";
-    var I2C = require("i2c-bus");
+    var BusQueue = require("./busqueue");
+    var map = require("./regmap"); // generated from regmap/ioplus.map
     const DEFAULT_HW_ADD = 0x28;
 
-    const I2C_MEM_RELAY_VAL_ADD = 0;   
-    const I2C_RELAY_SET_ADD = 1;
-    const I2C_RELAY_CLR_ADD = 2;
-    const I2C_MEM_OPTO_IN_VAL = 3;
-    const I2C_MEM_U0_10_OUT_VAL1 = 40;
-    const I2C_MEM_OD_PWM1 = 48;
-    const I2C_MEM_ADC_MV_VAL1 = 24;
-    const I2C_MEM_OPTO_RISING_ENABLE = 56;
-    const I2C_MEM_OPTO_FALLING_ENABLE = 57;
-    const I2C_MEM_OPTO_CH_CONT_RESET = 60;
-    const I2C_MEM_OPTO_COUNT1 = 128; //4 bytes integers
+    const I2C_MEM_RELAY_VAL_ADD = map.I2C_MEM_RELAY_VAL_ADD;
+    const I2C_RELAY_SET_ADD = map.I2C_MEM_RELAY_SET_ADD;
+    const I2C_RELAY_CLR_ADD = map.I2C_MEM_RELAY_CLR_ADD;
+    const I2C_MEM_OPTO_IN_VAL = map.I2C_MEM_OPTO_IN_ADD;
+    const I2C_MEM_U0_10_OUT_VAL1 = map.I2C_MEM_DAC_VAL_MV_ADD;
+    const I2C_MEM_OD_PWM1 = map.I2C_MEM_OD_PWM_VAL_RAW_ADD;
+    const I2C_MEM_ADC_MV_VAL1 = map.I2C_MEM_ADC_VAL_MV_ADD;
+    const I2C_MEM_OPTO_RISING_ENABLE = map.I2C_MEM_OPTO_IT_RISING_ADD;
+    const I2C_MEM_OPTO_FALLING_ENABLE = map.I2C_MEM_OPTO_IT_FALLING_ADD;
+    const I2C_MEM_OPTO_CH_CONT_RESET = map.I2C_MEM_OPTO_CNT_RST_ADD;
+    const I2C_MEM_OPTO_COUNT1 = map.I2C_MEM_OPTO_EDGE_COUNT_ADD; //4 bytes integers
+    const DEFAULT_I2C_BUS = 1;
+
+    // shared I2C adapter, all the nodes using the same adapter go through one queue
+    function IoplusBusNode(n) {
+        RED.nodes.createNode(this, n);
+        this.bus = parseInt(n.bus);
+        if (isNaN(this.bus)) {
+            this.bus = DEFAULT_I2C_BUS;
+        }
+    }
+    RED.nodes.registerType("ioplus-bus", IoplusBusNode);
+
+    function busOpen(node, n) {
+        var cfg = RED.nodes.getNode(n.bus);
+
+        node.busNo = cfg ? cfg.bus : DEFAULT_I2C_BUS;
+        node.port = BusQueue.acquire(node.busNo);
+    }
 
 
     function RelayNode(n) {
@@ -24,7 +43,7 @@ module.exports = function(RED) {
         this.payloadType = n.payloadType;
         var node = this;
 
-        node.port = I2C.openSync( 1 );
+        busOpen(node, n);
         node.on("input", function(msg) {
             var myPayload;
             var stack = node.stack;
@@ -107,7 +126,7 @@ module.exports = function(RED) {
         });
 
         node.on("close", function() {
-            node.port.closeSync();
+            BusQueue.release(node.busNo);
         });
     }
     RED.nodes.registerType("IOPLUS RELAY", RelayNode);
@@ -119,9 +138,8 @@ module.exports = function(RED) {
         this.payload = n.payload;
         this.payloadType = n.payloadType;
         var node = this;
-        var buffer = Buffer.alloc(2);
         
-        node.port = I2C.openSync( 1 );
+        busOpen(node, n);
         node.on("input", function(msg) {
             var myPayload;
             var stack = node.stack; 
@@ -164,7 +182,7 @@ module.exports = function(RED) {
                 } else {
                     myPayload = RED.util.evaluateNodeProperty(this.payload, this.payloadType, this,msg);
                 }
-                node.port.readI2cBlock(hwAdd, I2C_MEM_ADC_MV_VAL1 + (channel - 1)*2, 2, buffer,  function(err, size, res) {
+                node.port.read(hwAdd, I2C_MEM_ADC_MV_VAL1 + (channel - 1)*2, 2, function(err, res) {
                     if (err) { 
                         node.error(err, msg);
                     } 
@@ -181,7 +199,7 @@ module.exports = function(RED) {
         });
 
         node.on("close", function() {
-            node.port.closeSync();
+            BusQueue.release(node.busNo);
         });
     }
     RED.nodes.registerType("IOPLUS ADC in", VInNode);
@@ -195,7 +213,7 @@ module.exports = function(RED) {
         var node = this;
         var buffer = Buffer.alloc(2);
         
-        node.port = I2C.openSync( 1 );
+        busOpen(node, n);
         node.on("input", function(msg) {
             var myPayload;
             var stack = node.stack; 
@@ -266,7 +284,7 @@ module.exports = function(RED) {
         });
 
         node.on("close", function() {
-            node.port.closeSync();
+            BusQueue.release(node.busNo);
         });
     }
     RED.nodes.registerType("IOPLUS 0-10V out", VOutNode);   
@@ -280,12 +298,11 @@ module.exports = function(RED) {
         this.payload = n.payload;
         this.payloadType = n.payloadType;
         var node = this;
-        var buffer = Buffer.alloc(4);
         var lastCfgCh = 0;
         var cfgByte = 0;
 		var cntReset = 0;
         
-        node.port = I2C.openSync( 1 );
+        busOpen(node, n);
         node.on("input", function(msg) {
             var myPayload;
             var stack = node.stack; 
@@ -406,7 +423,7 @@ module.exports = function(RED) {
                 } else {
                     myPayload = RED.util.evaluateNodeProperty(this.payload, this.payloadType, this,msg);
                 }
-                node.port.readI2cBlock(hwAdd, I2C_MEM_OPTO_COUNT1 + (channel - 1)*4, 4, buffer,  function(err, size, res) {
+                node.port.read(hwAdd, I2C_MEM_OPTO_COUNT1 + (channel - 1)*4, 4, function(err, res) {
                     if (err) { 
                         node.error(err, msg);
                     } 
@@ -423,7 +440,7 @@ module.exports = function(RED) {
         });
 
         node.on("close", function() {
-            node.port.closeSync();
+            BusQueue.release(node.busNo);
         });
     }
     RED.nodes.registerType("IOPLUS OPT cnt", OptoCounterNode);
@@ -439,7 +456,7 @@ module.exports = function(RED) {
         var buffer = Buffer.alloc(4);
       
         
-        node.port = I2C.openSync( 1 );
+        busOpen(node, n);
         node.on("input", function(msg) {
             var myPayload;
             var stack = node.stack; 
@@ -511,7 +528,7 @@ module.exports = function(RED) {
         });
 
         node.on("close", function() {
-            node.port.closeSync();
+            BusQueue.release(node.busNo);
         });
     }
     RED.nodes.registerType("IOPLUS OPT in", OptoInNode);
@@ -525,7 +542,7 @@ module.exports = function(RED) {
         var node = this;
         var buffer = Buffer.alloc(2);
         
-        node.port = I2C.openSync( 1 );
+        busOpen(node, n);
         node.on("input", function(msg) {
             var myPayload;
             var stack = node.stack; 
@@ -596,7 +613,7 @@ module.exports = function(RED) {
         });
 
         node.on("close", function() {
-            node.port.closeSync();
+            BusQueue.release(node.busNo);
         });
     }
     RED.nodes.registerType("IOPLUS OD out", PWMOutNode);  
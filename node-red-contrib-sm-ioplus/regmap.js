@@ -0,0 +1,234 @@
+// Generated by regmap/regmap.py from regmap/ioplus.map, do not edit,
+// change the map and run "make regmap".
+"use strict";
+
+module.exports.ADC_CH_NO = 8;
+module.exports.DAC_CH_NO = 4;
+module.exports.OD_CH_NO = 4;
+module.exports.ADC_RAW_VAL_SIZE = 2;
+module.exports.DAC_MV_VAL_SIZE = 2;
+module.exports.OPTO_CH_NO = 8;
+module.exports.GPIO_CH_NO = 4;
+module.exports.COUNTER_SIZE = 4;
+module.exports.OWB_TEMP_SIZE_B = 2;
+module.exports.OWB_SENS_CNT = 8;
+
+module.exports.I2C_MEM_RELAY_VAL_ADD = 0;
+module.exports.I2C_MEM_RELAY_SET_ADD = 1;
+module.exports.I2C_MEM_RELAY_CLR_ADD = 2;
+module.exports.I2C_MEM_OPTO_IN_ADD = 3;
+module.exports.I2C_MEM_GPIO_VAL_ADD = 4;
+module.exports.I2C_MEM_GPIO_SET_ADD = 5;
+module.exports.I2C_MEM_GPIO_CLR_ADD = 6;
+module.exports.I2C_MEM_GPIO_DIR_ADD = 7;
+module.exports.I2C_MEM_ADC_VAL_RAW_ADD = 8;
+module.exports.I2C_MEM_ADC_VAL_MV_ADD = 24;
+module.exports.I2C_MEM_DAC_VAL_MV_ADD = 40;
+module.exports.I2C_MEM_OD_PWM_VAL_RAW_ADD = 48;
+module.exports.I2C_MEM_OPTO_IT_RISING_ADD = 56;
+module.exports.I2C_MEM_OPTO_IT_FALLING_ADD = 57;
+module.exports.I2C_MEM_GPIO_EXT_IT_RISING_ADD = 58;
+module.exports.I2C_MEM_GPIO_EXT_IT_FALLING_ADD = 59;
+module.exports.I2C_MEM_OPTO_CNT_RST_ADD = 60;
+module.exports.I2C_MEM_GPIO_CNT_RST_ADD = 61;
+module.exports.I2C_MEM_DIAG_TEMPERATURE_ADD = 62;
+module.exports.I2C_MEM_DIAG_3V3_MV_ADD = 63;
+module.exports.I2C_MEM_DIAG_3V3_MV_ADD1 = 64;
+module.exports.I2C_MEM_CALIB_VALUE = 65;
+module.exports.I2C_MEM_CALIB_CHANNEL = 67;
+module.exports.I2C_MEM_CALIB_KEY = 68;
+module.exports.I2C_MEM_CALIB_STATUS = 69;
+module.exports.I2C_MEM_OPTO_ENC_ENABLE_ADD = 70;
+module.exports.I2C_MEM_GPIO_ENC_ENABLE_ADD = 71;
+module.exports.I2C_MEM_OPTO_ENC_CNT_RST_ADD = 72;
+module.exports.I2C_MEM_GPIO_ENC_CNT_RST_ADD = 73;
+module.exports.I2C_MEM_OD_PULSE_CNT_SET = 74;
+module.exports.I2C_MEM_OD_PULSE_CNT_SET_END_ADD = 90;
+module.exports.I2C_MEM_OD_PWM_FREQUENCY_CH1 = 90;
+module.exports.I2C_MEM_OD_PWM_FREQUENCY_CH2 = 92;
+module.exports.I2C_MEM_OD_PWM_FREQUENCY_CH3 = 94;
+module.exports.I2C_MEM_OD_PWM_FREQUENCY_CH4 = 96;
+module.exports.I2C_MEM_RELAY_DEFAULT = 98;
+module.exports.I2C_MEM_OD_DEFAULT = 99;
+module.exports.I2C_MEM_WDT_RESET_ADD = 100;
+module.exports.I2C_MEM_WDT_INTERVAL_SET_ADD = 101;
+module.exports.I2C_MEM_WDT_INTERVAL_GET_ADD = 103;
+module.exports.I2C_MEM_WDT_INIT_INTERVAL_SET_ADD = 105;
+module.exports.I2C_MEM_WDT_INIT_INTERVAL_GET_ADD = 107;
+module.exports.I2C_MEM_WDT_RESET_COUNT_ADD = 109;
+module.exports.I2C_MEM_WDT_CLEAR_RESET_COUNT_ADD = 111;
+module.exports.I2C_MEM_WDT_POWER_OFF_INTERVAL_SET_ADD = 112;
+module.exports.I2C_MEM_WDT_POWER_OFF_INTERVAL_GET_ADD = 116;
+module.exports.I2C_MEM_REVISION_HW_MAJOR_ADD = 120;
+module.exports.I2C_MEM_REVISION_HW_MINOR_ADD = 121;
+module.exports.I2C_MEM_REVISION_MAJOR_ADD = 122;
+module.exports.I2C_MEM_REVISION_MINOR_ADD = 123;
+module.exports.I2C_DBG_FIFO_SIZE = 124;
+module.exports.I2C_DBG_FIFO_ADD = 126;
+module.exports.I2C_DBG_CMD = 127;
+module.exports.I2C_MEM_OPTO_EDGE_COUNT_ADD = 128;
+module.exports.I2C_MEM_OPTO_EDGE_COUNT_END_ADD = 160;
+module.exports.I2C_MEM_OD_PWM_FREQUENCY = 161;
+module.exports.I2C_MEM_MIN_MAX_SAMPLES = 163;
+module.exports.I2C_MEM_OD_P_SET_VALUE = 164;
+module.exports.I2C_MEM_OD_P_SET_CMD = 168;
+module.exports.I2C_MEM_ADD_RESERVED = 170;
+module.exports.I2C_MEM_GPIO_EDGE_COUNT_ADD = 171;
+module.exports.I2C_MEM_PULSE_COUNTER_SET = 171;
+module.exports.I2C_MEM_OD_CH_SET = 175;
+module.exports.I2C_MEM_OPTO_CH_SET = 176;
+module.exports.I2C_MEM_OPTO_ENC_COUNT_ADD = 187;
+module.exports.I2C_MEM_GPIO_ENC_COUNT_ADD = 203;
+module.exports.I2C_MEM_GPIO_ENC_COUNT_END_ADD = 211;
+module.exports.I2C_MEM_1WB_DEV = 211;
+module.exports.I2C_MEM_1WB_ROM_CODE_IDX = 212;
+module.exports.I2C_MEM_1WB_ROM_CODE = 213;
+module.exports.I2C_MEM_1WB_ROM_CODE_END = 220;
+module.exports.I2C_MEM_1WB_START_SEARCH = 221;
+module.exports.I2C_MEM_1WB_T1 = 222;
+module.exports.I2C_MEM_1WB_T_END = 238;
+module.exports.I2C_MEM_ADC_MAX = 238;
+module.exports.I2C_MEM_ADC_MIN = 246;
+module.exports.I2C_MEM_ODP_ACC = 238;
+module.exports.I2C_MEM_ODP_DEC = 240;
+module.exports.I2C_MEM_ODP_MAXS = 242;
+module.exports.I2C_MEM_ODP_MINS = 244;
+module.exports.I2C_MEM_ODP_CMD = 246;
+module.exports.SLAVE_BUFF_SIZE = 255;
+
+// Buffer reader, value width, divisor of the raw value, access
+var REGS = {
+    relay: { add: 0, read: "readUInt8", width: 1, count: 1, div: 1, access: "rw" },
+    relay_set: { add: 1, read: "readUInt8", width: 1, count: 1, div: 1, access: "w" },
+    relay_clr: { add: 2, read: "readUInt8", width: 1, count: 1, div: 1, access: "w" },
+    opto: { add: 3, read: "readUInt8", width: 1, count: 1, div: 1, access: "r" },
+    gpio: { add: 4, read: "readUInt8", width: 1, count: 1, div: 1, access: "rw" },
+    gpio_set: { add: 5, read: "readUInt8", width: 1, count: 1, div: 1, access: "w" },
+    gpio_clr: { add: 6, read: "readUInt8", width: 1, count: 1, div: 1, access: "w" },
+    gpio_dir: { add: 7, read: "readUInt8", width: 1, count: 1, div: 1, access: "rw" },
+    adc_raw: { add: 8, read: "readUInt16LE", width: 2, count: 8, div: 1, access: "r" },
+    adc_mv: { add: 24, read: "readUInt16LE", width: 2, count: 8, div: 1000, access: "r" },
+    dac_mv: { add: 40, read: "readUInt16LE", width: 2, count: 4, div: 1000, access: "rw" },
+    od_pwm: { add: 48, read: "readUInt16LE", width: 2, count: 4, div: 1, access: "rw" },
+    opto_rising: { add: 56, read: "readUInt8", width: 1, count: 1, div: 1, access: "rw" },
+    opto_falling: { add: 57, read: "readUInt8", width: 1, count: 1, div: 1, access: "rw" },
+    gpio_rising: { add: 58, read: "readUInt8", width: 1, count: 1, div: 1, access: "rw" },
+    gpio_falling: { add: 59, read: "readUInt8", width: 1, count: 1, div: 1, access: "rw" },
+    opto_cnt_rst: { add: 60, read: "readUInt8", width: 1, count: 1, div: 1, access: "w" },
+    gpio_cnt_rst: { add: 61, read: "readUInt8", width: 1, count: 1, div: 1, access: "w" },
+    diag_temp: { add: 62, read: "readUInt8", width: 1, count: 1, div: 1, access: "r" },
+    diag_3v3: { add: 63, read: "readUInt16LE", width: 2, count: 1, div: 1000, access: "r" },
+    calib_value: { add: 65, read: "readUInt16LE", width: 2, count: 1, div: 1, access: "w" },
+    calib_channel: { add: 67, read: "readUInt8", width: 1, count: 1, div: 1, access: "w" },
+    calib_key: { add: 68, read: "readUInt8", width: 1, count: 1, div: 1, access: "w" },
+    calib_status: { add: 69, read: "readUInt8", width: 1, count: 1, div: 1, access: "r" },
+    opto_enc_enable: { add: 70, read: "readUInt8", width: 1, count: 1, div: 1, access: "rw" },
+    gpio_enc_enable: { add: 71, read: "readUInt8", width: 1, count: 1, div: 1, access: "rw" },
+    opto_enc_cnt_rst: { add: 72, read: "readUInt8", width: 1, count: 1, div: 1, access: "w" },
+    gpio_enc_cnt_rst: { add: 73, read: "readUInt8", width: 1, count: 1, div: 1, access: "w" },
+    od_pulses: { add: 74, read: "readUInt32LE", width: 4, count: 4, div: 1, access: "rw" },
+    od_pwm_freq: { add: 90, read: "readUInt16LE", width: 2, count: 4, div: 1, access: "rw" },
+    relay_default: { add: 98, read: "readUInt8", width: 1, count: 1, div: 1, access: "rw" },
+    od_default: { add: 99, read: "readUInt8", width: 1, count: 1, div: 1, access: "rw" },
+    wdt_reset: { add: 100, read: "readUInt8", width: 1, count: 1, div: 1, access: "w" },
+    wdt_period_set: { add: 101, read: "readUInt16LE", width: 2, count: 1, div: 1, access: "w" },
+    wdt_period: { add: 103, read: "readUInt16LE", width: 2, count: 1, div: 1, access: "r" },
+    wdt_init_period_set: { add: 105, read: "readUInt16LE", width: 2, count: 1, div: 1, access: "w" },
+    wdt_init_period: { add: 107, read: "readUInt16LE", width: 2, count: 1, div: 1, access: "r" },
+    wdt_reset_count: { add: 109, read: "readUInt16LE", width: 2, count: 1, div: 1, access: "r" },
+    wdt_reset_count_clr: { add: 111, read: "readUInt8", width: 1, count: 1, div: 1, access: "w" },
+    wdt_off_period_set: { add: 112, read: "readUInt32LE", width: 4, count: 1, div: 1, access: "w" },
+    wdt_off_period: { add: 116, read: "readUInt32LE", width: 4, count: 1, div: 1, access: "r" },
+    revision: { add: 120, read: "readUInt8", width: 1, count: 4, div: 1, access: "r" },
+    dbg_fifo_size: { add: 124, read: "readUInt16LE", width: 2, count: 1, div: 1, access: "r" },
+    dbg_fifo: { add: 126, read: "readUInt8", width: 1, count: 1, div: 1, access: "r" },
+    dbg_cmd: { add: 127, read: "readUInt8", width: 1, count: 1, div: 1, access: "w" },
+    opto_count: { add: 128, read: "readUInt32LE", width: 4, count: 8, div: 1, access: "r" },
+    od_pwm_freq_all: { add: 161, read: "readUInt16LE", width: 2, count: 1, div: 1, access: "rw" },
+    min_max_samples: { add: 163, read: "readUInt8", width: 1, count: 1, div: 1, access: "rw" },
+    od_pulses_value: { add: 164, read: "readUInt32LE", width: 4, count: 1, div: 1, access: "w" },
+    od_pulses_cmd: { add: 168, read: "readUInt8", width: 1, count: 1, div: 1, access: "w" },
+    gpio_count: { add: 171, read: "readUInt32LE", width: 4, count: 4, div: 1, access: "r" },
+    in_pulses_set: { add: 171, read: "readUInt32LE", width: 4, count: 1, div: 1, access: "w" },
+    in_pulses_out: { add: 175, read: "readUInt8", width: 1, count: 1, div: 1, access: "w" },
+    in_pulses_in: { add: 176, read: "readUInt8", width: 1, count: 1, div: 1, access: "w" },
+    opto_enc_count: { add: 187, read: "readInt32LE", width: 4, count: 4, div: 1, access: "r" },
+    gpio_enc_count: { add: 203, read: "readInt32LE", width: 4, count: 2, div: 1, access: "r" },
+    owb_count: { add: 211, read: "readUInt8", width: 1, count: 1, div: 1, access: "r" },
+    owb_rom_idx: { add: 212, read: "readUInt8", width: 1, count: 1, div: 1, access: "rw" },
+    owb_rom: { add: 213, read: "readBigUInt64LE", width: 8, count: 1, div: 1, access: "r" },
+    owb_search: { add: 221, read: "readUInt8", width: 1, count: 1, div: 1, access: "w" },
+    owb_temp: { add: 222, read: "readInt16LE", width: 2, count: 8, div: 100, access: "r" },
+    adc_max: { add: 238, read: "readUInt16LE", width: 2, count: 4, div: 1000, access: "r" },
+    adc_min: { add: 246, read: "readUInt16LE", width: 2, count: 4, div: 1000, access: "r" },
+    od_acc: { add: 238, read: "readUInt16LE", width: 2, count: 1, div: 1, access: "w" },
+    od_dec: { add: 240, read: "readUInt16LE", width: 2, count: 1, div: 1, access: "w" },
+    od_max_speed: { add: 242, read: "readUInt16LE", width: 2, count: 1, div: 1, access: "w" },
+    od_min_speed: { add: 244, read: "readUInt16LE", width: 2, count: 1, div: 1, access: "w" },
+    od_move_cmd: { add: 246, read: "readUInt8", width: 1, count: 1, div: 1, access: "w" },
+};
+
+// one block read, the fields at their offset in the read buffer
+var LAYOUTS = {
+    SNAP_LOW: { add: 0, size: 65, fields: [
+        { id: "relay", offset: 0 },
+        { id: "opto", offset: 3 },
+        { id: "gpio", offset: 4 },
+        { id: "gpio_dir", offset: 7 },
+        { id: "adc_raw", offset: 8 },
+        { id: "adc_mv", offset: 24 },
+        { id: "dac_mv", offset: 40 },
+        { id: "od_pwm", offset: 48 },
+        { id: "opto_rising", offset: 56 },
+        { id: "opto_falling", offset: 57 },
+        { id: "gpio_rising", offset: 58 },
+        { id: "gpio_falling", offset: 59 },
+        { id: "diag_temp", offset: 62 },
+        { id: "diag_3v3", offset: 63 },
+    ] },
+    SNAP_HIGH: { add: 128, size: 110, fields: [
+        { id: "opto_count", offset: 0 },
+        { id: "gpio_count", offset: 43 },
+        { id: "opto_enc_count", offset: 59 },
+        { id: "gpio_enc_count", offset: 75 },
+        { id: "owb_count", offset: 83 },
+        { id: "owb_rom_idx", offset: 84 },
+        { id: "owb_rom", offset: 85 },
+        { id: "owb_temp", offset: 94 },
+    ] },
+    COUNTERS: { add: 128, size: 83, fields: [
+        { id: "opto_count", offset: 0 },
+        { id: "gpio_count", offset: 43 },
+        { id: "opto_enc_count", offset: 59 },
+        { id: "gpio_enc_count", offset: 75 },
+    ] },
+    OWB: { add: 211, size: 27, fields: [
+        { id: "owb_count", offset: 0 },
+        { id: "owb_rom_idx", offset: 1 },
+        { id: "owb_rom", offset: 2 },
+        { id: "owb_temp", offset: 11 },
+    ] },
+};
+
+// values of the layout registers by id, in the register unit unless
+// scale is false
+function decode(layout, buf, scale) {
+    var out = {};
+    layout.fields.forEach(function(f) {
+        var reg = REGS[f.id];
+        var vals = [];
+        for (var i = 0; i < reg.count; i++) {
+            var v = buf[reg.read](f.offset + i * reg.width);
+            if (scale !== false && reg.div !== 1) {
+                v = v / reg.div;
+            }
+            vals.push(v);
+        }
+        out[f.id] = reg.count === 1 ? vals[0] : vals;
+    });
+    return out;
+}
+
+module.exports.REGS = REGS;
+module.exports.LAYOUTS = LAYOUTS;
+module.exports.decode = decode;
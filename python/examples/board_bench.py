@@ -0,0 +1,40 @@
+import libioplus as io
+import time
+import sys
+
+# Compare the module level functions (bus opened on every call) with a
+# persistent Board object and its bulk readers.
+# Usage: python board_bench.py <stack level> [seconds per test]
+
+
+def bench(name, func, duration, values):
+	count = 0
+	start = time.perf_counter()
+	end = start + duration
+	while time.perf_counter() < end:
+		func()
+		count += 1
+	elapsed = time.perf_counter() - start
+	print("%-36s %8.1f calls/s %9.1f values/s" % (name, count / elapsed, values * count / elapsed))
+
+
+if __name__ == "__main__":
+	if len(sys.argv) < 2:
+		print("Invalid params number, Usage: python board_bench.py <stack level> [seconds]")
+		sys.exit(-1)
+	stack = int(sys.argv[1])
+	duration = 2.0
+	if len(sys.argv) > 2:
+		duration = float(sys.argv[2])
+
+	board = io.Board(stack)
+	try:
+		bench("getAdcV() x 8 channels", lambda: [io.getAdcV(stack, ch) for ch in range(1, 9)], duration, 8)
+		bench("Board.get_adc_v() x 8 channels", lambda: [board.get_adc_v(ch) for ch in range(1, 9)], duration, 8)
+		bench("Board.read_all_adc()", board.read_all_adc, duration, 8)
+		bench("getOptoCount() x 8 channels", lambda: [io.getOptoCount(stack, ch) for ch in range(1, 9)], duration, 8)
+		bench("Board.read_counters()", board.read_counters, duration, 18)
+		bench("Board.read_snapshot()", board.read_snapshot, duration, 60)
+	except KeyboardInterrupt:
+		pass
+	board.close()
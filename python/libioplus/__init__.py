@@ -1,139 +1,366 @@
 import smbus2
 import struct
 
+# register map, generated from regmap/ioplus.map
+from .regmap import (ADC_CH_NO, DAC_CH_NO, OD_CH_NO, OPTO_CH_NO, GPIO_CH_NO, OWB_SENS_CNT,
+                     I2C_MEM_OPTO_IT_RISING_ADD, I2C_MEM_OPTO_IT_FALLING_ADD, I2C_MEM_OPTO_CNT_RST_ADD,
+                     I2C_MEM_DIAG_TEMPERATURE_ADD, I2C_MEM_OPTO_ENC_ENABLE_ADD, I2C_MEM_OPTO_ENC_CNT_RST_ADD,
+                     I2C_MEM_OPTO_EDGE_COUNT_ADD, I2C_MEM_GPIO_EDGE_COUNT_ADD, I2C_MEM_OPTO_ENC_COUNT_ADD,
+                     I2C_MEM_GPIO_ENC_COUNT_ADD, I2C_MEM_1WB_DEV, I2C_MEM_1WB_ROM_CODE_IDX,
+                     I2C_MEM_1WB_ROM_CODE, I2C_MEM_1WB_START_SEARCH, I2C_MEM_1WB_T1)
+from . import regmap
+
 # bus = smbus2.SMBus(1)    # 0 = /dev/i2c-0 (port I2C0), 1 = /dev/i2c-1 (port I2C1)
 
 DEVICE_ADDRESS = 0x28  # 7 bit address (will be left shifted to add the read write bit)
 
-
-def getAdcV(stack, channel):
-    data = 0
+RELAY_VAL_ADD = regmap.I2C_MEM_RELAY_VAL_ADD
+RELAY_SET_ADD = regmap.I2C_MEM_RELAY_SET_ADD
+RELAY_CLR_ADD = regmap.I2C_MEM_RELAY_CLR_ADD
+OPTO_IN_ADD = regmap.I2C_MEM_OPTO_IN_ADD
+GPIO_VAL_ADD = regmap.I2C_MEM_GPIO_VAL_ADD
+GPIO_SET_ADD = regmap.I2C_MEM_GPIO_SET_ADD
+GPIO_CLR_ADD = regmap.I2C_MEM_GPIO_CLR_ADD
+GPIO_DIR_ADD = regmap.I2C_MEM_GPIO_DIR_ADD
+ADC_VAL_RAW_ADD = regmap.I2C_MEM_ADC_VAL_RAW_ADD
+ADC_VAL_MV_ADD = regmap.I2C_MEM_ADC_VAL_MV_ADD
+DAC_VAL_MV_ADD = regmap.I2C_MEM_DAC_VAL_MV_ADD
+OD_PWM_VAL_RAW_ADD = regmap.I2C_MEM_OD_PWM_VAL_RAW_ADD
+
+SPURIOUS_RETRY = 10
+SMBUS_BLOCK_MAX = 32
+
+# Snapshot layout: two block reads (regmap.SNAP_LOW, regmap.SNAP_HIGH) cover
+# every input and output register
+# 0..64: relays, opto, gpio, adc raw/mV, dac, od pwm, edges, diagnostics
+# 128..237: edge counters, encoders and one wire bus temperatures
+
+
+def _check_stack(stack):
     if stack < 0 or stack > 7:
         raise ValueError('Invalid stack level')
-    if channel < 1 or channel > 8:
-        raise ValueError('Invalid channel number')
-    ADC_VAL_MV_ADD = 24
-    bus = smbus2.SMBus(1)
-    dataA = 5000
-    data = 6000
-    retry = 10
-    try:
-        while (dataA & 0xfffc) != (data & 0xfffc) and retry > 0:
-            dataA = data
-            retry -= 1
-            data = bus.read_word_data(DEVICE_ADDRESS + stack, ADC_VAL_MV_ADD + 2 * (channel - 1))
-        val = data / 1000.0
-    except Exception as e:
-        bus.close()
-        raise Exception(e)
-    bus.close()
-    if retry == 0:
-        raise Exception('Spurious read detected')
-    return val
 
 
-def getAdcRaw(stack, channel):
-    data = 0
-    if stack < 0 or stack > 7:
-        raise ValueError('Invalid stack level')
-    if channel < 1 or channel > 8:
+def _check_channel(channel, max_ch):
+    if channel < 1 or channel > max_ch:
         raise ValueError('Invalid channel number')
-    ADC_VAL_RAW_ADD = 8
-    bus = smbus2.SMBus(1)
-    dataA = 5000
-    data = 6000
-    retry = 10
-    try:
-        while (dataA & 0xfffc) != (data & 0xfffc) and retry > 0:
-            dataA = data
-            retry -= 1
-            data = bus.read_word_data(DEVICE_ADDRESS + stack, ADC_VAL_RAW_ADD + 2 * (channel - 1));
-        val = data;
-    except Exception as e:
-        bus.close()
-        raise Exception(e)
-    bus.close()
-    if retry == 0:
-        raise Exception('Spurious read detected')
-    return val
 
 
-def setDacV(stack, channel, value):
-    if stack < 0 or stack > 7:
-        raise ValueError('Invalid stack level')
-    if channel < 1 or channel > 4:
-        raise ValueError('Invalid channel number')
-    if value < 0:
-        value = 0;
+def _counters(vals):
+    return {'opto': vals['opto_count'], 'gpio': vals['gpio_count'],
+            'opto_encoder': vals['opto_enc_count'], 'gpio_encoder': vals['gpio_enc_count']}
 
-    if value > 10:
-        value = 10;
 
-    raw = int(value * 1000)
-    bus = smbus2.SMBus(1)
-    DAC_VAL_MV_ADD = 40
+def _read_layout(board, layout):
+    return regmap.decode(layout, board.read_block(layout.add, layout.size))
 
-    try:
-        bus.write_word_data(DEVICE_ADDRESS + stack, DAC_VAL_MV_ADD + 2 * (channel - 1), raw)
-    except Exception as e:
-        bus.close()
-        raise Exception(e)
-    bus.close()
-    return 1
 
-def getDacV(stack, channel):
-    if stack < 0 or stack > 7:
-        raise ValueError('Invalid stack level')
-    if channel < 1 or channel > 4:
-        raise ValueError('Invalid channel number')
+class Board:
+    """One IO-PLUS card on a persistent SMBus connection.
 
-    bus = smbus2.SMBus(1)
-    DAC_VAL_MV_ADD = 40
+    Keep the object alive between calls to avoid opening /dev/i2c-x on every
+    access; the bulk readers fetch whole register groups in one transfer.
+    Pass an already opened smbus2.SMBus as `bus` to share it between cards.
+    """
 
-    try:
-        raw = bus.read_word_data(DEVICE_ADDRESS + stack, DAC_VAL_MV_ADD + 2 * (channel - 1))
-        val = float(raw) / 1000
-        bus.close()
+    def __init__(self, stack=0, i2c=1, bus=None):
+        _check_stack(stack)
+        self.stack = stack
+        self.address = DEVICE_ADDRESS + stack
+        self._own_bus = bus is None
+        self.bus = smbus2.SMBus(i2c) if bus is None else bus
+
+    def close(self):
+        if self._own_bus and self.bus is not None:
+            self.bus.close()
+        self.bus = None
+
+    def __enter__(self):
+        return self
+
+    def __exit__(self, exc_type, exc_value, traceback):
+        self.close()
+
+    # ---------------------------------------------------------------- low level
+    def read_block(self, add, size):
+        if size <= SMBUS_BLOCK_MAX:
+            return bytes(self.bus.read_i2c_block_data(self.address, add, size))
+        wr = smbus2.i2c_msg.write(self.address, [add])
+        rd = smbus2.i2c_msg.read(self.address, size)
+        self.bus.i2c_rdwr(wr, rd)
+        return bytes(rd)
+
+    def _read_byte_as(self, add):
+        valA = 257
+        val = 258
+        retry = SPURIOUS_RETRY
+        while valA != val and retry > 0:
+            valA = val
+            retry -= 1
+            val = self.bus.read_byte_data(self.address, add)
+        if retry == 0:
+            raise Exception('Spurious read detected')
         return val
-    except Exception as e:
-        bus.close()
-        raise Exception(e)
+
+    def _read_words_as(self, add, count, signed=False, mask=0xfffc):
+        # every word must read the same (low bits masked) in two consecutive
+        # block reads, only the words still unstable keep the loop going
+        fmt = '<%d%s' % (count, 'h' if signed else 'H')
+        size = 2 * count
+        result = [None] * count
+        pending = count
+        prev = None
+        retry = SPURIOUS_RETRY
+        while pending > 0 and retry > 0:
+            retry -= 1
+            vals = struct.unpack(fmt, self.read_block(add, size))
+            if prev is not None:
+                for i in range(count):
+                    if result[i] is None and (vals[i] & mask) == (prev[i] & mask):
+                        result[i] = vals[i]
+                        pending -= 1
+            prev = vals
+        if pending > 0:
+            raise Exception('Spurious read detected')
+        return result
+
+    # ---------------------------------------------------------------- bulk access
+    def read_all_adc(self):
+        return [v / 1000.0 for v in self._read_words_as(ADC_VAL_MV_ADD, ADC_CH_NO)]
+
+    def read_all_adc_raw(self):
+        return self._read_words_as(ADC_VAL_RAW_ADD, ADC_CH_NO)
+
+    def read_counters(self):
+        return _counters(_read_layout(self, regmap.COUNTERS))
+
+    def read_temperatures(self):
+        owb = _read_layout(self, regmap.OWB)
+        return owb['owb_temp'][:min(owb['owb_count'], OWB_SENS_CNT)]
+
+    def read_snapshot(self):
+        """Read every input and output of the card with two block transfers.
+
+        Values are read once (no anti-spurious re-read), use the per-channel
+        methods when a single value must be double checked.
+        """
+        low = _read_layout(self, regmap.SNAP_LOW)
+        high = _read_layout(self, regmap.SNAP_HIGH)
+        owb_nr = min(high['owb_count'], OWB_SENS_CNT)
+        return {
+            'relays': low['relay'],
+            'opto': low['opto'],
+            'gpio': low['gpio'],
+            'gpio_dir': low['gpio_dir'],
+            'adc_raw': low['adc_raw'],
+            'adc': low['adc_mv'],
+            'dac': low['dac_mv'],
+            'od_pwm': low['od_pwm'],
+            'opto_rising': low['opto_rising'],
+            'opto_falling': low['opto_falling'],
+            'gpio_rising': low['gpio_rising'],
+            'gpio_falling': low['gpio_falling'],
+            'cpu_temp': low['diag_temp'],
+            'v3v3': low['diag_3v3'],
+            'counters': _counters(high),
+            'owb_count': owb_nr,
+            'owb_temp': high['owb_temp'][:owb_nr],
+        }
+
+    # ---------------------------------------------------------------- analog
+    def get_adc_v(self, channel):
+        _check_channel(channel, ADC_CH_NO)
+        return self._read_words_as(ADC_VAL_MV_ADD + 2 * (channel - 1), 1)[0] / 1000.0
+
+    def get_adc_raw(self, channel):
+        _check_channel(channel, ADC_CH_NO)
+        return self._read_words_as(ADC_VAL_RAW_ADD + 2 * (channel - 1), 1)[0]
+
+    def set_dac_v(self, channel, value):
+        _check_channel(channel, DAC_CH_NO)
+        if value < 0:
+            value = 0
+        if value > 10:
+            value = 10
+        self.bus.write_word_data(self.address, DAC_VAL_MV_ADD + 2 * (channel - 1), int(value * 1000))
+        return 1
+
+    def get_dac_v(self, channel):
+        _check_channel(channel, DAC_CH_NO)
+        return float(self.bus.read_word_data(self.address, DAC_VAL_MV_ADD + 2 * (channel - 1))) / 1000
+
+    def set_od_pwm(self, channel, value):
+        _check_channel(channel, OD_CH_NO)
+        if value < 0:
+            value = 0
+        if value > 10000:
+            value = 10000
+        self.bus.write_word_data(self.address, OD_PWM_VAL_RAW_ADD + 2 * (channel - 1), value)
+        return 1
+
+    def get_od_pwm(self, channel):
+        _check_channel(channel, OD_CH_NO)
+        return self.bus.read_word_data(self.address, OD_PWM_VAL_RAW_ADD + 2 * (channel - 1))
+
+    # ---------------------------------------------------------------- relays
+    def set_relay_ch(self, channel, value):
+        _check_channel(channel, 8)
+        if value == 0:
+            self.bus.write_byte_data(self.address, RELAY_CLR_ADD, channel)
+        else:
+            self.bus.write_byte_data(self.address, RELAY_SET_ADD, channel)
+        return 1
+
+    def set_relays(self, value):
+        if value < 0 or value > 255:
+            raise ValueError('Invalid relays value')
+        self.bus.write_byte_data(self.address, RELAY_VAL_ADD, value)
+
+    def get_relays(self):
+        return self._read_byte_as(RELAY_VAL_ADD)
+
+    # ---------------------------------------------------------------- digital inputs
+    def get_opto(self):
+        return self._read_byte_as(OPTO_IN_ADD)
+
+    def set_gpio_dir(self, dir):
+        if dir < 0 or dir > 15:
+            raise ValueError('Invalid channel direction register value (allow 0..15)')
+        self.bus.write_byte_data(self.address, GPIO_DIR_ADD, dir)
+        return 1
+
+    def get_gpio(self):
+        return self._read_byte_as(GPIO_VAL_ADD)
+
+    def set_gpio_pin(self, pin, val):
+        if pin < 1 or pin > GPIO_CH_NO:
+            raise ValueError('Invalid pin number')
+        if val == 0:
+            self.bus.write_byte_data(self.address, GPIO_CLR_ADD, pin)
+        else:
+            self.bus.write_byte_data(self.address, GPIO_SET_ADD, pin)
+        return 1
+
+    def cfg_opto_edge_count(self, channel, state):
+        _check_channel(channel, OPTO_CH_NO)
+        EDGE_NONE = 0
+        EDGE_FALLING = 2
+        EDGE_RISING = 1
+        if state < EDGE_NONE or state > EDGE_FALLING + EDGE_RISING:
+            raise ValueError('Invalid edge type 0-none, 1-rising, 2-falling, 3-both')
+        rising, falling = self.bus.read_i2c_block_data(self.address, I2C_MEM_OPTO_IT_RISING_ADD, 2)
+        if state & EDGE_FALLING:
+            falling |= 1 << (channel - 1)
+        else:
+            falling &= ~(1 << (channel - 1))
+        if state & EDGE_RISING:
+            rising |= 1 << (channel - 1)
+        else:
+            rising &= ~(1 << (channel - 1))
+        self.bus.write_i2c_block_data(self.address, I2C_MEM_OPTO_IT_RISING_ADD, [rising, falling])
+        return 1
+
+    def get_opto_count(self, channel):
+        _check_channel(channel, OPTO_CH_NO)
+        buff = self.read_block(I2C_MEM_OPTO_EDGE_COUNT_ADD + 4 * (channel - 1), 4)
+        return struct.unpack('<I', buff)[0]
+
+    def rst_opto_count(self, channel):
+        _check_channel(channel, OPTO_CH_NO)
+        self.bus.write_byte_data(self.address, I2C_MEM_OPTO_CNT_RST_ADD, channel)
+        return 1
+
+    def cfg_opto_encoder(self, channel, state):
+        _check_channel(channel, 4)
+        if state < 0 or state > 1:
+            raise ValueError('Invalid state value 0-off, 1-on')
+        encoders = self.bus.read_byte_data(self.address, I2C_MEM_OPTO_ENC_ENABLE_ADD)
+        if state == 1:
+            encoders |= 1 << (channel - 1)
+        else:
+            encoders &= ~(1 << (channel - 1))
+        self.bus.write_byte_data(self.address, I2C_MEM_OPTO_ENC_ENABLE_ADD, encoders)
+        return 1
+
+    def get_opto_encoder_count(self, channel):
+        _check_channel(channel, 4)
+        buff = self.read_block(I2C_MEM_OPTO_ENC_COUNT_ADD + 4 * (channel - 1), 4)
+        return struct.unpack('<i', buff)[0]
+
+    def reset_opto_encoder_count(self, channel):
+        _check_channel(channel, 4)
+        self.bus.write_byte_data(self.address, I2C_MEM_OPTO_ENC_CNT_RST_ADD, channel)
+        return 1
+
+    # ---------------------------------------------------------------- one wire bus
+    def owb_get_sns_no(self):
+        return self.bus.read_byte_data(self.address, I2C_MEM_1WB_DEV)
+
+    def owb_get_temp(self, channel):
+        nr = self.owb_get_sns_no()
+        if channel > nr or channel < 1:
+            raise ValueError('Invalid channel number')
+        data = self.bus.read_word_data(self.address, I2C_MEM_1WB_T1 + 2 * (channel - 1))
+        if data > 0x7fff:
+            data -= 0x10000
+        return data / 100
+
+    def owb_scan(self):
+        self.bus.write_byte_data(self.address, I2C_MEM_1WB_START_SEARCH, 1)
+        return 1
+
+    def owb_get_sns_id(self, channel):
+        nr = self.owb_get_sns_no()
+        if channel > nr or channel < 1:
+            raise ValueError('Invalid channel number')
+        self.bus.write_byte_data(self.address, I2C_MEM_1WB_ROM_CODE_IDX, channel - 1)
+        return self.bus.read_i2c_block_data(self.address, I2C_MEM_1WB_ROM_CODE, 8)
+
+
+# Module level API, every call opens the bus for one access.
+# Use a Board object to keep the bus open and read several channels at once.
+
+def getAdcV(stack, channel):
+    _check_stack(stack)
+    _check_channel(channel, ADC_CH_NO)
+    with Board(stack) as board:
+        return board.get_adc_v(channel)
+
+
+def getAdcRaw(stack, channel):
+    _check_stack(stack)
+    _check_channel(channel, ADC_CH_NO)
+    with Board(stack) as board:
+        return board.get_adc_raw(channel)
+
+
+def setDacV(stack, channel, value):
+    _check_stack(stack)
+    _check_channel(channel, DAC_CH_NO)
+    with Board(stack) as board:
+        return board.set_dac_v(channel, value)
+
+
+def getDacV(stack, channel):
+    _check_stack(stack)
+    _check_channel(channel, DAC_CH_NO)
+    with Board(stack) as board:
+        return board.get_dac_v(channel)
 
 
 def setOdPwm(stack, channel, value):
-    if stack < 0 or stack > 7:
-        raise ValueError('Invalid stack level')
-    if channel < 1 or channel > 4:
-        raise ValueError('Invalid channel number')
-    bus = smbus2.SMBus(1)
-    if value < 0:
-        value = 0
-    if value > 10000:
-        value = 10000
-    OD_PWM_VAL_RAW_ADD = 48
-    try:
-        bus.write_word_data(DEVICE_ADDRESS + stack, OD_PWM_VAL_RAW_ADD + 2 * (channel - 1), value)
-    except Exception as e:
-        bus.close()
-        raise Exception(e)
-    bus.close()
-    return 1
+    _check_stack(stack)
+    _check_channel(channel, OD_CH_NO)
+    with Board(stack) as board:
+        return board.set_od_pwm(channel, value)
+
 
 def getOdPwm(stack, channel):
-    if stack < 0 or stack > 7:
-        raise ValueError('Invalid stack level')
-    if channel < 1 or channel > 4:
-        raise ValueError('Invalid channel number')
-    bus = smbus2.SMBus(1)
-    OD_PWM_VAL_RAW_ADD = 48
-    try:
-        raw = bus.read_word_data(DEVICE_ADDRESS + stack, OD_PWM_VAL_RAW_ADD + 2 * (channel - 1))
+    _check_stack(stack)
+    _check_channel(channel, OD_CH_NO)
+    with Board(stack) as board:
         # TODO: doesn't need transformation?
-        bus.close()
-        return raw
-    except Exception as e:
-        bus.close()
-        raise Exception(e)
+        return board.get_od_pwm(channel)
 
 def _fixed_setOdPwm(stack, channel, value):
     return setOdPwm(stack, channel, int(value * 100))
@@ -144,71 +371,32 @@ def _fixed_getOdPwm(stack, channel):
 
 
 def setRelayCh(stack, channel, value):
-    if stack < 0 or stack > 7:
-        raise ValueError('Invalid stack level')
-    if channel < 1 or channel > 8:
-        raise ValueError('Invalid channel number')
-    bus = smbus2.SMBus(1)
-    RELAY_SET_ADD = 1
-    RELAY_CLR_ADD = 2
-    if value == 0:
-        try:
-            bus.write_byte_data(DEVICE_ADDRESS + stack, RELAY_CLR_ADD, channel)
-        except Exception as e:
-            bus.close()
-            return -1
-    else:
-        try:
-            bus.write_byte_data(DEVICE_ADDRESS + stack, RELAY_SET_ADD, channel)
-        except Exception as e:
-            bus.close()
-            return -1
-    bus.close()
-    return 1
+    _check_stack(stack)
+    _check_channel(channel, 8)
+    try:
+        with Board(stack) as board:
+            return board.set_relay_ch(channel, value)
+    except Exception as e:
+        return -1
 
 
 def setRelays(stack, value):
-    if stack < 0 or stack > 7:
-        raise ValueError('Invalid stack level')
+    _check_stack(stack)
     if value < 0 or value > 255:
         raise ValueError('Invalid relays value')
-    bus = smbus2.SMBus(1)
-    RELAY_VAL_ADD = 0;
-    try:
-        bus.write_byte_data(DEVICE_ADDRESS + stack, RELAY_VAL_ADD, value)
-    except Exception as e:
-        bus.close()
-        raise Exception(e)
-    bus.close()
+    with Board(stack) as board:
+        board.set_relays(value)
 
 
 def getRelays(stack):
-    if stack < 0 or stack > 7:
-        raise ValueError('Invalid stack level')
-    bus = smbus2.SMBus(1)
-    RELAY_VAL_ADD = 0
-    valA = 257
-    val = 258
-    retry = 10
-    try:
-        while valA != val and retry > 0:
-            valA = val
-            retry -= 1
-            val = bus.read_byte_data(DEVICE_ADDRESS + stack, RELAY_VAL_ADD)
-    except Exception as e:
-        bus.close()
-        raise Exception(e)
-    bus.close()
-    if retry == 0:
-        raise Exception('Spurious read detected')
-    return val
+    _check_stack(stack)
+    with Board(stack) as board:
+        return board.get_relays()
 
 
 def getRelayCh(stack, channel):
-    if stack < 0 or stack > 7:
-        raise ValueError('Invalid stack level')
-    if channel < 1 or channel > 8:
-        raise ValueError('Invalid channel number')
+    _check_stack(stack)
+    _check_channel(channel, 8)
     val = getRelays(stack)
     if val < 0:
         return -1
@@ -216,26 +404,9 @@ def getRelayCh(stack, channel):
 
 
 def getOptoCh(stack, channel):
-    if stack < 0 or stack > 7:
-        raise ValueError('Invalid stack level')
-    if channel < 1 or channel > 8:
-        raise ValueError('Invalid channel number')
-    bus = smbus2.SMBus(1)
-    OPTO_IN_ADD = 3
-    valA = 257
-    val = 258
-    retry = 10
-    try:
-      while valA != val and retry > 0:
-        valA = val
-        retry -= 1
-        val = bus.read_byte_data(DEVICE_ADDRESS + stack, OPTO_IN_ADD)
-    except Exception as e:
-        bus.close()
-        raise Exception(e)
-    bus.close()
-    if retry == 0:
-        raise Exception('Spurious read detected')
+    _check_stack(stack)
+    _check_channel(channel, OPTO_CH_NO)
+    val = getOpto(stack)
     if val & (1 << (channel - 1)):
         return 1
     else:
@@ -243,270 +414,112 @@ def getOptoCh(stack, channel):
 
 
 def getOpto(stack):
-    if stack < 0 or stack > 7:
-        raise ValueError('Invalid stack level')
-    bus = smbus2.SMBus(1)
-    OPTO_IN_ADD = 3
-    valA = 257
-    val = 258
-    retry = 10
-    try:
-        while valA != val and retry > 0:
-            valA = val
-            retry -= 1
-            val = bus.read_byte_data(DEVICE_ADDRESS + stack, OPTO_IN_ADD)
-    except Exception as e:
-        bus.close()
-        raise Exception(e)
-    bus.close()
-    if retry == 0:
-        raise Exception('Spurious read detected')
-    return val
+    _check_stack(stack)
+    with Board(stack) as board:
+        return board.get_opto()
 
 
 def setGpioDir(stack, dir):
-    if stack < 0 or stack > 7:
-        raise ValueError('Invalid stack level')
+    _check_stack(stack)
     if dir < 0 or dir > 15:
         raise ValueError('Invalid channel direction register value (allow 0..15)')
-    bus = smbus2.SMBus(1)
-    GPIO_DIR_ADD = 7
-    try:
-        bus.write_byte_data(DEVICE_ADDRESS + stack, GPIO_DIR_ADD, dir)
-    except Exception as e:
-        bus.close()
-        raise Exception(e)
-    bus.close()
-    return 1
+    with Board(stack) as board:
+        return board.set_gpio_dir(dir)
 
 
 def getGpio(stack):
-    if stack < 0 or stack > 7:
-        raise ValueError('Invalid stack level')
-    bus = smbus2.SMBus(1)
-    GPIO_VAL_ADD = 4
-    valA = 257
-    val = 258
-    retry = 10
-    try:
-        while valA != val and retry > 0:
-            valA = val
-            retry -= 1
-            val = bus.read_byte_data(DEVICE_ADDRESS + stack, GPIO_VAL_ADD)
-    except Exception as e:
-        bus.close()
-        raise Exception(e)
-    bus.close()
-    if retry == 0:
-        raise Exception('Spurious read detected')
-    return val
+    _check_stack(stack)
+    with Board(stack) as board:
+        return board.get_gpio()
 
 
 def setGpioPin(stack, pin, val):
-    if stack < 0 or stack > 7:
-        raise ValueError('Invalid stack level')
+    _check_stack(stack)
     if pin < 1 or pin > 4:
         raise ValueError('Invalid pin number')
-    bus = smbus2.SMBus(1)
-    GPIO_SET_ADD = 5
-    GPIO_CLR_ADD = 6
     try:
-        if val == 0:
-            bus.write_byte_data(DEVICE_ADDRESS + stack, GPIO_CLR_ADD, pin)
-        else:
-            bus.write_byte_data(DEVICE_ADDRESS + stack, GPIO_SET_ADD, pin)
+        with Board(stack) as board:
+            return board.set_gpio_pin(pin, val)
     except Exception as e:
-        bus.close()
         return -1
-    bus.close()
-    return 1
 
 def cfgOptoEdgeCount(stack, channel, state):
-    if stack < 0 or stack > 7:
-        raise ValueError('Invalid stack level')
-    if channel < 1 or channel > 8:
-        raise ValueError('Invalid channel number')
-    EDGE_NONE = 0
-    EDGE_FALLING = 2
-    EDGE_RISING = 1
-    if state < EDGE_NONE or state > EDGE_FALLING + EDGE_RISING:
+    _check_stack(stack)
+    _check_channel(channel, OPTO_CH_NO)
+    if state < 0 or state > 3:
         raise ValueError('Invalid edge type 0-none, 1-rising, 2-falling, 3-both')
-    I2C_MEM_OPTO_IT_RISING_ADD = 56
-    I2C_MEM_OPTO_IT_FALLING_ADD = 57
-    bus = smbus2.SMBus(1)
     try:
-        rising = bus.read_byte_data(DEVICE_ADDRESS + stack, I2C_MEM_OPTO_IT_RISING_ADD)
-        falling = bus.read_byte_data(DEVICE_ADDRESS + stack, I2C_MEM_OPTO_IT_FALLING_ADD)
-        if state & EDGE_FALLING:
-            falling |= 1 << (channel - 1)
-        else:
-            falling &= ~(1 << (channel - 1))
-        if state & EDGE_RISING:
-            rising |= 1 << (channel - 1)
-        else:
-            rising &= ~(1 << (channel -1))
-        bus.write_byte_data(DEVICE_ADDRESS + stack,I2C_MEM_OPTO_IT_RISING_ADD, rising)
-        bus.write_byte_data(DEVICE_ADDRESS + stack, I2C_MEM_OPTO_IT_FALLING_ADD, falling);
-
+        with Board(stack) as board:
+            return board.cfg_opto_edge_count(channel, state)
     except Exception as e:
-        bus.close()
         return -1
-    bus.close()
-    return 1
 
 def getOptoCount(stack, channel):
-    if stack < 0 or stack > 7:
-        raise ValueError('Invalid stack level')
-    if channel < 1 or channel > 8:
-        raise ValueError('Invalid channel number')
-    I2C_MEM_OPTO_EDGE_COUNT_ADD = 128
-    bus = smbus2.SMBus(1)
+    _check_stack(stack)
+    _check_channel(channel, OPTO_CH_NO)
     try:
-        buff = bus.read_i2c_block_data(DEVICE_ADDRESS + stack, I2C_MEM_OPTO_EDGE_COUNT_ADD + 4 * (channel - 1), 4)
-        count = buff[0] + buff[1] * 0x100 + buff[2] * 0x10000 + buff[3] * 0x1000000
+        with Board(stack) as board:
+            return board.get_opto_count(channel)
     except Exception as e:
-        bus.close()
         return -1
-    bus.close()
-    return count
 
 def rstOptoCount(stack, channel):
-    if stack < 0 or stack > 7:
-        raise ValueError('Invalid stack level')
-    if channel < 1 or channel > 8:
-        raise ValueError('Invalid channel number')
-    I2C_MEM_OPTO_CNT_RST_ADD = 60
-    bus = smbus2.SMBus(1)
+    _check_stack(stack)
+    _check_channel(channel, OPTO_CH_NO)
     try:
-        bus.write_byte_data(DEVICE_ADDRESS + stack, I2C_MEM_OPTO_CNT_RST_ADD, channel)
+        with Board(stack) as board:
+            return board.rst_opto_count(channel)
     except Exception as e:
-        bus.close()
         return -1
-    bus.close()
-    return 1
 
 def cfgOptoEncoder(stack, channel, state):
-    if stack < 0 or stack > 7:
-        raise ValueError('Invalid stack level')
-    if channel < 1 or channel > 4:
-        raise ValueError('Invalid channel number')
+    _check_stack(stack)
+    _check_channel(channel, 4)
     if state < 0 or state > 1:
         raise ValueError('Invalid state value 0-off, 1-on')
-    I2C_MEM_OPTO_ENC_ENABLE_ADD = 70
-    bus = smbus2.SMBus(1)
     try:
-        encoders = bus.read_byte_data(DEVICE_ADDRESS + stack, I2C_MEM_OPTO_ENC_ENABLE_ADD)
-        if state == 1:
-            encoders |= 1 << (channel - 1)
-        else:
-            encoders &= ~(1 << (channel - 1))
-        bus.write_byte_data(DEVICE_ADDRESS + stack, I2C_MEM_OPTO_ENC_ENABLE_ADD, encoders)
+        with Board(stack) as board:
+            return board.cfg_opto_encoder(channel, state)
     except Exception as e:
-        bus.close()
         return -1
-    bus.close()
-    return 1
 
 def getOptoEncoderCount(stack, channel):
-    if stack < 0 or stack > 7:
-        raise ValueError('Invalid stack level')
-    if channel < 1 or channel > 4:
-        raise ValueError('Invalid channel number')
-    I2C_MEM_OPTO_ENC_COUNT_ADD = 187
-    bus = smbus2.SMBus(1)
-    try:
-        buff = bus.read_i2c_block_data(DEVICE_ADDRESS + stack, I2C_MEM_OPTO_ENC_COUNT_ADD + 4 * (channel - 1), 4)
-        count = struct.unpack('i', bytearray(buff)) #int.from_bytes(buff, byteorder='big', signed=True)
-    except Exception as e:
-        bus.close()
-        raise e
-    bus.close()
-    return count
+    _check_stack(stack)
+    _check_channel(channel, 4)
+    with Board(stack) as board:
+        # kept as a tuple for compatibility with previous releases
+        return (board.get_opto_encoder_count(channel),)
 
 def resetOptoEncoderCount(stack, channel):
-    if stack < 0 or stack > 7:
-        raise ValueError('Invalid stack level')
-    if channel < 1 or channel > 4:
-        raise ValueError('Invalid channel number')
-    I2C_MEM_OPTO_ENC_CNT_RST_ADD = 72
-    bus = smbus2.SMBus(1)
-    try:
-        bus.write_byte_data(DEVICE_ADDRESS + stack, I2C_MEM_OPTO_ENC_CNT_RST_ADD, channel)
-    except Exception as e:
-        bus.close()
-        raise e
-    bus.close()
-    return 1
+    _check_stack(stack)
+    _check_channel(channel, 4)
+    with Board(stack) as board:
+        return board.reset_opto_encoder_count(channel)
 
 
 def owbGetTemp(stack, channel):
-    I2C_MEM_1WB_DEV = 211
-    I2C_MEM_1WB_T1 = 222
-    if stack < 0 or stack > 7:
-        raise ValueError('Invalid stack level')
-    bus = smbus2.SMBus(1)
-    temp = 0
-    try:
-        nr = bus.read_byte_data(DEVICE_ADDRESS + stack, I2C_MEM_1WB_DEV)
-        if channel > nr or channel < 1:
-            bus.close()
-            raise ValueError('Invalid channel number')
-        data = bus.read_word_data(DEVICE_ADDRESS + stack, I2C_MEM_1WB_T1 + 2 * (channel - 1))
-        temp = data / 100
-    except Exception as e:
-        bus.close()
-        raise e
-    bus.close()
-    return temp
+    _check_stack(stack)
+    with Board(stack) as board:
+        return board.owb_get_temp(channel)
 
 def owbGetSnsNo(stack):
-    I2C_MEM_1WB_DEV = 211
-    if stack < 0 or stack > 7:
-        raise ValueError('Invalid stack level')
-    bus = smbus2.SMBus(1)
-    try:
-         nr = bus.read_byte_data(DEVICE_ADDRESS + stack, I2C_MEM_1WB_DEV)
-    except Exception as e:
-        bus.close()
-        raise e
-    bus.close()
-    return nr
+    _check_stack(stack)
+    with Board(stack) as board:
+        return board.owb_get_sns_no()
 
 def owbScan(stack):
-    I2C_MEM_1WB_START_SEARCH = 221
-    if stack < 0 or stack > 7:
-        raise ValueError('Invalid stack level')
-    bus = smbus2.SMBus(1)
-    try:
-        bus.write_byte_data(DEVICE_ADDRESS + stack, I2C_MEM_1WB_START_SEARCH,1 )
-    except Exception as e:
-        bus.close()
-        raise e
-    bus.close()   
-    return 1
+    _check_stack(stack)
+    with Board(stack) as board:
+        return board.owb_scan()
 
 def owbGetSnsId(stack, channel):
-    I2C_MEM_1WB_ROM_CODE_IDX =212
-    I2C_MEM_1WB_ROM_CODE = 213
-    ROM_CODE_LEN = 8
-    I2C_MEM_1WB_T1 = 222
-    I2C_MEM_1WB_START_SEARCH = 221
-    I2C_MEM_1WB_DEV = 211
-    if stack < 0 or stack > 7:
-        raise ValueError('Invalid stack level')
-    bus = smbus2.SMBus(1)
-    temp = 0
-    try:
-        nr = bus.read_byte_data(DEVICE_ADDRESS + stack, I2C_MEM_1WB_DEV)
-        if channel > nr or channel < 1:
-            bus.close()
-            raise ValueError('Invalid channel number') 
-        bus.write_byte_data(DEVICE_ADDRESS + stack, I2C_MEM_1WB_ROM_CODE_IDX, channel - 1)
-        buff = bus.read_i2c_block_data(DEVICE_ADDRESS + stack, I2C_MEM_1WB_ROM_CODE, 8)
-    except Exception as e:
-        bus.close()
-        raise e
-    bus.close()
-    return buff
+    _check_stack(stack)
+    with Board(stack) as board:
+        return board.owb_get_sns_id(channel)
 
 
+# native accessors over libioplus.so (see "Native module" in README.md), None when not built
+try:
+    from ._ioplus import Board as NativeBoard
+except ImportError:
+    NativeBoard = None
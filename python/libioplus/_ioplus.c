@@ -0,0 +1,548 @@
+/*
+ * _ioplus.c:
+ *	CPython extension over libioplus.so
+ *	I2C transfers run with the GIL released, one at a time per Board object,
+ *	multi channel readings are returned as array.array objects (buffer
+ *	protocol, numpy.frombuffer ready) built directly from the C buffers.
+ *
+ *	Copyright (c) 2016-2023 Sequent Microsystem
+ *	<http://www.sequentmicrosystem.com>
+ ***********************************************************************
+ */
+#define PY_SSIZE_T_CLEAN
+#include <Python.h>
+#include <pythread.h>
+#include <libioplus.h>
+
+typedef struct
+{
+	PyObject_HEAD
+	IoplusBoardType board;
+	PyThread_type_lock lock; // held around every use of board
+} NativeBoardObject;
+
+static PyObject *gArrayType = NULL;
+
+static PyObject* raiseErr(int err)
+{
+	if (err == IOPLUS_ERR_ARG)
+	{
+		PyErr_SetString(PyExc_ValueError, ioplusErrStr(err));
+	}
+	else
+	{
+		PyErr_SetString(PyExc_OSError, ioplusErrStr(err));
+	}
+	return NULL;
+}
+
+static PyObject* newArray(const char *typecode, const void *data, Py_ssize_t size)
+{
+	return PyObject_CallFunction(gArrayType, "sy#", typecode, (const char*)data,
+		size);
+}
+
+static PyObject* arrayScaled(const uint16_t *raw, int count, float scale)
+{
+	float val[IOPLUS_ADC_CH_NO];
+	int i;
+
+	for (i = 0; i < count; i++)
+	{
+		val[i] = raw[i] * scale;
+	}
+	return newArray("f", val, count * sizeof(float));
+}
+
+/* STMT on self->board with the GIL released; the board lock serializes the
+ * threads sharing one Board (output shadow, close during a transfer) and is
+ * waited for without the GIL */
+#define BOARD_CALL(STMT)	\
+	Py_BEGIN_ALLOW_THREADS	\
+	PyThread_acquire_lock(self->lock, WAIT_LOCK);	\
+	STMT;	\
+	PyThread_release_lock(self->lock);	\
+	Py_END_ALLOW_THREADS
+
+#define CALL_RELEASED(RET, EXPR)	BOARD_CALL(RET = (EXPR))
+
+static PyObject* NativeBoard_new(PyTypeObject *type, PyObject *args,
+	PyObject *kwds)
+{
+	NativeBoardObject *self;
+
+	(void)args;
+	(void)kwds;
+	self = (NativeBoardObject*)type->tp_alloc(type, 0);
+	if (NULL == self)
+	{
+		return NULL;
+	}
+	// not open until __init__ succeeds, dealloc must not close fd 0
+	self->board.dev = -1;
+	self->lock = PyThread_allocate_lock();
+	if (NULL == self->lock)
+	{
+		Py_DECREF(self);
+		return PyErr_NoMemory();
+	}
+	return (PyObject*)self;
+}
+
+static int NativeBoard_init(NativeBoardObject *self, PyObject *args,
+	PyObject *kwds)
+{
+	static char *kwlist[] = {"stack", NULL};
+	int stack = 0;
+	int ret;
+
+	if (!PyArg_ParseTupleAndKeywords(args, kwds, "|i", kwlist, &stack))
+	{
+		return -1;
+	}
+	CALL_RELEASED(ret, ioplusOpen(&self->board, stack));
+	if (ret != IOPLUS_OK)
+	{
+		raiseErr(ret);
+		return -1;
+	}
+	return 0;
+}
+
+static void NativeBoard_dealloc(NativeBoardObject *self)
+{
+	// last reference, no other thread can be using the board
+	ioplusClose(&self->board);
+	if (NULL != self->lock)
+	{
+		PyThread_free_lock(self->lock);
+	}
+	Py_TYPE(self)->tp_free((PyObject*)self);
+}
+
+static PyObject* NativeBoard_close(NativeBoardObject *self, PyObject *unused)
+{
+	(void)unused;
+	BOARD_CALL(ioplusClose(&self->board));
+	Py_RETURN_NONE;
+}
+
+static PyObject* NativeBoard_adc_read_all(NativeBoardObject *self,
+	PyObject *unused)
+{
+	uint16_t mV[IOPLUS_ADC_CH_NO];
+	int ret;
+
+	(void)unused;
+	CALL_RELEASED(ret, ioplusAdcGetAll(&self->board, mV));
+	if (ret != IOPLUS_OK)
+	{
+		return raiseErr(ret);
+	}
+	return arrayScaled(mV, IOPLUS_ADC_CH_NO, 0.001f);
+}
+
+static PyObject* NativeBoard_adc_read_all_mv(NativeBoardObject *self,
+	PyObject *unused)
+{
+	uint16_t mV[IOPLUS_ADC_CH_NO];
+	int ret;
+
+	(void)unused;
+	CALL_RELEASED(ret, ioplusAdcGetAll(&self->board, mV));
+	if (ret != IOPLUS_OK)
+	{
+		return raiseErr(ret);
+	}
+	return newArray("H", mV, sizeof(mV));
+}
+
+static PyObject* NativeBoard_adc_read_all_raw(NativeBoardObject *self,
+	PyObject *unused)
+{
+	uint16_t raw[IOPLUS_ADC_CH_NO];
+	int ret;
+
+	(void)unused;
+	CALL_RELEASED(ret, ioplusAdcRawGetAll(&self->board, raw));
+	if (ret != IOPLUS_OK)
+	{
+		return raiseErr(ret);
+	}
+	return newArray("H", raw, sizeof(raw));
+}
+
+static PyObject* NativeBoard_adc_read(NativeBoardObject *self, PyObject *args)
+{
+	uint16_t mV = 0;
+	int ch = 0;
+	int ret;
+
+	if (!PyArg_ParseTuple(args, "i", &ch))
+	{
+		return NULL;
+	}
+	CALL_RELEASED(ret, ioplusAdcGet(&self->board, ch, &mV));
+	if (ret != IOPLUS_OK)
+	{
+		return raiseErr(ret);
+	}
+	return PyFloat_FromDouble(mV / 1000.0);
+}
+
+static PyObject* NativeBoard_dac_read_all(NativeBoardObject *self,
+	PyObject *unused)
+{
+	uint16_t mV[IOPLUS_DAC_CH_NO];
+	int ret;
+
+	(void)unused;
+	CALL_RELEASED(ret, ioplusDacGetAll(&self->board, mV));
+	if (ret != IOPLUS_OK)
+	{
+		return raiseErr(ret);
+	}
+	return arrayScaled(mV, IOPLUS_DAC_CH_NO, 0.001f);
+}
+
+static PyObject* NativeBoard_dac_write(NativeBoardObject *self, PyObject *args)
+{
+	double volt = 0;
+	int ch = 0;
+	int ret;
+
+	if (!PyArg_ParseTuple(args, "id", &ch, &volt))
+	{
+		return NULL;
+	}
+	if (volt < 0)
+	{
+		volt = 0;
+	}
+	CALL_RELEASED(ret,
+		ioplusDacSet(&self->board, ch, (uint16_t)(volt * 1000 + 0.5)));
+	if (ret != IOPLUS_OK)
+	{
+		return raiseErr(ret);
+	}
+	Py_RETURN_NONE;
+}
+
+static PyObject* NativeBoard_od_read_all(NativeBoardObject *self,
+	PyObject *unused)
+{
+	uint16_t raw[IOPLUS_OD_CH_NO];
+	int ret;
+
+	(void)unused;
+	CALL_RELEASED(ret, ioplusOdPwmGetAll(&self->board, raw));
+	if (ret != IOPLUS_OK)
+	{
+		return raiseErr(ret);
+	}
+	return newArray("H", raw, sizeof(raw));
+}
+
+static PyObject* NativeBoard_od_write(NativeBoardObject *self, PyObject *args)
+{
+	int ch = 0;
+	int raw = 0;
+	int ret;
+
+	if (!PyArg_ParseTuple(args, "ii", &ch, &raw))
+	{
+		return NULL;
+	}
+	if (raw < 0)
+	{
+		raw = 0;
+	}
+	CALL_RELEASED(ret, ioplusOdPwmSet(&self->board, ch, (uint16_t)raw));
+	if (ret != IOPLUS_OK)
+	{
+		return raiseErr(ret);
+	}
+	Py_RETURN_NONE;
+}
+
+static PyObject* NativeBoard_relay_read(NativeBoardObject *self,
+	PyObject *unused)
+{
+	uint8_t val = 0;
+	int ret;
+
+	(void)unused;
+	CALL_RELEASED(ret, ioplusRelayGet(&self->board, &val));
+	if (ret != IOPLUS_OK)
+	{
+		return raiseErr(ret);
+	}
+	return PyLong_FromLong(val);
+}
+
+static PyObject* NativeBoard_relay_write(NativeBoardObject *self,
+	PyObject *args)
+{
+	int val = 0;
+	int ret;
+
+	if (!PyArg_ParseTuple(args, "i", &val))
+	{
+		return NULL;
+	}
+	if (val < 0 || val > 255)
+	{
+		return raiseErr(IOPLUS_ERR_ARG);
+	}
+	CALL_RELEASED(ret, ioplusRelaySet(&self->board, (uint8_t)val));
+	if (ret != IOPLUS_OK)
+	{
+		return raiseErr(ret);
+	}
+	Py_RETURN_NONE;
+}
+
+static PyObject* NativeBoard_relay_ch_write(NativeBoardObject *self,
+	PyObject *args)
+{
+	int ch = 0;
+	int state = 0;
+	int ret;
+
+	if (!PyArg_ParseTuple(args, "ip", &ch, &state))
+	{
+		return NULL;
+	}
+	CALL_RELEASED(ret, ioplusRelayChSet(&self->board, ch, state));
+	if (ret != IOPLUS_OK)
+	{
+		return raiseErr(ret);
+	}
+	Py_RETURN_NONE;
+}
+
+static PyObject* NativeBoard_opto_read(NativeBoardObject *self,
+	PyObject *unused)
+{
+	uint8_t val = 0;
+	int ret;
+
+	(void)unused;
+	CALL_RELEASED(ret, ioplusOptoGet(&self->board, &val));
+	if (ret != IOPLUS_OK)
+	{
+		return raiseErr(ret);
+	}
+	return PyLong_FromLong(val);
+}
+
+static PyObject* NativeBoard_opto_count_read_all(NativeBoardObject *self,
+	PyObject *unused)
+{
+	uint32_t cnt[IOPLUS_OPTO_CH_NO];
+	int ret;
+
+	(void)unused;
+	CALL_RELEASED(ret, ioplusOptoCountGetAll(&self->board, cnt));
+	if (ret != IOPLUS_OK)
+	{
+		return raiseErr(ret);
+	}
+	return newArray("I", cnt, sizeof(cnt));
+}
+
+static PyObject* NativeBoard_gpio_read(NativeBoardObject *self,
+	PyObject *unused)
+{
+	uint8_t val = 0;
+	int ret;
+
+	(void)unused;
+	CALL_RELEASED(ret, ioplusGpioGet(&self->board, &val));
+	if (ret != IOPLUS_OK)
+	{
+		return raiseErr(ret);
+	}
+	return PyLong_FromLong(val);
+}
+
+static PyObject* NativeBoard_gpio_write(NativeBoardObject *self, PyObject *args)
+{
+	int val = 0;
+	int ret;
+
+	if (!PyArg_ParseTuple(args, "i", &val))
+	{
+		return NULL;
+	}
+	CALL_RELEASED(ret, ioplusGpioSet(&self->board, (uint8_t)val));
+	if (ret != IOPLUS_OK)
+	{
+		return raiseErr(ret);
+	}
+	Py_RETURN_NONE;
+}
+
+static PyObject* NativeBoard_owb_temp_read_all(NativeBoardObject *self,
+	PyObject *unused)
+{
+	int16_t temp[IOPLUS_OWB_SENS_NO];
+	float val[IOPLUS_OWB_SENS_NO];
+	int cnt = 0;
+	int ret;
+	int i;
+
+	(void)unused;
+	CALL_RELEASED(ret, ioplusOwbTempGetAll(&self->board, temp, &cnt));
+	if (ret != IOPLUS_OK)
+	{
+		return raiseErr(ret);
+	}
+	for (i = 0; i < cnt; i++)
+	{
+		val[i] = temp[i] / 100.0f;
+	}
+	return newArray("f", val, cnt * sizeof(float));
+}
+
+static PyObject* NativeBoard_shadow_enable(NativeBoardObject *self,
+	PyObject *args)
+{
+	unsigned int periodMs = 0;
+	int ret;
+
+	if (!PyArg_ParseTuple(args, "|I", &periodMs))
+	{
+		return NULL;
+	}
+	CALL_RELEASED(ret, ioplusShadowEnable(&self->board, periodMs));
+	if (ret != IOPLUS_OK)
+	{
+		return raiseErr(ret);
+	}
+	Py_RETURN_NONE;
+}
+
+static PyObject* NativeBoard_shadow_disable(NativeBoardObject *self,
+	PyObject *unused)
+{
+	(void)unused;
+	BOARD_CALL(ioplusShadowDisable(&self->board));
+	Py_RETURN_NONE;
+}
+
+static PyObject* NativeBoard_shadow_stats(NativeBoardObject *self,
+	PyObject *unused)
+{
+	IoplusShadowStatsType st;
+
+	(void)unused;
+	BOARD_CALL(ioplusShadowStatsGet(&self->board, &st));
+	return Py_BuildValue("{s:I,s:I,s:I,s:I}", "issued", st.issued, "suppressed",
+		st.suppressed, "resyncs", st.resyncs, "errors", st.errors);
+}
+
+static PyMethodDef NativeBoard_methods[] = {
+	{"close", (PyCFunction)NativeBoard_close, METH_NOARGS, "Close the I2C port"},
+	{"adc_read", (PyCFunction)NativeBoard_adc_read, METH_VARARGS,
+		"Read one ADC channel in volts"},
+	{"adc_read_all", (PyCFunction)NativeBoard_adc_read_all, METH_NOARGS,
+		"Read the 8 ADC channels in volts, array('f')"},
+	{"adc_read_all_mv", (PyCFunction)NativeBoard_adc_read_all_mv, METH_NOARGS,
+		"Read the 8 ADC channels in millivolts, array('H')"},
+	{"adc_read_all_raw", (PyCFunction)NativeBoard_adc_read_all_raw,
+		METH_NOARGS, "Read the 8 ADC channels raw values, array('H')"},
+	{"dac_read_all", (PyCFunction)NativeBoard_dac_read_all, METH_NOARGS,
+		"Read the 4 DAC outputs in volts, array('f')"},
+	{"dac_write", (PyCFunction)NativeBoard_dac_write, METH_VARARGS,
+		"Write one DAC output in volts"},
+	{"od_read_all", (PyCFunction)NativeBoard_od_read_all, METH_NOARGS,
+		"Read the 4 open drain pwm values [0..10000], array('H')"},
+	{"od_write", (PyCFunction)NativeBoard_od_write, METH_VARARGS,
+		"Write one open drain pwm value [0..10000]"},
+	{"relay_read", (PyCFunction)NativeBoard_relay_read, METH_NOARGS,
+		"Read the relays state bitmap"},
+	{"relay_write", (PyCFunction)NativeBoard_relay_write, METH_VARARGS,
+		"Write the relays state bitmap"},
+	{"relay_ch_write", (PyCFunction)NativeBoard_relay_ch_write, METH_VARARGS,
+		"Turn one relay on or off"},
+	{"opto_read", (PyCFunction)NativeBoard_opto_read, METH_NOARGS,
+		"Read the optocoupled inputs bitmap"},
+	{"opto_count_read_all", (PyCFunction)NativeBoard_opto_count_read_all,
+		METH_NOARGS, "Read the 8 opto edge counters, array('I')"},
+	{"gpio_read", (PyCFunction)NativeBoard_gpio_read, METH_NOARGS,
+		"Read the gpio bitmap"},
+	{"gpio_write", (PyCFunction)NativeBoard_gpio_write, METH_VARARGS,
+		"Write the gpio bitmap"},
+	{"owb_temp_read_all", (PyCFunction)NativeBoard_owb_temp_read_all,
+		METH_NOARGS, "Read the one wire bus temperatures, array('f')"},
+	{"shadow_enable", (PyCFunction)NativeBoard_shadow_enable, METH_VARARGS,
+		"Skip output writes that do not change the card, optional resync period in ms"},
+	{"shadow_disable", (PyCFunction)NativeBoard_shadow_disable, METH_NOARGS,
+		"Write every output again"},
+	{"shadow_stats", (PyCFunction)NativeBoard_shadow_stats, METH_NOARGS,
+		"Issued / suppressed output writes, resyncs and errors, dict"},
+	{NULL, NULL, 0, NULL}};
+
+static PyTypeObject NativeBoardType = {
+	PyVarObject_HEAD_INIT(NULL, 0)
+	.tp_name = "libioplus._ioplus.Board",
+	.tp_basicsize = sizeof(NativeBoardObject),
+	.tp_flags = Py_TPFLAGS_DEFAULT,
+	.tp_doc = "IO-PLUS card handle over libioplus.so",
+	.tp_new = NativeBoard_new,
+	.tp_init = (initproc)NativeBoard_init,
+	.tp_dealloc = (destructor)NativeBoard_dealloc,
+	.tp_methods = NativeBoard_methods,
+};
+
+static struct PyModuleDef ioplusModule = {
+	PyModuleDef_HEAD_INIT,
+	"_ioplus",
+	"Native IO-PLUS card access over libioplus.so",
+	-1,
+	NULL,
+	NULL,
+	NULL,
+	NULL,
+	NULL};
+
+PyMODINIT_FUNC PyInit__ioplus(void)
+{
+	PyObject *module;
+	PyObject *arrayModule;
+
+	if (ioplusAbiVersion() != IOPLUS_ABI_VERSION)
+	{
+		PyErr_SetString(PyExc_ImportError, "libioplus.so ABI version mismatch");
+		return NULL;
+	}
+	if (PyType_Ready(&NativeBoardType) < 0)
+	{
+		return NULL;
+	}
+	arrayModule = PyImport_ImportModule("array");
+	if (NULL == arrayModule)
+	{
+		return NULL;
+	}
+	gArrayType = PyObject_GetAttrString(arrayModule, "array");
+	Py_DECREF(arrayModule);
+	if (NULL == gArrayType)
+	{
+		return NULL;
+	}
+	module = PyModule_Create(&ioplusModule);
+	if (NULL == module)
+	{
+		return NULL;
+	}
+	Py_INCREF(&NativeBoardType);
+	if (PyModule_AddObject(module, "Board", (PyObject*)&NativeBoardType) < 0)
+	{
+		Py_DECREF(&NativeBoardType);
+		Py_DECREF(module);
+		return NULL;
+	}
+	return module;
+}
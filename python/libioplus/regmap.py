@@ -0,0 +1,201 @@
+# Generated by regmap/regmap.py from regmap/ioplus.map, do not edit,
+# change the map and run "make regmap".
+import struct
+from collections import namedtuple
+
+ADC_CH_NO = 8
+DAC_CH_NO = 4
+OD_CH_NO = 4
+ADC_RAW_VAL_SIZE = 2
+DAC_MV_VAL_SIZE = 2
+OPTO_CH_NO = 8
+GPIO_CH_NO = 4
+COUNTER_SIZE = 4
+OWB_TEMP_SIZE_B = 2
+OWB_SENS_CNT = 8
+
+I2C_MEM_RELAY_VAL_ADD = 0
+I2C_MEM_RELAY_SET_ADD = 1
+I2C_MEM_RELAY_CLR_ADD = 2
+I2C_MEM_OPTO_IN_ADD = 3
+I2C_MEM_GPIO_VAL_ADD = 4
+I2C_MEM_GPIO_SET_ADD = 5
+I2C_MEM_GPIO_CLR_ADD = 6
+I2C_MEM_GPIO_DIR_ADD = 7
+I2C_MEM_ADC_VAL_RAW_ADD = 8
+I2C_MEM_ADC_VAL_MV_ADD = 24
+I2C_MEM_DAC_VAL_MV_ADD = 40
+I2C_MEM_OD_PWM_VAL_RAW_ADD = 48
+I2C_MEM_OPTO_IT_RISING_ADD = 56
+I2C_MEM_OPTO_IT_FALLING_ADD = 57
+I2C_MEM_GPIO_EXT_IT_RISING_ADD = 58
+I2C_MEM_GPIO_EXT_IT_FALLING_ADD = 59
+I2C_MEM_OPTO_CNT_RST_ADD = 60
+I2C_MEM_GPIO_CNT_RST_ADD = 61
+I2C_MEM_DIAG_TEMPERATURE_ADD = 62
+I2C_MEM_DIAG_3V3_MV_ADD = 63
+I2C_MEM_DIAG_3V3_MV_ADD1 = 64
+I2C_MEM_CALIB_VALUE = 65
+I2C_MEM_CALIB_CHANNEL = 67
+I2C_MEM_CALIB_KEY = 68
+I2C_MEM_CALIB_STATUS = 69
+I2C_MEM_OPTO_ENC_ENABLE_ADD = 70
+I2C_MEM_GPIO_ENC_ENABLE_ADD = 71
+I2C_MEM_OPTO_ENC_CNT_RST_ADD = 72
+I2C_MEM_GPIO_ENC_CNT_RST_ADD = 73
+I2C_MEM_OD_PULSE_CNT_SET = 74
+I2C_MEM_OD_PULSE_CNT_SET_END_ADD = 90
+I2C_MEM_OD_PWM_FREQUENCY_CH1 = 90
+I2C_MEM_OD_PWM_FREQUENCY_CH2 = 92
+I2C_MEM_OD_PWM_FREQUENCY_CH3 = 94
+I2C_MEM_OD_PWM_FREQUENCY_CH4 = 96
+I2C_MEM_RELAY_DEFAULT = 98
+I2C_MEM_OD_DEFAULT = 99
+I2C_MEM_WDT_RESET_ADD = 100
+I2C_MEM_WDT_INTERVAL_SET_ADD = 101
+I2C_MEM_WDT_INTERVAL_GET_ADD = 103
+I2C_MEM_WDT_INIT_INTERVAL_SET_ADD = 105
+I2C_MEM_WDT_INIT_INTERVAL_GET_ADD = 107
+I2C_MEM_WDT_RESET_COUNT_ADD = 109
+I2C_MEM_WDT_CLEAR_RESET_COUNT_ADD = 111
+I2C_MEM_WDT_POWER_OFF_INTERVAL_SET_ADD = 112
+I2C_MEM_WDT_POWER_OFF_INTERVAL_GET_ADD = 116
+I2C_MEM_REVISION_HW_MAJOR_ADD = 120
+I2C_MEM_REVISION_HW_MINOR_ADD = 121
+I2C_MEM_REVISION_MAJOR_ADD = 122
+I2C_MEM_REVISION_MINOR_ADD = 123
+I2C_DBG_FIFO_SIZE = 124
+I2C_DBG_FIFO_ADD = 126
+I2C_DBG_CMD = 127
+I2C_MEM_OPTO_EDGE_COUNT_ADD = 128
+I2C_MEM_OPTO_EDGE_COUNT_END_ADD = 160
+I2C_MEM_OD_PWM_FREQUENCY = 161
+I2C_MEM_MIN_MAX_SAMPLES = 163
+I2C_MEM_OD_P_SET_VALUE = 164
+I2C_MEM_OD_P_SET_CMD = 168
+I2C_MEM_ADD_RESERVED = 170
+I2C_MEM_GPIO_EDGE_COUNT_ADD = 171
+I2C_MEM_PULSE_COUNTER_SET = 171
+I2C_MEM_OD_CH_SET = 175
+I2C_MEM_OPTO_CH_SET = 176
+I2C_MEM_OPTO_ENC_COUNT_ADD = 187
+I2C_MEM_GPIO_ENC_COUNT_ADD = 203
+I2C_MEM_GPIO_ENC_COUNT_END_ADD = 211
+I2C_MEM_1WB_DEV = 211
+I2C_MEM_1WB_ROM_CODE_IDX = 212
+I2C_MEM_1WB_ROM_CODE = 213
+I2C_MEM_1WB_ROM_CODE_END = 220
+I2C_MEM_1WB_START_SEARCH = 221
+I2C_MEM_1WB_T1 = 222
+I2C_MEM_1WB_T_END = 238
+I2C_MEM_ADC_MAX = 238
+I2C_MEM_ADC_MIN = 246
+I2C_MEM_ODP_ACC = 238
+I2C_MEM_ODP_DEC = 240
+I2C_MEM_ODP_MAXS = 242
+I2C_MEM_ODP_MINS = 244
+I2C_MEM_ODP_CMD = 246
+SLAVE_BUFF_SIZE = 255
+
+# struct code, count, divisor of the raw value, access
+Reg = namedtuple('Reg', 'add code count div access')
+REGS = {
+    'relay': Reg(0, 'B', 1, 1, 'rw'),
+    'relay_set': Reg(1, 'B', 1, 1, 'w'),
+    'relay_clr': Reg(2, 'B', 1, 1, 'w'),
+    'opto': Reg(3, 'B', 1, 1, 'r'),
+    'gpio': Reg(4, 'B', 1, 1, 'rw'),
+    'gpio_set': Reg(5, 'B', 1, 1, 'w'),
+    'gpio_clr': Reg(6, 'B', 1, 1, 'w'),
+    'gpio_dir': Reg(7, 'B', 1, 1, 'rw'),
+    'adc_raw': Reg(8, 'H', 8, 1, 'r'),
+    'adc_mv': Reg(24, 'H', 8, 1000, 'r'),
+    'dac_mv': Reg(40, 'H', 4, 1000, 'rw'),
+    'od_pwm': Reg(48, 'H', 4, 1, 'rw'),
+    'opto_rising': Reg(56, 'B', 1, 1, 'rw'),
+    'opto_falling': Reg(57, 'B', 1, 1, 'rw'),
+    'gpio_rising': Reg(58, 'B', 1, 1, 'rw'),
+    'gpio_falling': Reg(59, 'B', 1, 1, 'rw'),
+    'opto_cnt_rst': Reg(60, 'B', 1, 1, 'w'),
+    'gpio_cnt_rst': Reg(61, 'B', 1, 1, 'w'),
+    'diag_temp': Reg(62, 'B', 1, 1, 'r'),
+    'diag_3v3': Reg(63, 'H', 1, 1000, 'r'),
+    'calib_value': Reg(65, 'H', 1, 1, 'w'),
+    'calib_channel': Reg(67, 'B', 1, 1, 'w'),
+    'calib_key': Reg(68, 'B', 1, 1, 'w'),
+    'calib_status': Reg(69, 'B', 1, 1, 'r'),
+    'opto_enc_enable': Reg(70, 'B', 1, 1, 'rw'),
+    'gpio_enc_enable': Reg(71, 'B', 1, 1, 'rw'),
+    'opto_enc_cnt_rst': Reg(72, 'B', 1, 1, 'w'),
+    'gpio_enc_cnt_rst': Reg(73, 'B', 1, 1, 'w'),
+    'od_pulses': Reg(74, 'I', 4, 1, 'rw'),
+    'od_pwm_freq': Reg(90, 'H', 4, 1, 'rw'),
+    'relay_default': Reg(98, 'B', 1, 1, 'rw'),
+    'od_default': Reg(99, 'B', 1, 1, 'rw'),
+    'wdt_reset': Reg(100, 'B', 1, 1, 'w'),
+    'wdt_period_set': Reg(101, 'H', 1, 1, 'w'),
+    'wdt_period': Reg(103, 'H', 1, 1, 'r'),
+    'wdt_init_period_set': Reg(105, 'H', 1, 1, 'w'),
+    'wdt_init_period': Reg(107, 'H', 1, 1, 'r'),
+    'wdt_reset_count': Reg(109, 'H', 1, 1, 'r'),
+    'wdt_reset_count_clr': Reg(111, 'B', 1, 1, 'w'),
+    'wdt_off_period_set': Reg(112, 'I', 1, 1, 'w'),
+    'wdt_off_period': Reg(116, 'I', 1, 1, 'r'),
+    'revision': Reg(120, 'B', 4, 1, 'r'),
+    'dbg_fifo_size': Reg(124, 'H', 1, 1, 'r'),
+    'dbg_fifo': Reg(126, 'B', 1, 1, 'r'),
+    'dbg_cmd': Reg(127, 'B', 1, 1, 'w'),
+    'opto_count': Reg(128, 'I', 8, 1, 'r'),
+    'od_pwm_freq_all': Reg(161, 'H', 1, 1, 'rw'),
+    'min_max_samples': Reg(163, 'B', 1, 1, 'rw'),
+    'od_pulses_value': Reg(164, 'I', 1, 1, 'w'),
+    'od_pulses_cmd': Reg(168, 'B', 1, 1, 'w'),
+    'gpio_count': Reg(171, 'I', 4, 1, 'r'),
+    'in_pulses_set': Reg(171, 'I', 1, 1, 'w'),
+    'in_pulses_out': Reg(175, 'B', 1, 1, 'w'),
+    'in_pulses_in': Reg(176, 'B', 1, 1, 'w'),
+    'opto_enc_count': Reg(187, 'i', 4, 1, 'r'),
+    'gpio_enc_count': Reg(203, 'i', 2, 1, 'r'),
+    'owb_count': Reg(211, 'B', 1, 1, 'r'),
+    'owb_rom_idx': Reg(212, 'B', 1, 1, 'rw'),
+    'owb_rom': Reg(213, 'Q', 1, 1, 'r'),
+    'owb_search': Reg(221, 'B', 1, 1, 'w'),
+    'owb_temp': Reg(222, 'h', 8, 100, 'r'),
+    'adc_max': Reg(238, 'H', 4, 1000, 'r'),
+    'adc_min': Reg(246, 'H', 4, 1000, 'r'),
+    'od_acc': Reg(238, 'H', 1, 1, 'w'),
+    'od_dec': Reg(240, 'H', 1, 1, 'w'),
+    'od_max_speed': Reg(242, 'H', 1, 1, 'w'),
+    'od_min_speed': Reg(244, 'H', 1, 1, 'w'),
+    'od_move_cmd': Reg(246, 'B', 1, 1, 'w'),
+}
+
+# one block read decoded by one struct.unpack, gaps skipped with x
+Layout = namedtuple('Layout', 'add size fmt fields')
+SNAP_LOW = Layout(0, 65, '<B2xBB2xB8H8H4H4HBBBB2xBH', (
+    'relay', 'opto', 'gpio', 'gpio_dir', 'adc_raw', 'adc_mv', 'dac_mv',
+    'od_pwm', 'opto_rising', 'opto_falling', 'gpio_rising', 'gpio_falling',
+    'diag_temp', 'diag_3v3'))
+SNAP_HIGH = Layout(128, 110, '<8I11x4I4i2iBBQ1x8h', (
+    'opto_count', 'gpio_count', 'opto_enc_count', 'gpio_enc_count',
+    'owb_count', 'owb_rom_idx', 'owb_rom', 'owb_temp'))
+COUNTERS = Layout(128, 83, '<8I11x4I4i2i', (
+    'opto_count', 'gpio_count', 'opto_enc_count', 'gpio_enc_count'))
+OWB = Layout(211, 27, '<BBQ1x8h', (
+    'owb_count', 'owb_rom_idx', 'owb_rom', 'owb_temp'))
+
+
+def decode(layout, buff, scale=True):
+    """Values of the layout registers by id from the bytes of its block
+    read, scaled to V and degC unless scale is False"""
+    vals = struct.unpack_from(layout.fmt, buff)
+    out = {}
+    i = 0
+    for rid in layout.fields:
+        reg = REGS[rid]
+        v = vals[i:i + reg.count]
+        i += reg.count
+        if scale and reg.div != 1:
+            v = [x / float(reg.div) for x in v]
+        out[rid] = v[0] if reg.count == 1 else list(v)
+    return out
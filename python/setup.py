@@ -6,6 +6,13 @@ with open("README.md", "r") as f:
 setuptools.setup(
     name='smioplus',
     packages=setuptools.find_packages(),
+    # optional native accessors, built only when libioplus.so is installed (sudo make install-lib)
+    ext_modules=[
+        setuptools.Extension('libioplus._ioplus',
+                             sources=['libioplus/_ioplus.c'],
+                             libraries=['ioplus'],
+                             optional=True),
+        ],
     version='1.0.6',
     license='MIT',
     description='Library to control Sequent Microsystems ioplus Card',
@@ -0,0 +1,402 @@
+#!/usr/bin/env python3
+"""Generate the IO-PLUS register bindings from regmap/ioplus.map.
+
+    python3 regmap/regmap.py [--check]
+
+Writes src/ioplusmem.h, the ioplus::reg block of src/ioplus.hpp,
+python/libioplus/regmap.py and node-red-contrib-sm-ioplus/regmap.js.
+With --check nothing is written, the exit code is 1 when a file is stale.
+"""
+import os
+import struct
+import sys
+
+ROOT = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+MAP = os.path.join(ROOT, 'regmap', 'ioplus.map')
+
+# size, C type, struct code, JS Buffer reader
+TYPES = {
+    'u8': (1, 'uint8_t', 'B', 'readUInt8'),
+    's8': (1, 'int8_t', 'b', 'readInt8'),
+    'u16': (2, 'uint16_t', 'H', 'readUInt16LE'),
+    's16': (2, 'int16_t', 'h', 'readInt16LE'),
+    'u32': (4, 'uint32_t', 'I', 'readUInt32LE'),
+    's32': (4, 'int32_t', 'i', 'readInt32LE'),
+    'u64': (8, 'uint64_t', 'Q', 'readBigUInt64LE'),
+}
+ACCESS = {'r': 'Access::Read', 'w': 'Access::Write', 'rw': 'Access::ReadWrite'}
+BUFF_SIZE = 256
+
+HPP_BEGIN = '// generated from regmap/ioplus.map, begin'
+HPP_END = '// generated from regmap/ioplus.map, end'
+NOTE = 'Generated by regmap/regmap.py from regmap/ioplus.map, do not edit'
+
+
+class MapError(Exception):
+    pass
+
+
+class Reg(object):
+    def __init__(self, enum, add, rid, typ, count, countName, access, scale,
+                 comment):
+        self.enum = enum
+        self.add = add
+        self.id = rid
+        self.type = typ
+        self.count = count
+        self.countName = countName
+        self.access = access
+        self.scale = scale
+        self.comment = comment
+        self.width = TYPES[typ][0]
+        self.size = self.width * count
+
+    def camel(self):
+        return ''.join(w[:1].upper() + w[1:] for w in self.id.split('_'))
+
+    def div(self):
+        # integer divisor of the raw value, 1 when there is no scale
+        return 1 if self.scale is None else int(round(1 / self.scale))
+
+
+def parseMap(path):
+    consts = []
+    enums = []  # (name, add, kind, reg) in map order
+    regs = {}
+    layouts = []
+    values = {}
+    for nr, line in enumerate(open(path), 1):
+        comment = ''
+        if '#' in line:
+            line, comment = line.split('#', 1)
+            comment = comment.strip()
+        f = line.split()
+        if not f:
+            continue
+        where = '%s:%d: ' % (os.path.basename(path), nr)
+        try:
+            if f[0] == 'const' and len(f) == 3:
+                values[f[1]] = int(f[2], 0)
+                consts.append((f[1], values[f[1]]))
+            elif f[0] in ('mark', 'end') and len(f) == 3:
+                enums.append((f[1], int(f[2], 0), f[0], None))
+            elif f[0] == 'reg' and len(f) in (7, 8):
+                if f[4] not in TYPES or f[6] not in ACCESS:
+                    raise MapError('bad type or access')
+                if f[3] in regs:
+                    raise MapError('id %s defined twice' % f[3])
+                countName = None if f[5].isdigit() else f[5]
+                count = values[countName] if countName else int(f[5])
+                scale = float(f[7]) if len(f) == 8 else None
+                r = Reg(f[1], int(f[2], 0), f[3], f[4], count, countName, f[6],
+                        scale, comment)
+                if r.add + r.size > BUFF_SIZE or count < 1:
+                    raise MapError('register outside the card map')
+                regs[r.id] = r
+                enums.append((r.enum, r.add, 'reg', r))
+            elif f[0] == 'layout' and len(f) > 2:
+                for rid in f[2:]:
+                    if rid not in regs:
+                        raise MapError('unknown register %s' % rid)
+                    if 'r' not in regs[rid].access:
+                        raise MapError('write only register %s' % rid)
+                layouts.append((f[1], [regs[rid] for rid in f[2:]], comment))
+            else:
+                raise MapError('unknown line')
+        except (MapError, KeyError, ValueError) as e:
+            raise MapError(where + str(e))
+    return consts, enums, regs, layouts
+
+
+def layoutSpec(fields):
+    """Address, size and little endian struct format of one block read,
+    the bytes between the fields are skipped with 'x'"""
+    add = fields[0].add
+    pos = add
+    fmt = '<'
+    for r in fields:
+        if r.add < pos:
+            raise MapError('layout fields overlap or are out of order at %s' % r.id)
+        if r.add > pos:
+            fmt += '%dx' % (r.add - pos)
+        code = TYPES[r.type][2]
+        fmt += code if r.count == 1 else '%d%s' % (r.count, code)
+        pos = r.add + r.size
+    return add, pos - add, fmt
+
+
+def traceName(enum):
+    for prefix in ('I2C_MEM_', 'I2C_'):
+        if enum.startswith(prefix):
+            enum = enum[len(prefix):]
+            break
+    return enum[:-4] if enum.endswith('_ADD') else enum
+
+
+# ------------------------------------------------------------------ C
+def genC(consts, enums, regs, layouts):
+    o = []
+    o.append('/*')
+    o.append(' * ioplusmem.h:')
+    o.append(' *\tRegister map of the IO-PLUS card firmware, shared by the command line')
+    o.append(' *\ttool, the C library and the C++ layer (ioplus.hpp).')
+    o.append(' *\t%s,' % NOTE)
+    o.append(' *\tchange the map and run "make regmap".')
+    o.append(' *')
+    o.append(' *\tCopyright (c) 2016-2023 Sequent Microsystem')
+    o.append(' *\t<http://www.sequentmicrosystem.com>')
+    o.append(' ***********************************************************************')
+    o.append(' */')
+    o.append('#ifndef IOPLUSMEM_H_')
+    o.append('#define IOPLUSMEM_H_')
+    o.append('')
+    o.append('#include <stdint.h>')
+    o.append('#include <string.h>')
+    o.append('')
+    for name, val in consts:
+        o.append('#define %s\t%d' % (name, val))
+    o.append('')
+    o.append('typedef enum')
+    o.append('{')
+    for name, add, kind, r in enums:
+        line = '\t%s = %d,' % (name, add)
+        if r is not None and r.comment:
+            line += ' // %s' % r.comment
+        o.append(line)
+    o.append('} I2C_MEM_ADD;')
+    o.append('')
+    o.append('/* X(name, address) for each named address, sorted, for the I2C trace */')
+    o.append('#define IOPLUS_MEM_NAMES(X) \\')
+    names = []
+    covered = 0
+    for name, add, kind, r in sorted(enums, key=lambda e: e[1]):
+        # a register over the bytes of another one is a command alias
+        if kind == 'end' or (names and names[-1][1] == add) \
+                or (kind == 'reg' and add < covered):
+            continue
+        names.append((name, add))
+        if r is not None:
+            covered = max(covered, add + r.size)
+    for i, (name, add) in enumerate(names):
+        o.append('\tX("%s", %s)%s' % (traceName(name), name,
+                                      ' \\' if i + 1 < len(names) else ''))
+    o.append('')
+    o.append('/* Typed values out of an image of the map read from imgAdd, channels')
+    o.append(' * are 1 based: IOPLUS_MEM_ADC_MV(buff, I2C_MEM_RELAY_VAL_ADD, 2) */')
+    for t in ('u8', 's8', 'u16', 's16', 'u32', 's32', 'u64'):
+        size, ctype = TYPES[t][0], TYPES[t][1]
+        fn = 'ioplusMem' + t.upper()
+        if size == 1:
+            o.append('static inline %s %s(const uint8_t *p)' % (ctype, fn))
+            o.append('{')
+            o.append('\treturn (%s)p[0];' % ctype)
+            o.append('}')
+        else:
+            o.append('static inline %s %s(const uint8_t *p)' % (ctype, fn))
+            o.append('{')
+            o.append('\t%s v;' % ctype)
+            o.append('')
+            o.append('\tmemcpy(&v, p, sizeof(v));')
+            o.append('\treturn v;')
+            o.append('}')
+        o.append('')
+    for name, add, kind, r in enums:
+        if r is None or 'r' not in r.access:
+            continue
+        m = 'IOPLUS_MEM_' + r.id.upper()
+        fn = 'ioplusMem' + r.type.upper()
+        if r.count == 1:
+            o.append('#define %s(img, imgAdd) \\' % m)
+            o.append('\t%s( (img) + %s - (imgAdd))' % (fn, r.enum))
+        else:
+            o.append('#define %s_CH_NO\t%s' % (m, r.countName or r.count))
+            o.append('#define %s(img, imgAdd, ch) \\' % m)
+            o.append('\t%s( (img) + %s - (imgAdd) + %d * ( (ch) - 1))'
+                     % (fn, r.enum, r.width))
+    o.append('')
+    o.append('/* Block reads decoded with the macros above */')
+    for name, fields, comment in layouts:
+        add, size, fmt = layoutSpec(fields)
+        if comment:
+            o.append('// %s' % comment)
+        o.append('#define IOPLUS_MEM_LAYOUT_%s_ADD\t%d' % (name, add))
+        o.append('#define IOPLUS_MEM_LAYOUT_%s_SIZE\t%d' % (name, size))
+    o.append('')
+    o.append('#endif //IOPLUSMEM_H_')
+    return '\n'.join(o) + '\n'
+
+
+# ------------------------------------------------------------------ C++
+def genHpp(enums, old):
+    o = []
+    for name, add, kind, r in enums:
+        if r is None:
+            continue
+        args = [r.enum, TYPES[r.type][1]]
+        if r.count != 1 or r.access != 'r':
+            args.append(r.countName or str(r.count))
+        if r.access != 'r':
+            args.append(ACCESS[r.access])
+        line = 'using %s = Reg<%s>;' % (r.camel(), ', '.join(args))
+        if r.comment:
+            line += ' // %s' % r.comment
+        o.append(line)
+    try:
+        head, rest = old.split(HPP_BEGIN + '\n', 1)
+        _, tail = rest.split(HPP_END, 1)
+    except ValueError:
+        raise MapError('src/ioplus.hpp: generated block markers missing')
+    return head + HPP_BEGIN + '\n' + '\n'.join(o) + '\n' + HPP_END + tail
+
+
+# ------------------------------------------------------------------ Python
+def genPy(consts, enums, regs, layouts):
+    o = []
+    o.append('# %s,' % NOTE)
+    o.append('# change the map and run "make regmap".')
+    o.append('import struct')
+    o.append('from collections import namedtuple')
+    o.append('')
+    for name, val in consts:
+        o.append('%s = %d' % (name, val))
+    o.append('')
+    for name, add, kind, r in enums:
+        o.append('%s = %d' % (name, add))
+    o.append('')
+    o.append("# struct code, count, divisor of the raw value, access")
+    o.append("Reg = namedtuple('Reg', 'add code count div access')")
+    o.append('REGS = {')
+    for name, add, kind, r in enums:
+        if r is not None:
+            o.append("    '%s': Reg(%d, '%s', %d, %d, '%s'),"
+                     % (r.id, r.add, TYPES[r.type][2], r.count, r.div(), r.access))
+    o.append('}')
+    o.append('')
+    o.append('# one block read decoded by one struct.unpack, gaps skipped with x')
+    o.append("Layout = namedtuple('Layout', 'add size fmt fields')")
+    for name, fields, comment in layouts:
+        add, size, fmt = layoutSpec(fields)
+        if comment:
+            o.append('# %s' % comment)
+        o.append("%s = Layout(%d, %d, '%s', (" % (name, add, size, fmt))
+        line = '   '
+        for r in fields:
+            item = " '%s'," % r.id
+            if len(line) + len(item) > 79:
+                o.append(line)
+                line = '   '
+            line += item
+        o.append(line[:-1] + '))')
+    o.append('')
+    o.append('')
+    o.append('def decode(layout, buff, scale=True):')
+    o.append('    """Values of the layout registers by id from the bytes of its block')
+    o.append('    read, scaled to V and degC unless scale is False"""')
+    o.append('    vals = struct.unpack_from(layout.fmt, buff)')
+    o.append('    out = {}')
+    o.append('    i = 0')
+    o.append('    for rid in layout.fields:')
+    o.append('        reg = REGS[rid]')
+    o.append('        v = vals[i:i + reg.count]')
+    o.append('        i += reg.count')
+    o.append('        if scale and reg.div != 1:')
+    o.append('            v = [x / float(reg.div) for x in v]')
+    o.append('        out[rid] = v[0] if reg.count == 1 else list(v)')
+    o.append('    return out')
+    return '\n'.join(o) + '\n'
+
+
+# ------------------------------------------------------------------ JavaScript
+def genJs(consts, enums, regs, layouts):
+    o = []
+    o.append('// %s,' % NOTE)
+    o.append('// change the map and run "make regmap".')
+    o.append('"use strict";')
+    o.append('')
+    for name, val in consts:
+        o.append('module.exports.%s = %d;' % (name, val))
+    o.append('')
+    for name, add, kind, r in enums:
+        o.append('module.exports.%s = %d;' % (name, add))
+    o.append('')
+    o.append('// Buffer reader, value width, divisor of the raw value, access')
+    o.append('var REGS = {')
+    for name, add, kind, r in enums:
+        if r is not None:
+            o.append('    %s: { add: %d, read: "%s", width: %d, count: %d, div: %d, '
+                     'access: "%s" },' % (r.id, r.add, TYPES[r.type][3], r.width,
+                                           r.count, r.div(), r.access))
+    o.append('};')
+    o.append('')
+    o.append('// one block read, the fields at their offset in the read buffer')
+    o.append('var LAYOUTS = {')
+    for name, fields, comment in layouts:
+        add, size, fmt = layoutSpec(fields)
+        if comment:
+            o.append('    // %s' % comment)
+        o.append('    %s: { add: %d, size: %d, fields: [' % (name, add, size))
+        for r in fields:
+            o.append('        { id: "%s", offset: %d },' % (r.id, r.add - add))
+        o.append('    ] },')
+    o.append('};')
+    o.append('')
+    o.append('// values of the layout registers by id, in the register unit unless')
+    o.append('// scale is false')
+    o.append('function decode(layout, buf, scale) {')
+    o.append('    var out = {};')
+    o.append('    layout.fields.forEach(function(f) {')
+    o.append('        var reg = REGS[f.id];')
+    o.append('        var vals = [];')
+    o.append('        for (var i = 0; i < reg.count; i++) {')
+    o.append('            var v = buf[reg.read](f.offset + i * reg.width);')
+    o.append('            if (scale !== false && reg.div !== 1) {')
+    o.append('                v = v / reg.div;')
+    o.append('            }')
+    o.append('            vals.push(v);')
+    o.append('        }')
+    o.append('        out[f.id] = reg.count === 1 ? vals[0] : vals;')
+    o.append('    });')
+    o.append('    return out;')
+    o.append('}')
+    o.append('')
+    o.append('module.exports.REGS = REGS;')
+    o.append('module.exports.LAYOUTS = LAYOUTS;')
+    o.append('module.exports.decode = decode;')
+    return '\n'.join(o) + '\n'
+
+
+def main(argv):
+    check = '--check' in argv
+    try:
+        consts, enums, regs, layouts = parseMap(MAP)
+        for name, fields, comment in layouts:
+            add, size, fmt = layoutSpec(fields)
+            if struct.calcsize(fmt) != size:
+                raise MapError('layout %s: format does not match its span' % name)
+        hppPath = os.path.join(ROOT, 'src', 'ioplus.hpp')
+        out = {
+            os.path.join(ROOT, 'src', 'ioplusmem.h'): genC(consts, enums, regs, layouts),
+            hppPath: genHpp(enums, open(hppPath).read()),
+            os.path.join(ROOT, 'python', 'libioplus', 'regmap.py'):
+                genPy(consts, enums, regs, layouts),
+            os.path.join(ROOT, 'node-red-contrib-sm-ioplus', 'regmap.js'):
+                genJs(consts, enums, regs, layouts),
+        }
+    except (MapError, IOError) as e:
+        sys.stderr.write('regmap: %s\n' % e)
+        return 2
+    stale = 0
+    for path, text in sorted(out.items()):
+        old = open(path).read() if os.path.exists(path) else None
+        if old == text:
+            continue
+        stale = 1
+        print('%s %s' % ('stale' if check else 'write', os.path.relpath(path, ROOT)))
+        if not check:
+            with open(path, 'w') as f:
+                f.write(text)
+    return stale if check else 0
+
+
+if __name__ == '__main__':
+    sys.exit(main(sys.argv[1:]))
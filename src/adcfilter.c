@@ -0,0 +1,396 @@
+/*
+ * adcfilter.c:
+ *	Host side filtering of the ADC channels: moving average, median, first
+ *	order IIR, decimation and deadband stages chained in a fixed pipeline.
+ *	All channels are processed together, the loops over IOPLUS_ADC_CH_NO
+ *	contiguous floats are left for the compiler to vectorize.
+ *
+ *	Copyright (c) 2016-2023 Sequent Microsystem
+ *	<http://www.sequentmicrosystem.com>
+ ***********************************************************************
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+
+#include "libioplus.h"
+
+#define CH_NO	IOPLUS_ADC_CH_NO
+
+typedef struct
+{
+	const char *name;
+	int kind;
+} FilterNameType;
+
+static const FilterNameType gFilterNames[] = {
+	{"avg", IOPLUS_FILTER_AVG},
+	{"median", IOPLUS_FILTER_MEDIAN},
+	{"iir", IOPLUS_FILTER_IIR},
+	{"decim", IOPLUS_FILTER_DECIM},
+	{"deadband", IOPLUS_FILTER_DEADBAND},
+	{NULL, 0}};
+
+int ioplusFilterInit(IoplusFilterType *f)
+{
+	if (NULL == f)
+	{
+		return IOPLUS_ERR_ARG;
+	}
+	memset(f, 0, sizeof(IoplusFilterType));
+	return IOPLUS_OK;
+}
+
+int ioplusFilterAdd(IoplusFilterType *f, int kind, float param)
+{
+	IoplusFilterStageType *st;
+
+	if ( (NULL == f) || (f->stages >= IOPLUS_FILTER_STAGES_MAX))
+	{
+		return IOPLUS_ERR_ARG;
+	}
+	st = &f->stage[f->stages];
+	memset(st, 0, sizeof(IoplusFilterStageType));
+	switch (kind)
+	{
+	case IOPLUS_FILTER_AVG:
+	case IOPLUS_FILTER_MEDIAN:
+		if ( (param < 1) || (param > IOPLUS_FILTER_WIN_MAX))
+		{
+			return IOPLUS_ERR_ARG;
+		}
+		st->n = (int)param;
+		break;
+	case IOPLUS_FILTER_DECIM:
+		if (param < 1)
+		{
+			return IOPLUS_ERR_ARG;
+		}
+		st->n = (int)param;
+		break;
+	case IOPLUS_FILTER_IIR:
+		if ( (param <= 0) || (param > 1))
+		{
+			return IOPLUS_ERR_ARG;
+		}
+		st->k = param;
+		break;
+	case IOPLUS_FILTER_DEADBAND:
+		if (param < 0)
+		{
+			return IOPLUS_ERR_ARG;
+		}
+		st->k = param;
+		break;
+	default:
+		return IOPLUS_ERR_ARG;
+	}
+	st->kind = kind;
+	f->stages++;
+	return IOPLUS_OK;
+}
+
+int ioplusFilterParse(IoplusFilterType *f, const char *spec)
+{
+	char buff[128];
+	char *tok;
+	char *save = NULL;
+	char *arg;
+	char *end;
+	float param;
+	int i;
+	int ret;
+
+	if ( (NULL == spec) || (strlen(spec) >= sizeof(buff)))
+	{
+		return IOPLUS_ERR_ARG;
+	}
+	ret = ioplusFilterInit(f);
+	if (ret != IOPLUS_OK)
+	{
+		return ret;
+	}
+	strcpy(buff, spec);
+	for (tok = strtok_r(buff, ",", &save); tok != NULL;
+		tok = strtok_r(NULL, ",", &save))
+	{
+		arg = strchr(tok, ':');
+		if (NULL == arg)
+		{
+			return IOPLUS_ERR_ARG;
+		}
+		*arg++ = 0;
+		param = strtof(arg, &end);
+		if ( (end == arg) || (*end != 0))
+		{
+			return IOPLUS_ERR_ARG;
+		}
+		for (i = 0; gFilterNames[i].name != NULL; i++)
+		{
+			if (0 == strcmp(tok, gFilterNames[i].name))
+			{
+				break;
+			}
+		}
+		ret = ioplusFilterAdd(f, gFilterNames[i].kind, param);
+		if (ret != IOPLUS_OK)
+		{
+			return ret;
+		}
+	}
+	return (f->stages > 0) ? IOPLUS_OK : IOPLUS_ERR_ARG;
+}
+
+void ioplusFilterReset(IoplusFilterType *f)
+{
+	int i;
+
+	if (NULL == f)
+	{
+		return;
+	}
+	for (i = 0; i < f->stages; i++)
+	{
+		f->stage[i].pos = 0;
+		f->stage[i].fill = 0;
+	}
+	memset(f->out, 0, sizeof(f->out));
+}
+
+int ioplusFilterSettle(IoplusFilterType *f)
+{
+	int need = 1;
+	int i;
+
+	if ( (NULL == f) || (f->stages == 0))
+	{
+		return 1;
+	}
+	// walk back from the output, decimation multiplies what the stages after it need
+	for (i = f->stages - 1; i >= 0; i--)
+	{
+		switch (f->stage[i].kind)
+		{
+		case IOPLUS_FILTER_AVG:
+		case IOPLUS_FILTER_MEDIAN:
+			need += f->stage[i].n - 1;
+			break;
+		case IOPLUS_FILTER_DECIM:
+			need *= f->stage[i].n;
+			break;
+		case IOPLUS_FILTER_IIR:
+			need += (int)ceilf(3 / f->stage[i].k); // 95% of a step
+			break;
+		default:
+			break;
+		}
+	}
+	return need;
+}
+
+static void runAvg(IoplusFilterStageType *st, float *v)
+{
+	float sum[CH_NO];
+	float scale;
+	int i;
+	int ch;
+
+	for (ch = 0; ch < CH_NO; ch++)
+	{
+		st->hist[st->pos][ch] = v[ch];
+	}
+	if (st->fill < st->n)
+	{
+		st->fill++;
+	}
+	st->pos = (st->pos + 1) % st->n;
+	// running sum, rebuilt from the window once per turn to drop the rounding drift
+	if ( (st->pos == 0) || (st->fill < st->n))
+	{
+		memset(sum, 0, sizeof(sum));
+		for (i = 0; i < st->fill; i++)
+		{
+			for (ch = 0; ch < CH_NO; ch++)
+			{
+				sum[ch] += st->hist[i][ch];
+			}
+		}
+		memcpy(st->state, sum, sizeof(sum));
+	}
+	else
+	{
+		// the oldest sample was taken out at the end of the previous call
+		for (ch = 0; ch < CH_NO; ch++)
+		{
+			st->state[ch] += v[ch];
+		}
+	}
+	scale = 1.0f / st->fill;
+	for (ch = 0; ch < CH_NO; ch++)
+	{
+		v[ch] = st->state[ch] * scale;
+	}
+	// slot pos holds the sample leaving the window on the next call
+	if (st->fill == st->n)
+	{
+		for (ch = 0; ch < CH_NO; ch++)
+		{
+			st->state[ch] -= st->hist[st->pos][ch];
+		}
+	}
+}
+
+/* odd-even transposition sort of a copy of the window, every compare and
+ * swap is a min / max over the channels */
+static void runMedian(IoplusFilterStageType *st, float *v)
+{
+	float w[IOPLUS_FILTER_WIN_MAX][CH_NO];
+	float lo;
+	float hi;
+	int pass;
+	int i;
+	int ch;
+
+	for (ch = 0; ch < CH_NO; ch++)
+	{
+		st->hist[st->pos][ch] = v[ch];
+	}
+	if (st->fill < st->n)
+	{
+		st->fill++;
+	}
+	st->pos = (st->pos + 1) % st->n;
+	memcpy(w, st->hist, st->fill * sizeof(w[0]));
+	for (pass = 0; pass < st->fill; pass++)
+	{
+		for (i = pass & 1; i + 1 < st->fill; i += 2)
+		{
+			for (ch = 0; ch < CH_NO; ch++)
+			{
+				lo = (w[i][ch] < w[i + 1][ch]) ? w[i][ch] : w[i + 1][ch];
+				hi = (w[i][ch] < w[i + 1][ch]) ? w[i + 1][ch] : w[i][ch];
+				w[i][ch] = lo;
+				w[i + 1][ch] = hi;
+			}
+		}
+	}
+	memcpy(v, w[st->fill / 2], sizeof(w[0]));
+}
+
+static void runIir(IoplusFilterStageType *st, float *v)
+{
+	int ch;
+
+	if (st->fill == 0)
+	{
+		memcpy(st->state, v, sizeof(st->state));
+		st->fill = 1;
+	}
+	for (ch = 0; ch < CH_NO; ch++)
+	{
+		st->state[ch] += st->k * (v[ch] - st->state[ch]);
+		v[ch] = st->state[ch];
+	}
+}
+
+static int runDecim(IoplusFilterStageType *st)
+{
+	int pass = (st->pos == 0);
+
+	st->pos = (st->pos + 1) % st->n;
+	return pass;
+}
+
+static void runDeadband(IoplusFilterStageType *st, float *v)
+{
+	int ch;
+
+	if (st->fill == 0)
+	{
+		memcpy(st->state, v, sizeof(st->state));
+		st->fill = 1;
+	}
+	for (ch = 0; ch < CH_NO; ch++)
+	{
+		st->state[ch] = (fabsf(v[ch] - st->state[ch]) >= st->k) ? v[ch] : st->state[ch];
+		v[ch] = st->state[ch];
+	}
+}
+
+int ioplusFilterRun(IoplusFilterType *f, const float *in, float *out)
+{
+	float v[CH_NO];
+	IoplusFilterStageType *st;
+	int i;
+
+	if ( (NULL == f) || (NULL == in))
+	{
+		return IOPLUS_ERR_ARG;
+	}
+	memcpy(v, in, sizeof(v));
+	for (i = 0; i < f->stages; i++)
+	{
+		st = &f->stage[i];
+		switch (st->kind)
+		{
+		case IOPLUS_FILTER_AVG:
+			runAvg(st, v);
+			break;
+		case IOPLUS_FILTER_MEDIAN:
+			runMedian(st, v);
+			break;
+		case IOPLUS_FILTER_IIR:
+			runIir(st, v);
+			break;
+		case IOPLUS_FILTER_DECIM:
+			if (!runDecim(st))
+			{
+				return 0;
+			}
+			break;
+		case IOPLUS_FILTER_DEADBAND:
+			runDeadband(st, v);
+			break;
+		default:
+			break;
+		}
+	}
+	memcpy(f->out, v, sizeof(v));
+	if (NULL != out)
+	{
+		memcpy(out, v, sizeof(v));
+	}
+	return 1;
+}
+
+int ioplusAdcFilterRead(IoplusBoardType *board, IoplusFilterType *f, float *mV,
+	int *fresh)
+{
+	uint16_t raw[CH_NO];
+	float in[CH_NO];
+	int ret;
+	int ch;
+
+	if ( (NULL == f) || (NULL == mV))
+	{
+		return IOPLUS_ERR_ARG;
+	}
+	ret = ioplusAdcGetAll(board, raw);
+	if (ret != IOPLUS_OK)
+	{
+		return ret;
+	}
+	for (ch = 0; ch < CH_NO; ch++)
+	{
+		in[ch] = raw[ch];
+	}
+	ret = ioplusFilterRun(f, in, NULL);
+	if (NULL != fresh)
+	{
+		*fresh = ret;
+	}
+	memcpy(mV, f->out, sizeof(f->out));
+	return IOPLUS_OK;
+}
@@ -0,0 +1,210 @@
+/*
+ * adcstats.c:
+ *	Rolling statistics of the ADC channels over the last second, minute and
+ *	hour. Every window is a fixed ring of time buckets holding min, max, sum
+ *	and sum of squares per channel, so memory and cost do not depend on the
+ *	poll rate.
+ *
+ *	Copyright (c) 2016-2023 Sequent Microsystem
+ *	<http://www.sequentmicrosystem.com>
+ ***********************************************************************
+ */
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+
+#include "libioplus.h"
+
+#define CH_NO	IOPLUS_ADC_CH_NO
+
+typedef struct
+{
+	uint32_t bucketMs;
+	int buckets;
+} StatsWinCfgType;
+
+static const StatsWinCfgType gWinCfg[IOPLUS_STATS_WIN_NO] = {
+	{100, 10}, // 1 s
+	{1000, 60}, // 1 min
+	{60000, 60}, // 1 h
+};
+
+static uint64_t statsNowMs(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+int ioplusAdcStatsInit(IoplusAdcStatsType *st)
+{
+	int w;
+	int b;
+
+	if (NULL == st)
+	{
+		return IOPLUS_ERR_ARG;
+	}
+	memset(st, 0, sizeof(IoplusAdcStatsType));
+	for (w = 0; w < IOPLUS_STATS_WIN_NO; w++)
+	{
+		st->ring[w].bucketMs = gWinCfg[w].bucketMs;
+		st->ring[w].buckets = gWinCfg[w].buckets;
+		for (b = 0; b < IOPLUS_STATS_BUCKETS_MAX; b++)
+		{
+			st->ring[w].slot[b] = -1;
+		}
+	}
+	return IOPLUS_OK;
+}
+
+static void ringAdd(IoplusStatsRingType *r, uint64_t ms, const float *val,
+	const float *lo, const float *hi)
+{
+	int64_t slot = (int64_t) (ms / r->bucketMs);
+	int b = (int) (slot % r->buckets);
+	int ch;
+
+	if (r->slot[b] != slot)
+	{
+		// bucket reused after a full turn of the ring
+		r->slot[b] = slot;
+		r->count[b] = 0;
+		for (ch = 0; ch < CH_NO; ch++)
+		{
+			r->min[b][ch] = lo[ch];
+			r->max[b][ch] = hi[ch];
+			r->sum[b][ch] = 0;
+			r->sumSq[b][ch] = 0;
+		}
+	}
+	r->count[b]++;
+	for (ch = 0; ch < CH_NO; ch++)
+	{
+		r->min[b][ch] = (lo[ch] < r->min[b][ch]) ? lo[ch] : r->min[b][ch];
+		r->max[b][ch] = (hi[ch] > r->max[b][ch]) ? hi[ch] : r->max[b][ch];
+		r->sum[b][ch] += val[ch];
+		r->sumSq[b][ch] += (double)val[ch] * val[ch];
+	}
+}
+
+int ioplusAdcStatsAdd(IoplusAdcStatsType *st, uint64_t ms, const uint16_t *mV,
+	const uint16_t *minMv, const uint16_t *maxMv)
+{
+	float val[CH_NO];
+	float lo[CH_NO];
+	float hi[CH_NO];
+	int w;
+	int ch;
+
+	if ( (NULL == st) || (NULL == mV))
+	{
+		return IOPLUS_ERR_ARG;
+	}
+	for (ch = 0; ch < CH_NO; ch++)
+	{
+		val[ch] = lo[ch] = hi[ch] = mV[ch];
+	}
+	// firmware extremes over its last samples widen the polled range
+	for (ch = 0; (NULL != minMv) && (NULL != maxMv)
+		&& (ch < IOPLUS_ADC_MINMAX_CH_NO); ch++)
+	{
+		lo[ch] = (minMv[ch] < lo[ch]) ? minMv[ch] : lo[ch];
+		hi[ch] = (maxMv[ch] > hi[ch]) ? maxMv[ch] : hi[ch];
+	}
+	for (w = 0; w < IOPLUS_STATS_WIN_NO; w++)
+	{
+		ringAdd(&st->ring[w], ms, val, lo, hi);
+	}
+	st->lastMs = ms;
+	return IOPLUS_OK;
+}
+
+int ioplusAdcStatsSample(IoplusBoardType *board, IoplusAdcStatsType *st)
+{
+	uint16_t mV[CH_NO];
+	uint16_t minMv[IOPLUS_ADC_MINMAX_CH_NO];
+	uint16_t maxMv[IOPLUS_ADC_MINMAX_CH_NO];
+	int ret;
+
+	if (NULL == st)
+	{
+		return IOPLUS_ERR_ARG;
+	}
+	ret = ioplusAdcGetAll(board, mV);
+	if (ret != IOPLUS_OK)
+	{
+		return ret;
+	}
+	ret = ioplusAdcMinMaxGetAll(board, minMv, maxMv);
+	if (ret == IOPLUS_ERR_NOT_SUPPORTED)
+	{
+		return ioplusAdcStatsAdd(st, statsNowMs(), mV, NULL, NULL);
+	}
+	if (ret != IOPLUS_OK)
+	{
+		return ret;
+	}
+	return ioplusAdcStatsAdd(st, statsNowMs(), mV, minMv, maxMv);
+}
+
+int ioplusAdcStatsGet(IoplusAdcStatsType *st, int win, IoplusAdcWindowType *out)
+{
+	IoplusStatsRingType *r;
+	double sum[CH_NO];
+	double sumSq[CH_NO];
+	double mean;
+	double var;
+	int64_t last;
+	int b;
+	int ch;
+
+	if ( (NULL == st) || (NULL == out) || (win < 0)
+		|| (win >= IOPLUS_STATS_WIN_NO))
+	{
+		return IOPLUS_ERR_ARG;
+	}
+	r = &st->ring[win];
+	last = (int64_t) (st->lastMs / r->bucketMs);
+	memset(out, 0, sizeof(IoplusAdcWindowType));
+	memset(sum, 0, sizeof(sum));
+	memset(sumSq, 0, sizeof(sumSq));
+	for (ch = 0; ch < CH_NO; ch++)
+	{
+		out->min[ch] = INFINITY;
+		out->max[ch] = -INFINITY;
+	}
+	for (b = 0; b < r->buckets; b++)
+	{
+		// skip the empty buckets and the ones older than the window
+		if ( (r->slot[b] < 0) || (r->slot[b] <= last - r->buckets)
+			|| (r->slot[b] > last))
+		{
+			continue;
+		}
+		out->samples += r->count[b];
+		for (ch = 0; ch < CH_NO; ch++)
+		{
+			out->min[ch] = (r->min[b][ch] < out->min[ch]) ? r->min[b][ch] : out->min[ch];
+			out->max[ch] = (r->max[b][ch] > out->max[ch]) ? r->max[b][ch] : out->max[ch];
+			sum[ch] += r->sum[b][ch];
+			sumSq[ch] += r->sumSq[b][ch];
+		}
+	}
+	if (out->samples == 0)
+	{
+		memset(out, 0, sizeof(IoplusAdcWindowType));
+		return IOPLUS_OK;
+	}
+	for (ch = 0; ch < CH_NO; ch++)
+	{
+		mean = sum[ch] / out->samples;
+		var = sumSq[ch] / out->samples - mean * mean;
+		out->mean[ch] = (float)mean;
+		out->stddev[ch] = (var > 0) ? (float)sqrt(var) : 0;
+	}
+	return IOPLUS_OK;
+}
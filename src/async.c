@@ -0,0 +1,396 @@
+/*
+ * async.c:
+ *	Asynchronous register access. Producers push caller owned requests on
+ *	an intrusive lock free MPSC queue (Vyukov), a single I/O thread takes
+ *	them in batches, runs them in order under the bus semaphore and merges
+ *	consecutive reads of neighbouring registers into one transfer. The
+ *	callbacks run once the semaphore is released.
+ *
+ *	Copyright (c) 2016-2023 Sequent Microsystem
+ *	<http://www.sequentmicrosystem.com>
+ ***********************************************************************
+ */
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <sched.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/eventfd.h>
+
+#include "comm.h"
+#include "libioplus.h"
+#include "i2cerr.h"
+
+#define ASYNC_SPIN	64 // empty polls before the I/O thread sleeps
+
+static uint64_t asyncNowUs(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+static void asyncPush(IoplusAsyncType *q, IoplusAsyncReqType *req)
+{
+	IoplusAsyncReqType *prev;
+
+	__atomic_store_n(&req->next, NULL, __ATOMIC_RELAXED);
+	prev = __atomic_exchange_n(&q->head, req, __ATOMIC_SEQ_CST);
+	// the queue is cut here until the link is stored, asyncPop() sees it busy
+	__atomic_store_n(&prev->next, req, __ATOMIC_RELEASE);
+}
+
+// I/O thread only, NULL when empty or when a push is half done
+static IoplusAsyncReqType* asyncPop(IoplusAsyncType *q)
+{
+	IoplusAsyncReqType *tail = q->tail;
+	IoplusAsyncReqType *next = __atomic_load_n(&tail->next, __ATOMIC_ACQUIRE);
+
+	if (tail == &q->stub)
+	{
+		if (NULL == next)
+		{
+			return NULL;
+		}
+		q->tail = next;
+		tail = next;
+		next = __atomic_load_n(&next->next, __ATOMIC_ACQUIRE);
+	}
+	if (next)
+	{
+		q->tail = next;
+		return tail;
+	}
+	if (tail != __atomic_load_n(&q->head, __ATOMIC_ACQUIRE))
+	{
+		return NULL;
+	}
+	// last request, park the stub behind it so it can be unlinked
+	asyncPush(q, &q->stub);
+	next = __atomic_load_n(&tail->next, __ATOMIC_ACQUIRE);
+	if (next)
+	{
+		q->tail = next;
+		return tail;
+	}
+	return NULL;
+}
+
+static int asyncEmpty(IoplusAsyncType *q)
+{
+	return (q->tail == &q->stub)
+		&& (NULL == __atomic_load_n(&q->stub.next, __ATOMIC_SEQ_CST))
+		&& (&q->stub == __atomic_load_n(&q->head, __ATOMIC_SEQ_CST));
+}
+
+// req->result is set, the bus semaphore released
+static void asyncComplete(IoplusAsyncType *q, IoplusAsyncReqType *req)
+{
+	IoplusAsyncCbType cb = req->cb;
+	uint64_t one = 1;
+	uint32_t us;
+	int efd = req->efd;
+	int ret = req->result;
+
+	us = (uint32_t) (asyncNowUs() - req->submitUs);
+	// the I/O thread is the only writer, other threads read the stats
+	if (us > __atomic_load_n(&q->stats.latencyUsMax, __ATOMIC_RELAXED))
+	{
+		__atomic_store_n(&q->stats.latencyUsMax, us, __ATOMIC_RELAXED);
+	}
+	__atomic_fetch_add(&q->stats.latencyUsSum, us, __ATOMIC_RELAXED);
+	__atomic_fetch_add(&q->stats.completed, 1, __ATOMIC_RELAXED);
+	if (ret != IOPLUS_OK)
+	{
+		__atomic_fetch_add(&q->stats.errors, 1, __ATOMIC_RELAXED);
+	}
+	// req is not touched after this, the callback may submit it again
+	__atomic_store_n(&req->done, 1, __ATOMIC_SEQ_CST);
+	if (cb)
+	{
+		cb(req);
+	}
+	if (efd >= 0)
+	{
+		if (write(efd, &one, sizeof(one)) != sizeof(one))
+		{
+			// counter saturated, the reader is awake anyway
+		}
+	}
+}
+
+/* run b[0 .. n-1] in order and set their result, returns how many requests
+ * were taken from b */
+static int asyncRun(IoplusAsyncType *q, IoplusAsyncReqType **b, int n)
+{
+	uint8_t buf[IOPLUS_ASYNC_MERGE_MAX];
+	IoplusAsyncReqType *r = b[0];
+	int lo = r->add;
+	int hi = r->add + r->size;
+	int newLo;
+	int newHi;
+	int ret;
+	int i;
+	int j = 1;
+
+	if (r->op == IOPLUS_ASYNC_WRITE)
+	{
+		__atomic_fetch_add(&q->stats.transfers, 1, __ATOMIC_RELAXED);
+		r->result = i2cErrToIoplus(i2cMem8Write(r->board->dev, r->add, r->buf,
+			r->size));
+		return 1;
+	}
+	// grow the block while the next read touches it and the transfer fits
+	while ( (j < n) && (b[j]->op == IOPLUS_ASYNC_READ)
+		&& (b[j]->board == r->board) && (b[j]->add <= hi)
+		&& (b[j]->add + b[j]->size >= lo))
+	{
+		newLo = (b[j]->add < lo) ? b[j]->add : lo;
+		newHi = (b[j]->add + b[j]->size > hi) ? b[j]->add + b[j]->size : hi;
+		if (newHi - newLo > IOPLUS_ASYNC_MERGE_MAX)
+		{
+			break;
+		}
+		lo = newLo;
+		hi = newHi;
+		j++;
+	}
+	__atomic_fetch_add(&q->stats.transfers, 1, __ATOMIC_RELAXED);
+	__atomic_fetch_add(&q->stats.merged, j - 1, __ATOMIC_RELAXED);
+	ret = i2cErrToIoplus(i2cMem8Read(r->board->dev, lo, buf, hi - lo));
+	for (i = 0; i < j; i++)
+	{
+		if (ret == IOPLUS_OK)
+		{
+			memcpy(b[i]->buf, &buf[b[i]->add - lo], b[i]->size);
+		}
+		b[i]->result = ret;
+	}
+	return j;
+}
+
+static void* asyncThread(void *arg)
+{
+	IoplusAsyncType *q = (IoplusAsyncType*)arg;
+	IoplusAsyncReqType *b[IOPLUS_ASYNC_BATCH_MAX];
+	uint64_t val;
+	sem_t *sem;
+	int spin = 0;
+	int n;
+	int i;
+
+	while (1)
+	{
+		n = 0;
+		while ( (n < IOPLUS_ASYNC_BATCH_MAX) && (NULL != (b[n] = asyncPop(q))))
+		{
+			n++;
+		}
+		if (n > 0)
+		{
+			spin = 0;
+			__atomic_fetch_add(&q->stats.batches, 1, __ATOMIC_RELAXED);
+			sem = i2cBusLock();
+			for (i = 0; i < n;)
+			{
+				i += asyncRun(q, &b[i], n - i);
+			}
+			i2cBusUnlock(sem);
+			/* the callbacks are user code: a coroutine resumed there may take
+			 * the bus again, other processes must not wait on it meanwhile */
+			for (i = 0; i < n; i++)
+			{
+				asyncComplete(q, b[i]);
+			}
+			if (__atomic_load_n(&q->waiters, __ATOMIC_SEQ_CST))
+			{
+				pthread_mutex_lock(&q->lock);
+				pthread_cond_broadcast(&q->cond);
+				pthread_mutex_unlock(&q->lock);
+			}
+			continue;
+		}
+		if (!asyncEmpty(q) || (spin++ < ASYNC_SPIN))
+		{
+			// a push in progress, or more requests likely soon
+			sched_yield();
+			continue;
+		}
+		if (__atomic_load_n(&q->stop, __ATOMIC_ACQUIRE))
+		{
+			break;
+		}
+		__atomic_store_n(&q->idle, 1, __ATOMIC_SEQ_CST);
+		if (asyncEmpty(q) && !__atomic_load_n(&q->stop, __ATOMIC_SEQ_CST))
+		{
+			while ( (read(q->wakeFd, &val, sizeof(val)) < 0) && (errno == EINTR))
+				;
+		}
+		__atomic_store_n(&q->idle, 0, __ATOMIC_SEQ_CST);
+		spin = 0;
+	}
+	return NULL;
+}
+
+static void asyncWake(IoplusAsyncType *q)
+{
+	uint64_t one = 1;
+
+	if (__atomic_exchange_n(&q->idle, 0, __ATOMIC_SEQ_CST))
+	{
+		if (write(q->wakeFd, &one, sizeof(one)) != sizeof(one))
+		{
+			// counter saturated, the I/O thread is awake anyway
+		}
+	}
+}
+
+int ioplusAsyncStart(IoplusAsyncType *q)
+{
+	if (NULL == q)
+	{
+		return IOPLUS_ERR_ARG;
+	}
+	memset(q, 0, sizeof(IoplusAsyncType));
+	q->head = &q->stub;
+	q->tail = &q->stub;
+	q->wakeFd = eventfd(0, EFD_CLOEXEC);
+	if (q->wakeFd < 0)
+	{
+		return IOPLUS_ERR_IO;
+	}
+	pthread_mutex_init(&q->lock, NULL);
+	pthread_cond_init(&q->cond, NULL);
+	if (0 != pthread_create(&q->thread, NULL, asyncThread, q))
+	{
+		close(q->wakeFd);
+		pthread_cond_destroy(&q->cond);
+		pthread_mutex_destroy(&q->lock);
+		return IOPLUS_ERR_IO;
+	}
+	q->running = 1;
+	return IOPLUS_OK;
+}
+
+int ioplusAsyncStop(IoplusAsyncType *q)
+{
+	uint64_t one = 1;
+
+	if ( (NULL == q) || !q->running)
+	{
+		return IOPLUS_ERR_ARG;
+	}
+	__atomic_store_n(&q->stop, 1, __ATOMIC_SEQ_CST);
+	if (write(q->wakeFd, &one, sizeof(one)) != sizeof(one))
+	{
+		// counter saturated, the I/O thread is awake anyway
+	}
+	pthread_join(q->thread, NULL);
+	q->running = 0;
+	close(q->wakeFd);
+	pthread_cond_destroy(&q->cond);
+	pthread_mutex_destroy(&q->lock);
+	return IOPLUS_OK;
+}
+
+int ioplusAsyncReqInit(IoplusAsyncReqType *req, IoplusBoardType *board,
+	int op, int add, uint8_t *buf, int size)
+{
+	if (NULL == req)
+	{
+		return IOPLUS_ERR_ARG;
+	}
+	memset(req, 0, sizeof(IoplusAsyncReqType));
+	req->board = board;
+	req->op = op;
+	req->add = add;
+	req->buf = buf;
+	req->size = size;
+	req->efd = -1;
+	return IOPLUS_OK;
+}
+
+int ioplusAsyncSubmit(IoplusAsyncType *q, IoplusAsyncReqType *req)
+{
+	if ( (NULL == q) || (NULL == req) || (NULL == req->board)
+		|| (req->board->dev < 0) || (NULL == req->buf)
+		|| ( (req->op != IOPLUS_ASYNC_READ) && (req->op != IOPLUS_ASYNC_WRITE))
+		|| (req->size < 1) || (req->size > IOPLUS_ASYNC_SIZE_MAX)
+		|| (req->add < 0) || (req->add + req->size > IOPLUS_MAP_SIZE))
+	{
+		return IOPLUS_ERR_ARG;
+	}
+	if (!q->running || __atomic_load_n(&q->stop, __ATOMIC_ACQUIRE))
+	{
+		return IOPLUS_ERR_ARG;
+	}
+	req->done = 0;
+	req->result = IOPLUS_OK;
+	req->submitUs = asyncNowUs();
+	__atomic_fetch_add(&q->stats.submitted, 1, __ATOMIC_RELAXED);
+	asyncPush(q, req);
+	asyncWake(q);
+	return IOPLUS_OK;
+}
+
+int ioplusAsyncDone(IoplusAsyncReqType *req)
+{
+	return (NULL != req) && __atomic_load_n(&req->done, __ATOMIC_ACQUIRE);
+}
+
+int ioplusAsyncWait(IoplusAsyncType *q, IoplusAsyncReqType *req)
+{
+	if ( (NULL == q) || (NULL == req))
+	{
+		return IOPLUS_ERR_ARG;
+	}
+	if (!ioplusAsyncDone(req))
+	{
+		pthread_mutex_lock(&q->lock);
+		__atomic_fetch_add(&q->waiters, 1, __ATOMIC_SEQ_CST);
+		while (!__atomic_load_n(&req->done, __ATOMIC_SEQ_CST))
+		{
+			pthread_cond_wait(&q->cond, &q->lock);
+		}
+		__atomic_fetch_sub(&q->waiters, 1, __ATOMIC_SEQ_CST);
+		pthread_mutex_unlock(&q->lock);
+	}
+	return req->result;
+}
+
+int ioplusAsyncStatsGet(IoplusAsyncType *q, IoplusAsyncStatsType *stats)
+{
+	if ( (NULL == q) || (NULL == stats))
+	{
+		return IOPLUS_ERR_ARG;
+	}
+	stats->submitted = __atomic_load_n(&q->stats.submitted, __ATOMIC_RELAXED);
+	stats->completed = __atomic_load_n(&q->stats.completed, __ATOMIC_RELAXED);
+	stats->errors = __atomic_load_n(&q->stats.errors, __ATOMIC_RELAXED);
+	stats->batches = __atomic_load_n(&q->stats.batches, __ATOMIC_RELAXED);
+	stats->transfers = __atomic_load_n(&q->stats.transfers, __ATOMIC_RELAXED);
+	stats->merged = __atomic_load_n(&q->stats.merged, __ATOMIC_RELAXED);
+	stats->latencyUsMax = __atomic_load_n(&q->stats.latencyUsMax,
+		__ATOMIC_RELAXED);
+	stats->latencyUsSum = __atomic_load_n(&q->stats.latencyUsSum,
+		__ATOMIC_RELAXED);
+	return IOPLUS_OK;
+}
+
+void ioplusAsyncStatsReset(IoplusAsyncType *q)
+{
+	if (NULL != q)
+	{
+		__atomic_store_n(&q->stats.submitted, 0, __ATOMIC_RELAXED);
+		__atomic_store_n(&q->stats.completed, 0, __ATOMIC_RELAXED);
+		__atomic_store_n(&q->stats.errors, 0, __ATOMIC_RELAXED);
+		__atomic_store_n(&q->stats.batches, 0, __ATOMIC_RELAXED);
+		__atomic_store_n(&q->stats.transfers, 0, __ATOMIC_RELAXED);
+		__atomic_store_n(&q->stats.merged, 0, __ATOMIC_RELAXED);
+		__atomic_store_n(&q->stats.latencyUsMax, 0, __ATOMIC_RELAXED);
+		__atomic_store_n(&q->stats.latencyUsSum, 0, __ATOMIC_RELAXED);
+	}
+}
@@ -0,0 +1,210 @@
+/*
+ * attn.c:
+ *	Event driven card reads. A host GPIO line requested through the gpio
+ *	character device (uAPI v2) with edge detection wakes the reader, which
+ *	then reads the card once for all the edges queued so far. A slow
+ *	fallback read catches input changes the line did not report.
+ *
+ *	Copyright (c) 2016-2023 Sequent Microsystem
+ *	<http://www.sequentmicrosystem.com>
+ ***********************************************************************
+ */
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <ctype.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <linux/gpio.h>
+
+#include "libioplus.h"
+
+#define ATTN_CONSUMER	"ioplus"
+#define ATTN_EVENTS_MAX	16
+
+static uint64_t attnNowNs(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+// inputs worth an event: opto, gpio and the counters, not the analog values
+static int attnChanged(const IoplusSnapshotType *a, const IoplusSnapshotType *b,
+	int parts)
+{
+	if ( (parts & IOPLUS_SNAP_DIGITAL)
+		&& ( (a->opto != b->opto) || (a->gpio != b->gpio)))
+	{
+		return 1;
+	}
+	if ( (parts & IOPLUS_SNAP_COUNTERS) && memcmp(a->cnt, b->cnt, sizeof(a->cnt)))
+	{
+		return 1;
+	}
+	return 0;
+}
+
+int ioplusAttnOpen(IoplusAttnType *a, const char *chip, int line, int edge,
+	uint32_t debounceUs, uint32_t fallbackMs)
+{
+	struct gpio_v2_line_request req;
+	char path[64];
+	int chipFd;
+	int err;
+	int i;
+
+	if ( (NULL == a) || (NULL == chip) || (line < 0) || (fallbackMs == 0)
+		|| (edge < IOPLUS_EDGE_RISING) || (edge > IOPLUS_EDGE_BOTH))
+	{
+		return IOPLUS_ERR_ARG;
+	}
+	memset(a, 0, sizeof(IoplusAttnType));
+	a->fd = -1;
+	a->fallbackMs = fallbackMs;
+	for (i = 0; isdigit((unsigned char)chip[i]); i++)
+		;
+	if (chip[0] == '/')
+	{
+		snprintf(path, sizeof(path), "%s", chip);
+	}
+	else if ( (i > 0) && (chip[i] == 0))
+	{
+		snprintf(path, sizeof(path), "/dev/gpiochip%s", chip);
+	}
+	else
+	{
+		snprintf(path, sizeof(path), "/dev/%s", chip);
+	}
+	chipFd = open(path, O_RDWR | O_CLOEXEC);
+	if (chipFd < 0)
+	{
+		return IOPLUS_ERR_IO;
+	}
+	memset(&req, 0, sizeof(req));
+	req.offsets[0] = (uint32_t)line;
+	req.num_lines = 1;
+	snprintf(req.consumer, sizeof(req.consumer), "%s", ATTN_CONSUMER);
+	req.config.flags = GPIO_V2_LINE_FLAG_INPUT;
+	if (edge & IOPLUS_EDGE_RISING)
+	{
+		req.config.flags |= GPIO_V2_LINE_FLAG_EDGE_RISING;
+	}
+	if (edge & IOPLUS_EDGE_FALLING)
+	{
+		req.config.flags |= GPIO_V2_LINE_FLAG_EDGE_FALLING;
+	}
+	if (debounceUs != 0)
+	{
+		req.config.num_attrs = 1;
+		req.config.attrs[0].attr.id = GPIO_V2_LINE_ATTR_ID_DEBOUNCE;
+		req.config.attrs[0].attr.debounce_period_us = debounceUs;
+		req.config.attrs[0].mask = 1;
+	}
+	if (ioctl(chipFd, GPIO_V2_GET_LINE_IOCTL, &req) < 0)
+	{
+		err = errno; // an unsupported edge or debounce, close() may overwrite it
+		close(chipFd);
+		return (err == EINVAL) ? IOPLUS_ERR_ARG : IOPLUS_ERR_IO;
+	}
+	close(chipFd);
+	// drained without blocking once poll() reported an edge
+	fcntl(req.fd, F_SETFL, fcntl(req.fd, F_GETFL) | O_NONBLOCK);
+	a->fd = req.fd;
+	return IOPLUS_OK;
+}
+
+int ioplusAttnWait(IoplusBoardType *board, IoplusAttnType *a,
+	IoplusSnapshotType *snap, int parts, int *edge)
+{
+	struct gpio_v2_line_event ev[ATTN_EVENTS_MAX];
+	struct pollfd pfd;
+	uint64_t first = 0;
+	uint64_t now;
+	uint32_t us;
+	int timeout = 0;
+	ssize_t n;
+	int events = 0;
+	int ret;
+
+	if ( (NULL == board) || (NULL == a) || (a->fd < 0) || (NULL == snap))
+	{
+		return IOPLUS_ERR_ARG;
+	}
+	now = attnNowNs() / 1000000;
+	if (a->valid && (a->readMs + a->fallbackMs > now))
+	{
+		timeout = (int) (a->readMs + a->fallbackMs - now);
+	}
+	pfd.fd = a->fd;
+	pfd.events = POLLIN;
+	// a signal ends the wait early, the card is read as on a fallback
+	if ( (poll(&pfd, 1, timeout) > 0) && (pfd.revents & POLLIN))
+	{
+		while ( (n = read(a->fd, ev, sizeof(ev))) > 0)
+		{
+			if (events == 0)
+			{
+				first = ev[0].timestamp_ns;
+			}
+			events += (int) (n / sizeof(ev[0]));
+		}
+	}
+	ret = ioplusSnapshotPartGet(board, snap, parts);
+	a->readMs = attnNowNs() / 1000000;
+	if (ret != IOPLUS_OK)
+	{
+		a->valid = 0;
+		return ret;
+	}
+	if (events > 0)
+	{
+		a->stats.events += events;
+		a->stats.edgeReads++;
+		us = (uint32_t) ( (attnNowNs() - first) / 1000);
+		if (us > a->stats.latencyUsMax)
+		{
+			a->stats.latencyUsMax = us;
+		}
+		a->stats.latencyUsSum += us;
+	}
+	else
+	{
+		a->stats.fallbackReads++;
+		if (a->valid && attnChanged(&a->last, snap, parts))
+		{
+			a->stats.missed++;
+		}
+	}
+	a->last = *snap;
+	a->valid = 1;
+	if (edge)
+	{
+		*edge = events > 0;
+	}
+	return IOPLUS_OK;
+}
+
+void ioplusAttnClose(IoplusAttnType *a)
+{
+	if ( (NULL != a) && (a->fd >= 0))
+	{
+		close(a->fd);
+		a->fd = -1;
+	}
+}
+
+int ioplusAttnStatsGet(IoplusAttnType *a, IoplusAttnStatsType *stats)
+{
+	if ( (NULL == a) || (NULL == stats))
+	{
+		return IOPLUS_ERR_ARG;
+	}
+	*stats = a->stats;
+	return IOPLUS_OK;
+}
@@ -0,0 +1,519 @@
+/*
+ * calrun.c:
+ *	Multi point calibration of the ADC and DAC channels driven by a plan
+ *	file. Every card runs the plan in its own thread with its own handle,
+ *	the calibration status is polled instead of waiting a fixed delay and
+ *	a report of all the steps is printed once every card is done.
+ *
+ *	Copyright (c) 2016-2023 Sequent Microsystem
+ *	<http://www.sequentmicrosystem.com>
+ ***********************************************************************
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+
+#include "ioplus.h"
+#include "libioplus.h"
+#include "thread.h"
+
+#define CAL_BOARDS_MAX	8
+#define CAL_STEPS_MAX	64
+#define CAL_LINE_MAX	128
+#define CAL_TIMEOUT_MS	1000
+#define CAL_SETTLE_MS	50
+#define CAL_TOLERANCE_MV	30
+#define CAL_VERIFY_SAMPLES	8
+#define CAL_NOT_READ	-1
+#define CAL_MSG_MAX	64
+
+typedef enum
+{
+	CAL_STEP_ADC = 0,
+	CAL_STEP_DAC,
+	CAL_STEP_ADC_RST,
+	CAL_STEP_DAC_RST,
+	CAL_STEP_PAUSE,
+} CalStepKindType;
+
+typedef struct
+{
+	int kind;
+	int ch;
+	int mV;
+	int dac; // loopback DAC driving the ADC input, 0 for an external reference
+	int verifyNow; // last point of a channel on an external reference
+	char msg[CAL_MSG_MAX]; // operator prompt of a pause
+} CalStepType;
+
+typedef struct
+{
+	int tolMv;
+	int timeoutMs;
+	int settleMs;
+	int steps;
+	int pauses;
+	CalStepType step[CAL_STEPS_MAX];
+} CalPlanType;
+
+typedef struct
+{
+	int ret; // library result of the calibration command
+	int status; // last calibration status read
+	int ms; // from the command to the final status
+	int readMv; // verification reading or CAL_NOT_READ
+} CalResultType;
+
+typedef struct
+{
+	const CalPlanType *plan;
+	int stack;
+	int ret;
+	pthread_t thread;
+	CalResultType res[CAL_STEPS_MAX];
+} CalBoardType;
+
+static const char *gStepName[] = {"adc", "dac", "adcrst", "dacrst", "pause"};
+// the card threads and the operator meet here on every pause of the plan
+static pthread_barrier_t gPause;
+
+static int calNowMs(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (int) (ts.tv_sec * 1000 + ts.tv_nsec / 1000000);
+}
+
+// DAC wired to each ADC input by the loopback cable used for iotest
+static int loopbackDac(int adcCh)
+{
+	return DAC_CH_NR_MAX - (adcCh - 1) % DAC_CH_NR_MAX;
+}
+
+static int planParse(const char *fileName, CalPlanType *plan)
+{
+	FILE *f;
+	char line[CAL_LINE_MAX];
+	char cmd[16];
+	char opt[16];
+	float val;
+	CalStepType *st;
+	int lineNo = 0;
+	int ch;
+	int n;
+	int i;
+	int j;
+
+	f = fopen(fileName, "r");
+	if (NULL == f)
+	{
+		printf("Fail to open the plan file %s!\n", fileName);
+		return ERROR;
+	}
+	memset(plan, 0, sizeof(CalPlanType));
+	plan->tolMv = CAL_TOLERANCE_MV;
+	plan->timeoutMs = CAL_TIMEOUT_MS;
+	plan->settleMs = CAL_SETTLE_MS;
+	while (NULL != fgets(line, sizeof(line), f))
+	{
+		lineNo++;
+		if (NULL != strchr(line, '#'))
+		{
+			*strchr(line, '#') = 0;
+		}
+		opt[0] = 0;
+		val = 0;
+		ch = 0;
+		n = sscanf(line, "%15s", cmd);
+		if (n < 1)
+		{
+			continue;
+		}
+		if (0 == strcmp(cmd, "tolerance") && 1 == sscanf(line, "%*s %f", &val)
+			&& val > 0)
+		{
+			plan->tolMv = (int) (val * VOLT_TO_MILIVOLT);
+			continue;
+		}
+		if (0 == strcmp(cmd, "timeout") && 1 == sscanf(line, "%*s %d", &ch)
+			&& ch > 0)
+		{
+			plan->timeoutMs = ch;
+			continue;
+		}
+		if (0 == strcmp(cmd, "settle") && 1 == sscanf(line, "%*s %d", &ch)
+			&& ch >= 0)
+		{
+			plan->settleMs = ch;
+			continue;
+		}
+		if (plan->steps >= CAL_STEPS_MAX)
+		{
+			printf("Plan line %d: more than %d steps!\n", lineNo, CAL_STEPS_MAX);
+			fclose(f);
+			return ERROR;
+		}
+		st = &plan->step[plan->steps];
+		if (0 == strcmp(cmd, "pause"))
+		{
+			st->kind = CAL_STEP_PAUSE;
+			sscanf(line, "%*s %63[^\n]", st->msg);
+			plan->pauses++;
+			plan->steps++;
+			continue;
+		}
+		n = sscanf(line, "%*s %d %f %15s", &ch, &val, opt);
+		if (0 == strcmp(cmd, "adc") && n >= 2 && ch >= CHANNEL_NR_MIN
+			&& ch <= ADC_CH_NR_MAX && val >= 0 && val <= 3.3)
+		{
+			st->kind = CAL_STEP_ADC;
+			if (n == 3)
+			{
+				if (0 != strcmp(opt, "loop"))
+				{
+					printf("Plan line %d: unknown option %s!\n", lineNo, opt);
+					fclose(f);
+					return ERROR;
+				}
+				st->dac = loopbackDac(ch);
+			}
+		}
+		else if (0 == strcmp(cmd, "dac") && n == 2 && ch >= CHANNEL_NR_MIN
+			&& ch <= DAC_CH_NR_MAX && val >= 0 && val <= 10)
+		{
+			st->kind = CAL_STEP_DAC;
+		}
+		else if (0 == strcmp(cmd, "adcrst") && n == 1 && ch >= CHANNEL_NR_MIN
+			&& ch <= ADC_CH_NR_MAX)
+		{
+			st->kind = CAL_STEP_ADC_RST;
+		}
+		else if (0 == strcmp(cmd, "dacrst") && n == 1 && ch >= CHANNEL_NR_MIN
+			&& ch <= DAC_CH_NR_MAX)
+		{
+			st->kind = CAL_STEP_DAC_RST;
+		}
+		else
+		{
+			printf("Plan line %d: invalid step \"%s\"!\n", lineNo, cmd);
+			fclose(f);
+			return ERROR;
+		}
+		st->ch = ch;
+		st->mV = (int) (val * VOLT_TO_MILIVOLT + 0.5);
+		plan->steps++;
+	}
+	fclose(f);
+	if (plan->steps == 0)
+	{
+		printf("No calibration steps in %s!\n", fileName);
+		return ERROR;
+	}
+	// an external reference is gone once the plan moves on, verify the
+	// channel right after its last point
+	for (i = 0; i < plan->steps; i++)
+	{
+		if ( (plan->step[i].kind != CAL_STEP_ADC) || (plan->step[i].dac != 0))
+		{
+			continue;
+		}
+		plan->step[i].verifyNow = 1;
+		for (j = i + 1; j < plan->steps; j++)
+		{
+			if ( (plan->step[j].kind == CAL_STEP_ADC)
+				&& (plan->step[j].ch == plan->step[i].ch))
+			{
+				plan->step[i].verifyNow = 0;
+			}
+		}
+	}
+	return OK;
+}
+
+static int adcAverage(IoplusBoardType *board, int ch, int *mV)
+{
+	uint16_t val = 0;
+	int sum = 0;
+	int i;
+
+	for (i = 0; i < CAL_VERIFY_SAMPLES; i++)
+	{
+		if (IOPLUS_OK != ioplusAdcGet(board, ch, &val))
+		{
+			return ERROR;
+		}
+		sum += val;
+	}
+	*mV = (sum + CAL_VERIFY_SAMPLES / 2) / CAL_VERIFY_SAMPLES;
+	return OK;
+}
+
+static int loopbackDrive(IoplusBoardType *board, const CalPlanType *plan,
+	const CalStepType *st)
+{
+	if (IOPLUS_OK != ioplusDacSet(board, st->dac, (uint16_t)st->mV))
+	{
+		return ERROR;
+	}
+	busyWait(plan->settleMs);
+	return OK;
+}
+
+static void pauseWait(void)
+{
+	pthread_barrier_wait(&gPause); // everybody there
+	pthread_barrier_wait(&gPause); // operator done
+}
+
+static void* calBoardRun(void *arg)
+{
+	CalBoardType *cb = (CalBoardType*)arg;
+	const CalPlanType *plan = cb->plan;
+	const CalStepType *st;
+	CalResultType *res;
+	IoplusBoardType board;
+	uint16_t dacSave[IOPLUS_DAC_CH_NO];
+	int start;
+	int i;
+
+	cb->ret = ioplusOpen(&board, cb->stack);
+	if (cb->ret != IOPLUS_OK)
+	{
+		for (i = 0; i < plan->pauses; i++)
+		{
+			pauseWait();
+		}
+		return NULL;
+	}
+	cb->ret = ioplusDacGetAll(&board, dacSave);
+	for (i = 0; i < plan->steps; i++)
+	{
+		st = &plan->step[i];
+		res = &cb->res[i];
+		res->readMv = CAL_NOT_READ;
+		if (st->kind == CAL_STEP_PAUSE)
+		{
+			pauseWait();
+			continue;
+		}
+		if (cb->ret != IOPLUS_OK)
+		{
+			continue;
+		}
+		if ( (st->dac != 0) && (OK != loopbackDrive(&board, plan, st)))
+		{
+			res->ret = IOPLUS_ERR_IO;
+			continue;
+		}
+		start = calNowMs();
+		switch (st->kind)
+		{
+		case CAL_STEP_ADC:
+			res->ret = ioplusAdcCalSet(&board, st->ch, (uint16_t)st->mV);
+			break;
+		case CAL_STEP_DAC:
+			res->ret = ioplusDacCalSet(&board, st->ch, (uint16_t)st->mV);
+			break;
+		case CAL_STEP_ADC_RST:
+			res->ret = ioplusAdcCalReset(&board, st->ch);
+			break;
+		default:
+			res->ret = ioplusDacCalReset(&board, st->ch);
+			break;
+		}
+		if (res->ret == IOPLUS_OK)
+		{
+			res->ret = ioplusCalWait(&board, plan->timeoutMs, &res->status);
+		}
+		res->ms = calNowMs() - start;
+		if ( (res->ret == IOPLUS_OK) && st->verifyNow
+			&& (OK != adcAverage(&board, st->ch, &res->readMv)))
+		{
+			res->ret = IOPLUS_ERR_IO;
+		}
+	}
+	// loopback points are checked again once all of them are calibrated
+	for (i = 0; (cb->ret == IOPLUS_OK) && (i < plan->steps); i++)
+	{
+		st = &plan->step[i];
+		res = &cb->res[i];
+		if ( (st->kind != CAL_STEP_ADC) || (st->dac == 0)
+			|| (res->ret != IOPLUS_OK))
+		{
+			continue;
+		}
+		if ( (OK != loopbackDrive(&board, plan, st))
+			|| (OK != adcAverage(&board, st->ch, &res->readMv)))
+		{
+			res->ret = IOPLUS_ERR_IO;
+		}
+	}
+	for (i = 0; (cb->ret == IOPLUS_OK) && (i < IOPLUS_DAC_CH_NO); i++)
+	{
+		ioplusDacSet(&board, i + 1, dacSave[i]);
+	}
+	ioplusClose(&board);
+	return NULL;
+}
+
+static int stepPass(const CalPlanType *plan, const CalStepType *st,
+	const CalResultType *res)
+{
+	if ( (res->ret != IOPLUS_OK) || (res->status != IOPLUS_CAL_DONE))
+	{
+		return 0;
+	}
+	if (res->readMv == CAL_NOT_READ)
+	{
+		return 1;
+	}
+	return abs(res->readMv - st->mV) <= plan->tolMv;
+}
+
+static const char* stepStatus(const CalResultType *res)
+{
+	if (res->ret != IOPLUS_OK)
+	{
+		return ioplusErrStr(res->ret);
+	}
+	switch (res->status)
+	{
+	case IOPLUS_CAL_DONE:
+		return "done";
+	case IOPLUS_CAL_ERROR:
+		return "error";
+	case IOPLUS_CAL_IN_PROGRESS:
+		return "in progress";
+	default:
+		break;
+	}
+	return "unknown";
+}
+
+static int calReport(const CalPlanType *plan, CalBoardType *cb, int boards)
+{
+	const CalStepType *st;
+	const CalResultType *res;
+	int failed = 0;
+	int pass;
+	int b;
+	int i;
+
+	printf("Board Step Command        Status        Time(ms) Read(V) Error(V) Result\n");
+	for (b = 0; b < boards; b++)
+	{
+		if (cb[b].ret != IOPLUS_OK)
+		{
+			printf("%-5d -    -              %s\n", cb[b].stack,
+				ioplusErrStr(cb[b].ret));
+			failed += plan->steps - plan->pauses;
+			continue;
+		}
+		for (i = 0; i < plan->steps; i++)
+		{
+			st = &plan->step[i];
+			res = &cb[b].res[i];
+			if (st->kind == CAL_STEP_PAUSE)
+			{
+				continue;
+			}
+			pass = stepPass(plan, st, res);
+			failed += !pass;
+			printf("%-5d %-4d %-6s %d", cb[b].stack, i + 1, gStepName[st->kind],
+				st->ch);
+			if ( (st->kind == CAL_STEP_ADC) || (st->kind == CAL_STEP_DAC))
+			{
+				printf(" @%6.3fV", (float)st->mV / VOLT_TO_MILIVOLT);
+			}
+			else
+			{
+				printf("         ");
+			}
+			printf(" %-13s %-8d", stepStatus(res), res->ms);
+			if (res->readMv != CAL_NOT_READ)
+			{
+				printf(" %-7.3f %-8.3f", (float)res->readMv / VOLT_TO_MILIVOLT,
+					(float) (res->readMv - st->mV) / VOLT_TO_MILIVOLT);
+			}
+			else
+			{
+				printf(" -       -       ");
+			}
+			printf(" %s\n", pass ? "PASS" : "FAIL");
+		}
+	}
+	printf("\n%d card(s), %d step(s), %d failed, tolerance %0.3fV\n", boards,
+		boards * (plan->steps - plan->pauses), failed, (float)plan->tolMv / VOLT_TO_MILIVOLT);
+	return (failed == 0) ? OK : FAIL;
+}
+
+static void operatorWait(const char *msg)
+{
+	int c;
+
+	pthread_barrier_wait(&gPause);
+	printf("%s\nPress Enter to continue ", msg);
+	fflush(stdout);
+	do
+	{
+		c = getchar();
+	}
+	while ( (c != '\n') && (c != EOF));
+	pthread_barrier_wait(&gPause);
+}
+
+int doCalRun(int argc, char *argv[])
+{
+	static CalPlanType plan;
+	static CalBoardType cb[CAL_BOARDS_MAX];
+	int boards = 0;
+	int i;
+
+	if ( (argc < 4) || (argc > 3 + CAL_BOARDS_MAX))
+	{
+		return ARG_CNT_ERR;
+	}
+	if (OK != planParse(argv[2], &plan))
+	{
+		return ARG_ERR;
+	}
+	for (i = 3; i < argc; i++)
+	{
+		memset(&cb[boards], 0, sizeof(CalBoardType));
+		cb[boards].plan = &plan;
+		cb[boards].stack = atoi(argv[i]);
+		if ( (cb[boards].stack < 0) || (cb[boards].stack > 7))
+		{
+			printf("Invalid stack level %s!\n", argv[i]);
+			return ARG_ERR;
+		}
+		boards++;
+	}
+	busTokenRelease();
+	pthread_barrier_init(&gPause, NULL, boards + 1);
+	for (i = 0; i < boards; i++)
+	{
+		if (0 != pthread_create(&cb[i].thread, NULL, calBoardRun, &cb[i]))
+		{
+			printf("Fail to start the calibration of card %d!\n", cb[i].stack);
+			return FAIL;
+		}
+	}
+	for (i = 0; i < plan.steps; i++)
+	{
+		if (plan.step[i].kind == CAL_STEP_PAUSE)
+		{
+			operatorWait(plan.step[i].msg);
+		}
+	}
+	for (i = 0; i < boards; i++)
+	{
+		pthread_join(cb[i].thread, NULL);
+	}
+	pthread_barrier_destroy(&gPause);
+	return calReport(&plan, cb, boards);
+}
@@ -0,0 +1,564 @@
+/*
+ * cntjournal.c:
+ *	Durable 64 bit totals of the card counters. The card keeps its counters
+ *	in RAM only, every sample turns them into deltas appended to a journal
+ *	file and the totals are checkpointed from time to time so the journal
+ *	stays short.
+ *
+ *	journal:	header {"IOPJ", u16 version, u16 counters, u32 gen, u32 crc}
+ *			records {0xa5, u8 len, payload[len], u16 crc}
+ *			payload: varint changed mask, then for every changed counter
+ *			varint(zigzag(total delta) << 1 | raw moved by the same delta)
+ *			followed by varint(zigzag(raw delta)) when the flag is 0
+ *	checkpoint:	{"IOPC", u16 version, u16 counters, u32 gen, u32 valid,
+ *			i64 total[], u32 raw[], u32 crc}
+ *
+ *	Copyright (c) 2016-2023 Sequent Microsystem
+ *	<http://www.sequentmicrosystem.com>
+ ***********************************************************************
+ */
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <libgen.h>
+
+#include "libioplus.h"
+#include "varint.h"
+
+#define JOURNAL_VERSION	1
+#define JOURNAL_HDR_SIZE	16
+#define JOURNAL_SYNC_BYTE	0xa5
+#define JOURNAL_REC_MAX	(2 + 255 + 2)
+#define CKP_SIZE	(16 + 12 * IOPLUS_CNT_NO + 4)
+#define CKP_SUFFIX	".ckp"
+#define CKP_TMP_SUFFIX	".ckp.tmp"
+#define WRAP_HALF	0x80000000UL
+
+static uint64_t jrnlNowMs(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+static uint32_t crc32(const uint8_t *buff, int size)
+{
+	uint32_t crc = 0xffffffff;
+	int i;
+	int b;
+
+	for (i = 0; i < size; i++)
+	{
+		crc ^= buff[i];
+		for (b = 0; b < 8; b++)
+		{
+			crc = (crc >> 1) ^ (0xedb88320 & (0 - (crc & 1)));
+		}
+	}
+	return ~crc;
+}
+
+static void pathMake(char *dst, const IoplusCntJournalType *j,
+	const char *suffix)
+{
+	snprintf(dst, IOPLUS_JOURNAL_PATH_MAX + 8, "%s%s", j->path, suffix);
+}
+
+static int ckpLoad(IoplusCntJournalType *j)
+{
+	char path[IOPLUS_JOURNAL_PATH_MAX + 8];
+	uint8_t buff[CKP_SIZE];
+	uint32_t crc;
+	uint16_t val16;
+	int fd;
+	int n;
+
+	pathMake(path, j, CKP_SUFFIX);
+	fd = open(path, O_RDONLY);
+	if (fd < 0)
+	{
+		return IOPLUS_ERR_IO;
+	}
+	n = read(fd, buff, sizeof(buff));
+	close(fd);
+	if (n != CKP_SIZE)
+	{
+		return IOPLUS_ERR_IO;
+	}
+	memcpy(&crc, buff + CKP_SIZE - 4, 4);
+	memcpy(&val16, buff + 6, 2);
+	if ( (0 != memcmp(buff, "IOPC", 4)) || (val16 != IOPLUS_CNT_NO)
+		|| (crc != crc32(buff, CKP_SIZE - 4)))
+	{
+		return IOPLUS_ERR_IO;
+	}
+	memcpy(&j->gen, buff + 8, 4);
+	memcpy(&j->valid, buff + 12, 4);
+	memcpy(j->total, buff + 16, 8 * IOPLUS_CNT_NO);
+	memcpy(j->raw, buff + 16 + 8 * IOPLUS_CNT_NO, 4 * IOPLUS_CNT_NO);
+	return IOPLUS_OK;
+}
+
+/* new checkpoint next to the old one, then renamed over it so a power loss
+ * leaves either of them complete */
+static int ckpSave(IoplusCntJournalType *j, uint32_t gen)
+{
+	char path[IOPLUS_JOURNAL_PATH_MAX + 8];
+	char tmp[IOPLUS_JOURNAL_PATH_MAX + 8];
+	char dir[IOPLUS_JOURNAL_PATH_MAX + 8];
+	uint8_t buff[CKP_SIZE];
+	uint16_t val16;
+	uint32_t crc;
+	int ok;
+	int fd;
+
+	memcpy(buff, "IOPC", 4);
+	val16 = JOURNAL_VERSION;
+	memcpy(buff + 4, &val16, 2);
+	val16 = IOPLUS_CNT_NO;
+	memcpy(buff + 6, &val16, 2);
+	memcpy(buff + 8, &gen, 4);
+	memcpy(buff + 12, &j->valid, 4);
+	memcpy(buff + 16, j->total, 8 * IOPLUS_CNT_NO);
+	memcpy(buff + 16 + 8 * IOPLUS_CNT_NO, j->raw, 4 * IOPLUS_CNT_NO);
+	crc = crc32(buff, CKP_SIZE - 4);
+	memcpy(buff + CKP_SIZE - 4, &crc, 4);
+
+	pathMake(tmp, j, CKP_TMP_SUFFIX);
+	pathMake(path, j, CKP_SUFFIX);
+	fd = open(tmp, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+	if (fd < 0)
+	{
+		return IOPLUS_ERR_IO;
+	}
+	ok = (CKP_SIZE == write(fd, buff, CKP_SIZE)) && (0 == fsync(fd));
+	close(fd);
+	if (!ok || (0 != rename(tmp, path)))
+	{
+		return IOPLUS_ERR_IO;
+	}
+	// make the rename itself durable
+	pathMake(dir, j, "");
+	fd = open(dirname(dir), O_RDONLY);
+	if (fd >= 0)
+	{
+		fsync(fd);
+		close(fd);
+	}
+	return IOPLUS_OK;
+}
+
+static int journalReset(IoplusCntJournalType *j)
+{
+	uint8_t hdr[JOURNAL_HDR_SIZE];
+	uint16_t val16;
+	uint32_t crc;
+
+	memcpy(hdr, "IOPJ", 4);
+	val16 = JOURNAL_VERSION;
+	memcpy(hdr + 4, &val16, 2);
+	val16 = IOPLUS_CNT_NO;
+	memcpy(hdr + 6, &val16, 2);
+	memcpy(hdr + 8, &j->gen, 4);
+	crc = crc32(hdr, 12);
+	memcpy(hdr + 12, &crc, 4);
+	if ( (0 != ftruncate(j->fd, 0))
+		|| (JOURNAL_HDR_SIZE != pwrite(j->fd, hdr, JOURNAL_HDR_SIZE, 0))
+		|| (0 != fsync(j->fd)))
+	{
+		return IOPLUS_ERR_IO;
+	}
+	j->size = JOURNAL_HDR_SIZE;
+	return IOPLUS_OK;
+}
+
+// apply one record payload, nothing changes when it does not decode
+static int recordApply(IoplusCntJournalType *j, const uint8_t *p,
+	const uint8_t *end)
+{
+	int64_t dTotal[IOPLUS_CNT_NO];
+	uint64_t dRaw[IOPLUS_CNT_NO];
+	uint64_t mask;
+	uint64_t val;
+	int n;
+	int i;
+
+	n = varintGet(p, end, &mask);
+	if ( (n == 0) || (mask >> IOPLUS_CNT_NO))
+	{
+		return IOPLUS_ERR_IO;
+	}
+	p += n;
+	for (i = 0; i < IOPLUS_CNT_NO; i++)
+	{
+		if (0 == (mask & (1ULL << i)))
+		{
+			continue;
+		}
+		n = varintGet(p, end, &val);
+		if (n == 0)
+		{
+			return IOPLUS_ERR_IO;
+		}
+		p += n;
+		dTotal[i] = unzigzag(val >> 1);
+		dRaw[i] = (uint64_t)dTotal[i];
+		if (0 == (val & 1))
+		{
+			n = varintGet(p, end, &dRaw[i]);
+			if (n == 0)
+			{
+				return IOPLUS_ERR_IO;
+			}
+			p += n;
+			dRaw[i] = (uint64_t)unzigzag(dRaw[i]);
+		}
+	}
+	if (p != end)
+	{
+		return IOPLUS_ERR_IO;
+	}
+	for (i = 0; i < IOPLUS_CNT_NO; i++)
+	{
+		if (mask & (1ULL << i))
+		{
+			j->total[i] += dTotal[i];
+			j->raw[i] += (uint32_t)dRaw[i];
+		}
+	}
+	j->valid = 1;
+	return IOPLUS_OK;
+}
+
+/* replay the records of the current generation and cut the file after the
+ * last good one */
+static int journalReplay(IoplusCntJournalType *j)
+{
+	uint8_t hdr[JOURNAL_HDR_SIZE];
+	uint8_t rec[JOURNAL_REC_MAX];
+	uint32_t gen;
+	uint32_t crc;
+	uint16_t crc16;
+	uint32_t pos = JOURNAL_HDR_SIZE;
+	off_t end;
+	int len;
+
+	end = lseek(j->fd, 0, SEEK_END);
+	if ( (end < JOURNAL_HDR_SIZE)
+		|| (JOURNAL_HDR_SIZE != pread(j->fd, hdr, JOURNAL_HDR_SIZE, 0))
+		|| (0 != memcmp(hdr, "IOPJ", 4)))
+	{
+		return journalReset(j);
+	}
+	memcpy(&gen, hdr + 8, 4);
+	memcpy(&crc, hdr + 12, 4);
+	if ( (gen != j->gen) || (crc != crc32(hdr, 12)))
+	{
+		// left over from before the last checkpoint
+		return journalReset(j);
+	}
+	while (pos + 4 <= end)
+	{
+		if ( (2 != pread(j->fd, rec, 2, pos)) || (rec[0] != JOURNAL_SYNC_BYTE))
+		{
+			break;
+		}
+		len = rec[1];
+		if ( (pos + 4 + len > end)
+			|| (len + 2 != pread(j->fd, rec + 2, len + 2, pos + 2)))
+		{
+			break;
+		}
+		memcpy(&crc16, rec + 2 + len, 2);
+		if (crc16 != (uint16_t)crc32(rec, 2 + len))
+		{
+			break;
+		}
+		if (IOPLUS_OK != recordApply(j, rec + 2, rec + 2 + len))
+		{
+			break;
+		}
+		j->stats.replayed++;
+		pos += 4 + len;
+	}
+	j->stats.dropped = (uint32_t) (end - pos);
+	if ( (pos != end) && (0 != ftruncate(j->fd, pos)))
+	{
+		return IOPLUS_ERR_IO;
+	}
+	j->size = pos;
+	return IOPLUS_OK;
+}
+
+int ioplusCntJournalOpen(IoplusCntJournalType *j, const char *path,
+	uint32_t syncMs, uint32_t checkpointMs, uint32_t checkpointBytes)
+{
+	int ret;
+
+	if ( (NULL == j) || (NULL == path) || (strlen(path) >= IOPLUS_JOURNAL_PATH_MAX)
+		|| (checkpointBytes < JOURNAL_HDR_SIZE + JOURNAL_REC_MAX))
+	{
+		return IOPLUS_ERR_ARG;
+	}
+	memset(j, 0, sizeof(IoplusCntJournalType));
+	strcpy(j->path, path);
+	j->syncMs = syncMs;
+	j->checkpointMs = checkpointMs;
+	j->checkpointBytes = checkpointBytes;
+	if (IOPLUS_OK != ckpLoad(j))
+	{
+		// first run, or a checkpoint nobody can trust: start from zero
+		j->gen = 0;
+		j->valid = 0;
+		memset(j->total, 0, sizeof(j->total));
+		memset(j->raw, 0, sizeof(j->raw));
+	}
+	j->fd = open(path, O_RDWR | O_CREAT, 0644);
+	if (j->fd < 0)
+	{
+		return IOPLUS_ERR_IO;
+	}
+	ret = journalReplay(j);
+	if (ret != IOPLUS_OK)
+	{
+		close(j->fd);
+		j->fd = -1;
+		return ret;
+	}
+	j->syncedMs = j->checkpointedMs = jrnlNowMs();
+	return IOPLUS_OK;
+}
+
+static int bufferWrite(IoplusCntJournalType *j)
+{
+	if (j->used == 0)
+	{
+		return IOPLUS_OK;
+	}
+	if ((ssize_t)j->used != pwrite(j->fd, j->buff, j->used, j->size))
+	{
+		return IOPLUS_ERR_IO;
+	}
+	j->size += j->used;
+	j->stats.bytes += j->used;
+	j->used = 0;
+	return IOPLUS_OK;
+}
+
+static int journalSync(IoplusCntJournalType *j, uint64_t ms)
+{
+	int ret;
+
+	ret = bufferWrite(j);
+	if ( (ret == IOPLUS_OK) && (0 != fdatasync(j->fd)))
+	{
+		ret = IOPLUS_ERR_IO;
+	}
+	j->syncedMs = ms;
+	j->stats.syncs++;
+	return ret;
+}
+
+static int journalCheckpoint(IoplusCntJournalType *j, uint64_t ms)
+{
+	int ret;
+
+	ret = ckpSave(j, j->gen + 1);
+	if (ret != IOPLUS_OK)
+	{
+		return ret;
+	}
+	// the buffered records are part of the saved totals
+	j->used = 0;
+	j->gen++;
+	j->checkpointedMs = j->syncedMs = ms;
+	j->stats.checkpoints++;
+	return journalReset(j);
+}
+
+int ioplusCntJournalSync(IoplusCntJournalType *j)
+{
+	if ( (NULL == j) || (j->fd < 0))
+	{
+		return IOPLUS_ERR_ARG;
+	}
+	return journalSync(j, jrnlNowMs());
+}
+
+int ioplusCntJournalCheckpoint(IoplusCntJournalType *j)
+{
+	if ( (NULL == j) || (j->fd < 0))
+	{
+		return IOPLUS_ERR_ARG;
+	}
+	return journalCheckpoint(j, jrnlNowMs());
+}
+
+// the buffer is left as it is when there is no room for the record
+static int recordPut(IoplusCntJournalType *j, uint32_t mask,
+	const int64_t *dTotal, const uint32_t *dRaw)
+{
+	uint8_t *rec;
+	uint16_t crc16;
+	int len = 0;
+	int ret;
+	int i;
+
+	if (j->used + JOURNAL_REC_MAX > IOPLUS_JOURNAL_BUF_SIZE)
+	{
+		ret = bufferWrite(j);
+		if (ret != IOPLUS_OK)
+		{
+			return ret;
+		}
+	}
+	rec = j->buff + j->used;
+	len += varintPut(rec + 2 + len, mask);
+	for (i = 0; i < IOPLUS_CNT_NO; i++)
+	{
+		if (0 == (mask & (1UL << i)))
+		{
+			continue;
+		}
+		if ((uint32_t)dTotal[i] == dRaw[i])
+		{
+			len += varintPut(rec + 2 + len, (zigzag(dTotal[i]) << 1) | 1);
+		}
+		else
+		{
+			len += varintPut(rec + 2 + len, zigzag(dTotal[i]) << 1);
+			len += varintPut(rec + 2 + len, zigzag((int32_t)dRaw[i]));
+		}
+	}
+	rec[0] = JOURNAL_SYNC_BYTE;
+	rec[1] = (uint8_t)len;
+	crc16 = (uint16_t)crc32(rec, 2 + len);
+	memcpy(rec + 2 + len, &crc16, 2);
+	j->used += 4 + len;
+	j->stats.records++;
+	return IOPLUS_OK;
+}
+
+int ioplusCntJournalAdd(IoplusCntJournalType *j, uint64_t ms,
+	const uint32_t *raw)
+{
+	int64_t dTotal[IOPLUS_CNT_NO];
+	uint32_t dRaw[IOPLUS_CNT_NO];
+	uint32_t mask = 0;
+	uint32_t prev;
+	uint32_t resets = 0;
+	uint32_t wraps = 0;
+	int ret;
+	int i;
+
+	if ( (NULL == j) || (NULL == raw) || (j->fd < 0))
+	{
+		return IOPLUS_ERR_ARG;
+	}
+	j->stats.samples++;
+	for (i = 0; i < IOPLUS_CNT_NO; i++)
+	{
+		prev = j->valid ? j->raw[i] : 0;
+		dRaw[i] = raw[i] - prev;
+		if (i >= IOPLUS_CNT_OD)
+		{
+			// pulses left only go down while they are sent, a rise is a reload
+			dTotal[i] = (raw[i] < prev) ? (int64_t) (prev - raw[i]) : 0;
+		}
+		else if (i >= IOPLUS_CNT_OPTO_ENC)
+		{
+			dTotal[i] = (int32_t)dRaw[i];
+		}
+		else if ( (raw[i] < prev) && (prev - raw[i] < WRAP_HALF))
+		{
+			// went back by less than half the range: the card restarted
+			// counting from 0, everything it holds is new
+			dTotal[i] = raw[i];
+			resets++;
+		}
+		else
+		{
+			if (raw[i] < prev)
+			{
+				wraps++;
+			}
+			dTotal[i] = dRaw[i];
+		}
+		if (dRaw[i] != 0)
+		{
+			mask |= 1UL << i;
+		}
+	}
+	if (mask != 0)
+	{
+		// the totals move only once the record is in the buffer, a failed
+		// sample is taken again whole by the next one
+		ret = recordPut(j, mask, dTotal, dRaw);
+		if (ret != IOPLUS_OK)
+		{
+			return ret;
+		}
+	}
+	for (i = 0; i < IOPLUS_CNT_NO; i++)
+	{
+		if (mask & (1UL << i))
+		{
+			j->total[i] += dTotal[i];
+			j->raw[i] = raw[i];
+		}
+	}
+	j->valid = 1;
+	j->stats.resets += resets;
+	j->stats.wraps += wraps;
+	if ( (j->size + j->used >= j->checkpointBytes)
+		|| (ms - j->checkpointedMs >= j->checkpointMs))
+	{
+		return journalCheckpoint(j, ms);
+	}
+	if ( (j->used > 0) && (ms - j->syncedMs >= j->syncMs))
+	{
+		return journalSync(j, ms);
+	}
+	return IOPLUS_OK;
+}
+
+int ioplusCntJournalSample(IoplusBoardType *board, IoplusCntJournalType *j)
+{
+	uint32_t raw[IOPLUS_CNT_NO];
+	int ret;
+
+	ret = ioplusCountersGetAll(board, raw);
+	if (ret != IOPLUS_OK)
+	{
+		return ret;
+	}
+	return ioplusCntJournalAdd(j, jrnlNowMs(), raw);
+}
+
+int ioplusCntJournalTotals(IoplusCntJournalType *j, int64_t *total)
+{
+	if ( (NULL == j) || (NULL == total))
+	{
+		return IOPLUS_ERR_ARG;
+	}
+	memcpy(total, j->total, sizeof(j->total));
+	return IOPLUS_OK;
+}
+
+int ioplusCntJournalClose(IoplusCntJournalType *j)
+{
+	int ret;
+
+	if ( (NULL == j) || (j->fd < 0))
+	{
+		return IOPLUS_ERR_ARG;
+	}
+	ret = ioplusCntJournalCheckpoint(j);
+	close(j->fd);
+	j->fd = -1;
+	return ret;
+}
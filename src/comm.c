@@ -9,13 +9,23 @@
  ***********************************************************************
  */
 #include <stdio.h>
+#include <stdlib.h>
 #include <stdint.h>
 #include <string.h>
+#include <errno.h>
+#include <limits.h>
 #include <unistd.h>
 #include <fcntl.h>
+#include <signal.h>
+#include <time.h>
+#include <semaphore.h>
+#include <pthread.h>
 #include <sys/ioctl.h>
 #include <linux/i2c-dev.h>
 #include "comm.h"
+#include "ioplus.h"
+
+#define I2C_INSTRUMENT
 
 #define I2C_SLAVE	0x0703
 #define I2C_SMBUS	0x0720	/* SMBus-level access */
@@ -40,29 +50,1140 @@
 #define I2C_SMBUS_BLOCK_MAX	512	/* As specified in SMBus standard */
 #define I2C_SMBUS_I2C_BLOCK_MAX	512	/* Not specified but we use same structure */
 
-int i2cSetup(int addr)
+#define I2C_DEV_FD_MAX	256
+#define BUS_SEM_NAME	"/SMI2C_SEM"
+
+static u8 gDevAdd[I2C_DEV_FD_MAX];
+static u8 gDevBus[I2C_DEV_FD_MAX]; // bus + 1 of the descriptors opened here, 0 for others
+// the two tables above and the bus wedge recovery state
+static pthread_mutex_t gWedgeLock = PTHREAD_MUTEX_INITIALIZER;
+
+#ifdef I2C_INSTRUMENT
+/*
+ * Transaction instrumentation, enabled at run time with IOPLUS_STATS
+ * (counters and latency histograms, dumped on exit or on SIGUSR1) and
+ * IOPLUS_TRACE (decoded transaction log on stderr).
+ * When both are off every hook costs one predicted branch.
+ */
+#define INSTR_STATS	0x01
+#define INSTR_TRACE	0x02
+#define INSTR_INIT	0x80
+
+#define HIST_SUB_BITS	2
+#define HIST_SUB_CNT	(1 << HIST_SUB_BITS)
+#define HIST_BUCKETS	128
+
+typedef struct
+{
+	u32 count;
+	u32 errors;
+	uint64_t bytes;
+	uint64_t totalUs;
+	u32 maxUs;
+	u32 hist[HIST_BUCKETS];
+} I2cOpStatType;
+
+typedef struct
+{
+	u32 rdCount;
+	u32 wrCount;
+	u32 errors;
+	u32 retries;
+	uint64_t rdBytes;
+	uint64_t wrBytes;
+} I2cRegStatType;
+
+typedef struct
+{
+	const char *name;
+	u8 add;
+} RegNameType;
+
+static int gInstr = 0;
+static FILE *gStatsFile = NULL;
+static volatile sig_atomic_t gStatsDumpReq = 0;
+static struct timespec gInstrStart;
+static I2cOpStatType gOpStat[I2C_OP_NO];
+static I2cRegStatType gRegStat[SLAVE_BUFF_SIZE + 1];
+static u32 gAsReads = 0;
+static u32 gAsRetries = 0;
+static u32 gAsFails = 0;
+// the counters are updated by every thread doing transfers (async I/O
+// thread, exporter poller) and read by the exporter page and the dumps
+static pthread_mutex_t gInstrLock = PTHREAD_MUTEX_INITIALIZER;
+
+static const char *gOpName[I2C_OP_NO] = {"read", "write"};
+
+#define REG_NAME(name, add)	{name, add},
+
+//sorted by address, generated with the map (ioplusmem.h)
+static const RegNameType gRegNames[] = {
+	IOPLUS_MEM_NAMES(REG_NAME)
+};
+#define REG_NAMES_NO	(int)(sizeof(gRegNames) / sizeof(RegNameType))
+
+static void instrSigHandler(int sig)
+{
+	(void)sig;
+	gStatsDumpReq = 1;
+}
+
+static void instrAtExit(void)
+{
+	i2cStatsDump(gStatsFile != NULL ? gStatsFile : stderr);
+	if (gStatsFile != NULL)
+	{
+		fclose(gStatsFile);
+	}
+}
+
+static int envFlag(const char *name, const char **val)
+{
+	const char *env = getenv(name);
+
+	*val = env;
+	if ( (env == NULL) || (env[0] == 0) || (strcmp(env, "0") == 0))
+	{
+		return 0;
+	}
+	return 1;
+}
+
+static void instrInit(void)
+{
+	const char *val = NULL;
+
+	gInstr = INSTR_INIT;
+	clock_gettime(CLOCK_MONOTONIC, &gInstrStart);
+	if (envFlag("IOPLUS_TRACE", &val))
+	{
+		gInstr |= INSTR_TRACE;
+	}
+	if (envFlag("IOPLUS_STATS", &val))
+	{
+		gInstr |= INSTR_STATS;
+		if (val[0] == '/')
+		{
+			gStatsFile = fopen(val, "a");
+		}
+		signal(SIGUSR1, instrSigHandler);
+		atexit(instrAtExit);
+	}
+}
+
+static inline u32 usSince(const struct timespec *start)
+{
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (u32) ( (now.tv_sec - start->tv_sec) * 1000000
+		+ (now.tv_nsec - start->tv_nsec) / 1000);
+}
+
+/*
+ * HDR style log-linear bucket: values below HIST_SUB_CNT get their own bucket,
+ * above that every power of two is split in HIST_SUB_CNT linear sub-buckets
+ * (relative error < 25%)
+ */
+static int histIndex(u32 us)
+{
+	int exp = 31 - __builtin_clz(us | 1);
+
+	if (us < HIST_SUB_CNT)
+	{
+		return (int)us;
+	}
+	return HIST_SUB_CNT + (exp - HIST_SUB_BITS) * HIST_SUB_CNT
+		+ (int) ( (us >> (exp - HIST_SUB_BITS)) & (HIST_SUB_CNT - 1));
+}
+
+static u32 histValue(int idx)
+{
+	int exp;
+
+	if (idx < HIST_SUB_CNT)
+	{
+		return (u32)idx;
+	}
+	exp = (idx - HIST_SUB_CNT) / HIST_SUB_CNT + HIST_SUB_BITS;
+	return (u32) (HIST_SUB_CNT + (idx - HIST_SUB_CNT) % HIST_SUB_CNT)
+		<< (exp - HIST_SUB_BITS);
+}
+
+static u32 histPercentile(const I2cOpStatType *op, int perMille)
+{
+	uint64_t target = ((uint64_t)op->count * perMille + 999) / 1000;
+	uint64_t acc = 0;
+	int i;
+
+	for (i = 0; i < HIST_BUCKETS; i++)
+	{
+		acc += op->hist[i];
+		if (acc >= target && acc > 0)
+		{
+			return histValue(i);
+		}
+	}
+	return 0;
+}
+
+const char* i2cRegName(int add, int *offset)
+{
+	int i;
+
+	for (i = REG_NAMES_NO - 1; i >= 0; i--)
+	{
+		if (gRegNames[i].add <= add)
+		{
+			*offset = add - gRegNames[i].add;
+			return gRegNames[i].name;
+		}
+	}
+	*offset = add;
+	return "MEM";
+}
+
+static void instrTrace(int dev, int op, int add, const u8 *buff, int size,
+	int ret, u32 us)
+{
+	struct timespec now;
+	int64_t t;
+	int offset = 0;
+	const char *name = i2cRegName(add, &offset);
+	int i;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	t = (int64_t) (now.tv_sec - gInstrStart.tv_sec) * 1000000
+		+ (now.tv_nsec - gInstrStart.tv_nsec) / 1000;
+	fprintf(stderr, "[%5lld.%06lld] %s(0x%02x, %s", (long long) (t / 1000000),
+		(long long) (t % 1000000), gOpName[op],
+		(dev >= 0 && dev < I2C_DEV_FD_MAX) ? gDevAdd[dev] : 0, name);
+	if (offset != 0)
+	{
+		fprintf(stderr, "+%d", offset);
+	}
+	fprintf(stderr, ", %d) = ", size);
+	if (ret != 0)
+	{
+		fprintf(stderr, "-1 FAIL");
+	}
+	else
+	{
+		fprintf(stderr, "[");
+		for (i = 0; (i < size) && (i < 16); i++)
+		{
+			fprintf(stderr, i == 0 ? "%02x" : " %02x", buff[i]);
+		}
+		fprintf(stderr, size > 16 ? " ...]" : "]");
+	}
+	fprintf(stderr, " <%u us>\n", us);
+}
+
+static void instrDump(FILE *f);
+
+static void instrRecord(int dev, int op, int add, const u8 *buff, int size,
+	int ret, u32 us)
+{
+	I2cOpStatType *opS = &gOpStat[op];
+	I2cRegStatType *reg = &gRegStat[add & SLAVE_BUFF_SIZE];
+
+	if (gInstr & INSTR_STATS)
+	{
+		pthread_mutex_lock(&gInstrLock);
+		opS->count++;
+		opS->totalUs += us;
+		if (us > opS->maxUs)
+		{
+			opS->maxUs = us;
+		}
+		opS->hist[histIndex(us)]++;
+		if (ret != 0)
+		{
+			opS->errors++;
+			reg->errors++;
+		}
+		else
+		{
+			opS->bytes += size;
+		}
+		if (op == I2C_OP_READ)
+		{
+			reg->rdCount++;
+			reg->rdBytes += ret == 0 ? size : 0;
+		}
+		else
+		{
+			reg->wrCount++;
+			reg->wrBytes += ret == 0 ? size : 0;
+		}
+		if (gStatsDumpReq)
+		{
+			gStatsDumpReq = 0;
+			instrDump(gStatsFile != NULL ? gStatsFile : stderr);
+		}
+		pthread_mutex_unlock(&gInstrLock);
+	}
+	if (gInstr & INSTR_TRACE)
+	{
+		instrTrace(dev, op, add, buff, size, ret, us);
+	}
+}
+
+static void instrAntiSpurious(int add, int reads, int ok)
+{
+	if (gInstr & INSTR_STATS)
+	{
+		pthread_mutex_lock(&gInstrLock);
+		gAsReads += reads;
+		if (reads > 2)
+		{
+			gAsRetries += reads - 2;
+			gRegStat[add & SLAVE_BUFF_SIZE].retries += reads - 2;
+		}
+		if (!ok)
+		{
+			gAsFails++;
+		}
+		pthread_mutex_unlock(&gInstrLock);
+	}
+}
+
+#define INSTR_ON	__builtin_expect(gInstr & (INSTR_STATS | INSTR_TRACE), 0)
+#define INSTR_START(T)	\
+	do { if (INSTR_ON) clock_gettime(CLOCK_MONOTONIC, &T); } while (0)
+#define INSTR_END(DEV, OP, ADD, BUFF, SIZE, RET, T)	\
+	do { if (INSTR_ON) instrRecord(DEV, OP, ADD, BUFF, SIZE, RET, usSince(&T)); } while (0)
+#define INSTR_AS(ADD, READS, OK)	\
+	do { if (INSTR_ON) instrAntiSpurious(ADD, READS, OK); } while (0)
+
+void i2cStatsEnable(int enable)
+{
+	if (0 == (gInstr & INSTR_INIT))
+	{
+		instrInit();
+	}
+	if (enable)
+	{
+		gInstr |= INSTR_STATS;
+	}
+	else
+	{
+		gInstr &= ~INSTR_STATS;
+	}
+}
+
+void i2cTraceEnable(int enable)
+{
+	if (0 == (gInstr & INSTR_INIT))
+	{
+		instrInit();
+	}
+	if (enable)
+	{
+		gInstr |= INSTR_TRACE;
+	}
+	else
+	{
+		gInstr &= ~INSTR_TRACE;
+	}
+}
+
+void i2cStatsReset(void)
+{
+	pthread_mutex_lock(&gInstrLock);
+	memset(gOpStat, 0, sizeof(gOpStat));
+	memset(gRegStat, 0, sizeof(gRegStat));
+	gAsReads = 0;
+	gAsRetries = 0;
+	gAsFails = 0;
+	pthread_mutex_unlock(&gInstrLock);
+}
+
+int i2cStatsGet(int op, I2cStatType *stat)
+{
+	const I2cOpStatType *opS;
+
+	if ( (op < 0) || (op >= I2C_OP_NO) || (NULL == stat))
+	{
+		return -1;
+	}
+	opS = &gOpStat[op];
+	pthread_mutex_lock(&gInstrLock);
+	stat->count = opS->count;
+	stat->errors = opS->errors;
+	stat->bytes = opS->bytes;
+	stat->totalUs = opS->totalUs;
+	stat->maxUs = opS->maxUs;
+	stat->p50Us = histPercentile(opS, 500);
+	stat->p99Us = histPercentile(opS, 990);
+	stat->asRetries = gAsRetries;
+	pthread_mutex_unlock(&gInstrLock);
+	return 0;
+}
+
+void i2cStatsDump(FILE *f)
+{
+	if (NULL != f)
+	{
+		pthread_mutex_lock(&gInstrLock);
+		instrDump(f);
+		pthread_mutex_unlock(&gInstrLock);
+	}
+}
+
+/* gInstrLock held */
+static void instrDump(FILE *f)
+{
+	int i;
+	int offset;
+	const char *name;
+	const I2cOpStatType *op;
+
+	fprintf(f, "# ioplus i2c statistics\n");
+	fprintf(f, "%-6s %10s %8s %12s %10s %8s %8s %8s %8s\n", "op", "count",
+		"errors", "bytes", "avg_us", "p50_us", "p90_us", "p99_us", "max_us");
+	for (i = 0; i < I2C_OP_NO; i++)
+	{
+		op = &gOpStat[i];
+		fprintf(f, "%-6s %10u %8u %12llu %10.1f %8u %8u %8u %8u\n", gOpName[i],
+			op->count, op->errors, (unsigned long long)op->bytes,
+			op->count ? (double)op->totalUs / op->count : 0.0,
+			histPercentile(op, 500), histPercentile(op, 900),
+			histPercentile(op, 990), op->maxUs);
+	}
+	fprintf(f, "anti-spurious reads %u, retries %u, failures %u\n", gAsReads,
+		gAsRetries, gAsFails);
+	fprintf(f, "%-4s %-28s %8s %10s %8s %10s %8s %8s\n", "add", "register",
+		"reads", "rd_bytes", "writes", "wr_bytes", "retries", "errors");
+	for (i = 0; i <= SLAVE_BUFF_SIZE; i++)
+	{
+		const I2cRegStatType *reg = &gRegStat[i];
+		char regName[40];
+
+		if (reg->rdCount == 0 && reg->wrCount == 0)
+		{
+			continue;
+		}
+		name = i2cRegName(i, &offset);
+		if (offset)
+		{
+			snprintf(regName, sizeof(regName), "%s+%d", name, offset);
+		}
+		else
+		{
+			snprintf(regName, sizeof(regName), "%s", name);
+		}
+		fprintf(f, "0x%02x %-28s %8u %10llu %8u %10llu %8u %8u\n", i, regName,
+			reg->rdCount, (unsigned long long)reg->rdBytes, reg->wrCount,
+			(unsigned long long)reg->wrBytes, reg->retries, reg->errors);
+	}
+	fprintf(f, "latency histogram (us, read/write)\n");
+	for (i = 0; i < HIST_BUCKETS; i++)
+	{
+		if (gOpStat[I2C_OP_READ].hist[i] || gOpStat[I2C_OP_WRITE].hist[i])
+		{
+			fprintf(f, ">=%-8u %10u %10u\n", histValue(i),
+				gOpStat[I2C_OP_READ].hist[i], gOpStat[I2C_OP_WRITE].hist[i]);
+		}
+	}
+	fflush(f);
+}
+
+#else
+#define INSTR_START(T)
+#define INSTR_END(DEV, OP, ADD, BUFF, SIZE, RET, T)
+#define INSTR_AS(ADD, READS, OK)
+
+void i2cStatsEnable(int enable)
+{
+	(void)enable;
+}
+
+void i2cTraceEnable(int enable)
+{
+	(void)enable;
+}
+
+void i2cStatsReset(void)
+{
+}
+
+int i2cStatsGet(int op, I2cStatType *stat)
+{
+	(void)op;
+	if (NULL != stat)
+	{
+		memset(stat, 0, sizeof(I2cStatType));
+	}
+	return -1;
+}
+
+void i2cStatsDump(FILE *f)
+{
+	(void)f;
+}
+
+const char* i2cRegName(int add, int *offset)
+{
+	*offset = add;
+	return "MEM";
+}
+#endif //I2C_INSTRUMENT
+
+static int i2cOpenBus(int bus, int addr, int verbose)
 {
 	int file;
 	char filename[40];
-	sprintf(filename, "/dev/i2c-1");
 
+	snprintf(filename, sizeof(filename), "/dev/i2c-%d", bus);
 	if ( (file = open(filename, O_RDWR)) < 0)
 	{
-		printf("Failed to open the bus.");
+		if (verbose)
+		{
+			printf("Failed to open the bus.");
+		}
 		return -1;
 	}
 	if (ioctl(file, I2C_SLAVE, addr) < 0)
 	{
-		printf("Failed to acquire bus access and/or talk to slave.\n");
+		if (verbose)
+		{
+			printf("Failed to acquire bus access and/or talk to slave.\n");
+		}
+		close(file);
 		return -1;
 	}
-
+	if (file < I2C_DEV_FD_MAX)
+	{
+		pthread_mutex_lock(&gWedgeLock);
+		gDevAdd[file] = (u8)addr;
+		gDevBus[file] = (u8) (bus + 1);
+		pthread_mutex_unlock(&gWedgeLock);
+	}
+#ifdef I2C_INSTRUMENT
+	if (0 == (gInstr & INSTR_INIT))
+	{
+		instrInit();
+	}
+#endif
 	return file;
 }
 
+int i2cSetup(int addr)
+{
+	return i2cOpenBus(1, addr, 1);
+}
+
+/*
+ * i2cOpen:
+ *	Open the I2C adapter /dev/i2c-<bus> and select the slave without printing,
+ *	returns the file descriptor or -1
+ */
+int i2cOpen(int bus, int addr)
+{
+	return i2cOpenBus(bus, addr, 0);
+}
+
+void i2cClose(int dev)
+{
+	if (dev >= 0)
+	{
+		// a recovery must not reopen the number once it is free for reuse
+		pthread_mutex_lock(&gWedgeLock);
+		if (dev < I2C_DEV_FD_MAX)
+		{
+			gDevBus[dev] = 0;
+		}
+		close(dev);
+		pthread_mutex_unlock(&gWedgeLock);
+	}
+}
+
+static int gBusHeld = 0;
+
+/*
+ * i2cBusLock:
+ *	Take the named semaphore the Sequent Microsystems programs share for the
+ *	bus, SEM_FAILED (nothing to release) when the caller already holds it
+ */
+sem_t* i2cBusLock(void)
+{
+	sem_t *sem;
+
+	if (gBusHeld)
+	{
+		return SEM_FAILED;
+	}
+	sem = sem_open(BUS_SEM_NAME, O_CREAT, 0000666, 3);
+
+	if (sem != SEM_FAILED)
+	{
+		sem_wait(sem);
+	}
+	return sem;
+}
+
+void i2cBusUnlock(sem_t *sem)
+{
+	if (sem != SEM_FAILED)
+	{
+		sem_post(sem);
+		sem_close(sem);
+	}
+}
+
+void i2cBusLockHeld(int held)
+{
+	gBusHeld = held;
+}
+
+/*
+ * Circuit breaker, one per card: once <errors> transfers failed in a row the
+ * card is skipped, I2C_ERR_OPEN without touching the bus, so a missing or hung
+ * card does not cost a NACK or a timeout to every poll. One probe transfer is
+ * let through after probeMs, the wait doubles after every failed probe up to
+ * probeMaxMs and the first good transfer closes the circuit again.
+ * While on, the last good value of every byte read is kept for
+ * i2cMem8ReadLast(). One predicted branch per transfer when off.
+ */
+#define BRK_CARD_NO	8 // SLAVE_OWN_ADDRESS_BASE + stack level
+#define BRK_MAP_SIZE	(SLAVE_BUFF_SIZE + 1)
+
+typedef struct
+{
+	I2cHealthType h;
+	uint64_t probeMs; // when the next probe is let through
+	u32 valid[(BRK_MAP_SIZE + 31) / 32]; // bytes read at least once
+	u32 stamp[BRK_MAP_SIZE]; // ms of the last good read of the byte
+	u8 img[BRK_MAP_SIZE];
+} BrkCardType;
+
+static int gBrkErrors = 0;
+static u32 gBrkProbeMs = 0;
+static u32 gBrkProbeMaxMs = 0;
+static BrkCardType gBrkCard[BRK_CARD_NO];
+static pthread_mutex_t gBrkLock = PTHREAD_MUTEX_INITIALIZER;
+
+static uint64_t brkNowMs(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+static BrkCardType* brkCard(int dev)
+{
+	int idx;
+
+	if ( (dev < 0) || (dev >= I2C_DEV_FD_MAX))
+	{
+		return NULL;
+	}
+	idx = gDevAdd[dev] - SLAVE_OWN_ADDRESS_BASE;
+	if ( (idx < 0) || (idx >= BRK_CARD_NO))
+	{
+		return NULL;
+	}
+	return &gBrkCard[idx];
+}
+
+/* 0 when the transfer may go on the bus, I2C_ERR_OPEN when skipped */
+static int brkBefore(BrkCardType *c)
+{
+	int ret = 0;
+
+	pthread_mutex_lock(&gBrkLock);
+	if (c->h.state == I2C_BRK_OPEN && brkNowMs() >= c->probeMs)
+	{
+		c->h.state = I2C_BRK_HALF_OPEN;
+		c->h.probes++;
+	}
+	else if (c->h.state != I2C_BRK_CLOSED)
+	{
+		// still waiting, or an other thread is probing
+		c->h.skipped++;
+		ret = I2C_ERR_OPEN;
+	}
+	pthread_mutex_unlock(&gBrkLock);
+	return ret;
+}
+
+/* transfer result, buff not NULL for a good read to keep */
+static void brkAfter(BrkCardType *c, int ok, int add, const u8 *buff, int size)
+{
+	u32 now;
+	int i;
+
+	pthread_mutex_lock(&gBrkLock);
+	if (ok)
+	{
+		c->h.state = I2C_BRK_CLOSED;
+		c->h.errors = 0;
+		c->h.backoffMs = 0;
+		if ( (NULL != buff) && (add >= 0) && (add + size <= BRK_MAP_SIZE))
+		{
+			now = (u32)brkNowMs();
+			memcpy(&c->img[add], buff, size);
+			for (i = add; i < add + size; i++)
+			{
+				c->valid[i / 32] |= 1u << (i % 32);
+				c->stamp[i] = now;
+			}
+		}
+	}
+	else
+	{
+		c->h.errors++;
+		if (c->h.state == I2C_BRK_HALF_OPEN)
+		{
+			c->h.backoffMs *= 2;
+			if (c->h.backoffMs > gBrkProbeMaxMs)
+			{
+				c->h.backoffMs = gBrkProbeMaxMs;
+			}
+			c->h.state = I2C_BRK_OPEN;
+			c->probeMs = brkNowMs() + c->h.backoffMs;
+		}
+		else if ( (c->h.state == I2C_BRK_CLOSED)
+			&& (c->h.errors >= (u32)gBrkErrors))
+		{
+			c->h.trips++;
+			c->h.backoffMs = gBrkProbeMs;
+			c->h.state = I2C_BRK_OPEN;
+			c->probeMs = brkNowMs() + c->h.backoffMs;
+		}
+	}
+	pthread_mutex_unlock(&gBrkLock);
+}
+
+/* close every circuit, the errors were not the cards' fault */
+static void brkCloseAll(void)
+{
+	int i;
+
+	pthread_mutex_lock(&gBrkLock);
+	for (i = 0; i < BRK_CARD_NO; i++)
+	{
+		gBrkCard[i].h.state = I2C_BRK_CLOSED;
+		gBrkCard[i].h.errors = 0;
+		gBrkCard[i].h.backoffMs = 0;
+	}
+	pthread_mutex_unlock(&gBrkLock);
+}
+
+/*
+ * i2cBreakerSet:
+ *	Skip a card after <errors> failed transfers in a row, 0 turns the breakers
+ *	off and closes them
+ */
+void i2cBreakerSet(int errors, uint32_t probeMs, uint32_t probeMaxMs)
+{
+	pthread_mutex_lock(&gBrkLock);
+	gBrkErrors = (errors > 0) ? errors : 0;
+	gBrkProbeMs = (probeMs > 0) ? probeMs : 1;
+	gBrkProbeMaxMs = (probeMaxMs > gBrkProbeMs) ? probeMaxMs : gBrkProbeMs;
+	pthread_mutex_unlock(&gBrkLock);
+	if (errors <= 0)
+	{
+		brkCloseAll();
+	}
+}
+
+int i2cHealthGet(int dev, I2cHealthType *health)
+{
+	BrkCardType *c = brkCard(dev);
+
+	if ( (NULL == c) || (NULL == health))
+	{
+		return -1;
+	}
+	pthread_mutex_lock(&gBrkLock);
+	*health = c->h;
+	pthread_mutex_unlock(&gBrkLock);
+	return 0;
+}
+
+/* close the circuit of the card and forget its counters and last values */
+void i2cHealthReset(int dev)
+{
+	BrkCardType *c = brkCard(dev);
+
+	if (NULL != c)
+	{
+		pthread_mutex_lock(&gBrkLock);
+		memset(c, 0, sizeof(BrkCardType));
+		pthread_mutex_unlock(&gBrkLock);
+	}
+}
+
+/*
+ * i2cMem8ReadLast:
+ *	i2cMem8Read() falling back on the last good values when the read fails or
+ *	the card is skipped: returns 1 with the age of the oldest byte in ageMs
+ *	(1 at least, 0 for a fresh read), the read error when one of the bytes
+ *	was never read
+ */
+int i2cMem8ReadLast(int dev, int add, uint8_t* buff, int size, uint32_t *ageMs)
+{
+	BrkCardType *c;
+	u32 now;
+	u32 age = 0;
+	int ret;
+	int i;
+
+	if (NULL == ageMs)
+	{
+		return -1;
+	}
+	*ageMs = 0;
+	ret = i2cMem8Read(dev, add, buff, size);
+	c = brkCard(dev);
+	if ( (ret == 0) || (NULL == c) || (NULL == buff) || (add < 0)
+		|| (size < 1) || (add + size > BRK_MAP_SIZE))
+	{
+		return ret;
+	}
+	pthread_mutex_lock(&gBrkLock);
+	now = (u32)brkNowMs();
+	for (i = add; i < add + size; i++)
+	{
+		if (0 == (c->valid[i / 32] & (1u << (i % 32))))
+		{
+			pthread_mutex_unlock(&gBrkLock);
+			return ret;
+		}
+		if (now - c->stamp[i] > age)
+		{
+			age = now - c->stamp[i];
+		}
+	}
+	memcpy(buff, &c->img[add], size);
+	pthread_mutex_unlock(&gBrkLock);
+	*ageMs = (age > 0) ? age : 1;
+	return 1;
+}
+
+/*
+ * Bus wedge recovery: a slave holding SDA low or a hung controller fails every
+ * transfer, to every card, with EIO or ETIMEDOUT. After <errors> of them in a
+ * row (a good transfer or a NACK resets the count), coming from two cards at
+ * least when more than one is open, the I2C descriptors of the process are
+ * reopened in place and a card is probed. A lone card failing is left to its
+ * circuit breaker. If the bus is still
+ * stuck and the step allows it, the adapter driver is unbound and bound again
+ * through sysfs, which resets the controller and its pins; user space has
+ * no other way to start the kernel bus recovery. A recovery lasts at most
+ * WEDGE_RECOVER_MAX_MS plus one transfer timeout, is timed, and is not tried
+ * again before a holdoff that doubles after every failure.
+ */
+#define WEDGE_RECOVER_MAX_MS	1000
+#define WEDGE_HOLDOFF_MS	100
+#define WEDGE_HOLDOFF_MAX_MS	10000
+#define WEDGE_NODE_POLL_US	1000 // wait for /dev/i2c-<bus> after a rebind
+
+static int gWedgeErrors = 0;
+static int gWedgeStep = I2C_RECOVER_REOPEN;
+static u32 gWedgeRun = 0; // bus errors in a row
+static int gWedgeRunAdd = 0; // slave of the first error of the run
+static int gWedgeRunCards = 0; // 2 once another slave failed in the run
+static int gWedgeBusy = 0;
+static uint64_t gWedgeNextMs = 0; // no recovery before
+static u32 gWedgeHoldoffMs = WEDGE_HOLDOFF_MS;
+static I2cRecoverStatType gWedgeStat;
+
+/* new descriptors on the same numbers, the callers keep theirs; gWedgeLock
+ * held so i2cClose() can not free a number meanwhile */
+static int wedgeReopen(int bus)
+{
+	char filename[40];
+	int fd;
+	int file;
+
+	snprintf(filename, sizeof(filename), "/dev/i2c-%d", bus);
+	for (fd = 0; fd < I2C_DEV_FD_MAX; fd++)
+	{
+		if (gDevBus[fd] != bus + 1)
+		{
+			continue;
+		}
+		file = open(filename, O_RDWR);
+		if (file < 0)
+		{
+			return -1;
+		}
+		if ( (ioctl(file, I2C_SLAVE, gDevAdd[fd]) < 0) || (dup2(file, fd) < 0))
+		{
+			close(file);
+			return -1;
+		}
+		close(file);
+	}
+	return 0;
+}
+
+/* one card answering is enough, a NACK moves to the next one; gWedgeLock
+ * held */
+static int wedgeProbe(int bus)
+{
+	u8 add = I2C_MEM_REVISION_HW_MAJOR_ADD;
+	u8 val;
+	int fd;
+
+	for (fd = 0; fd < I2C_DEV_FD_MAX; fd++)
+	{
+		if (gDevBus[fd] != bus + 1)
+		{
+			continue;
+		}
+		if ( (write(fd, &add, 1) == 1) && (read(fd, &val, 1) == 1))
+		{
+			return 0;
+		}
+		if ( (errno == EIO) || (errno == ETIMEDOUT))
+		{
+			return -1;
+		}
+	}
+	return -1;
+}
+
+static int wedgeSysWrite(const char *path, const char *val)
+{
+	int fd = open(path, O_WRONLY);
+	int ret;
+
+	if (fd < 0)
+	{
+		return -1;
+	}
+	ret = (write(fd, val, strlen(val)) == (ssize_t)strlen(val)) ? 0 : -1;
+	close(fd);
+	return ret;
+}
+
+static int wedgeRebind(int bus, uint64_t deadlineMs)
+{
+	char path[PATH_MAX + 16];
+	char dev[PATH_MAX];
+	char drv[PATH_MAX];
+	const char *name;
+
+	snprintf(path, sizeof(path), "/sys/class/i2c-adapter/i2c-%d/device", bus);
+	if (NULL == realpath(path, dev))
+	{
+		return -1;
+	}
+	snprintf(path, sizeof(path), "%s/driver", dev);
+	if (NULL == realpath(path, drv))
+	{
+		return -1;
+	}
+	name = strrchr(dev, '/') + 1;
+	snprintf(path, sizeof(path), "%s/unbind", drv);
+	if (0 != wedgeSysWrite(path, name))
+	{
+		return -1;
+	}
+	snprintf(path, sizeof(path), "%s/bind", drv);
+	if (0 != wedgeSysWrite(path, name))
+	{
+		return -1;
+	}
+	// the adapter node is back once the driver probed
+	snprintf(path, sizeof(path), "/dev/i2c-%d", bus);
+	while (0 != access(path, R_OK | W_OK))
+	{
+		if (brkNowMs() >= deadlineMs)
+		{
+			return -1;
+		}
+		usleep(WEDGE_NODE_POLL_US);
+	}
+	return 0;
+}
+
+static int wedgeReopenProbe(int bus)
+{
+	int ret;
+
+	pthread_mutex_lock(&gWedgeLock);
+	ret = wedgeReopen(bus);
+	if (0 == ret)
+	{
+		ret = wedgeProbe(bus);
+	}
+	pthread_mutex_unlock(&gWedgeLock);
+	return ret;
+}
+
+static int wedgeRecover(int bus, int step)
+{
+	struct timespec t0;
+	struct timespec t1;
+	uint64_t deadlineMs = brkNowMs() + WEDGE_RECOVER_MAX_MS;
+	int done = I2C_RECOVER_REOPEN;
+	int ret;
+	u32 us;
+
+	pthread_mutex_lock(&gWedgeLock);
+	if (gWedgeBusy)
+	{
+		pthread_mutex_unlock(&gWedgeLock);
+		return -1;
+	}
+	gWedgeBusy = 1;
+	pthread_mutex_unlock(&gWedgeLock);
+
+	clock_gettime(CLOCK_MONOTONIC, &t0);
+	ret = wedgeReopenProbe(bus);
+	if ( (0 != ret) && (step >= I2C_RECOVER_REBIND)
+		&& (brkNowMs() < deadlineMs))
+	{
+		done = I2C_RECOVER_REBIND;
+		ret = wedgeRebind(bus, deadlineMs);
+		if (0 == ret)
+		{
+			ret = wedgeReopenProbe(bus);
+		}
+	}
+	clock_gettime(CLOCK_MONOTONIC, &t1);
+	us = (u32) ( (t1.tv_sec - t0.tv_sec) * 1000000
+		+ (t1.tv_nsec - t0.tv_nsec) / 1000);
+	if (0 == ret)
+	{
+		brkCloseAll();
+	}
+
+	pthread_mutex_lock(&gWedgeLock);
+	if (0 == ret)
+	{
+		gWedgeStat.recovered++;
+		gWedgeHoldoffMs = WEDGE_HOLDOFF_MS;
+	}
+	else
+	{
+		gWedgeStat.failed++;
+		gWedgeHoldoffMs *= 2;
+		if (gWedgeHoldoffMs > WEDGE_HOLDOFF_MAX_MS)
+		{
+			gWedgeHoldoffMs = WEDGE_HOLDOFF_MAX_MS;
+		}
+	}
+	gWedgeStat.lastUs = us;
+	if (us > gWedgeStat.maxUs)
+	{
+		gWedgeStat.maxUs = us;
+	}
+	gWedgeStat.lastStep = done;
+	gWedgeNextMs = brkNowMs() + gWedgeHoldoffMs;
+	gWedgeRun = 0;
+	gWedgeBusy = 0;
+	pthread_mutex_unlock(&gWedgeLock);
+	return ret;
+}
+
+/* slaves open on bus, up to 2; gWedgeLock held */
+static int wedgeCards(int bus)
+{
+	int add = -1;
+	int fd;
+
+	for (fd = 0; fd < I2C_DEV_FD_MAX; fd++)
+	{
+		if (gDevBus[fd] != bus + 1)
+		{
+			continue;
+		}
+		if ( (add >= 0) && (gDevAdd[fd] != add))
+		{
+			return 2;
+		}
+		add = gDevAdd[fd];
+	}
+	return (add >= 0) ? 1 : 0;
+}
+
+/* transfer result, err the errno of a failed one */
+static void wedgeAfter(int dev, int ok, int err)
+{
+	int bus = -1;
+
+	pthread_mutex_lock(&gWedgeLock);
+	if (ok || ( (err != EIO) && (err != ETIMEDOUT)))
+	{
+		gWedgeRun = 0;
+	}
+	else if ( (dev >= 0) && (dev < I2C_DEV_FD_MAX) && (gDevBus[dev] != 0))
+	{
+		if (gWedgeRun++ == 0)
+		{
+			gWedgeRunAdd = gDevAdd[dev];
+			gWedgeRunCards = 1;
+		}
+		else if (gDevAdd[dev] != gWedgeRunAdd)
+		{
+			gWedgeRunCards = 2;
+		}
+		if ( (gWedgeRun >= (u32)gWedgeErrors) && !gWedgeBusy
+			&& (brkNowMs() >= gWedgeNextMs)
+			&& ( (gWedgeRunCards > 1) || (wedgeCards(gDevBus[dev] - 1) < 2)))
+		{
+			gWedgeStat.wedges++;
+			bus = gDevBus[dev] - 1;
+		}
+	}
+	pthread_mutex_unlock(&gWedgeLock);
+	if (bus >= 0)
+	{
+		wedgeRecover(bus, gWedgeStep);
+	}
+}
+
+/*
+ * i2cRecoverSet:
+ *	Recover the bus after <errors> EIO / ETIMEDOUT failures in a row from two
+ *	cards or more, up to <step> (I2C_RECOVER_REOPEN or I2C_RECOVER_REBIND),
+ *	errors 0 for off
+ */
+void i2cRecoverSet(int errors, int step)
+{
+	pthread_mutex_lock(&gWedgeLock);
+	gWedgeErrors = (errors > 0) ? errors : 0;
+	gWedgeStep = step;
+	gWedgeRun = 0;
+	pthread_mutex_unlock(&gWedgeLock);
+}
+
+/* recover now, whatever the holdoff, 0 when a card answers afterwards */
+int i2cRecover(int bus, int step)
+{
+	if ( (bus < 0) || (step < I2C_RECOVER_REOPEN))
+	{
+		return -1;
+	}
+	return wedgeRecover(bus, step);
+}
+
+void i2cRecoverStatsGet(I2cRecoverStatType *stat)
+{
+	if (NULL != stat)
+	{
+		pthread_mutex_lock(&gWedgeLock);
+		*stat = gWedgeStat;
+		pthread_mutex_unlock(&gWedgeLock);
+	}
+}
+
 int i2cMem8Read(int dev, int add, uint8_t* buff, int size)
 {
 	uint8_t intBuff[I2C_SMBUS_BLOCK_MAX];
+	BrkCardType *card = NULL;
+	int err = 0;
+	int ret = 0;
+#ifdef I2C_INSTRUMENT
+	struct timespec t0;
+#endif
 
 	if (NULL == buff)
 	{
@@ -76,22 +1197,48 @@ int i2cMem8Read(int dev, int add, uint8_t* buff, int size)
 
 	intBuff[0] = 0xff & add;
 
+	if (__builtin_expect(gBrkErrors > 0, 0))
+	{
+		card = brkCard(dev);
+		if ( (NULL != card) && (0 != brkBefore(card)))
+		{
+			return I2C_ERR_OPEN;
+		}
+	}
+	INSTR_START(t0);
 	if (write(dev, intBuff, 1) != 1)
 	{
 		//printf("Fail to select mem add!\n");
-		return -1;
+		err = errno;
+		ret = -1;
 	}
-	if (read(dev, buff, size) != size)
+	else if (read(dev, buff, size) != size)
 	{
 		//printf("Fail to read memory!\n");
-		return -1;
+		err = errno;
+		ret = -1;
+	}
+	INSTR_END(dev, I2C_OP_READ, add, buff, size, ret, t0);
+	if (NULL != card)
+	{
+		brkAfter(card, ret == 0, add, buff, size);
 	}
-	return 0; //OK
+	if (__builtin_expect(gWedgeErrors > 0, 0))
+	{
+		wedgeAfter(dev, ret == 0, err);
+	}
+	return ret; //0 = OK
 }
 
 int i2cMem8Write(int dev, int add, uint8_t* buff, int size)
 {
 	uint8_t intBuff[I2C_SMBUS_BLOCK_MAX];
+	BrkCardType *card = NULL;
+	int err = 0;
+	int ret = 0;
+#ifdef I2C_INSTRUMENT
+	struct timespec t0;
+#endif
 
 	if (NULL == buff)
 	{
@@ -106,12 +1253,31 @@ int i2cMem8Write(int dev, int add, uint8_t* buff, int size)
 	intBuff[0] = 0xff & add;
 	memcpy(&intBuff[1], buff, size);
 
+	if (__builtin_expect(gBrkErrors > 0, 0))
+	{
+		card = brkCard(dev);
+		if ( (NULL != card) && (0 != brkBefore(card)))
+		{
+			return I2C_ERR_OPEN;
+		}
+	}
+	INSTR_START(t0);
 	if (write(dev, intBuff, size + 1) != size + 1)
 	{
 		//printf("Fail to write memory!\n");
-		return -1;
+		err = errno;
+		ret = -1;
 	}
-	return 0;
+	INSTR_END(dev, I2C_OP_WRITE, add, buff, size, ret, t0);
+	if (NULL != card)
+	{
+		brkAfter(card, ret == 0, add, NULL, 0);
+	}
+	if (__builtin_expect(gWedgeErrors > 0, 0))
+	{
+		wedgeAfter(dev, ret == 0, err);
+	}
+	return ret;
 }
 #define SPURIOUS_RETRY	10 
 int i2cReadByteAS(int dev, int add, uint8_t* val)
@@ -126,9 +1292,11 @@ int i2cReadByteAS(int dev, int add, uint8_t* val)
 		valA = read;
 		if (0 != i2cMem8Read(dev, add, &read, 1))
 		{
+			INSTR_AS(add, SPURIOUS_RETRY - retry, 0);
 			return -1;
 		}
 	}
+	INSTR_AS(add, SPURIOUS_RETRY - retry, retry != 0);
 	if (retry == 0)
 	{
 		return -1;
@@ -150,10 +1318,12 @@ int i2cReadWordAS(int dev, int add, uint16_t* val)
 		valA = read;
 		if (0 != i2cMem8Read(dev, add, buff, 2))
 		{
+			INSTR_AS(add, SPURIOUS_RETRY - retry, 0);
 			return -1;
 		}
 		memcpy(&read, buff, 2);
 	}
+	INSTR_AS(add, SPURIOUS_RETRY - retry, retry != 0);
 	if (retry == 0)
 	{
 		return -1;
@@ -176,10 +1346,12 @@ int i2cReadDWordAS(int dev, int add, uint32_t* val)
 		valA = read;
 		if (0 != i2cMem8Read(dev, add, buff, 4))
 		{
+			INSTR_AS(add, SPURIOUS_RETRY - retry, 0);
 			return -1;
 		}
 		memcpy(&read, buff, 4);
 	}
+	INSTR_AS(add, SPURIOUS_RETRY - retry, retry != 0);
 	if (retry == 0)
 	{
 		return -1;
@@ -216,10 +1388,12 @@ int i2cReadIntAS(int dev, int add, int* val)
 		valA = read;
 		if (0 != i2cMem8Read(dev, add, buff, 4))
 		{
+			INSTR_AS(add, SPURIOUS_RETRY - retry, 0);
 			return -1;
 		}
 		memcpy(&read, buff, 4);
 	}
+	INSTR_AS(add, SPURIOUS_RETRY - retry, retry != 0);
 	if (retry == 0)
 	{
 		return -1;
@@ -227,3 +1401,74 @@ int i2cReadIntAS(int dev, int add, int* val)
 	*val = read;
 	return 0;
 }
+
+/*
+ * i2cMemReadAS:
+ *	Anti-spurious block read, every <width> bytes element (1, 2 or 4) must read
+ *	the same (2 LSB masked for words) in two consecutive transfers.
+ *	Only the elements still unstable keep the loop going, so a block costs the
+ *	same number of transfers as a single value. A failed transfer ends the
+ *	loop with its i2cMem8Read() code, values still changing after the last
+ *	retry give I2C_ERR_SPURIOUS.
+ */
+int i2cMemReadAS(int dev, int add, uint8_t* buff, int size, int width)
+{
+	uint8_t prev[I2C_SMBUS_BLOCK_MAX];
+	uint8_t read[I2C_SMBUS_BLOCK_MAX];
+	uint8_t done[I2C_SMBUS_BLOCK_MAX];
+	uint32_t mask = 0xffffffff;
+	uint32_t a = 0;
+	uint32_t b = 0;
+	int pending = 0;
+	int retry = SPURIOUS_RETRY;
+	int i = 0;
+
+	if ( (NULL == buff) || (size <= 0) || (size > I2C_SMBUS_BLOCK_MAX)
+		|| ( (width != 1) && (width != 2) && (width != 4)) || (size % width))
+	{
+		return -1;
+	}
+	if (width > 1)
+	{
+		mask = 0xfffffffc;
+	}
+	pending = size / width;
+	memset(done, 0, sizeof(done));
+	while ( (pending > 0) && (retry > 0))
+	{
+		retry--;
+		i = i2cMem8Read(dev, add, read, size);
+		if (0 != i)
+		{
+			INSTR_AS(add, SPURIOUS_RETRY - retry, 0);
+			return i;
+		}
+		if (retry < SPURIOUS_RETRY - 1)
+		{
+			for (i = 0; i < size / width; i++)
+			{
+				if (done[i])
+				{
+					continue;
+				}
+				a = 0;
+				b = 0;
+				memcpy(&a, &read[i * width], width);
+				memcpy(&b, &prev[i * width], width);
+				if ( (a & mask) == (b & mask))
+				{
+					memcpy(&buff[i * width], &read[i * width], width);
+					done[i] = 1;
+					pending--;
+				}
+			}
+		}
+		memcpy(prev, read, size);
+	}
+	INSTR_AS(add, SPURIOUS_RETRY - retry, pending == 0);
+	if (pending > 0)
+	{
+		return I2C_ERR_SPURIOUS;
+	}
+	return 0;
+}
@@ -1,8 +1,65 @@
 #ifndef COMM_H_
 #define COMM_H_
 
+#include <stdio.h>
 #include <stdint.h>
+#include <semaphore.h>
 
+#define I2C_OP_READ	0
+#define I2C_OP_WRITE	1
+#define I2C_OP_NO	2
+
+// i2cMem8Read() / i2cMem8Write(): card skipped, its circuit breaker is open
+#define I2C_ERR_OPEN	-2
+// i2cMemReadAS(): transfers good but the values never read the same twice
+#define I2C_ERR_SPURIOUS	-3
+
+#define I2C_BRK_CLOSED	0
+#define I2C_BRK_OPEN	1
+#define I2C_BRK_HALF_OPEN	2
+
+// bus wedge recovery steps, i2cRecoverSet()
+#define I2C_RECOVER_OFF	0
+#define I2C_RECOVER_REOPEN	1 // reopen the adapter
+#define I2C_RECOVER_REBIND	2 // then rebind the adapter driver (root)
+
+typedef struct
+{
+	uint32_t count;
+	uint32_t errors;
+	uint64_t bytes;
+	uint64_t totalUs;
+	uint32_t maxUs;
+	uint32_t p50Us;
+	uint32_t p99Us;
+	uint32_t asRetries;
+} I2cStatType;
+
+typedef struct
+{
+	int state; // I2C_BRK_xxx
+	uint32_t errors; // failed transfers in a row
+	uint32_t trips; // closed to open
+	uint32_t probes; // transfers let through after a wait
+	uint32_t skipped; // transfers refused while open
+	uint32_t backoffMs; // wait before the next probe
+} I2cHealthType;
+
+typedef struct
+{
+	uint32_t wedges; // runs of bus errors detected
+	uint32_t recovered; // recoveries after which a card answered
+	uint32_t failed;
+	uint32_t lastUs; // duration of the last recovery
+	uint32_t maxUs;
+	int lastStep; // I2C_RECOVER_xxx that ended the last recovery
+} I2cRecoverStatType;
+
+int i2cOpen(int bus, int addr);
+void i2cClose(int dev);
+sem_t* i2cBusLock(void);
+void i2cBusUnlock(sem_t *sem);
+void i2cBusLockHeld(int held);
 int i2cSetup(int addr);
 int i2cMem8Read(int dev, int add, uint8_t* buff, int size);
 int i2cMem8Write(int dev, int add, uint8_t* buff, int size);
@@ -11,4 +68,24 @@ int i2cReadWordAS(int dev, int add, uint16_t* val);
 int i2cReadDWord(int dev, int add, uint32_t* val);
 int i2cReadDWordAS(int dev, int add, uint32_t* val);
 int i2cReadIntAS(int dev, int add, int* val);
+int i2cMemReadAS(int dev, int add, uint8_t* buff, int size, int width);
+
+// per card circuit breaker, off until i2cBreakerSet() with errors > 0
+void i2cBreakerSet(int errors, uint32_t probeMs, uint32_t probeMaxMs);
+int i2cHealthGet(int dev, I2cHealthType *health);
+void i2cHealthReset(int dev);
+int i2cMem8ReadLast(int dev, int add, uint8_t* buff, int size, uint32_t *ageMs);
+
+// bus wedge detection and recovery, off until i2cRecoverSet() with errors > 0
+void i2cRecoverSet(int errors, int step);
+int i2cRecover(int bus, int step);
+void i2cRecoverStatsGet(I2cRecoverStatType *stat);
+
+// transaction instrumentation (IOPLUS_STATS / IOPLUS_TRACE environment variables)
+void i2cStatsEnable(int enable);
+void i2cTraceEnable(int enable);
+void i2cStatsReset(void);
+int i2cStatsGet(int op, I2cStatType *stat);
+void i2cStatsDump(FILE *f);
+const char* i2cRegName(int add, int *offset);
 #endif //COMM_H_
@@ -9,40 +9,26 @@
 
 int gpioChSet(int dev, u8 channel, OutStateEnumType state)
 {
-	int resp;
-	u8 buff[2];
-
 	if ( (channel < CHANNEL_NR_MIN) || (channel > GPIO_CH_NR_MAX))
 	{
 		printf("Invalid GPIO nr!\n");
 		return ERROR;
 	}
-	if (FAIL == i2cMem8Read(dev, I2C_MEM_GPIO_VAL_ADD, buff, 1))
+	if ( (state != OFF) && (state != ON))
 	{
-		return FAIL;
-	}
-
-	switch (state)
-	{
-	case OFF:
-		buff[0] &= ~ (1 << (channel - 1));
-		resp = i2cMem8Write(dev, I2C_MEM_GPIO_VAL_ADD, buff, 1);
-		break;
-	case ON:
-		buff[0] |= 1 << (channel - 1);
-		resp = i2cMem8Write(dev, I2C_MEM_GPIO_VAL_ADD, buff, 1);
-		break;
-	default:
 		printf("Invalid GPIO state!\n");
 		return ERROR;
-		break;
 	}
-	return resp;
+	if (IOPLUS_OK != ioplusGpioChSet(boardHandle(dev), channel, state))
+	{
+		return FAIL;
+	}
+	return OK;
 }
 
 int gpioChGet(int dev, u8 channel, OutStateEnumType *state)
 {
-	u8 buff[2];
+	int val = 0;
 
 	if (NULL == state)
 	{
@@ -54,166 +40,95 @@ int gpioChGet(int dev, u8 channel, OutStateEnumType *state)
 		printf("Invalid GPIO nr!\n");
 		return ERROR;
 	}
-
-	if (OK != i2cReadByteAS(dev, I2C_MEM_GPIO_VAL_ADD, buff))
+	if (IOPLUS_OK != ioplusGpioChGet(boardHandle(dev), channel, &val))
 	{
 		return ERROR;
 	}
-
-	if (buff[0] & (1 << (channel - 1)))
-	{
-		*state = ON;
-	}
-	else
-	{
-		*state = OFF;
-	}
+	*state = val ? ON : OFF;
 	return OK;
 }
 
 int gpioSet(int dev, int val)
 {
-	u8 buff[2];
-
-	buff[0] = 0xff & val;
-
-	return i2cMem8Write(dev, I2C_MEM_GPIO_VAL_ADD, buff, 1);
+	if (IOPLUS_OK != ioplusGpioSet(boardHandle(dev), 0xff & val))
+	{
+		return FAIL;
+	}
+	return OK;
 }
 
 int gpioGet(int dev, int *val)
 {
-	u8 buff[2];
+	u8 buff = 0;
 
 	if (NULL == val)
 	{
 		return ERROR;
 	}
-
-	if (OK != i2cReadByteAS(dev, I2C_MEM_GPIO_VAL_ADD, buff))
+	if (IOPLUS_OK != ioplusGpioGet(boardHandle(dev), &buff))
 	{
 		return ERROR;
 	}
-	*val = buff[0];
+	*val = buff;
 	return OK;
 }
 
 int gpioChDirSet(int dev, u8 channel, u8 state)
 {
-	int resp;
-	u8 buff[2];
-
 	if ( (channel < CHANNEL_NR_MIN) || (channel > GPIO_CH_NR_MAX))
 	{
 		printf("Invalid GPIO nr!\n");
 		return ERROR;
 	}
-
-	if (OK != i2cReadByteAS(dev, I2C_MEM_GPIO_DIR_ADD, buff))
+	if (state > 1) // 0 - output, 1 - input
 	{
+		printf("Invalid GPIO state!\n");
 		return ERROR;
 	}
-	switch (state)
-	{
-	case 0: //output
-		buff[0] &= ~ (1 << (channel - 1));
-		resp = i2cMem8Write(dev, I2C_MEM_GPIO_DIR_ADD, buff, 1);
-		break;
-	case 1: //input
-		buff[0] |= 1 << (channel - 1);
-		resp = i2cMem8Write(dev, I2C_MEM_GPIO_DIR_ADD, buff, 1);
-		break;
-	default:
-		printf("Invalid GPIO state!\n");
+	if (IOPLUS_OK != ioplusGpioChDirSet(boardHandle(dev), channel, state))
+	{
 		return ERROR;
-		break;
 	}
-	return resp;
+	return OK;
 }
 
 int gpioDirSet(int dev, int val)
 {
-	u8 buff[2];
-
-	buff[0] = 0xff & val;
-
-	return i2cMem8Write(dev, I2C_MEM_GPIO_DIR_ADD, buff, 1);
+	if (IOPLUS_OK != ioplusGpioDirSet(boardHandle(dev), 0xff & val))
+	{
+		return FAIL;
+	}
+	return OK;
 }
 
 int gpioDirGet(int dev, int *val)
 {
-	u8 buff[2];
+	u8 buff = 0;
 
 	if (NULL == val)
 	{
 		return ERROR;
 	}
-
-	if (OK != i2cReadByteAS(dev, I2C_MEM_GPIO_DIR_ADD, buff))
+	if (IOPLUS_OK != ioplusGpioDirGet(boardHandle(dev), &buff))
 	{
 		return ERROR;
 	}
-	*val = buff[0];
+	*val = buff;
 	return OK;
 }
 
 int gpioEdgeGet(int dev, u8 channel, u8 *val)
 {
-	u8 rising = 0;
-	u8 falling = 0;
-
-	if ( (NULL == val) || (channel < CHANNEL_NR_MIN)
-		|| (channel > GPIO_CH_NR_MAX))
+	if (IOPLUS_OK != ioplusGpioEdgeGet(boardHandle(dev), channel, val))
 	{
 		return ERROR;
 	}
-	if (OK != i2cReadByteAS(dev, I2C_MEM_GPIO_EXT_IT_RISING_ADD, &rising))
-	{
-		return ERROR;
-	}
-	if (OK != i2cReadByteAS(dev, I2C_MEM_GPIO_EXT_IT_RISING_ADD + 1, &falling))
-	{
-		return ERROR;
-	}
-	*val = ( ( (1 << (channel - 1)) & rising) == 0 ? 0 : 1);
-	*val += ( ( (1 << (channel - 1)) & falling) == 0 ? 0 : 2);
 	return OK;
 }
 
 int gpioEdgeSet(int dev, u8 channel, u8 val)
 {
-	u8 buff[2];
-	u8 rising = 0;
-	u8 falling = 0;
-
-	if ( (channel < CHANNEL_NR_MIN) || (channel > GPIO_CH_NR_MAX))
-	{
-		return ERROR;
-	}
-	if (FAIL == i2cMem8Read(dev, I2C_MEM_GPIO_EXT_IT_RISING_ADD, buff, 2))
-	{
-		return ERROR;
-	}
-	rising = buff[0];
-	falling = buff[1];
-	if (val & 0x01) //check rising
-	{
-		rising |= 1 << (channel - 1);
-	}
-	else
-	{
-		rising &= ~ (1 << (channel - 1));
-	}
-	if (val & 0x02) //check falling
-	{
-		falling |= 1 << (channel - 1);
-	}
-	else
-	{
-		falling &= ~ (1 << (channel - 1));
-	}
-	buff[0] = rising;
-	buff[1] = falling;
-	if (FAIL == i2cMem8Write(dev, I2C_MEM_GPIO_EXT_IT_RISING_ADD, buff, 2))
+	if (IOPLUS_OK != ioplusGpioEdgeSet(boardHandle(dev), channel, val))
 	{
 		return ERROR;
 	}
@@ -222,14 +137,7 @@ int gpioEdgeSet(int dev, u8 channel, u8 val)
 
 int gpioCountGet(int dev, u8 channel, u32 *val)
 {
-	if ( (channel < CHANNEL_NR_MIN) || (channel > GPIO_CH_NR_MAX))
-	{
-		return ERROR;
-	}
-
-	if (OK
-		!= i2cReadDWordAS(dev,
-			I2C_MEM_GPIO_EDGE_COUNT_ADD + COUNTER_SIZE * (channel - 1), val))
+	if (IOPLUS_OK != ioplusGpioCountGet(boardHandle(dev), channel, val))
 	{
 		return ERROR;
 	}
@@ -239,12 +147,7 @@ int gpioCountGet(int dev, u8 channel, u32 *val)
 //*********************************** for PLC08Pi only ***************************************
 int gpioEncGetCnt(int dev, int *val)
 {
-	if (NULL == val)
-	{
-		return ERROR;
-	}
-
-	if (OK != i2cReadIntAS(dev, I2C_MEM_GPIO_ENC_COUNT_ADD, val))
+	if (IOPLUS_OK != ioplusGpioEncCountGet(boardHandle(dev), (int32_t*)val))
 	{
 		return ERROR;
 	}
@@ -253,9 +156,7 @@ int gpioEncGetCnt(int dev, int *val)
 
 int gpioEncRstCnt(int dev)
 {
-	u8 val = 1;
-
-	if (FAIL == i2cMem8Write(dev, I2C_MEM_GPIO_ENC_CNT_RST_ADD, &val, 1))
+	if (IOPLUS_OK != ioplusGpioEncCountReset(boardHandle(dev)))
 	{
 		return ERROR;
 	}
@@ -274,28 +175,8 @@ int gpioEncRstCnt(int dev)
 
 int inCmdSet(int dev, u8 inCh, u8 outCh, u32 count, u8 enable)
 {
-	u8 buff[6];
-
-	if ( (inCh > OPTO_CH_NO) || (inCh == 0))
-	{
-		return ERROR;
-	}
-	if ( outCh > OD_CH_NO)
-	{
-		return ERROR;
-	}
-	memcpy(buff, &count, sizeof(u32));
-	buff[5] = inCh;
-
-	if (enable)
-	{
-		buff[4] = outCh;
-	}
-	else
-	{
-		buff[4] = 0;
-	}
-	if (FAIL == i2cMem8Write(dev, I2C_MEM_PULSE_COUNTER_SET, buff, 6))
+	if (IOPLUS_OK
+		!= ioplusInCmdSet(boardHandle(dev), inCh, outCh, count, enable))
 	{
 		return ERROR;
 	}
@@ -306,12 +187,7 @@ int inCmdSet(int dev, u8 inCh, u8 outCh, u32 count, u8 enable)
 
 int gpioCountReset(int dev, u8 channel)
 {
-
-	if ( (channel < CHANNEL_NR_MIN) || (channel > OPTO_IN_CH_NR_MAX))
-	{
-		return ERROR;
-	}
-	if (FAIL == i2cMem8Write(dev, I2C_MEM_GPIO_CNT_RST_ADD, &channel, 1))
+	if (IOPLUS_OK != ioplusGpioCountReset(boardHandle(dev), channel))
 	{
 		return ERROR;
 	}
@@ -376,8 +252,6 @@ int doGpioWrite(int argc, char *argv[])
 	OutStateEnumType state = STATE_COUNT;
 	int val = 0;
 	int dev = 0;
-	OutStateEnumType stateR = STATE_COUNT;
-	int retry = 0;
 	int direction = 0x0f;
 
 	if ( (argc != 5) && (argc != 4))
@@ -426,29 +300,8 @@ int doGpioWrite(int argc, char *argv[])
 			printf("Fail to write gpio pin, is input\n");
 			return ERROR;
 		}
-		retry = RETRY_TIMES;
-
-		while ( (retry > 0) && (stateR != state))
-		{
-			if (OK != gpioChSet(dev, pin, state))
-			{
-				printf("Fail to write gpio\n");
-				return ERROR;
-			}
-			if (OK != gpioChGet(dev, pin, &stateR))
-			{
-				printf("Fail to read gpio\n");
-				return ERROR;
-			}
-			retry--;
-		}
-#ifdef DEBUG_I
-		if(retry < RETRY_TIMES)
-		{
-			printf("retry %d times\n", 3-retry);
-		}
-#endif
-		if (retry == 0)
+		// read back and retried by the library, see IOPLUS_VERIFY
+		if (OK != gpioChSet(dev, pin, state))
 		{
 			printf("Fail to write gpio pin\n");
 			return ERROR;
@@ -0,0 +1,34 @@
+/*
+ * i2cerr.h:
+ *	IOPLUS_xxx code of an I2C layer result, shared by the library sources
+ *	that call comm.c directly. Internal, not installed.
+ *
+ *	Copyright (c) 2016-2023 Sequent Microsystem
+ *	<http://www.sequentmicrosystem.com>
+ ***********************************************************************
+ */
+#ifndef I2CERR_H_
+#define I2CERR_H_
+
+#include "comm.h"
+#include "libioplus.h"
+
+// a card skipped by its breaker and a failed transfer stay apart
+static inline int i2cErrToIoplus(int ret)
+{
+	if (ret == 0)
+	{
+		return IOPLUS_OK;
+	}
+	if (ret == I2C_ERR_OPEN)
+	{
+		return IOPLUS_ERR_OPEN;
+	}
+	if (ret == I2C_ERR_SPURIOUS)
+	{
+		return IOPLUS_ERR_SPURIOUS;
+	}
+	return IOPLUS_ERR_IO;
+}
+
+#endif //I2CERR_H_
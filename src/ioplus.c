@@ -20,8 +20,13 @@
 #include "cli.h"
 
 #include <fcntl.h>
+#include <unistd.h>
 #include <sys/stat.h>
 #include <semaphore.h>
+#include <time.h>
+#include <signal.h>
+#include <ctype.h>
+#include <pthread.h>
 
 #define VERSION_BASE	(int)1
 #define VERSION_MAJOR	(int)3
@@ -33,7 +38,10 @@
 #define THREAD_SAFE
 #define MOVE_PROFILE
 
-u8 gHwVer = 0;
+static IoplusBoardType gBoard = {.dev = -1};
+#ifdef THREAD_SAFE
+static sem_t *gBusSem = SEM_FAILED; // bus token main() holds for the command
+#endif
 
 char *warranty =
 	"	       Copyright (c) 2016-2023 Sequent Microsystems\n"
@@ -97,59 +105,81 @@ void usage(void)
 	printf("Type ioplus -h <command> for more help\n");
 }
 
+/*
+ * verifyPolicySet:
+ *	Output writes are read back and written again until they match, at most
+ *	RETRY_TIMES times; IOPLUS_VERIFY=none|once|until[:<retries>[:<deadline ms>]]
+ *	trades that for latency
+ */
+static void verifyPolicySet(IoplusBoardType *board)
+{
+	IoplusVerifyType verify = {IOPLUS_VERIFY_UNTIL, RETRY_TIMES, 0};
+	const char *env = getenv("IOPLUS_VERIFY");
+
+	if ( (NULL != env) && (env[0] != 0)
+		&& (IOPLUS_OK != ioplusVerifyParse(env, &verify)))
+	{
+		fprintf(stderr, "Invalid IOPLUS_VERIFY \"%s\", using until:%d\n", env,
+			RETRY_TIMES);
+		ioplusVerifyParse("until", &verify);
+	}
+	ioplusVerifySet(board, &verify);
+}
+
 int doBoardInit(int stack)
 {
-	int dev = 0;
-	int add = 0;
-	uint8_t buff[8];
+	int ret = 0;
 
 	if ( (stack < 0) || (stack > 7))
 	{
 		printf("Invalid stack level [0..7]!");
 		return ERROR;
 	}
-	add = stack + SLAVE_OWN_ADDRESS_BASE;
-	dev = i2cSetup(add);
-	if (dev == -1)
+	ioplusClose(&gBoard);
+	ret = ioplusOpen(&gBoard, stack);
+	if (IOPLUS_ERR_NO_BOARD == ret)
 	{
+		printf("IO-PLUS id %d not detected\n", stack);
 		return ERROR;
 	}
-	if (ERROR == i2cMem8Read(dev, I2C_MEM_REVISION_HW_MAJOR_ADD, buff, 1))
+	if (IOPLUS_OK != ret)
 	{
-		printf("IO-PLUS id %d not detected\n", stack);
+		printf("Failed to open the I2C bus!\n");
 		return ERROR;
 	}
-	gHwVer = buff[0];
-	return dev;
+	verifyPolicySet(&gBoard);
+	return gBoard.dev;
 }
 
 u8 getHwVer(void)
 {
-	return gHwVer;
+	return gBoard.hwMajor;
 }
 
-int boardCheck(int stack)
+/*
+ * boardHandle:
+ *	The command line talks to one card per run; map the file descriptor the
+ *	accessors below receive on the library handle opened by doBoardInit()
+ */
+IoplusBoardType* boardHandle(int dev)
 {
-	int dev = 0;
-	int add = 0;
-	uint8_t buff[8];
-
-	if ( (stack < 0) || (stack > 7))
-	{
-		printf("Invalid stack level [0..7]!");
-		return ERROR;
-	}
-	add = stack + SLAVE_OWN_ADDRESS_BASE;
-	dev = i2cSetup(add);
-	if (dev == -1)
+	if (gBoard.dev != dev)
 	{
-		return ERROR;
+		memset(&gBoard, 0, sizeof(gBoard));
+		gBoard.dev = dev;
 	}
-	if (ERROR == i2cMem8Read(dev, I2C_MEM_REVISION_MAJOR_ADD, buff, 1))
-	{
+	return &gBoard;
+}
+
+int boardCheck(int stack)
+{
+	IoplusBoardType board;
 
+	if (IOPLUS_OK != ioplusOpen(&board, stack))
+	{
 		return ERROR;
 	}
+	ioplusClose(&board);
 	return OK;
 }
 int doHelp(int argc, char *argv[]);
@@ -292,10 +322,9 @@ const CliCmdType CMD_BOARD = {"board", 2, &doBoard,
 int doBoard(int argc, char *argv[])
 {
 	int dev = -1;
-	u8 buff[4];
-	int resp = 0;
+	IoplusBoardType *board = NULL;
 	int temperature = 25;
-	float voltage = 3.3;
+	u16 mV = 0;
 
 	if (argc != 3)
 	{
@@ -307,26 +336,16 @@ int doBoard(int argc, char *argv[])
 	{
 		return (FAIL);
 	}
-	resp = i2cMem8Read(dev, I2C_MEM_DIAG_TEMPERATURE_ADD, buff, 3);
-	if (FAIL == resp)
-	{
-		printf("Fail to read board info!\n");
-		return (FAIL);
-	}
-	temperature = buff[0];
-	memcpy(&resp, &buff[1], 2);
-	voltage = (float)resp / 1000; //read in milivolts
-
-	resp = i2cMem8Read(dev, I2C_MEM_REVISION_HW_MAJOR_ADD, buff, 4);
-	if (FAIL == resp)
+	board = boardHandle(dev);
+	if (IOPLUS_OK != ioplusDiagGet(board, &temperature, &mV))
 	{
 		printf("Fail to read board info!\n");
 		return (FAIL);
 	}
 	printf(
 		"Hardware %02d.%02d, Firmware %02d.%02d, CPU temperature %d C, voltage %0.2f V\n",
-		(int)buff[0], (int)buff[1], (int)buff[2], (int)buff[3], temperature,
-		voltage);
+		(int)board->hwMajor, (int)board->hwMinor, (int)board->fwMajor,
+		(int)board->fwMinor, temperature, (float)mV / 1000);
 	return OK;
 }
 #ifdef HW_DEBUG
@@ -404,40 +423,26 @@ int doGetErrors(int argc, char *argv[])
 
 int relayChSet(int dev, u8 channel, OutStateEnumType state)
 {
-	int resp = 0;
-	u8 buff[2];
-
 	if ( (channel < CHANNEL_NR_MIN) || (channel > RELAY_CH_NR_MAX))
 	{
 		printf("Invalid relay nr!\n");
 		return ERROR;
 	}
-	if (FAIL == i2cMem8Read(dev, I2C_MEM_RELAY_VAL_ADD, buff, 1))
+	if ( (state != OFF) && (state != ON))
 	{
-		return FAIL;
-	}
-
-	switch (state)
-	{
-	case OFF:
-		buff[0] &= ~ (1 << (channel - 1));
-		resp = i2cMem8Write(dev, I2C_MEM_RELAY_VAL_ADD, buff, 1);
-		break;
-	case ON:
-		buff[0] |= 1 << (channel - 1);
-		resp = i2cMem8Write(dev, I2C_MEM_RELAY_VAL_ADD, buff, 1);
-		break;
-	default:
 		printf("Invalid relay state!\n");
 		return ERROR;
-		break;
 	}
-	return resp;
+	if (IOPLUS_OK != ioplusRelayChSet(boardHandle(dev), channel, state))
+	{
+		return FAIL;
+	}
+	return OK;
 }
 
 int relayChGet(int dev, u8 channel, OutStateEnumType *state)
 {
-	u8 buff[2];
+	int val = 0;
 
 	if (NULL == state)
 	{
@@ -449,78 +454,66 @@ int relayChGet(int dev, u8 channel, OutStateEnumType *state)
 		printf("Invalid relay nr!\n");
 		return ERROR;
 	}
-
-//	if (FAIL == i2cMem8Read(dev, I2C_MEM_RELAY_VAL_ADD, buff, 1))
-//	{
-//		return ERROR;
-//	}
-	if (OK != i2cReadByteAS(dev, I2C_MEM_RELAY_VAL_ADD, buff))
+	if (IOPLUS_OK != ioplusRelayChGet(boardHandle(dev), channel, &val))
 	{
 		return ERROR;
 	}
-	if (buff[0] & (1 << (channel - 1)))
-	{
-		*state = ON;
-	}
-	else
-	{
-		*state = OFF;
-	}
+	*state = val ? ON : OFF;
 	return OK;
 }
 
 int relaySet(int dev, int val)
 {
-	u8 buff[2];
-
-	buff[0] = 0xff & val;
-
-	return i2cMem8Write(dev, I2C_MEM_RELAY_VAL_ADD, buff, 1);
+	if (IOPLUS_OK != ioplusRelaySet(boardHandle(dev), 0xff & val))
+	{
+		return FAIL;
+	}
+	return OK;
 }
 
 int relayGet(int dev, int *val)
 {
-	u8 buff[2];
+	u8 buff = 0;
 
 	if (NULL == val)
 	{
 		return ERROR;
 	}
-	if (OK != i2cReadByteAS(dev, I2C_MEM_RELAY_VAL_ADD, buff))
+	if (IOPLUS_OK != ioplusRelayGet(boardHandle(dev), &buff))
 	{
 		return ERROR;
 	}
-	*val = buff[0];
+	*val = buff;
 	return OK;
 }
 
 int relayDefaultSet(int dev, int val)
 {
-	u8 buff[2];
-
-	buff[0] = 0xff & val;
-
-	return i2cMem8Write(dev, I2C_MEM_RELAY_DEFAULT, buff, 1);
+	if (IOPLUS_OK != ioplusRelayDefaultSet(boardHandle(dev), 0xff & val))
+	{
+		return FAIL;
+	}
+	return OK;
 }
 
 int relayDefaultGet(int dev, int *val)
 {
-	u8 buff[2];
+	u8 buff = 0;
 
 	if (NULL == val)
 	{
 		return ERROR;
 	}
-	if (OK != i2cReadByteAS(dev, I2C_MEM_RELAY_DEFAULT, buff))
+	if (IOPLUS_OK != ioplusRelayDefaultGet(boardHandle(dev), &buff))
 	{
 		return ERROR;
 	}
-	*val = buff[0];
+	*val = buff;
 	return OK;
 }
 int relayDefaultChGet(int dev, u8 channel, OutStateEnumType *state)
 {
-	u8 buff[2];
+	int val = 0;
 
 	if (NULL == state)
 	{
@@ -532,54 +525,42 @@ int relayDefaultChGet(int dev, u8 channel, OutStateEnumType *state)
 		printf("Invalid relay nr!\n");
 		return ERROR;
 	}
-
-//	if (FAIL == i2cMem8Read(dev, I2C_MEM_RELAY_VAL_ADD, buff, 1))
-//	{
-//		return ERROR;
-//	}
-	if (OK != i2cReadByteAS(dev, I2C_MEM_RELAY_DEFAULT, buff))
+	if (OK != relayDefaultGet(dev, &val))
 	{
 		return ERROR;
 	}
-	if (buff[0] & (1 << (channel - 1)))
-	{
-		*state = ON;
-	}
-	else
-	{
-		*state = OFF;
-	}
+	*state = (val & (1 << (channel - 1))) ? ON : OFF;
 	return OK;
 }
 // open drain default access functions
 
 int odDefaultSet(int dev, int val)
 {
-	u8 buff[2];
-
-	buff[0] = 0xff & val;
-
-	return i2cMem8Write(dev, I2C_MEM_OD_DEFAULT, buff, 1);
+	if (IOPLUS_OK != ioplusOdDefaultSet(boardHandle(dev), 0xff & val))
+	{
+		return FAIL;
+	}
+	return OK;
 }
 
 int odDefaultGet(int dev, int *val)
 {
-	u8 buff[2];
+	u8 buff = 0;
 
 	if (NULL == val)
 	{
 		return ERROR;
 	}
-	if (OK != i2cReadByteAS(dev, I2C_MEM_OD_DEFAULT, buff))
+	if (IOPLUS_OK != ioplusOdDefaultGet(boardHandle(dev), &buff))
 	{
 		return ERROR;
 	}
-	*val = buff[0];
+	*val = buff;
 	return OK;
 }
 int odDefaultChGet(int dev, u8 channel, OutStateEnumType *state)
 {
-	u8 buff[2];
+	int val = 0;
 
 	if (NULL == state)
 	{
@@ -591,23 +572,11 @@ int odDefaultChGet(int dev, u8 channel, OutStateEnumType *state)
 		printf("Invalid relay nr!\n");
 		return ERROR;
 	}
-
-//	if (FAIL == i2cMem8Read(dev, I2C_MEM_RELAY_VAL_ADD, buff, 1))
-//	{
-//		return ERROR;
-//	}
-	if (OK != i2cReadByteAS(dev, I2C_MEM_OD_DEFAULT, buff))
+	if (OK != odDefaultGet(dev, &val))
 	{
 		return ERROR;
 	}
-	if (buff[0] & (1 << (channel - 1)))
-	{
-		*state = ON;
-	}
-	else
-	{
-		*state = OFF;
-	}
+	*state = (val & (1 << (channel - 1))) ? ON : OFF;
 	return OK;
 }
 
@@ -627,9 +596,6 @@ int doRelayWrite(int argc, char *argv[])
 	OutStateEnumType state = STATE_COUNT;
 	int val = 0;
 	int dev = 0;
-	OutStateEnumType stateR = STATE_COUNT;
-	int valR = 0;
-	int retry = 0;
 
 	if ( (argc != 5) && (argc != 4))
 	{
@@ -668,29 +634,8 @@ int doRelayWrite(int argc, char *argv[])
 			state = (OutStateEnumType)atoi(argv[4]);
 		}
 
-		retry = RETRY_TIMES;
-
-		while ( (retry > 0) && (stateR != state))
-		{
-			if (OK != relayChSet(dev, pin, state))
-			{
-				printf("Fail to write relay\n");
-				return (FAIL);
-			}
-			if (OK != relayChGet(dev, pin, &stateR))
-			{
-				printf("Fail to read relay\n");
-				return (FAIL);
-			}
-			retry--;
-		}
-#ifdef DEBUG_I
-		if(retry < RETRY_TIMES)
-		{
-			printf("retry %d times\n", 3-retry);
-		}
-#endif
-		if (retry == 0)
+		// read back and retried by the library, see IOPLUS_VERIFY
+		if (OK != relayChSet(dev, pin, state))
 		{
 			printf("Fail to write relay\n");
 			return (FAIL);
@@ -705,23 +650,7 @@ int doRelayWrite(int argc, char *argv[])
 			return (FAIL);
 		}
 
-		retry = RETRY_TIMES;
-		valR = -1;
-		while ( (retry > 0) && (valR != val))
-		{
-
-			if (OK != relaySet(dev, val))
-			{
-				printf("Fail to write relay!\n");
-				return (FAIL);
-			}
-			if (OK != relayGet(dev, &valR))
-			{
-				printf("Fail to read relay!\n");
-				return (FAIL);
-			}
-		}
-		if (retry == 0)
+		if (OK != relaySet(dev, val))
 		{
 			printf("Fail to write relay!\n");
 			return (FAIL);
@@ -1316,8 +1245,7 @@ int odGet(int dev, int ch, float *val)
 		printf("Open drain channel out of range!\n");
 		return ERROR;
 	}
-	if (OK
-		!= i2cReadWordAS(dev, I2C_MEM_OD_PWM_VAL_RAW_ADD + 2 * (ch - 1), &raw))
+	if (IOPLUS_OK != ioplusOdPwmGet(boardHandle(dev), ch, &raw))
 	{
 		printf("Fail to read!\n");
 		return ERROR;
@@ -1328,7 +1256,6 @@ int odGet(int dev, int ch, float *val)
 
 int odSet(int dev, int ch, float val)
 {
-	u8 buff[2] = {0, 0};
 	u16 raw = 0;
 
 	if ( (ch < CHANNEL_NR_MIN) || (ch > OD_CH_NR_MAX))
@@ -1345,9 +1272,7 @@ int odSet(int dev, int ch, float val)
 		val = 100;
 	}
 	raw = (u16)ceil(OD_PWM_VAL_MAX * val / 100);
-	memcpy(buff, &raw, 2);
-	if (OK
-		!= i2cMem8Write(dev, I2C_MEM_OD_PWM_VAL_RAW_ADD + 2 * (ch - 1), buff, 2))
+	if (IOPLUS_OK != ioplusOdPwmSet(boardHandle(dev), ch, raw))
 	{
 		printf("Fail to write!\n");
 		return ERROR;
@@ -1449,43 +1374,19 @@ int doOdWrite(int argc, char *argv[])
 }
 
 //----------------------------------- OD pulses --------------------------------------------------------
-#define SINGLE_TRANSFER
 
 int odWritePulses(int dev, int ch, unsigned int val)
 {
-	u8 buff[5] = {0, 0, 0, 0, 0};
-	u32 raw = 0;
-
 	if ( (ch < CHANNEL_NR_MIN) || (ch > 2 * OD_CH_NR_MAX))// channel from 5 to 8 are channel 1 to 4 in oposite direction
 	{
 		printf("Open drain channel out of range!\n");
 		return ERROR;
 	}
-	raw = (u32)val;
-	memcpy(buff, &raw, 4);
-
-#ifdef SINGLE_TRANSFER
-	buff[4] = ch;
-	if (OK != i2cMem8Write(dev, I2C_MEM_OD_P_SET_VALUE, buff, 5)) // write the value
-	{
-		printf("Fail to write!\n");
-		return ERROR;
-	}
-
-#else
-
-	if (OK != i2cMem8Write(dev, I2C_MEM_OD_P_SET_VALUE, buff, 4)) // write the value
-	{
-		printf("Fail to write!\n");
-		return ERROR;
-	}
-	buff[0] = ch;
-	if (OK != i2cMem8Write(dev, I2C_MEM_OD_P_SET_CMD, buff, 1))// update command
+	if (IOPLUS_OK != ioplusOdPulsesSet(boardHandle(dev), ch, (u32)val))
 	{
 		printf("Fail to write!\n");
 		return ERROR;
 	}
-#endif
 	return OK;
 }
 
@@ -1503,7 +1404,7 @@ int odReadPulses(int dev, int ch, unsigned int *val)
 		printf("Open drain channel out of range!\n");
 		return ERROR;
 	}
-	if (OK != i2cReadDWord(dev, I2C_MEM_OD_PULSE_CNT_SET + 4 * (ch - 1), &raw))
+	if (IOPLUS_OK != ioplusOdPulsesGet(boardHandle(dev), ch, &raw))
 	{
 		printf("Fail to read!\n");
 		return ERROR;
@@ -1631,7 +1532,7 @@ int dacGet(int dev, int ch, float *val)
 		printf("DAC channel out of range!\n");
 		return ERROR;
 	}
-	if (OK != i2cReadWordAS(dev, I2C_MEM_DAC_VAL_MV_ADD + 2 * (ch - 1), &raw))
+	if (IOPLUS_OK != ioplusDacGet(boardHandle(dev), ch, &raw))
 	{
 		printf("Fail to read!\n");
 		return ERROR;
@@ -1642,7 +1543,6 @@ int dacGet(int dev, int ch, float *val)
 
 int dacSet(int dev, int ch, float val)
 {
-	u8 buff[2] = {0, 0};
 	u16 raw = 0;
 
 	if ( (ch < CHANNEL_NR_MIN) || (ch > DAC_CH_NR_MAX))
@@ -1654,13 +1554,12 @@ int dacSet(int dev, int ch, float val)
 	{
 		val = 0;
 	}
-	if (val > 100)
+	if (val > 10)
 	{
-		val = 100;
+		val = 10;
 	}
 	raw = (u16)ceil(val * 1000); //transform to milivolts
-	memcpy(buff, &raw, 2);
-	if (OK != i2cMem8Write(dev, I2C_MEM_DAC_VAL_MV_ADD + 2 * (ch - 1), buff, 2))
+	if (IOPLUS_OK != ioplusDacSet(boardHandle(dev), ch, raw))
 	{
 		printf("Fail to write!\n");
 		return ERROR;
@@ -1769,7 +1668,7 @@ int adcGet(int dev, int ch, float *val)
 		printf("ADC channel out of range!\n");
 		return ERROR;
 	}
-	if (OK != i2cReadWordAS(dev, I2C_MEM_ADC_VAL_MV_ADD + 2 * (ch - 1), &raw))
+	if (IOPLUS_OK != ioplusAdcGet(boardHandle(dev), ch, &raw))
 	{
 		printf("Fail to read!\n");
 		return ERROR;
@@ -1781,15 +1680,45 @@ int adcGet(int dev, int ch, float *val)
 int doAdcRead(int argc, char *argv[]);
 const CliCmdType CMD_ADC_READ =
 	{"adcrd", 2, &doAdcRead,
-		"\tadcrd:		Read ADC input voltage value (0 - 3.3V)\n",
-		"\tUsage:		ioplus <stack> adcrd <channel>\n", "",
-		"\tExample:		ioplus 0 adcrd 2; Read the voltage input on ADC channel #2 on Board #0\n"};
+		"\tadcrd:		Read ADC input voltage value (0 - 3.3V), optionally filtered over consecutive samples\n",
+		"\tUsage:		ioplus <stack> adcrd <channel> [--filter=<stage:param>[,<stage:param>...]]\n",
+		"\tUsage:		stages: avg:<n> median:<n> iir:<k> decim:<n> deadband:<mV>, applied in order\n",
+		"\tExample:		ioplus 0 adcrd 2 --filter=median:5,avg:8; Read the voltage input on ADC channel #2 on Board #0, median of 5 then average of 8 samples\n"};
+
+static int adcFilterGet(int dev, int ch, const char *spec, float *val)
+{
+	IoplusFilterType filt;
+	float mV[IOPLUS_ADC_CH_NO];
+	int samples;
+	int i;
+
+	if (IOPLUS_OK != ioplusFilterParse(&filt, spec))
+	{
+		printf("Invalid filter \"%s\"!\n", spec);
+		return ERROR;
+	}
+	// enough samples for every window of the pipeline to be full
+	samples = ioplusFilterSettle(&filt);
+	for (i = 0; i < samples; i++)
+	{
+		if (IOPLUS_OK != ioplusAdcFilterRead(boardHandle(dev), &filt, mV, NULL))
+		{
+			printf("Fail to read!\n");
+			return ERROR;
+		}
+	}
+	*val = mV[ch - 1] / VOLT_TO_MILIVOLT;
+	return OK;
+}
 
 int doAdcRead(int argc, char *argv[])
 {
 	int ch = 0;
 	float val = 0;
 	int dev = 0;
+	const char *spec = NULL;
+	int args = argc;
+	int i;
 
 	dev = doBoardInit(atoi(argv[1]));
 	if (dev <= 0)
@@ -1797,16 +1726,34 @@ int doAdcRead(int argc, char *argv[])
 		return (FAIL);
 	}
 
-	if (argc == 4)
+	for (i = 3; i < argc; i++)
+	{
+		if (0 == strncmp(argv[i], "--filter=", 9))
+		{
+			spec = argv[i] + 9;
+			args--;
+		}
+		else
+		{
+			ch = atoi(argv[i]);
+		}
+	}
+	if (args == 4)
 	{
-		ch = atoi(argv[3]);
 		if ( (ch < CHANNEL_NR_MIN) || (ch > ADC_CH_NR_MAX))
 		{
 			printf("ADC channel out of range!\n");
 			return (FAIL);
 		}
 
-		if (OK != adcGet(dev, ch, &val))
+		if (NULL != spec)
+		{
+			if (OK != adcFilterGet(dev, ch, spec, &val))
+			{
+				return (FAIL);
+			}
+		}
+		else if (OK != adcGet(dev, ch, &val))
 		{
 			printf("Fail to read!\n");
 			return (FAIL);
@@ -1822,6 +1769,59 @@ int doAdcRead(int argc, char *argv[])
 	return OK;
 }
 
+#define FILTER_BENCH_SAMPLES	1000000
+#define FILTER_BENCH_PATTERN	1024
+
+int doAdcFilterBench(int argc, char *argv[]);
+const CliCmdType CMD_ADC_FILTER_BENCH =
+	{"adcfltbench", 1, &doAdcFilterBench,
+		"\tadcfltbench:	Measure the ADC filter pipeline throughput on synthetic samples, no card needed\n",
+		"\tUsage:		ioplus adcfltbench <stage:param>[,<stage:param>...]\n", "",
+		"\tExample:		ioplus adcfltbench median:5,avg:8; Time one million 8 channel samples through a median of 5 and an average of 8\n"};
+
+int doAdcFilterBench(int argc, char *argv[])
+{
+	static float pattern[FILTER_BENCH_PATTERN][IOPLUS_ADC_CH_NO];
+	IoplusFilterType filt;
+	struct timespec t0;
+	struct timespec t1;
+	float out[IOPLUS_ADC_CH_NO];
+	double sec;
+	int outputs = 0;
+	int i;
+	int ch;
+
+	if (argc != 3)
+	{
+		return ARG_CNT_ERR;
+	}
+	if (IOPLUS_OK != ioplusFilterParse(&filt, argv[2]))
+	{
+		printf("Invalid filter \"%s\"!\n", argv[2]);
+		return ARG_ERR;
+	}
+	// noisy ramps, generated up front so only the filter is timed
+	srand(1);
+	for (i = 0; i < FILTER_BENCH_PATTERN; i++)
+	{
+		for (ch = 0; ch < IOPLUS_ADC_CH_NO; ch++)
+		{
+			pattern[i][ch] = (float) ( (i * (ch + 1)) % 3300) + (rand() % 100);
+		}
+	}
+	clock_gettime(CLOCK_MONOTONIC, &t0);
+	for (i = 0; i < FILTER_BENCH_SAMPLES; i++)
+	{
+		outputs += ioplusFilterRun(&filt, pattern[i % FILTER_BENCH_PATTERN], out);
+	}
+	clock_gettime(CLOCK_MONOTONIC, &t1);
+	sec = (t1.tv_sec - t0.tv_sec) + (t1.tv_nsec - t0.tv_nsec) / 1e9;
+	printf("%d samples x %d channels in %0.3f s, %0.2f Msamples/s, %0.1f ns/sample, %d outputs (last ch1 %0.1f mV)\n",
+		FILTER_BENCH_SAMPLES, IOPLUS_ADC_CH_NO, sec, FILTER_BENCH_SAMPLES / sec / 1e6,
+		sec * 1e9 / FILTER_BENCH_SAMPLES, outputs, filt.out[0]);
+	return OK;
+}
+
 int adcGetMax(int dev, int ch, float *val)
 {
 	u16 raw = 0;
@@ -1831,7 +1831,7 @@ int adcGetMax(int dev, int ch, float *val)
 		printf("ADC channel for process min/max out of range!\n");
 		return ERROR;
 	}
-	if (OK != i2cReadWordAS(dev, I2C_MEM_ADC_MAX + 2 * (ch - 1), &raw))
+	if (IOPLUS_OK != ioplusAdcMaxGet(boardHandle(dev), ch, &raw))
 	{
 		printf("Fail to read!\n");
 		return ERROR;
@@ -1893,7 +1893,7 @@ int adcGetMin(int dev, int ch, float *val)
 		printf("ADC channel for process min/max out of range!\n");
 		return ERROR;
 	}
-	if (OK != i2cReadWordAS(dev, I2C_MEM_ADC_MIN + 2 * (ch - 1), &raw))
+	if (IOPLUS_OK != ioplusAdcMinGet(boardHandle(dev), ch, &raw))
 	{
 		printf("Fail to read!\n");
 		return ERROR;
@@ -1946,89 +1946,537 @@ int doAdcReadMin(int argc, char *argv[])
 	return OK;
 }
 
-int getCalStat(int dev)
+#define ADC_STATS_PERIOD_MS	100
+
+int doAdcStats(int argc, char *argv[]);
+const CliCmdType CMD_ADC_STATS =
+	{"adcstats", 2, &doAdcStats,
+		"\tadcstats:	Poll the ADC inputs and display min, max, mean and standard deviation over the last second, minute and hour\n",
+		"\tUsage:		ioplus <stack> adcstats <seconds> [<period ms>]\n", "",
+		"\tExample:		ioplus 0 adcstats 60; Poll the ADC inputs of Board #0 every 100ms for one minute and display the statistics\n"};
+
+int doAdcStats(int argc, char *argv[])
 {
-	u8 buff[2];
+	static IoplusAdcStatsType stats;
+	IoplusAdcWindowType win;
+	const char *winName[IOPLUS_STATS_WIN_NO] = {"1s", "1min", "1h"};
+	int period = ADC_STATS_PERIOD_MS;
+	int polls;
+	int dev = 0;
+	int i;
+	int ch;
 
-	busyWait(100);
-	if (OK != i2cReadByteAS(dev, I2C_MEM_CALIB_STATUS, buff))
+	if ( (argc != 4) && (argc != 5))
 	{
-		printf("Fail to read calibration status!\n");
-		return FAIL;
+		return ARG_CNT_ERR;
 	}
-	switch (buff[0])
+	if (argc == 5)
 	{
-	case 0:
-		printf("Calibration in progress\n");
-		break;
-	case 1:
-		printf("Calibration done\n");
-		break;
-	case 2:
-		printf("Calibration error!\n");
-		break;
-	default:
-		printf("Unknown calibration status\n");
-		break;
+		period = atoi(argv[4]);
+	}
+	if ( (atoi(argv[3]) <= 0) || (period <= 0))
+	{
+		printf("Invalid duration or period!\n");
+		return ARG_ERR;
 	}
-	return OK;
-}
-
-int doAdcCal(int argc, char *argv[]);
-const CliCmdType CMD_ADC_CAL =
-	{"adccal", 2, &doAdcCal,
-		"\tadccal:		Calibrate one ADC channel, the calibration must be done in 2 points at min 2V apart\n",
-		"\tUsage:		ioplus <stack> adccal <channel> <value>\n", "",
-		"\tExample:		ioplus 0 adccal 2 0.5; Calibrate the voltage input on ADC channel #2 on Board #0 at 0.5V\n"};
-
-int doAdcCal(int argc, char *argv[])
-{
-	int ch = 0;
-	float val = 0;
-	int dev = 0;
-	u8 buff[4] = {0, 0};
-	u16 raw = 0;
-
 	dev = doBoardInit(atoi(argv[1]));
 	if (dev <= 0)
 	{
 		return (FAIL);
 	}
-
-	if (argc == 5)
+	ioplusAdcStatsInit(&stats);
+	polls = atoi(argv[3]) * 1000 / period;
+	for (i = 0; i < polls; i++)
 	{
-		ch = atoi(argv[3]);
-		if ( (ch < CHANNEL_NR_MIN) || (ch > ADC_CH_NR_MAX))
+		if (IOPLUS_OK != ioplusAdcStatsSample(boardHandle(dev), &stats))
 		{
-			printf("ADC channel out of range!\n");
+			printf("Fail to read!\n");
 			return (FAIL);
 		}
-
-		val = atof(argv[4]);
-		if ( (val < 0) || (val > 3.3))
+		busyWait(period);
+	}
+	for (i = 0; i < IOPLUS_STATS_WIN_NO; i++)
+	{
+		ioplusAdcStatsGet(&stats, i, &win);
+		printf("%s window, %u samples\n", winName[i], win.samples);
+		printf("ch    min      max      mean     stddev\n");
+		for (ch = 0; (win.samples > 0) && (ch < IOPLUS_ADC_CH_NO); ch++)
 		{
-			printf("ADC calibration value out of range!\n");
-			return (FAIL);
+			printf("%d  %0.3f    %0.3f    %0.3f    %0.4f\n", ch + 1,
+				win.min[ch] / VOLT_TO_MILIVOLT, win.max[ch] / VOLT_TO_MILIVOLT,
+				win.mean[ch] / VOLT_TO_MILIVOLT, win.stddev[ch] / VOLT_TO_MILIVOLT);
 		}
-		raw = (u16)ceil(val * VOLT_TO_MILIVOLT);
-		memcpy(buff, &raw, 2);
-		buff[2] = ch;
-		buff[3] = CALIBRATION_KEY;
+	}
+	return OK;
+}
 
-		if (OK != i2cMem8Write(dev, I2C_MEM_CALIB_VALUE, buff, 4))
-		{
-			printf("Fail to write calibration data!\n");
-			return (FAIL);
-		}
+#define CNT_JOURNAL_PERIOD_MS	100
+#define CNT_JOURNAL_SYNC_MS	10000
+#define CNT_JOURNAL_CKP_MS	3600000
+#define CNT_JOURNAL_CKP_BYTES	65536
 
-		getCalStat(dev);
-	}
-	else
+/*
+ * busTokenRelease:
+ *	Commands running until stopped give back the bus token main() took, so
+ *	they do not starve the other programs sharing it, and the library takes
+ *	the semaphore around each transaction instead
+ */
+void busTokenRelease(void)
+{
+#ifdef THREAD_SAFE
+	if (gBusSem != SEM_FAILED)
 	{
-		printf("Invalid params number:\n %s", CMD_ADC_CAL.usage1);
-		return (FAIL);
+		sem_post(gBusSem);
+		gBusSem = SEM_FAILED;
 	}
-	return OK;
+	ioplusBusLockHeld(0);
+#endif
+}
+
+// set by SIGINT / SIGTERM to end the commands running until stopped
+volatile sig_atomic_t gRunStop = 0;
+
+void runStop(int sig)
+{
+	UNUSED(sig);
+	gRunStop = 1;
+}
+
+int doCntJournal(int argc, char *argv[]);
+const CliCmdType CMD_CNT_JOURNAL =
+	{"cntjrnl", 2, &doCntJournal,
+		"\tcntjrnl:	Keep 64 bit totals of all the card counters in a journal file that survives card resets and power loss\n",
+		"\tUsage:		ioplus <stack> cntjrnl <file> [<seconds> [<period ms>]]\n", "",
+		"\tExample:		ioplus 0 cntjrnl /var/lib/ioplus/cnt0 0; Log the counters of Board #0 until stopped (0 seconds), then display the totals\n"};
+
+int doCntJournal(int argc, char *argv[])
+{
+	static IoplusCntJournalType journal;
+	int64_t total[IOPLUS_CNT_NO];
+	int period = CNT_JOURNAL_PERIOD_MS;
+	int seconds = 0;
+	int polls = 1;
+	int dev = 0;
+	int ret;
+	int i;
+
+	if ( (argc < 4) || (argc > 6))
+	{
+		return ARG_CNT_ERR;
+	}
+	if (argc > 4)
+	{
+		seconds = atoi(argv[4]);
+	}
+	if (argc > 5)
+	{
+		period = atoi(argv[5]);
+	}
+	if ( (seconds < 0) || (period <= 0))
+	{
+		printf("Invalid duration or period!\n");
+		return ARG_ERR;
+	}
+	dev = doBoardInit(atoi(argv[1]));
+	if (dev <= 0)
+	{
+		return (FAIL);
+	}
+	ret = ioplusCntJournalOpen(&journal, argv[3], CNT_JOURNAL_SYNC_MS,
+		CNT_JOURNAL_CKP_MS, CNT_JOURNAL_CKP_BYTES);
+	if (ret != IOPLUS_OK)
+	{
+		printf("Fail to open the journal %s: %s!\n", argv[3], ioplusErrStr(ret));
+		return (FAIL);
+	}
+	if (argc > 4)
+	{
+		polls = (seconds == 0) ? -1 : seconds * 1000 / period;
+		signal(SIGINT, runStop);
+		signal(SIGTERM, runStop);
+		busTokenRelease();
+	}
+	for (i = 0; (polls < 0 || i < polls) && !gRunStop; i++)
+	{
+		ret = ioplusCntJournalSample(boardHandle(dev), &journal);
+		if (ret != IOPLUS_OK)
+		{
+			printf("Fail to sample the counters: %s!\n", ioplusErrStr(ret));
+			break;
+		}
+		if (polls != 1)
+		{
+			busyWait(period);
+		}
+	}
+	if (IOPLUS_OK != ioplusCntJournalClose(&journal))
+	{
+		printf("Fail to save the checkpoint!\n");
+		ret = IOPLUS_ERR_IO;
+	}
+	ioplusCntJournalTotals(&journal, total);
+	for (i = 0; i < OPTO_CH_NO; i++)
+	{
+		printf("opto %d: %lld\n", i + 1, (long long)total[IOPLUS_CNT_OPTO + i]);
+	}
+	for (i = 0; i < GPIO_CH_NO; i++)
+	{
+		printf("gpio %d: %lld\n", i + 1, (long long)total[IOPLUS_CNT_GPIO + i]);
+	}
+	for (i = 0; i < OPTO_CH_NO / 2; i++)
+	{
+		printf("opto encoder %d: %lld\n", i + 1,
+			(long long)total[IOPLUS_CNT_OPTO_ENC + i]);
+	}
+	printf("gpio encoder: %lld\n", (long long)total[IOPLUS_CNT_GPIO_ENC]);
+	for (i = 0; i < OD_CH_NO; i++)
+	{
+		printf("od pulses %d: %lld\n", i + 1, (long long)total[IOPLUS_CNT_OD + i]);
+	}
+	if (journal.stats.dropped > 0)
+	{
+		printf("%u torn bytes dropped from the journal end\n",
+			journal.stats.dropped);
+	}
+	return (ret == IOPLUS_OK) ? OK : FAIL;
+}
+
+#define REC_PERIOD_MS	1000
+#define REC_FLUSH_MS	60000
+
+int doRec(int argc, char *argv[]);
+const CliCmdType CMD_REC =
+	{"rec", 2, &doRec,
+		"\trec:		Record every input and output of the card in a compact columnar log file, see logq\n",
+		"\tUsage:		ioplus <stack> rec <file> <seconds> [<period ms>]\n", "",
+		"\tExample:		ioplus 0 rec /var/log/ioplus0.rec 0 500; Record Board #0 every 500ms until stopped (0 seconds)\n"};
+
+int doRec(int argc, char *argv[])
+{
+	static IoplusRecorderType rec;
+	int period = REC_PERIOD_MS;
+	int polls;
+	int dev = 0;
+	int ret;
+	int i;
+
+	if ( (argc != 5) && (argc != 6))
+	{
+		return ARG_CNT_ERR;
+	}
+	if (argc == 6)
+	{
+		period = atoi(argv[5]);
+	}
+	if ( (atoi(argv[4]) < 0) || (period <= 0))
+	{
+		printf("Invalid duration or period!\n");
+		return ARG_ERR;
+	}
+	dev = doBoardInit(atoi(argv[1]));
+	if (dev <= 0)
+	{
+		return (FAIL);
+	}
+	ret = ioplusRecOpen(&rec, argv[3], atoi(argv[1]), REC_FLUSH_MS);
+	if (ret != IOPLUS_OK)
+	{
+		printf("Fail to open the log %s: %s!\n", argv[3], ioplusErrStr(ret));
+		return (FAIL);
+	}
+	polls = (atoi(argv[4]) == 0) ? -1 : atoi(argv[4]) * 1000 / period;
+	signal(SIGINT, runStop);
+	signal(SIGTERM, runStop);
+	busTokenRelease();
+	for (i = 0; (polls < 0 || i < polls) && !gRunStop; i++)
+	{
+		ret = ioplusRecSample(boardHandle(dev), &rec);
+		if (ret != IOPLUS_OK)
+		{
+			printf("Fail to record: %s!\n", ioplusErrStr(ret));
+			break;
+		}
+		busyWait(period);
+	}
+	if (IOPLUS_OK != ioplusRecClose(&rec))
+	{
+		printf("Fail to write the log!\n");
+		ret = IOPLUS_ERR_IO;
+	}
+	printf("%llu samples, %llu bytes in %u chunks\n", (unsigned long long)rec.total,
+		(unsigned long long)rec.bytes, rec.chunks);
+	return (ret == IOPLUS_OK) ? OK : FAIL;
+}
+
+/* "<n>[s|m|h|d]", seconds without unit */
+static int logDurationParse(const char *str, int64_t *ms)
+{
+	long long val = 0;
+	char unit = 's';
+	char extra;
+
+	if ( (sscanf(str, "%lld%c%c", &val, &unit, &extra) > 2) || (val < 0))
+	{
+		return ERROR;
+	}
+	switch (unit)
+	{
+	case 's':
+		*ms = (int64_t)val * 1000;
+		break;
+	case 'm':
+		*ms = (int64_t)val * 60000;
+		break;
+	case 'h':
+		*ms = (int64_t)val * 3600000;
+		break;
+	case 'd':
+		*ms = (int64_t)val * 86400000;
+		break;
+	default:
+		return ERROR;
+	}
+	return (isdigit((unsigned char)str[0])) ? OK : ERROR;
+}
+
+static int64_t logNowMs(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_REALTIME, &ts);
+	return (int64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+/* "now", "-<n>[s|m|h|d]" before now, seconds since the epoch or local
+ * "YYYY-MM-DD[ HH:MM[:SS]]" */
+static int logTimeParse(const char *str, int64_t *ms)
+{
+	struct tm tm;
+	long long val = 0;
+	char extra;
+
+	if (0 == strcmp(str, "now"))
+	{
+		*ms = logNowMs();
+		return OK;
+	}
+	if (str[0] == '-')
+	{
+		if (OK != logDurationParse(str + 1, ms))
+		{
+			return ERROR;
+		}
+		*ms = logNowMs() - *ms;
+		return OK;
+	}
+	memset(&tm, 0, sizeof(tm));
+	if (sscanf(str, "%d-%d-%d%*c%d:%d:%d", &tm.tm_year, &tm.tm_mon, &tm.tm_mday,
+		&tm.tm_hour, &tm.tm_min, &tm.tm_sec) >= 3)
+	{
+		tm.tm_year -= 1900;
+		tm.tm_mon -= 1;
+		tm.tm_isdst = -1;
+		*ms = (int64_t)mktime(&tm) * 1000;
+		return OK;
+	}
+	if (1 == sscanf(str, "%lld%c", &val, &extra))
+	{
+		*ms = (int64_t)val * 1000;
+		return OK;
+	}
+	return ERROR;
+}
+
+static void logTimePrint(int64_t ms)
+{
+	time_t sec = (time_t) (ms / 1000);
+	struct tm tm;
+	char buff[32];
+
+	localtime_r(&sec, &tm);
+	strftime(buff, sizeof(buff), "%Y-%m-%d %H:%M:%S", &tm);
+	printf("%s.%03d", buff, (int) (ms % 1000));
+}
+
+static int logPointPrint(void *ctx, const IoplusRecPointType *p)
+{
+	int64_t step = *(int64_t*)ctx;
+
+	logTimePrint(p->t);
+	if (step == 0)
+	{
+		printf(" %lld\n", (long long)p->min);
+	}
+	else
+	{
+		printf(" %lld %0.2f %lld %u\n", (long long)p->min, p->avg,
+			(long long)p->max, p->count);
+	}
+	return 0;
+}
+
+int doLogQuery(int argc, char *argv[]);
+const CliCmdType CMD_LOG_QUERY =
+	{"logq", 1, &doLogQuery,
+		"\tlogq:		Query a log written by rec: one signal over a time range, optionally downsampled to min / avg / max per step\n",
+		"\tUsage:		ioplus logq <file> [<signal> [<from> [<to> [<step>]]]]\n",
+		"\tUsage:		time: now, -<n>[s|m|h|d], seconds since 1970 or \"YYYY-MM-DD HH:MM:SS\"; step: <n>[s|m|h|d]\n",
+		"\tExample:		ioplus logq /var/log/ioplus0.rec adc1 -1d now 1h; Hourly min / avg / max of ADC channel #1 over the last day\n"};
+
+int doLogQuery(int argc, char *argv[])
+{
+	IoplusRecReaderType r;
+	IoplusRecInfoType info;
+	int64_t from = INT64_MIN;
+	int64_t to = INT64_MAX;
+	int64_t step = 0;
+	int col = 0;
+	int ret;
+	int i;
+
+	if ( (argc < 3) || (argc > 7))
+	{
+		return ARG_CNT_ERR;
+	}
+	if (argc > 3)
+	{
+		col = ioplusRecColFind(argv[3]);
+		if (col <= 0)
+		{
+			printf("Unknown signal %s, run ioplus logq <file> for the list!\n", argv[3]);
+			return ARG_ERR;
+		}
+	}
+	if ( ( (argc > 4) && (OK != logTimeParse(argv[4], &from)))
+		|| ( (argc > 5) && (OK != logTimeParse(argv[5], &to))))
+	{
+		printf("Invalid time!\n");
+		return ARG_ERR;
+	}
+	if ( (argc > 6) && (OK != logDurationParse(argv[6], &step)))
+	{
+		printf("Invalid step!\n");
+		return ARG_ERR;
+	}
+	ret = ioplusRecReaderOpen(&r, argv[2]);
+	if (ret != IOPLUS_OK)
+	{
+		printf("Fail to open the log %s: %s!\n", argv[2], ioplusErrStr(ret));
+		return (FAIL);
+	}
+	if (col == 0)
+	{
+		ioplusRecInfo(&r, &info);
+		printf("stack %d, %llu samples in %u chunks, %llu bytes", r.stack,
+			(unsigned long long)info.samples, info.chunks,
+			(unsigned long long)info.bytes);
+		if (info.samples > 0)
+		{
+			printf(" (%0.1f bytes / sample)\nfrom ", (double)info.bytes / info.samples);
+			logTimePrint(info.firstMs);
+			printf(" to ");
+			logTimePrint(info.lastMs);
+		}
+		printf("\nsignals:");
+		for (i = 1; i < IOPLUS_REC_COL_NO; i++)
+		{
+			printf(" %s", ioplusRecColName(i));
+		}
+		printf("\n");
+		ioplusRecReaderClose(&r);
+		return OK;
+	}
+	ret = ioplusRecQuery(&r, col, from, to, step, logPointPrint, &step);
+	ioplusRecReaderClose(&r);
+	if (ret != IOPLUS_OK)
+	{
+		printf("Damaged log: %s!\n", ioplusErrStr(ret));
+		return (FAIL);
+	}
+	return OK;
+}
+
+#define CAL_TIMEOUT_MS	1000
+
+int getCalStat(int dev)
+{
+	int status = 0;
+	int ret;
+
+	ret = ioplusCalWait(boardHandle(dev), CAL_TIMEOUT_MS, &status);
+	if ( (IOPLUS_OK != ret) && (IOPLUS_ERR_TIMEOUT != ret))
+	{
+		printf("Fail to read calibration status!\n");
+		return FAIL;
+	}
+	switch (status)
+	{
+	case IOPLUS_CAL_IN_PROGRESS:
+		printf("Calibration in progress\n");
+		break;
+	case IOPLUS_CAL_DONE:
+		printf("Calibration done\n");
+		break;
+	case IOPLUS_CAL_ERROR:
+		printf("Calibration error!\n");
+		break;
+	default:
+		printf("Unknown calibration status\n");
+		break;
+	}
+	return OK;
+}
+
+int doAdcCal(int argc, char *argv[]);
+const CliCmdType CMD_ADC_CAL =
+	{"adccal", 2, &doAdcCal,
+		"\tadccal:		Calibrate one ADC channel, the calibration must be done in 2 points at min 2V apart\n",
+		"\tUsage:		ioplus <stack> adccal <channel> <value>\n", "",
+		"\tExample:		ioplus 0 adccal 2 0.5; Calibrate the voltage input on ADC channel #2 on Board #0 at 0.5V\n"};
+
+int doAdcCal(int argc, char *argv[])
+{
+	int ch = 0;
+	float val = 0;
+	int dev = 0;
+	u16 raw = 0;
+
+	dev = doBoardInit(atoi(argv[1]));
+	if (dev <= 0)
+	{
+		return (FAIL);
+	}
+
+	if (argc == 5)
+	{
+		ch = atoi(argv[3]);
+		if ( (ch < CHANNEL_NR_MIN) || (ch > ADC_CH_NR_MAX))
+		{
+			printf("ADC channel out of range!\n");
+			return (FAIL);
+		}
+
+		val = atof(argv[4]);
+		if ( (val < 0) || (val > 3.3))
+		{
+			printf("ADC calibration value out of range!\n");
+			return (FAIL);
+		}
+		raw = (u16)ceil(val * VOLT_TO_MILIVOLT);
+		if (IOPLUS_OK != ioplusAdcCalSet(boardHandle(dev), ch, raw))
+		{
+			printf("Fail to write calibration data!\n");
+			return (FAIL);
+		}
+
+		getCalStat(dev);
+	}
+	else
+	{
+		printf("Invalid params number:\n %s", CMD_ADC_CAL.usage1);
+		return (FAIL);
+	}
+	return OK;
 }
 
 int doAdcCalRst(int argc, char *argv[]);
@@ -2043,7 +2491,6 @@ int doAdcCalRst(int argc, char *argv[])
 	int ch = 0;
 
 	int dev = 0;
-	u8 buff[4] = {0, 0, 0, 0};
 
 	dev = doBoardInit(atoi(argv[1]));
 	if (dev <= 0)
@@ -2060,10 +2507,7 @@ int doAdcCalRst(int argc, char *argv[])
 			return (FAIL);
 		}
 
-		buff[2] = ch;
-		buff[3] = RESET_CALIBRATION_KEY;
-
-		if (OK != i2cMem8Write(dev, I2C_MEM_CALIB_VALUE, buff, 4))
+		if (IOPLUS_OK != ioplusAdcCalReset(boardHandle(dev), ch))
 		{
 			printf("Fail to write calibration data!\n");
 			return (FAIL);
@@ -2091,7 +2535,6 @@ int doDacCal(int argc, char *argv[])
 	int ch = 0;
 	float val = 0;
 	int dev = 0;
-	u8 buff[4] = {0, 0};
 	u16 raw = 0;
 
 	dev = doBoardInit(atoi(argv[1]));
@@ -2116,11 +2559,7 @@ int doDacCal(int argc, char *argv[])
 			return (FAIL);
 		}
 		raw = (u16)ceil(val * VOLT_TO_MILIVOLT);
-		memcpy(buff, &raw, 2);
-		buff[2] = ch + ADC_CH_NR_MAX;
-		buff[3] = CALIBRATION_KEY;
-
-		if (OK != i2cMem8Write(dev, I2C_MEM_CALIB_VALUE, buff, 4))
+		if (IOPLUS_OK != ioplusDacCalSet(boardHandle(dev), ch, raw))
 		{
 			printf("Fail to write calibration data!\n");
 			return (FAIL);
@@ -2148,8 +2587,6 @@ int doDacCalRst(int argc, char *argv[])
 	int ch = 0;
 
 	int dev = 0;
-	u8 buff[4] = {0, 0, 0, 0};
-	u16 raw = 0;
 
 	dev = doBoardInit(atoi(argv[1]));
 	if (dev <= 0)
@@ -2166,11 +2603,7 @@ int doDacCalRst(int argc, char *argv[])
 			return (FAIL);
 		}
 
-		memcpy(buff, &raw, 2);
-		buff[2] = ch + ADC_CH_NR_MAX;
-		buff[3] = RESET_CALIBRATION_KEY;
-
-		if (OK != i2cMem8Write(dev, I2C_MEM_CALIB_VALUE, buff, 4))
+		if (IOPLUS_OK != ioplusDacCalReset(boardHandle(dev), ch))
 		{
 			printf("Fail to write calibration data!\n");
 			return (FAIL);
@@ -2195,7 +2628,6 @@ const CliCmdType CMD_WDT_RELOAD =
 int doWdtReload(int argc, char *argv[])
 {
 	int dev = 0;
-	u8 buff[2] = {0, 0};
 
 	dev = doBoardInit(atoi(argv[1]));
 	if (dev <= 0)
@@ -2205,8 +2637,7 @@ int doWdtReload(int argc, char *argv[])
 
 	if (argc == 3)
 	{
-		buff[0] = WDT_RESET_SIGNATURE;
-		if (OK != i2cMem8Write(dev, I2C_MEM_WDT_RESET_ADD, buff, 1))
+		if (IOPLUS_OK != ioplusWdtReload(boardHandle(dev)))
 		{
 			printf("Fail to write watchdog reset key!\n");
 			return (FAIL);
@@ -2231,7 +2662,6 @@ int doWdtSetPeriod(int argc, char *argv[])
 {
 	int dev = 0;
 	u16 period;
-	u8 buff[2] = {0, 0};
 
 	dev = doBoardInit(atoi(argv[1]));
 	if (dev <= 0)
@@ -2247,8 +2677,7 @@ int doWdtSetPeriod(int argc, char *argv[])
 			printf("Invalid period!\n");
 			return (FAIL);
 		}
-		memcpy(buff, &period, 2);
-		if (OK != i2cMem8Write(dev, I2C_MEM_WDT_INTERVAL_SET_ADD, buff, 2))
+		if (IOPLUS_OK != ioplusWdtPeriodSet(boardHandle(dev), period))
 		{
 			printf("Fail to write watchdog period!\n");
 			return (FAIL);
@@ -2282,7 +2711,7 @@ int doWdtGetPeriod(int argc, char *argv[])
 
 	if (argc == 3)
 	{
-		if (OK != i2cReadWordAS(dev, I2C_MEM_WDT_INTERVAL_GET_ADD, &period))
+		if (IOPLUS_OK != ioplusWdtPeriodGet(boardHandle(dev), &period))
 		{
 			printf("Fail to read watchdog period!\n");
 			return (FAIL);
@@ -2308,7 +2737,6 @@ int doWdtSetInitPeriod(int argc, char *argv[])
 {
 	int dev = 0;
 	u16 period;
-	u8 buff[2] = {0, 0};
 
 	dev = doBoardInit(atoi(argv[1]));
 	if (dev <= 0)
@@ -2324,8 +2752,7 @@ int doWdtSetInitPeriod(int argc, char *argv[])
 			printf("Invalid period!\n");
 			return (FAIL);
 		}
-		memcpy(buff, &period, 2);
-		if (OK != i2cMem8Write(dev, I2C_MEM_WDT_INIT_INTERVAL_SET_ADD, buff, 2))
+		if (IOPLUS_OK != ioplusWdtInitPeriodSet(boardHandle(dev), period))
 		{
 			printf("Fail to write watchdog period!\n");
 			return (FAIL);
@@ -2359,7 +2786,7 @@ int doWdtGetInitPeriod(int argc, char *argv[])
 
 	if (argc == 3)
 	{
-		if (OK != i2cReadWordAS(dev, I2C_MEM_WDT_INIT_INTERVAL_GET_ADD, &period))
+		if (IOPLUS_OK != ioplusWdtInitPeriodGet(boardHandle(dev), &period))
 		{
 			printf("Fail to read watchdog period!\n");
 			return (FAIL);
@@ -2385,7 +2812,6 @@ int doWdtSetOffPeriod(int argc, char *argv[])
 {
 	int dev = 0;
 	u32 period;
-	u8 buff[4] = {0, 0, 0, 0};
 
 	dev = doBoardInit(atoi(argv[1]));
 	if (dev <= 0)
@@ -2401,9 +2827,7 @@ int doWdtSetOffPeriod(int argc, char *argv[])
 			printf("Invalid period!\n");
 			return (FAIL);
 		}
-		memcpy(buff, &period, 4);
-		if (OK
-			!= i2cMem8Write(dev, I2C_MEM_WDT_POWER_OFF_INTERVAL_SET_ADD, buff, 4))
+		if (IOPLUS_OK != ioplusWdtOffPeriodSet(boardHandle(dev), period))
 		{
 			printf("Fail to write watchdog period!\n");
 			return (FAIL);
@@ -2437,9 +2861,7 @@ int doWdtGetOffPeriod(int argc, char *argv[])
 
 	if (argc == 3)
 	{
-		if (OK
-			!= i2cReadDWordAS(dev, I2C_MEM_WDT_POWER_OFF_INTERVAL_GET_ADD,
-				&period))
+		if (IOPLUS_OK != ioplusWdtOffPeriodGet(boardHandle(dev), &period))
 		{
 			printf("Fail to read watchdog period!\n");
 			return (FAIL);
@@ -2454,6 +2876,24 @@ int doWdtGetOffPeriod(int argc, char *argv[])
 	return OK;
 }
 
+const CliCmdType CMD_CAL_RUN =
+	{"calrun", 1, &doCalRun,
+		"\tcalrun:		Run a calibration plan file on one or more cards in parallel and print the report\n",
+		"\tUsage:		ioplus calrun <plan file> <stack> [<stack>...]\n", "",
+		"\tExample:		ioplus calrun adc.plan 0 1 2; Calibrate the cards #0, #1 and #2 as described in adc.plan\n"};
+
+const CliCmdType CMD_MODBUS =
+	{"modbus", 2, &doModbus,
+		"\tmodbus:		Serve the card over Modbus TCP until stopped, see README for the register map\n",
+		"\tUsage:		ioplus <stack> modbus [<port> [<refresh ms>]]\n", "",
+		"\tExample:		ioplus 0 modbus 1502 20; Serve Board #0 on port 1502, inputs refreshed every 20ms\n"};
+
+const CliCmdType CMD_METRICS =
+	{"metrics", 1, &doMetrics,
+		"\tmetrics:		Serve the telemetry of all the cards to Prometheus until stopped\n",
+		"\tUsage:		ioplus metrics [[<address>:]<port> [<poll period ms>]]\n", "",
+		"\tExample:		ioplus metrics 0.0.0.0:9712 500; Poll the cards every 500ms, serve http://<host>:9712/metrics on every interface\n"};
+
 int doLoopbackTest(int argc, char *argv[]);
 const CliCmdType CMD_IO_TEST = {"iotest", 2, &doLoopbackTest,
 	"\tiotest:		Test the ioplus with loopback card inserted \n",
@@ -2467,7 +2907,7 @@ int pwmFreqGet(int dev, int *val)
 {
 	u16 raw = 0;
 
-	if (OK != i2cReadWordAS(dev, I2C_MEM_OD_PWM_FREQUENCY, &raw))
+	if (IOPLUS_OK != ioplusOdPwmFreqGet(boardHandle(dev), &raw))
 	{
 		printf("Fail to read!\n");
 		return ERROR;
@@ -2478,9 +2918,6 @@ int pwmFreqGet(int dev, int *val)
 
 int pwmFreqSet(int dev, int val)
 {
-	u8 buff[2] = {0, 0};
-	u16 raw = 0;
-
 	if (val < 10)
 	{
 		val = 10;
@@ -2489,9 +2926,7 @@ int pwmFreqSet(int dev, int val)
 	{
 		val = 65500;
 	}
-	raw = (u16)val;
-	memcpy(buff, &raw, 2);
-	if (OK != i2cMem8Write(dev, I2C_MEM_OD_PWM_FREQUENCY, buff, 2))
+	if (IOPLUS_OK != ioplusOdPwmFreqSet(boardHandle(dev), (u16)val))
 	{
 		printf("Fail to write!\n");
 		return ERROR;
@@ -2501,9 +2936,6 @@ int pwmFreqSet(int dev, int val)
 
 int pwmChFreqSet(int dev, int ch, int val)
 {
-	u8 buff[2] = {0, 0};
-	u16 raw = 0;
-
 	if (val < 10)
 	{
 		val = 10;
@@ -2512,11 +2944,7 @@ int pwmChFreqSet(int dev, int ch, int val)
 	{
 		val = 65500;
 	}
-	raw = (u16)val;
-	memcpy(buff, &raw, 2);
-	if (OK
-		!= i2cMem8Write(dev, I2C_MEM_OD_PWM_FREQUENCY_CH1 + (ch - 1) * 2, buff,
-			2))
+	if (IOPLUS_OK != ioplusOdPwmChFreqSet(boardHandle(dev), ch, (u16)val))
 	{
 		printf("Fail to write!\n");
 		return ERROR;
@@ -2541,7 +2969,7 @@ int doPwmFreqRead(int argc, char *argv[])
 	{
 		return (FAIL);
 	}
-	if (gHwVer < 3)
+	if (getHwVer() < 3)
 	{
 		printf(
 			"This feature is available on hardware versions greater or equal to 3.0!\n");
@@ -2585,7 +3013,7 @@ int doPwmFreqWrite(int argc, char *argv[])
 	{
 		return (FAIL);
 	}
-	if (gHwVer < 3)
+	if (getHwVer() < 3)
 	{
 		printf(
 			"This feature is available on hardware versions greater or equal to 3.0!\n");
@@ -2642,9 +3070,6 @@ int doPwmFreqWrite(int argc, char *argv[])
 
 int odOutMoveSet(int dev, int ch, int acc, int dec, int minSpd, int maxSpd)
 {
-	uint8_t buff[8];
-	uint16_t aux16 = 0;
-
 	if (ch <= 0 || ch > 4)
 	{
 		printf("invalid Channel number [1..4]\n");
@@ -2663,28 +3088,16 @@ int odOutMoveSet(int dev, int ch, int acc, int dec, int minSpd, int maxSpd)
 	if (maxSpd < MIN_SPEED || maxSpd > MAX_SPEED)
 	{
 		printf("Invalid speed [10..60000]\n");
+		return -1;
 	}
 
 	if (minSpd < MIN_SPEED || minSpd > maxSpd)
 	{
 		printf("Invalid speed [10..60000]\n");
-	}
-
-	aux16 = (u16)acc;
-	memcpy(buff, &aux16, sizeof(uint16_t));
-	aux16 = (u16)dec;
-	memcpy(buff + 2, &aux16, sizeof(uint16_t));
-	aux16 = (u16)maxSpd;
-	memcpy(buff + 4, &aux16, sizeof(uint16_t));
-	aux16 = (u16)minSpd;
-	memcpy(buff + 6, &aux16, sizeof(uint16_t));
-	if (OK != i2cMem8Write(dev, I2C_MEM_ODP_ACC, buff, 8))
-	{
-		printf("Fail to write\n");
 		return -1;
 	}
-	buff[0] = (uint8_t)ch;
-	if (OK != i2cMem8Write(dev, I2C_MEM_ODP_CMD, buff, 1))
+	if (IOPLUS_OK
+		!= ioplusOdMoveSet(boardHandle(dev), ch, acc, dec, minSpd, maxSpd))
 	{
 		printf("Fail to write\n");
 		return -1;
@@ -2714,7 +3127,7 @@ int doMoveParWrite(int argc, char *argv[])
 		{
 			return (FAIL);
 		}
-		if (gHwVer < 3)
+		if (getHwVer() < 3)
 		{
 			printf(
 				"This feature is available on hardware versions greater or equal to 3.0!\n");
@@ -2735,25 +3148,865 @@ int doMoveParWrite(int argc, char *argv[])
 	return odOutMoveSet(dev, channel, acc, dec, minSpd, maxSpd);
 }
 
-//***************************************************MIN/MAX sample count read write**********************************************
-int minMaxSamplesGet(int dev, int *val)
+#define MOVE_SEG_MAX	IOPLUS_MOTION_QUEUE_MAX
+
+typedef struct
 {
-	u8 raw = 0;
+	struct timespec start;
+	int failed;
+} MoveRunType;
 
-	if (OK != i2cReadByteAS(dev, I2C_MEM_MIN_MAX_SAMPLES, &raw))
+static void moveEvent(void *ctx, int ch, const IoplusMoveType *mv, int event)
+{
+	static const char *eventName[] = {"done", "failed", "cancelled"};
+	MoveRunType *run = (MoveRunType*)ctx;
+	struct timespec now;
+
+	UNUSED(ch);
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	printf("%8.3f segment %u %s\n",
+		(now.tv_sec - run->start.tv_sec)
+			+ (now.tv_nsec - run->start.tv_nsec) / 1e9, mv->tag, eventName[event]);
+	if (event != IOPLUS_MOVE_DONE)
 	{
-		printf("Fail to read!\n");
-		return ERROR;
+		run->failed = 1;
 	}
-	*val = raw;
-	return OK;
 }
 
-int minMaxSamplesSet(int dev, int val)
+// <pulses>[:<acc>:<dec>:<min speed>:<max speed>], negative pulses in reverse
+static int moveSegParse(const char *arg, IoplusMoveType *mv)
 {
-	u8 buff[2] = {0, 0};
+	char *end;
+	long long pulses;
+	int prof[4];
+	int n = 0;
 
-	if (val < 5)
+	memset(mv, 0, sizeof(IoplusMoveType));
+	pulses = strtoll(arg, &end, 10);
+	if ( (end == arg) || (pulses == 0) || (llabs(pulses) > 0xffffffffLL))
+	{
+		return ERROR;
+	}
+	if (*end == ':')
+	{
+		if ( (sscanf(end + 1, "%d:%d:%d:%d%n", &prof[0], &prof[1], &prof[2],
+			&prof[3], &n) != 4) || (end[1 + n] != 0) || (prof[0] < 0)
+			|| (prof[1] < 0) || (prof[2] <= 0) || (prof[3] <= 0)
+			|| (prof[0] > MAX_ACC) || (prof[1] > MAX_ACC) || (prof[3] > MAX_SPEED))
+		{
+			return ERROR;
+		}
+		mv->acc = (uint16_t)prof[0];
+		mv->dec = (uint16_t)prof[1];
+		mv->minSpd = (uint16_t)prof[2];
+		mv->maxSpd = (uint16_t)prof[3];
+	}
+	else if (*end != 0)
+	{
+		return ERROR;
+	}
+	mv->reverse = pulses < 0;
+	mv->pulses = (uint32_t)llabs(pulses);
+	return OK;
+}
+
+int doMove(int argc, char *argv[]);
+const CliCmdType CMD_MOVE =
+	{"move", 2, &doMove,
+		"\tmove:		Run a sequence of pulse trains on one open drain channel, each one started as soon as the previous one ends\n",
+		"\tUsage:		ioplus <stack> move <channel> <pulses>[:<acc>:<dec>:<min_speed>:<max_speed>] ...\n",
+		"\tUsage:		negative pulses are sent in reverse (channel + 4), a profile needs hardware 3.0 and up\n",
+		"\tExample:		ioplus 0 move 1 2000:1000:500:100:5000 -500 3000; 2000 pulses with a new movement profile, 500 in reverse, then 3000 on open drain channel #1 of Board #0\n"};
+
+int doMove(int argc, char *argv[])
+{
+	static IoplusMotionType motion;
+	IoplusMotionStatsType st;
+	IoplusMoveType mv;
+	MoveRunType run;
+	uint32_t wait = 0;
+	int ch = 0;
+	int dev = 0;
+	int ret = IOPLUS_OK;
+	int i;
+
+	if ( (argc < 5) || (argc > 4 + MOVE_SEG_MAX))
+	{
+		return ARG_CNT_ERR;
+	}
+	ch = atoi(argv[3]);
+	if ( (ch < CHANNEL_NR_MIN) || (ch > OD_CH_NR_MAX))
+	{
+		printf("Open drain channel out of range!\n");
+		return ARG_ERR;
+	}
+	memset(&run, 0, sizeof(run));
+	ioplusMotionInit(&motion, 0, 0, moveEvent, &run);
+	for (i = 4; i < argc; i++)
+	{
+		if (OK != moveSegParse(argv[i], &mv))
+		{
+			printf("Invalid segment \"%s\"!\n", argv[i]);
+			return ARG_ERR;
+		}
+		mv.tag = i - 3;
+		if (IOPLUS_OK != ioplusMotionQueue(&motion, ch, &mv))
+		{
+			printf("Invalid segment \"%s\"!\n", argv[i]);
+			return ARG_ERR;
+		}
+	}
+	dev = doBoardInit(atoi(argv[1]));
+	if (dev <= 0)
+	{
+		return (FAIL);
+	}
+	signal(SIGINT, runStop);
+	signal(SIGTERM, runStop);
+	busTokenRelease();
+	clock_gettime(CLOCK_MONOTONIC, &run.start);
+	while ( (ioplusMotionPending(&motion, ch) > 0) && !gRunStop)
+	{
+		ret = ioplusMotionPoll(boardHandle(dev), &motion, &wait);
+		if (ret != IOPLUS_OK)
+		{
+			printf("Fail to run the segments: %s!\n", ioplusErrStr(ret));
+			break;
+		}
+		if (wait != 0)
+		{
+			usleep(wait);
+		}
+	}
+	if (ioplusMotionPending(&motion, ch) > 0)
+	{
+		ioplusMotionStop(boardHandle(dev), &motion, ch);
+	}
+	ioplusMotionStatsGet(&motion, ch, &st);
+	printf("%u segments done, %u polls\n", st.done, st.polls);
+	if (st.transitions > 0)
+	{
+		printf("gap between segments min %u us, avg %u us, max %u us, %u late\n",
+			st.gapMinUs, (unsigned)(st.gapSumUs / st.transitions), st.gapMaxUs,
+			st.late);
+	}
+	return (ret == IOPLUS_OK && !run.failed && !gRunStop) ? OK : FAIL;
+}
+
+#define RULES_PERIOD_MS	1
+
+static void rulesChangePrint(const struct timespec *start, uint32_t changed,
+	uint32_t out)
+{
+	static const char *outName[] = {"relay", "gpio", "od"};
+	static const int outBase[] = {IOPLUS_RULE_OUT_RELAY, IOPLUS_RULE_OUT_GPIO,
+		IOPLUS_RULE_OUT_OD};
+	struct timespec now;
+	int grp;
+	int i;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	for (i = 0; i < IOPLUS_RULE_OUT_NO; i++)
+	{
+		if (changed & (1UL << i))
+		{
+			grp = (i >= IOPLUS_RULE_OUT_OD) ? 2 : (i >= IOPLUS_RULE_OUT_GPIO);
+			printf("%10.3f %s%d %s\n",
+				(now.tv_sec - start->tv_sec) + (now.tv_nsec - start->tv_nsec) / 1e9,
+				outName[grp], i - outBase[grp] + 1, ( (out >> i) & 1) ? "on" : "off");
+		}
+	}
+}
+
+int doRules(int argc, char *argv[]);
+const CliCmdType CMD_RULES =
+	{"rules", 2, &doRules,
+		"\trules:		Run interlock rules from a file (\"relay3 = !(opto1 & adc2 > 5.0)\") until stopped, writing only the outputs that change\n",
+		"\tUsage:		ioplus <stack> rules <file> [<period ms>]\n", "",
+		"\tExample:		ioplus 0 rules /etc/ioplus.rules 1; Evaluate the rules on Board #0 inputs every millisecond\n"};
+
+int doRules(int argc, char *argv[])
+{
+	static IoplusRulesType rules;
+	IoplusRulesStatsType st;
+	struct timespec start;
+	struct timespec next;
+	uint32_t changed = 0;
+	int period = RULES_PERIOD_MS;
+	int failing = 0;
+	int dev = 0;
+	int ret;
+
+	if ( (argc < 4) || (argc > 5))
+	{
+		return ARG_CNT_ERR;
+	}
+	if (argc > 4)
+	{
+		period = atoi(argv[4]);
+	}
+	if (period < 0)
+	{
+		printf("Invalid period!\n");
+		return ARG_ERR;
+	}
+	ret = ioplusRulesLoad(&rules, argv[3]);
+	if (ret != IOPLUS_OK)
+	{
+		if (rules.errLine > 0)
+		{
+			printf("%s:%d: %s\n", argv[3], rules.errLine, rules.err);
+		}
+		else
+		{
+			printf("%s: %s\n", argv[3], rules.err);
+		}
+		return ARG_ERR;
+	}
+	dev = doBoardInit(atoi(argv[1]));
+	if (dev <= 0)
+	{
+		return (FAIL);
+	}
+	signal(SIGINT, runStop);
+	signal(SIGTERM, runStop);
+	busTokenRelease();
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	next = start;
+	while (!gRunStop)
+	{
+		ret = ioplusRulesStep(boardHandle(dev), &rules, &changed);
+		if ( (ret != IOPLUS_OK) && !failing)
+		{
+			printf("Fail to run the rules: %s!\n", ioplusErrStr(ret));
+		}
+		failing = ret != IOPLUS_OK;
+		if (changed)
+		{
+			rulesChangePrint(&start, changed, rules.out);
+		}
+		if (period > 0)
+		{
+			next.tv_nsec += period * 1000000L;
+			next.tv_sec += next.tv_nsec / 1000000000L;
+			next.tv_nsec %= 1000000000L;
+			clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, NULL);
+		}
+	}
+	ioplusRulesStatsGet(&rules, &st);
+	printf("%u cycles, %u with output changes, %u outputs written, %u errors\n",
+		st.cycles, st.changes, st.writes, st.errors);
+	if (st.evals > 0)
+	{
+		printf("evaluation min %u ns, avg %u ns, max %u ns\n", st.evalNsMin,
+			(unsigned) (st.evalNsSum / st.evals), st.evalNsMax);
+	}
+	if (st.changes > 0)
+	{
+		printf("input read to output written min %u us, avg %u us, max %u us\n",
+			st.reactUsMin, (unsigned) (st.reactUsSum / st.changes), st.reactUsMax);
+	}
+	return OK;
+}
+
+#define WATCH_POLL_MS	10
+#define WATCH_FALLBACK_MS	1000
+#define WATCH_PARTS	(IOPLUS_SNAP_DIGITAL | IOPLUS_SNAP_COUNTERS)
+
+static void watchChangePrint(const struct timespec *start,
+	const IoplusSnapshotType *prev, const IoplusSnapshotType *cur,
+	const char *cause)
+{
+	struct timespec now;
+	int i;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	printf("%10.3f %-8s opto 0x%02x gpio 0x%x",
+		(now.tv_sec - start->tv_sec) + (now.tv_nsec - start->tv_nsec) / 1e9, cause,
+		cur->opto, cur->gpio);
+	for (i = 0; i < IOPLUS_CNT_NO; i++)
+	{
+		if (cur->cnt[i] != prev->cnt[i])
+		{
+			printf(" cnt%d=%u", i + 1, (unsigned)cur->cnt[i]);
+		}
+	}
+	printf("\n");
+}
+
+int doInWatch(int argc, char *argv[]);
+const CliCmdType CMD_IN_WATCH =
+	{"inwatch", 2, &doInWatch,
+		"\tinwatch:	Print the opto, gpio and counter changes until stopped, polling the card or reading it on the edges of a Raspberry Pi GPIO line\n",
+		"\tUsage:		ioplus <stack> inwatch [<period ms>]\n",
+		"\tUsage:		ioplus <stack> inwatch <gpiochip>:<line>[:rising|falling|both] [<fallback period ms>]\n",
+		"\tExample:		ioplus 0 inwatch gpiochip0:17:falling 1000; Read Board #0 inputs on every falling edge of GPIO17, and every second without edges\n"};
+
+int doInWatch(int argc, char *argv[])
+{
+	static IoplusAttnType attn;
+	IoplusSnapshotType prev;
+	IoplusSnapshotType cur;
+	IoplusAttnStatsType ast;
+	I2cStatType st[I2C_OP_NO];
+	struct timespec start;
+	struct timespec end;
+	char chip[32];
+	char edgeName[8] = "both";
+	double sec;
+	int period = 0;
+	int line = -1;
+	int edge = IOPLUS_EDGE_BOTH;
+	int byEdge = 0;
+	int reads = 0;
+	int dev = 0;
+	int ret = IOPLUS_OK;
+	int arg = 3;
+
+	if ( (argc < 3) || (argc > 5))
+	{
+		return ARG_CNT_ERR;
+	}
+	if ( (argc > arg) && strchr(argv[arg], ':'))
+	{
+		if ( (sscanf(argv[arg], "%31[^:]:%d:%7s", chip, &line, edgeName) < 2)
+			|| (line < 0))
+		{
+			printf("Invalid GPIO line \"%s\"!\n", argv[arg]);
+			return ARG_ERR;
+		}
+		if (strcmp(edgeName, "rising") == 0)
+		{
+			edge = IOPLUS_EDGE_RISING;
+		}
+		else if (strcmp(edgeName, "falling") == 0)
+		{
+			edge = IOPLUS_EDGE_FALLING;
+		}
+		else if (strcmp(edgeName, "both") != 0)
+		{
+			printf("Invalid edge \"%s\"!\n", edgeName);
+			return ARG_ERR;
+		}
+		arg++;
+	}
+	period = (line < 0) ? WATCH_POLL_MS : WATCH_FALLBACK_MS;
+	if (argc > arg)
+	{
+		period = atoi(argv[arg++]);
+	}
+	if ( (argc > arg) || (period <= 0))
+	{
+		printf("Invalid period!\n");
+		return ARG_ERR;
+	}
+	dev = doBoardInit(atoi(argv[1]));
+	if (dev <= 0)
+	{
+		return (FAIL);
+	}
+	if (line >= 0)
+	{
+		ret = ioplusAttnOpen(&attn, chip, line, edge, 0, period);
+		if (ret != IOPLUS_OK)
+		{
+			printf("Fail to request %s line %d: %s!\n", chip, line,
+				ioplusErrStr(ret));
+			return (FAIL);
+		}
+	}
+	i2cStatsEnable(1);
+	i2cStatsReset();
+	signal(SIGINT, runStop);
+	signal(SIGTERM, runStop);
+	busTokenRelease();
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	memset(&cur, 0, sizeof(cur));
+	while (!gRunStop)
+	{
+		prev = cur;
+		if (line >= 0)
+		{
+			ret = ioplusAttnWait(boardHandle(dev), &attn, &cur, WATCH_PARTS, &byEdge);
+		}
+		else
+		{
+			ret = ioplusSnapshotPartGet(boardHandle(dev), &cur, WATCH_PARTS);
+		}
+		if (ret != IOPLUS_OK)
+		{
+			printf("Fail to read the inputs: %s!\n", ioplusErrStr(ret));
+			break;
+		}
+		if ( (reads++ == 0) || (cur.opto != prev.opto) || (cur.gpio != prev.gpio)
+			|| memcmp(cur.cnt, prev.cnt, sizeof(cur.cnt)))
+		{
+			watchChangePrint(&start, &prev, &cur,
+				(line < 0) ? "poll" : (byEdge ? "edge" : "fallback"));
+		}
+		if (line < 0)
+		{
+			busyWait(period);
+		}
+	}
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	sec = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+	i2cStatsGet(I2C_OP_READ, &st[I2C_OP_READ]);
+	i2cStatsGet(I2C_OP_WRITE, &st[I2C_OP_WRITE]);
+	printf("%d card reads in %.1f s, %u I2C transactions (%.1f/s), %.1f bytes/s\n",
+		reads, sec, st[I2C_OP_READ].count + st[I2C_OP_WRITE].count,
+		(st[I2C_OP_READ].count + st[I2C_OP_WRITE].count) / sec,
+		(st[I2C_OP_READ].bytes + st[I2C_OP_WRITE].bytes) / sec);
+	if (line >= 0)
+	{
+		ioplusAttnStatsGet(&attn, &ast);
+		printf("%u edges, %u edge reads, %u fallback reads (%u found changes)\n",
+			ast.events, ast.edgeReads, ast.fallbackReads, ast.missed);
+		if (ast.edgeReads > 0)
+		{
+			printf("edge to inputs read avg %u us, max %u us\n",
+				(unsigned) (ast.latencyUsSum / ast.edgeReads), ast.latencyUsMax);
+		}
+		ioplusAttnClose(&attn);
+	}
+	return (ret == IOPLUS_OK) ? OK : FAIL;
+}
+
+#define ABENCH_PRODUCERS	16
+#define ABENCH_REQUESTS	1000 // per producer
+#define ABENCH_WINDOW	4 // requests in flight per producer
+#define ABENCH_PRODUCERS_MAX	64
+
+// registers the producers read in turn: relays, inputs, ADC, DAC, open drains
+static const struct
+{
+	int add;
+	int size;
+} gBenchRegs[] =
+{
+	{I2C_MEM_RELAY_VAL_ADD, 1},
+	{I2C_MEM_OPTO_IN_ADD, 1},
+	{I2C_MEM_GPIO_VAL_ADD, 1},
+	{I2C_MEM_ADC_VAL_MV_ADD, ADC_CH_NO * ADC_RAW_VAL_SIZE},
+	{I2C_MEM_DAC_VAL_MV_ADD, DAC_CH_NO * DAC_MV_VAL_SIZE},
+	{I2C_MEM_OD_PWM_VAL_RAW_ADD, OD_CH_NO * DAC_MV_VAL_SIZE},
+};
+#define ABENCH_REGS	(int)(sizeof(gBenchRegs) / sizeof(gBenchRegs[0]))
+
+typedef struct
+{
+	IoplusBoardType *board;
+	IoplusAsyncType *q;
+	pthread_mutex_t *lock;
+	int id;
+	int requests;
+	int errors;
+	uint64_t latencyUsSum;
+	uint32_t latencyUsMax;
+} AsyncBenchType;
+
+static uint64_t benchNowUs(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+// what a threaded application does today, every read under one mutex
+static void* benchBlocking(void *arg)
+{
+	AsyncBenchType *p = (AsyncBenchType*)arg;
+	uint8_t buf[IOPLUS_ASYNC_SIZE_MAX];
+	uint64_t t;
+	uint32_t us;
+	int r;
+	int i;
+
+	for (i = 0; i < p->requests; i++)
+	{
+		r = (p->id + i) % ABENCH_REGS;
+		t = benchNowUs();
+		pthread_mutex_lock(p->lock);
+		if (OK != i2cMem8Read(p->board->dev, gBenchRegs[r].add, buf,
+			gBenchRegs[r].size))
+		{
+			p->errors++;
+		}
+		pthread_mutex_unlock(p->lock);
+		us = (uint32_t) (benchNowUs() - t);
+		p->latencyUsSum += us;
+		if (us > p->latencyUsMax)
+		{
+			p->latencyUsMax = us;
+		}
+	}
+	return NULL;
+}
+
+static void* benchAsync(void *arg)
+{
+	AsyncBenchType *p = (AsyncBenchType*)arg;
+	IoplusAsyncReqType req[ABENCH_WINDOW];
+	uint8_t buf[ABENCH_WINDOW][IOPLUS_ASYNC_SIZE_MAX];
+	int sent = 0;
+	int done = 0;
+	int r;
+	int w;
+
+	while (done < p->requests)
+	{
+		if ( (sent < p->requests) && (sent - done < ABENCH_WINDOW))
+		{
+			w = sent % ABENCH_WINDOW;
+			r = (p->id + sent) % ABENCH_REGS;
+			ioplusAsyncReqInit(&req[w], p->board, IOPLUS_ASYNC_READ,
+				gBenchRegs[r].add, buf[w], gBenchRegs[r].size);
+			if (IOPLUS_OK != ioplusAsyncSubmit(p->q, &req[w]))
+			{
+				p->errors += p->requests - sent;
+				p->requests = sent;
+			}
+			else
+			{
+				sent++;
+			}
+			continue;
+		}
+		// window full or all sent, the oldest request frees its slot
+		if (IOPLUS_OK != ioplusAsyncWait(p->q, &req[done % ABENCH_WINDOW]))
+		{
+			p->errors++;
+		}
+		done++;
+	}
+	return NULL;
+}
+
+static int benchRun(const char *name, void* (*fn)(void*), AsyncBenchType *p,
+	int producers)
+{
+	pthread_t th[ABENCH_PRODUCERS_MAX];
+	uint64_t start;
+	uint64_t latSum = 0;
+	uint32_t latMax = 0;
+	double sec;
+	int total = 0;
+	int errors = 0;
+	int i;
+
+	start = benchNowUs();
+	for (i = 0; i < producers; i++)
+	{
+		if (0 != pthread_create(&th[i], NULL, fn, &p[i]))
+		{
+			printf("Fail to start the producer threads!\n");
+			while (i-- > 0)
+			{
+				pthread_join(th[i], NULL);
+			}
+			return FAIL;
+		}
+	}
+	for (i = 0; i < producers; i++)
+	{
+		pthread_join(th[i], NULL);
+		total += p[i].requests;
+		errors += p[i].errors;
+		latSum += p[i].latencyUsSum;
+		if (p[i].latencyUsMax > latMax)
+		{
+			latMax = p[i].latencyUsMax;
+		}
+	}
+	sec = (benchNowUs() - start) / 1e6;
+	printf("%-9s %d reads in %.3f s, %.0f reads/s, %d errors", name, total, sec,
+		total / sec, errors);
+	if (latSum > 0)
+	{
+		printf(", latency avg %u us, max %u us", (unsigned) (latSum / total),
+			latMax);
+	}
+	printf("\n");
+	return OK;
+}
+
+int doAsyncBench(int argc, char *argv[]);
+const CliCmdType CMD_ASYNC_BENCH =
+	{"asyncbench", 2, &doAsyncBench,
+		"\tasyncbench:	Compare the register read throughput of threads sharing the card through a mutex and through the asynchronous queue\n",
+		"\tUsage:		ioplus <stack> asyncbench [<producers> [<reads per producer>]]\n", "",
+		"\tExample:		ioplus 0 asyncbench 16 1000; 16 threads read 1000 registers blocks each, first blocking then asynchronous\n"};
+
+int doAsyncBench(int argc, char *argv[])
+{
+	static AsyncBenchType p[ABENCH_PRODUCERS_MAX];
+	pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+	IoplusAsyncType q;
+	IoplusAsyncStatsType st;
+	int producers = ABENCH_PRODUCERS;
+	int requests = ABENCH_REQUESTS;
+	int dev;
+	int i;
+
+	if ( (argc < 3) || (argc > 5))
+	{
+		return ARG_CNT_ERR;
+	}
+	if (argc > 3)
+	{
+		producers = atoi(argv[3]);
+	}
+	if (argc > 4)
+	{
+		requests = atoi(argv[4]);
+	}
+	if ( (producers < 1) || (producers > ABENCH_PRODUCERS_MAX) || (requests < 1))
+	{
+		printf("Invalid producers or reads count, 1..%d producers!\n",
+			ABENCH_PRODUCERS_MAX);
+		return ARG_ERR;
+	}
+	dev = doBoardInit(atoi(argv[1]));
+	if (dev <= 0)
+	{
+		return (FAIL);
+	}
+	memset(p, 0, sizeof(p));
+	for (i = 0; i < producers; i++)
+	{
+		p[i].board = boardHandle(dev);
+		p[i].lock = &lock;
+		p[i].id = i;
+		p[i].requests = requests;
+	}
+	if (OK != benchRun("blocking", benchBlocking, p, producers))
+	{
+		return FAIL;
+	}
+	if (IOPLUS_OK != ioplusAsyncStart(&q))
+	{
+		printf("Fail to start the I/O thread!\n");
+		return FAIL;
+	}
+	for (i = 0; i < producers; i++)
+	{
+		p[i].q = &q;
+		p[i].errors = 0;
+		p[i].latencyUsSum = 0;
+		p[i].latencyUsMax = 0;
+	}
+	benchRun("async", benchAsync, p, producers);
+	ioplusAsyncStop(&q);
+	ioplusAsyncStatsGet(&q, &st);
+	printf("async     %u transfers for %u reads (%u merged) in %u batches",
+		st.transfers, st.completed, st.merged, st.batches);
+	if (st.completed > 0)
+	{
+		printf(", submit to done avg %u us, max %u us",
+			(unsigned) (st.latencyUsSum / st.completed), st.latencyUsMax);
+	}
+	printf("\n");
+	return OK;
+}
+
+//***************************************************read planner**********************************************
+#define PLAN_CYCLES	50
+
+static const struct
+{
+	const char *name;
+	int add;
+	int size;
+} gPlanFields[] =
+{
+	{"relay", I2C_MEM_RELAY_VAL_ADD, 1},
+	{"opto", I2C_MEM_OPTO_IN_ADD, 1},
+	{"gpio", I2C_MEM_GPIO_VAL_ADD, 1},
+	{"adcraw", I2C_MEM_ADC_VAL_RAW_ADD, ADC_CH_NO * ADC_RAW_VAL_SIZE},
+	{"adc", I2C_MEM_ADC_VAL_MV_ADD, ADC_CH_NO * ADC_RAW_VAL_SIZE},
+	{"dac", I2C_MEM_DAC_VAL_MV_ADD, DAC_CH_NO * DAC_MV_VAL_SIZE},
+	{"od", I2C_MEM_OD_PWM_VAL_RAW_ADD, OD_CH_NO * 2},
+	{"diag", I2C_MEM_DIAG_TEMPERATURE_ADD, 3},
+	{"odpulses", I2C_MEM_OD_PULSE_CNT_SET, OD_CH_NO * COUNTER_SIZE},
+	{"revision", I2C_MEM_REVISION_HW_MAJOR_ADD, 4},
+	{"optocnt", I2C_MEM_OPTO_EDGE_COUNT_ADD, OPTO_CH_NO * COUNTER_SIZE},
+	{"gpiocnt", I2C_MEM_GPIO_EDGE_COUNT_ADD, GPIO_CH_NO * COUNTER_SIZE},
+	{"enc", I2C_MEM_OPTO_ENC_COUNT_ADD, (OPTO_CH_NO + GPIO_CH_NO) / 2 * COUNTER_SIZE},
+	{"owb", I2C_MEM_1WB_DEV, 1},
+	{"temps", I2C_MEM_1WB_T1, OWB_SENS_CNT * OWB_TEMP_SIZE_B},
+};
+#define PLAN_FIELDS	(int)(sizeof(gPlanFields) / sizeof(gPlanFields[0]))
+
+static void planBenchPrint(const char *name, uint64_t us, int xfers, int bytes,
+	int errors)
+{
+	printf("%-9s %6.0f us/cycle, %d transfers, %d bytes", name,
+		(double)us / PLAN_CYCLES, xfers, bytes);
+	if (errors > 0)
+	{
+		printf(", %d errors", errors);
+	}
+	printf("\n");
+}
+
+int doPlan(int argc, char *argv[]);
+const CliCmdType CMD_PLAN =
+	{"plan", 2, &doPlan,
+		"\tplan:		Plan the block reads of a set of fields with the bus cost model measured at start, compare it with a read per field and one read of the whole span\n",
+		"\tUsage:		ioplus <stack> plan [<field>...]\n",
+		"\tFields:		relay opto gpio adcraw adc dac od diag odpulses revision optocnt gpiocnt enc owb temps, opto and optocnt by default\n",
+		"\tExample:		ioplus 0 plan adc temps; Read the analog inputs and the one wire temperatures with the fewest bus time\n"};
+
+int doPlan(int argc, char *argv[])
+{
+	static uint8_t img[IOPLUS_MAP_SIZE];
+	static IoplusPlanCacheType cache;
+	const IoplusPlanType *plan = NULL;
+	IoplusFieldSetType set;
+	IoplusCostType cost;
+	IoplusBoardType *board;
+	int field[PLAN_FIELDS];
+	int fields = 0;
+	int lo = IOPLUS_MAP_SIZE;
+	int hi = 0;
+	int errors;
+	int bytes;
+	int xfers;
+	uint64_t t;
+	int dev;
+	int i;
+	int j;
+
+	if (argc > 3 + PLAN_FIELDS)
+	{
+		return ARG_CNT_ERR;
+	}
+	for (i = 3; i < argc; i++)
+	{
+		for (j = 0; (j < PLAN_FIELDS) && strcasecmp(argv[i], gPlanFields[j].name); j++)
+			;
+		if (j == PLAN_FIELDS)
+		{
+			printf("Invalid field %s!\n", argv[i]);
+			return ARG_ERR;
+		}
+		field[fields++] = j;
+	}
+	if (fields == 0)
+	{
+		// opto and optocnt
+		field[fields++] = 1;
+		field[fields++] = 10;
+	}
+	dev = doBoardInit(atoi(argv[1]));
+	if (dev <= 0)
+	{
+		return (FAIL);
+	}
+	board = boardHandle(dev);
+	ioplusFieldClear(&set);
+	for (i = 0; i < fields; i++)
+	{
+		j = field[i];
+		ioplusFieldAdd(&set, gPlanFields[j].add, gPlanFields[j].size);
+		lo = (gPlanFields[j].add < lo) ? gPlanFields[j].add : lo;
+		hi = (gPlanFields[j].add + gPlanFields[j].size > hi) ?
+			gPlanFields[j].add + gPlanFields[j].size : hi;
+	}
+	if (IOPLUS_OK != ioplusCostCalibrate(board, &cost))
+	{
+		printf("Fail to time the card reads!\n");
+		return FAIL;
+	}
+	printf("cost model %.1f us a transfer + %.2f us a byte\n", cost.txUs,
+		cost.byteUs);
+	ioplusPlanCacheInit(&cache, &cost);
+
+	// a read per field
+	errors = 0;
+	xfers = 0;
+	bytes = 0;
+	for (i = 0; i < fields; i++)
+	{
+		xfers += (gPlanFields[field[i]].size + IOPLUS_PLAN_XFER_MAX - 1)
+			/ IOPLUS_PLAN_XFER_MAX;
+		bytes += gPlanFields[field[i]].size;
+	}
+	t = benchNowUs();
+	for (j = 0; j < PLAN_CYCLES; j++)
+	{
+		for (i = 0; i < fields; i++)
+		{
+			if (IOPLUS_OK != ioplusRegRead(board, gPlanFields[field[i]].add,
+				img + gPlanFields[field[i]].add, gPlanFields[field[i]].size))
+			{
+				errors++;
+			}
+		}
+	}
+	planBenchPrint("per field", benchNowUs() - t, xfers, bytes, errors);
+
+	// one block from the first to the last field
+	errors = 0;
+	t = benchNowUs();
+	for (j = 0; j < PLAN_CYCLES; j++)
+	{
+		if (IOPLUS_OK != ioplusRegRead(board, lo, img + lo, hi - lo))
+		{
+			errors++;
+		}
+	}
+	planBenchPrint("one block", benchNowUs() - t,
+		(hi - lo + IOPLUS_PLAN_XFER_MAX - 1) / IOPLUS_PLAN_XFER_MAX, hi - lo, errors);
+
+	// the plan, taken from the cache every cycle as a polling loop would
+	errors = 0;
+	t = benchNowUs();
+	for (j = 0; j < PLAN_CYCLES; j++)
+	{
+		if ( (IOPLUS_OK != ioplusPlanCacheGet(&cache, &set, &plan))
+			|| (IOPLUS_OK != ioplusPlanRun(board, plan, img)))
+		{
+			errors++;
+		}
+	}
+	t = benchNowUs() - t;
+	if (NULL == plan)
+	{
+		printf("Fail to plan the reads!\n");
+		return FAIL;
+	}
+	planBenchPrint("planned", t, plan->reads, plan->bytes, errors);
+	printf("plan      predicted %.0f us/cycle, %u cache hits, %u misses:",
+		plan->costUs, cache.hits, cache.misses);
+	for (i = 0; i < plan->reads; i++)
+	{
+		const char *name = i2cRegName(plan->read[i].add, &j);
+
+		printf(" %s+%d[%d]", name, j, plan->read[i].size);
+	}
+	printf("\n");
+	return OK;
+}
+
+//***************************************************MIN/MAX sample count read write**********************************************
+int minMaxSamplesGet(int dev, int *val)
+{
+	u8 raw = 0;
+
+	if (IOPLUS_OK != ioplusMinMaxSamplesGet(boardHandle(dev), &raw))
+	{
+		printf("Fail to read!\n");
+		return ERROR;
+	}
+	*val = raw;
+	return OK;
+}
+
+int minMaxSamplesSet(int dev, int val)
+{
+	if (val < 5)
 	{
 		val = 10;
 	}
@@ -2761,8 +4014,7 @@ int minMaxSamplesSet(int dev, int val)
 	{
 		val = 250;
 	}
-	buff[0] = (u8)val;
-	if (OK != i2cMem8Write(dev, I2C_MEM_MIN_MAX_SAMPLES, buff, 1))
+	if (IOPLUS_OK != ioplusMinMaxSamplesSet(boardHandle(dev), (u8)val))
 	{
 		printf("Fail to write!\n");
 		return ERROR;
@@ -2787,7 +4039,7 @@ int doMinMaxSamplesRead(int argc, char *argv[])
 	{
 		return (FAIL);
 	}
-	if (gHwVer < 3)
+	if (getHwVer() < 3)
 	{
 		printf(
 			"This feature is available on hardware versions greater or equal to 3.0!\n");
@@ -2829,7 +4081,7 @@ int minMaxSamplesWrite(int argc, char *argv[])
 	{
 		return (FAIL);
 	}
-	if (gHwVer < 3)
+	if (getHwVer() < 3)
 	{
 		printf(
 			"This feature is available on hardware versions greater or equal to 3.0!\n");
@@ -2870,12 +4122,11 @@ const CliCmdType CMD_OWB_RD =
 int doOwbGet(int argc, char *argv[])
 {
 	int dev = -1;
-	u8 buff[5];
 	int resp = 0;
 	int channel = 0;
+	int cnt = 0;
 	float temp = 0;
 	s16 saux16 = 0;
-	int retry = 3;
 
 	if (argc != 4)
 	{
@@ -2891,32 +4142,23 @@ int doOwbGet(int argc, char *argv[])
 	{
 		return ERROR;
 	}
-	resp = i2cMem8Read(dev, I2C_MEM_1WB_DEV, buff, 1);
-	if (FAIL == resp)
+	if (IOPLUS_OK != ioplusOwbSensCountGet(boardHandle(dev), &cnt))
 	{
 		printf("Fail to read one wire bus info!\n");
 		return ERROR;
 	}
-	if (channel > buff[0])
+	if (channel > cnt)
 	{
-		printf("Invalid channel number, only %d sensors connected!\n", buff[0]);
+		printf("Invalid channel number, only %d sensors connected!\n", cnt);
 		return ERROR;
 	}
-	saux16 = -1;
-	retry = 4;
-	while ( (saux16 == -1) && (retry > 0))
+	resp = ioplusOwbTempGet(boardHandle(dev), channel, &saux16);
+	if (IOPLUS_ERR_IO == resp)
 	{
-		resp = i2cMem8Read(dev, I2C_MEM_1WB_T1 + (channel - 1) * OWB_TEMP_SIZE_B,
-			buff, OWB_TEMP_SIZE_B);
-		if (FAIL == resp)
-		{
-			printf("Fail to read one wire bus info!\n");
-			return ERROR;
-		}
-		memcpy(&saux16, &buff[0], 2);
-		retry--;
+		printf("Fail to read one wire bus info!\n");
+		return ERROR;
 	}
-	if (saux16 == -1)
+	if (IOPLUS_OK != resp)
 	{
 		return ERROR;
 	}
@@ -2936,8 +4178,7 @@ const CliCmdType CMD_OWB_ID_RD =
 int doOwbIdGet(int argc, char *argv[])
 {
 	int dev = -1;
-	u8 buff[8];
-	int resp = 0;
+	int cnt = 0;
 	int channel = 0;
 	uint64_t romID = 0;
 
@@ -2955,34 +4196,22 @@ int doOwbIdGet(int argc, char *argv[])
 	{
 		return ERROR;
 	}
-	buff[0] = 0xff & (channel - 1);
-	resp = i2cMem8Write(dev, I2C_MEM_1WB_ROM_CODE_IDX, buff, 1); //Select sensor ID to read
-	if (FAIL == resp)
+	if (IOPLUS_OK != ioplusOwbSensCountGet(boardHandle(dev), &cnt)) //check the number of connected sensors
 	{
 		printf("Fail to read one wire bus info!\n");
 		return ERROR;
 	}
-	resp = i2cMem8Read(dev, I2C_MEM_1WB_DEV, buff, 1); //check the number of connected sensors
-	if (FAIL == resp)
+	if (channel > cnt)
 	{
-		printf("Fail to read one wire bus info!\n");
+		printf("Invalid channel number, only %d sensors connected!\n", cnt);
 		return ERROR;
 	}
-	if (channel > buff[0])
-	{
-		printf("Invalid channel number, only %d sensors connected!\n", buff[0]);
-		return ERROR;
-	}
-
-	resp = i2cMem8Read(dev, I2C_MEM_1WB_ROM_CODE, buff, 8);
-	if (FAIL == resp)
+	if (IOPLUS_OK != ioplusOwbRomGet(boardHandle(dev), channel, &romID))
 	{
 		printf("Fail to read one wire bus info!\n");
 		return ERROR;
 	}
 
-	memcpy(&romID, &buff[0], 8);
-
 	printf("0x%llx\n", romID);
 	return OK;
 }
@@ -2996,8 +4225,7 @@ const CliCmdType CMD_OWB_SNS_CNT_RD = {"owbcntrd", 2, &doOwbSensCountRead,
 int doOwbSensCountRead(int argc, char *argv[])
 {
 	int dev = -1;
-	u8 buff[2];
-	int resp = 0;
+	int cnt = 0;
 
 	if (argc != 3)
 	{
@@ -3008,14 +4236,13 @@ int doOwbSensCountRead(int argc, char *argv[])
 	{
 		return ERROR;
 	}
-	resp = i2cMem8Read(dev, I2C_MEM_1WB_DEV, buff, 1);
-	if (FAIL == resp)
+	if (IOPLUS_OK != ioplusOwbSensCountGet(boardHandle(dev), &cnt))
 	{
 		printf("Fail to read!\n");
 		return ERROR;
 	}
 
-	printf("%d\n", buff[0]);
+	printf("%d\n", cnt);
 	return OK;
 }
 
@@ -3028,8 +4255,6 @@ const CliCmdType CMD_OWB_SCAN = {"owbscan", 2, &doOwbScan,
 int doOwbScan(int argc, char *argv[])
 {
 	int dev = -1;
-	u8 buff[2];
-	int resp = 0;
 
 	if (argc != 3)
 	{
@@ -3040,9 +4265,7 @@ int doOwbScan(int argc, char *argv[])
 	{
 		return ERROR;
 	}
-	buff[0] = 0xaa;
-	resp = i2cMem8Write(dev, I2C_MEM_1WB_START_SEARCH, buff, 1);
-	if (FAIL == resp)
+	if (IOPLUS_OK != ioplusOwbScan(boardHandle(dev)))
 	{
 		printf("Fail to write!\n");
 		return ERROR;
@@ -3088,17 +4311,30 @@ const CliCmdType *gCmdArray[] = {&CMD_VERSION, &CMD_HELP, &CMD_WAR, &CMD_PINOUT,
 	&CMD_OD_CNT_READ,
 	&CMD_OD_CNT_WRITE,
 	&CMD_OD_CNT_RST,
+	&CMD_MOVE,
+	&CMD_RULES,
+	&CMD_IN_WATCH,
+	&CMD_ASYNC_BENCH,
+	&CMD_PLAN,
 	&CMD_DAC_READ,
 	&CMD_DAC_WRITE,
 	&CMD_ADC_READ,
+	&CMD_ADC_FILTER_BENCH,
 	&CMD_ADC_READ_MAX,
 	&CMD_ADC_READ_MIN,
+	&CMD_ADC_STATS,
+	&CMD_CNT_JOURNAL,
+	&CMD_REC,
+	&CMD_LOG_QUERY,
 	&CMD_MIN_MAX_SAMPLE_WRITE,
 	&CMD_MIN_MAX_SAMPLE_READ,
 	&CMD_ADC_CAL,
 	&CMD_ADC_CAL_RST,
 	&CMD_DAC_CAL,
 	&CMD_DAC_CAL_RST,
+	&CMD_CAL_RUN,
+	&CMD_MODBUS,
+	&CMD_METRICS,
 	&CMD_WDT_RELOAD,
 	&CMD_WDT_SET_PERIOD,
 	&CMD_WDT_GET_PERIOD,
@@ -3134,6 +4370,8 @@ int main(int argc, char *argv[])
 	sem_t *semaphore = sem_open("/SMI2C_SEM", O_CREAT, 0000666, 3);//sem_open("/SMI2C_SEM", O_CREAT);
 	int semVal = 2;
 	sem_wait(semaphore);
+	gBusSem = semaphore;
+	ioplusBusLockHeld(1);
 #endif
 	while (NULL != gCmdArray[i])
 	{
@@ -3153,7 +4391,7 @@ int main(int argc, char *argv[])
 				}
 #ifdef THREAD_SAFE
 				sem_getvalue(semaphore, &semVal);
-				if (semVal < 1)
+				if ( (gBusSem != SEM_FAILED) && (semVal < 1))
 				{
 					sem_post(semaphore);
 				}
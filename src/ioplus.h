@@ -2,16 +2,12 @@
 #define IOPLUS_H_
 
 #include <stdint.h>
+#include <signal.h>
+
+#include "libioplus.h"
+#include "ioplusmem.h"
 
-#define ADC_CH_NO	8
-#define DAC_CH_NO	4
-#define OD_CH_NO 4
-#define ADC_RAW_VAL_SIZE	2
-#define DAC_MV_VAL_SIZE		2
 #define VOLT_TO_MILIVOLT	1000
-#define OPTO_CH_NO 8
-#define GPIO_CH_NO 4
-#define COUNTER_SIZE 4
 
 #define RETRY_TIMES	10
 #define CALIBRATION_KEY 0xaa
@@ -19,118 +15,6 @@
 #define WDT_RESET_SIGNATURE 	0xCA
 #define WDT_MAX_OFF_INTERVAL_S 4147200 //48 days
 
-#define OWB_TEMP_SIZE_B 2
-#define OWB_SENS_CNT 8
-
-typedef enum
-{
-	I2C_MEM_RELAY_VAL_ADD = 0,
-	I2C_MEM_RELAY_SET_ADD,
-	I2C_MEM_RELAY_CLR_ADD,
-	I2C_MEM_OPTO_IN_ADD,
-	I2C_MEM_GPIO_VAL_ADD,
-	I2C_MEM_GPIO_SET_ADD,
-	I2C_MEM_GPIO_CLR_ADD,
-	I2C_MEM_GPIO_DIR_ADD,
-
-	I2C_MEM_ADC_VAL_RAW_ADD,
-	I2C_MEM_ADC_VAL_MV_ADD = I2C_MEM_ADC_VAL_RAW_ADD
-		+ ADC_CH_NO * ADC_RAW_VAL_SIZE,
-	I2C_MEM_DAC_VAL_MV_ADD = I2C_MEM_ADC_VAL_MV_ADD
-		+ ADC_CH_NO * ADC_RAW_VAL_SIZE,
-	I2C_MEM_OD_PWM_VAL_RAW_ADD = I2C_MEM_DAC_VAL_MV_ADD
-		+ DAC_CH_NO * DAC_MV_VAL_SIZE,
-	I2C_MEM_OPTO_IT_RISING_ADD = I2C_MEM_OD_PWM_VAL_RAW_ADD
-		+ DAC_CH_NO * DAC_MV_VAL_SIZE,
-	I2C_MEM_OPTO_IT_FALLING_ADD,
-	I2C_MEM_GPIO_EXT_IT_RISING_ADD,
-	I2C_MEM_GPIO_EXT_IT_FALLING_ADD,
-	I2C_MEM_OPTO_CNT_RST_ADD,
-	I2C_MEM_GPIO_CNT_RST_ADD,
-
-	I2C_MEM_DIAG_TEMPERATURE_ADD,
-
-	I2C_MEM_DIAG_3V3_MV_ADD,
-	I2C_MEM_DIAG_3V3_MV_ADD1,
-
-	I2C_MEM_CALIB_VALUE,
-	I2C_MEM_CALIB_CHANNEL = I2C_MEM_CALIB_VALUE + 2, //ADC channels [1,8]; DAC channels [9, 12]
-	I2C_MEM_CALIB_KEY, //set calib point 0xaa; reset calibration on the channel 0x55
-	I2C_MEM_CALIB_STATUS,
-
-	I2C_MEM_OPTO_ENC_ENABLE_ADD,
-	I2C_MEM_GPIO_ENC_ENABLE_ADD,
-	I2C_MEM_OPTO_ENC_CNT_RST_ADD,
-	I2C_MEM_GPIO_ENC_CNT_RST_ADD,
-
-	I2C_MEM_OD_PULSE_CNT_SET,
-	I2C_MEM_OD_PULSE_CNT_SET_END_ADD = I2C_MEM_OD_PULSE_CNT_SET
-		+ OD_CH_NO * COUNTER_SIZE, //ADC_RAW_VAL_SIZE,
-	I2C_MEM_OD_PWM_FREQUENCY_CH1 = I2C_MEM_OD_PULSE_CNT_SET_END_ADD,
-	I2C_MEM_OD_PWM_FREQUENCY_CH2 = I2C_MEM_OD_PWM_FREQUENCY_CH1 + 2,
-	I2C_MEM_OD_PWM_FREQUENCY_CH3 = I2C_MEM_OD_PWM_FREQUENCY_CH2 + 2,
-	I2C_MEM_OD_PWM_FREQUENCY_CH4 = I2C_MEM_OD_PWM_FREQUENCY_CH3 + 2,
-	I2C_MEM_RELAY_DEFAULT = I2C_MEM_OD_PWM_FREQUENCY_CH4 + 2,
-	I2C_MEM_OD_DEFAULT,
-	I2C_MEM_WDT_RESET_ADD = 100,
-	I2C_MEM_WDT_INTERVAL_SET_ADD,
-	I2C_MEM_WDT_INTERVAL_GET_ADD = I2C_MEM_WDT_INTERVAL_SET_ADD + 2,
-	I2C_MEM_WDT_INIT_INTERVAL_SET_ADD = I2C_MEM_WDT_INTERVAL_GET_ADD + 2,
-	I2C_MEM_WDT_INIT_INTERVAL_GET_ADD = I2C_MEM_WDT_INIT_INTERVAL_SET_ADD + 2,
-	I2C_MEM_WDT_RESET_COUNT_ADD = I2C_MEM_WDT_INIT_INTERVAL_GET_ADD + 2,
-	I2C_MEM_WDT_CLEAR_RESET_COUNT_ADD = I2C_MEM_WDT_RESET_COUNT_ADD + 2,
-
-	I2C_MEM_WDT_POWER_OFF_INTERVAL_SET_ADD,
-	I2C_MEM_WDT_POWER_OFF_INTERVAL_GET_ADD = I2C_MEM_WDT_POWER_OFF_INTERVAL_SET_ADD
-		+ 4,
-
-	I2C_MEM_REVISION_HW_MAJOR_ADD = 0x78,
-	I2C_MEM_REVISION_HW_MINOR_ADD,
-	I2C_MEM_REVISION_MAJOR_ADD,
-	I2C_MEM_REVISION_MINOR_ADD,
-	I2C_DBG_FIFO_SIZE,
-	I2C_DBG_FIFO_ADD = I2C_DBG_FIFO_SIZE + 2,
-	I2C_DBG_CMD,
-	I2C_MEM_OPTO_EDGE_COUNT_ADD,
-	I2C_MEM_OPTO_EDGE_COUNT_END_ADD = I2C_MEM_OPTO_EDGE_COUNT_ADD
-		+ COUNTER_SIZE * OPTO_CH_NO, //!gap
-	I2C_MEM_OD_PWM_FREQUENCY, //2 bytes
-	I2C_MEM_MIN_MAX_SAMPLES = I2C_MEM_OD_PWM_FREQUENCY + 2,
-	I2C_MEM_OD_P_SET_VALUE, // set value for od pulses in32
-	I2C_MEM_OD_P_SET_CMD = I2C_MEM_OD_P_SET_VALUE + 4,
-
-	I2C_MEM_ADD_RESERVED = 0xaa,
-	//share the pulse command on inputs with gpio edge count addreses wich are not used
-	I2C_MEM_PULSE_COUNTER_SET,
-	I2C_MEM_OD_CH_SET = I2C_MEM_PULSE_COUNTER_SET + COUNTER_SIZE,
-	I2C_MEM_OPTO_CH_SET,
-	I2C_MEM_GPIO_EDGE_COUNT_ADD = 0xab,
-	I2C_MEM_OPTO_ENC_COUNT_ADD = I2C_MEM_GPIO_EDGE_COUNT_ADD
-		+ COUNTER_SIZE * GPIO_CH_NO,
-	I2C_MEM_GPIO_ENC_COUNT_ADD = I2C_MEM_OPTO_ENC_COUNT_ADD
-		+ COUNTER_SIZE * OPTO_CH_NO / 2,
-	I2C_MEM_GPIO_ENC_COUNT_END_ADD = I2C_MEM_GPIO_ENC_COUNT_ADD
-		+ COUNTER_SIZE * GPIO_CH_NO / 2,
-	I2C_MEM_1WB_DEV = I2C_MEM_GPIO_ENC_COUNT_END_ADD,
-	I2C_MEM_1WB_ROM_CODE_IDX,
-	I2C_MEM_1WB_ROM_CODE, //rom code 64 bits
-	I2C_MEM_1WB_ROM_CODE_END = I2C_MEM_1WB_ROM_CODE + 7,
-	I2C_MEM_1WB_START_SEARCH,
-	I2C_MEM_1WB_T1,
-	I2C_MEM_1WB_T_END = I2C_MEM_1WB_T1 + OWB_SENS_CNT * OWB_TEMP_SIZE_B,
-	I2C_MEM_ADC_MAX = I2C_MEM_1WB_T_END,
-	I2C_MEM_ADC_MIN = I2C_MEM_ADC_MAX + 2 * 4,
-	// od pulses movement parameters
-		I2C_MEM_ODP_ACC = I2C_MEM_1WB_T_END,
-		I2C_MEM_ODP_DEC = I2C_MEM_ODP_ACC + 2,
-		I2C_MEM_ODP_MAXS = I2C_MEM_ODP_DEC + 2,
-		I2C_MEM_ODP_MINS = I2C_MEM_ODP_MAXS + 2,
-		I2C_MEM_ODP_CMD = I2C_MEM_ODP_MINS + 2,
-
-
-	SLAVE_BUFF_SIZE = 255
-} I2C_MEM_ADD;
-
 #define CHANNEL_NR_MIN		1
 #define RELAY_CH_NR_MAX		8
 #define OPTO_IN_CH_NR_MAX	8
@@ -163,7 +47,12 @@ typedef enum
 } OutStateEnumType;
 
 int doBoardInit(int stack);
+void busTokenRelease(void);
+// SIGINT / SIGTERM handler of the commands that run until stopped
+extern volatile sig_atomic_t gRunStop;
+void runStop(int sig);
 u8 getHwVer(void);
+IoplusBoardType* boardHandle(int dev);
 int adcGet(int dev, int ch, float *val);
 int odSet(int dev, int ch, float val);
 int dacSet(int dev, int ch, float val);
@@ -197,5 +86,8 @@ int doOptoEncoderCntRead(int argc, char *argv[]);
 int doOptoEncoderCntReset(int argc, char *argv[]);
 
 int doLoopbackTest(int argc, char *argv[]);
+int doCalRun(int argc, char *argv[]);
+int doModbus(int argc, char *argv[]);
+int doMetrics(int argc, char *argv[]);
 
 #endif //IOPLUS_H_
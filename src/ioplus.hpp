@@ -0,0 +1,359 @@
+/*
+ * ioplus.hpp:
+ *	Header only C++17 layer over libioplus: a move only Board handle that
+ *	closes the card, register descriptors generated from regmap/ioplus.map
+ *	and typed reads and writes checked at compile time. Errors throw
+ *	ioplus::Error, nothing allocates unless an error is thrown.
+ *
+ *	board.read<ioplus::reg::AdcMv>() returns std::array<uint16_t, 8>,
+ *	board.read<ioplus::reg::Opto>() a uint8_t. ioplus::Block<R...> reads
+ *	the span holding several registers at once, and with C++20 the bulk
+ *	reads also take a std::span into a caller owned buffer.
+ *
+ *	The reads are plain transfers: counters the firmware updates while
+ *	they are read can still be fetched with the anti-spurious C calls,
+ *	through board.handle().
+ *
+ *	Copyright (c) 2016-2023 Sequent Microsystem
+ *	<http://www.sequentmicrosystem.com>
+ ***********************************************************************
+ */
+#ifndef IOPLUS_HPP_
+#define IOPLUS_HPP_
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <initializer_list>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#if __cplusplus >= 202002L
+#include <span>
+#endif
+
+#include "libioplus.h"
+#include "ioplusmem.h"
+
+namespace ioplus
+{
+
+class Error: public std::runtime_error
+{
+public:
+	explicit Error(int code)
+		: std::runtime_error(ioplusErrStr(code)), code_(code)
+	{
+	}
+
+	// IoplusErrType value
+	int code() const noexcept
+	{
+		return code_;
+	}
+
+private:
+	int code_;
+};
+
+inline void check(int ret)
+{
+	if (ret != IOPLUS_OK)
+	{
+		throw Error(ret);
+	}
+}
+
+enum class Access
+{
+	Read, Write, ReadWrite
+};
+
+/* Count values of type T from register Add, stored little endian like the
+ * Raspberry Pi so they are copied as they are */
+template<int Add, typename T, int Count = 1, Access Acc = Access::Read>
+struct Reg
+{
+	static_assert(std::is_arithmetic<T>::value, "register values are numbers");
+	static_assert(Count >= 1, "a register holds one value at least");
+	static_assert( (Add >= 0) && (Add + Count * sizeof(T) <= SLAVE_BUFF_SIZE + 1),
+		"register outside the card map");
+
+	using type = T;
+	// read<>() result, the value itself for a single value register
+	using value_type = typename std::conditional<Count == 1, T,
+		std::array<T, Count> >::type;
+	static constexpr int add = Add;
+	static constexpr int count = Count;
+	static constexpr int width = static_cast<int>(sizeof(T));
+	static constexpr int size = Count * width;
+	static constexpr bool readable = Acc != Access::Write;
+	static constexpr bool writable = Acc != Access::Read;
+};
+
+namespace reg
+{
+
+// generated from regmap/ioplus.map, begin
+using Relay = Reg<I2C_MEM_RELAY_VAL_ADD, uint8_t, 1, Access::ReadWrite>; // relay states, bit 0 is relay 1
+using RelaySet = Reg<I2C_MEM_RELAY_SET_ADD, uint8_t, 1, Access::Write>; // turn relay <value> on
+using RelayClr = Reg<I2C_MEM_RELAY_CLR_ADD, uint8_t, 1, Access::Write>; // turn relay <value> off
+using Opto = Reg<I2C_MEM_OPTO_IN_ADD, uint8_t>; // opto input states
+using Gpio = Reg<I2C_MEM_GPIO_VAL_ADD, uint8_t, 1, Access::ReadWrite>; // gpio states
+using GpioSet = Reg<I2C_MEM_GPIO_SET_ADD, uint8_t, 1, Access::Write>; // turn gpio <value> on
+using GpioClr = Reg<I2C_MEM_GPIO_CLR_ADD, uint8_t, 1, Access::Write>; // turn gpio <value> off
+using GpioDir = Reg<I2C_MEM_GPIO_DIR_ADD, uint8_t, 1, Access::ReadWrite>; // 1 for input
+using AdcRaw = Reg<I2C_MEM_ADC_VAL_RAW_ADD, uint16_t, ADC_CH_NO>; // ADC counts
+using AdcMv = Reg<I2C_MEM_ADC_VAL_MV_ADD, uint16_t, ADC_CH_NO>; // mV
+using DacMv = Reg<I2C_MEM_DAC_VAL_MV_ADD, uint16_t, DAC_CH_NO, Access::ReadWrite>; // mV
+using OdPwm = Reg<I2C_MEM_OD_PWM_VAL_RAW_ADD, uint16_t, OD_CH_NO, Access::ReadWrite>; // fill factor 0..10000
+using OptoRising = Reg<I2C_MEM_OPTO_IT_RISING_ADD, uint8_t, 1, Access::ReadWrite>; // count rising edges
+using OptoFalling = Reg<I2C_MEM_OPTO_IT_FALLING_ADD, uint8_t, 1, Access::ReadWrite>; // count falling edges
+using GpioRising = Reg<I2C_MEM_GPIO_EXT_IT_RISING_ADD, uint8_t, 1, Access::ReadWrite>;
+using GpioFalling = Reg<I2C_MEM_GPIO_EXT_IT_FALLING_ADD, uint8_t, 1, Access::ReadWrite>;
+using OptoCntRst = Reg<I2C_MEM_OPTO_CNT_RST_ADD, uint8_t, 1, Access::Write>; // reset counter <value>
+using GpioCntRst = Reg<I2C_MEM_GPIO_CNT_RST_ADD, uint8_t, 1, Access::Write>;
+using DiagTemp = Reg<I2C_MEM_DIAG_TEMPERATURE_ADD, uint8_t>; // degC
+using Diag3v3 = Reg<I2C_MEM_DIAG_3V3_MV_ADD, uint16_t>; // mV
+using CalibValue = Reg<I2C_MEM_CALIB_VALUE, uint16_t, 1, Access::Write>; // mV
+using CalibChannel = Reg<I2C_MEM_CALIB_CHANNEL, uint8_t, 1, Access::Write>; // ADC 1..8, DAC 9..12
+using CalibKey = Reg<I2C_MEM_CALIB_KEY, uint8_t, 1, Access::Write>; // 0xaa set point, 0x55 reset
+using CalibStatus = Reg<I2C_MEM_CALIB_STATUS, uint8_t>;
+using OptoEncEnable = Reg<I2C_MEM_OPTO_ENC_ENABLE_ADD, uint8_t, 1, Access::ReadWrite>;
+using GpioEncEnable = Reg<I2C_MEM_GPIO_ENC_ENABLE_ADD, uint8_t, 1, Access::ReadWrite>;
+using OptoEncCntRst = Reg<I2C_MEM_OPTO_ENC_CNT_RST_ADD, uint8_t, 1, Access::Write>;
+using GpioEncCntRst = Reg<I2C_MEM_GPIO_ENC_CNT_RST_ADD, uint8_t, 1, Access::Write>;
+using OdPulses = Reg<I2C_MEM_OD_PULSE_CNT_SET, uint32_t, OD_CH_NO, Access::ReadWrite>; // pulses left to send
+using OdPwmFreq = Reg<I2C_MEM_OD_PWM_FREQUENCY_CH1, uint16_t, OD_CH_NO, Access::ReadWrite>; // Hz
+using RelayDefault = Reg<I2C_MEM_RELAY_DEFAULT, uint8_t, 1, Access::ReadWrite>; // relay states at power up
+using OdDefault = Reg<I2C_MEM_OD_DEFAULT, uint8_t, 1, Access::ReadWrite>;
+using WdtReset = Reg<I2C_MEM_WDT_RESET_ADD, uint8_t, 1, Access::Write>; // 0xca reloads the watchdog
+using WdtPeriodSet = Reg<I2C_MEM_WDT_INTERVAL_SET_ADD, uint16_t, 1, Access::Write>; // s
+using WdtPeriod = Reg<I2C_MEM_WDT_INTERVAL_GET_ADD, uint16_t>; // s
+using WdtInitPeriodSet = Reg<I2C_MEM_WDT_INIT_INTERVAL_SET_ADD, uint16_t, 1, Access::Write>; // s
+using WdtInitPeriod = Reg<I2C_MEM_WDT_INIT_INTERVAL_GET_ADD, uint16_t>; // s
+using WdtResetCount = Reg<I2C_MEM_WDT_RESET_COUNT_ADD, uint16_t>;
+using WdtResetCountClr = Reg<I2C_MEM_WDT_CLEAR_RESET_COUNT_ADD, uint8_t, 1, Access::Write>;
+using WdtOffPeriodSet = Reg<I2C_MEM_WDT_POWER_OFF_INTERVAL_SET_ADD, uint32_t, 1, Access::Write>; // s
+using WdtOffPeriod = Reg<I2C_MEM_WDT_POWER_OFF_INTERVAL_GET_ADD, uint32_t>; // s
+using Revision = Reg<I2C_MEM_REVISION_HW_MAJOR_ADD, uint8_t, 4>; // hw major, minor, fw major, minor
+using DbgFifoSize = Reg<I2C_DBG_FIFO_SIZE, uint16_t>;
+using DbgFifo = Reg<I2C_DBG_FIFO_ADD, uint8_t>;
+using DbgCmd = Reg<I2C_DBG_CMD, uint8_t, 1, Access::Write>;
+using OptoCount = Reg<I2C_MEM_OPTO_EDGE_COUNT_ADD, uint32_t, OPTO_CH_NO>;
+using OdPwmFreqAll = Reg<I2C_MEM_OD_PWM_FREQUENCY, uint16_t, 1, Access::ReadWrite>; // Hz, all channels
+using MinMaxSamples = Reg<I2C_MEM_MIN_MAX_SAMPLES, uint8_t, 1, Access::ReadWrite>;
+using OdPulsesValue = Reg<I2C_MEM_OD_P_SET_VALUE, uint32_t, 1, Access::Write>;
+using OdPulsesCmd = Reg<I2C_MEM_OD_P_SET_CMD, uint8_t, 1, Access::Write>; // channel, +4 for reverse
+using GpioCount = Reg<I2C_MEM_GPIO_EDGE_COUNT_ADD, uint32_t, GPIO_CH_NO>;
+using InPulsesSet = Reg<I2C_MEM_PULSE_COUNTER_SET, uint32_t, 1, Access::Write>; // pulses on an output per input edge
+using InPulsesOut = Reg<I2C_MEM_OD_CH_SET, uint8_t, 1, Access::Write>;
+using InPulsesIn = Reg<I2C_MEM_OPTO_CH_SET, uint8_t, 1, Access::Write>;
+using OptoEncCount = Reg<I2C_MEM_OPTO_ENC_COUNT_ADD, int32_t, 4>;
+using GpioEncCount = Reg<I2C_MEM_GPIO_ENC_COUNT_ADD, int32_t, 2>;
+using OwbCount = Reg<I2C_MEM_1WB_DEV, uint8_t>; // sensors found
+using OwbRomIdx = Reg<I2C_MEM_1WB_ROM_CODE_IDX, uint8_t, 1, Access::ReadWrite>;
+using OwbRom = Reg<I2C_MEM_1WB_ROM_CODE, uint64_t>;
+using OwbSearch = Reg<I2C_MEM_1WB_START_SEARCH, uint8_t, 1, Access::Write>;
+using OwbTemp = Reg<I2C_MEM_1WB_T1, int16_t, OWB_SENS_CNT>; // 0.01 degC
+using AdcMax = Reg<I2C_MEM_ADC_MAX, uint16_t, 4>; // mV, hardware 3 and up
+using AdcMin = Reg<I2C_MEM_ADC_MIN, uint16_t, 4>; // mV
+using OdAcc = Reg<I2C_MEM_ODP_ACC, uint16_t, 1, Access::Write>; // pulses/s/s, firmware with motion
+using OdDec = Reg<I2C_MEM_ODP_DEC, uint16_t, 1, Access::Write>; // pulses/s/s
+using OdMaxSpeed = Reg<I2C_MEM_ODP_MAXS, uint16_t, 1, Access::Write>; // pulses/s
+using OdMinSpeed = Reg<I2C_MEM_ODP_MINS, uint16_t, 1, Access::Write>; // pulses/s
+using OdMoveCmd = Reg<I2C_MEM_ODP_CMD, uint8_t, 1, Access::Write>; // apply to channel <value>
+// generated from regmap/ioplus.map, end
+
+} // namespace reg
+
+/* One image of the smallest span holding all the registers R, read by
+ * Board::read(Block&) and decoded with get<>() without another transfer */
+template<class ... R>
+class Block
+{
+	static constexpr int lowest(std::initializer_list<int> v)
+	{
+		int m = SLAVE_BUFF_SIZE;
+		for (int x : v)
+		{
+			m = (x < m) ? x : m;
+		}
+		return m;
+	}
+
+	static constexpr int highest(std::initializer_list<int> v)
+	{
+		int m = 0;
+		for (int x : v)
+		{
+			m = (x > m) ? x : m;
+		}
+		return m;
+	}
+
+	template<class X>
+	static constexpr bool member()
+	{
+		return (std::is_same<X, R>::value || ...);
+	}
+
+public:
+	static_assert(sizeof...(R) > 0, "a block holds one register at least");
+	static_assert( (R::readable && ...), "a block holds readable registers");
+
+	static constexpr int add = lowest({R::add...});
+	static constexpr int size = highest({ (R::add + R::size)...}) - add;
+
+	template<class X>
+	typename X::value_type get() const noexcept
+	{
+		static_assert(member<X>(), "register not in this block");
+		typename X::value_type v;
+
+		std::memcpy(&v, &img_[X::add - add], X::size);
+		return v;
+	}
+
+	uint8_t* data() noexcept
+	{
+		return img_.data();
+	}
+
+private:
+	std::array<uint8_t, size> img_ {};
+};
+
+class Board
+{
+public:
+	explicit Board(int stack)
+	{
+		check(ioplusOpen(&b_, stack));
+	}
+
+	~Board()
+	{
+		ioplusClose(&b_);
+	}
+
+	Board(const Board&) = delete;
+	Board& operator=(const Board&) = delete;
+
+	Board(Board &&o) noexcept
+		: b_(o.b_)
+	{
+		o.b_.dev = -1;
+	}
+
+	Board& operator=(Board &&o) noexcept
+	{
+		if (this != &o)
+		{
+			ioplusClose(&b_);
+			b_ = o.b_;
+			o.b_.dev = -1;
+		}
+		return *this;
+	}
+
+	// for the C functions, the handle stays owned by the Board
+	IoplusBoardType* handle() noexcept
+	{
+		return &b_;
+	}
+
+	int stack() const noexcept
+	{
+		return b_.stack;
+	}
+
+	template<class R>
+	typename R::value_type read()
+	{
+		static_assert(R::readable, "write only register");
+		typename R::value_type v;
+
+		check(ioplusRegRead(&b_, R::add, reinterpret_cast<uint8_t*>(&v), R::size));
+		return v;
+	}
+
+	// one channel, 1 based, checked at compile time
+	template<class R, int Ch>
+	typename R::type read()
+	{
+		static_assert(R::readable, "write only register");
+		static_assert( (Ch >= 1) && (Ch <= R::count), "channel out of range");
+		typename R::type v;
+
+		check(ioplusRegRead(&b_, R::add + (Ch - 1) * R::width,
+			reinterpret_cast<uint8_t*>(&v), R::width));
+		return v;
+	}
+
+	template<class R>
+	void write(const typename R::value_type &v)
+	{
+		static_assert(R::writable, "read only register");
+		check(ioplusRegWrite(&b_, R::add, reinterpret_cast<const uint8_t*>(&v),
+			R::size));
+	}
+
+	template<class R, int Ch>
+	void write(typename R::type v)
+	{
+		static_assert(R::writable, "read only register");
+		static_assert( (Ch >= 1) && (Ch <= R::count), "channel out of range");
+		check(ioplusRegWrite(&b_, R::add + (Ch - 1) * R::width,
+			reinterpret_cast<const uint8_t*>(&v), R::width));
+	}
+
+	template<class ... R>
+	void read(Block<R...> &blk)
+	{
+		check(ioplusRegRead(&b_, Block<R...>::add, blk.data(), Block<R...>::size));
+	}
+
+	// the first n values of R into out, n at most R::count
+	template<class R>
+	void read(typename R::type *out, std::size_t n)
+	{
+		static_assert(R::readable, "write only register");
+		if (n > static_cast<std::size_t>(R::count))
+		{
+			throw Error(IOPLUS_ERR_ARG);
+		}
+		check(ioplusRegRead(&b_, R::add, reinterpret_cast<uint8_t*>(out),
+			static_cast<int>(n) * R::width));
+	}
+
+#if __cplusplus >= 202002L
+	// a fixed size span is checked at compile time, a dynamic one at run time
+	template<class R, std::size_t N>
+	void read(std::span<typename R::type, N> out)
+	{
+		static_assert( (N == std::dynamic_extent)
+			|| (N <= static_cast<std::size_t>(R::count)), "span larger than the register");
+		read<R>(out.data(), out.size());
+	}
+
+	// raw bytes of the map from add
+	void readBytes(int add, std::span<uint8_t> out)
+	{
+		check(ioplusRegRead(&b_, add, out.data(), static_cast<int>(out.size())));
+	}
+
+	void writeBytes(int add, std::span<const uint8_t> in)
+	{
+		check(ioplusRegWrite(&b_, add, in.data(), static_cast<int>(in.size())));
+	}
+#endif
+
+private:
+	IoplusBoardType b_;
+};
+
+} // namespace ioplus
+
+#endif //IOPLUS_HPP_
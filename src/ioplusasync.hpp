@@ -0,0 +1,96 @@
+/*
+ * ioplusasync.hpp:
+ *	C++20 coroutine adapter for the asynchronous register access of
+ *	libioplus: co_await ioplus::asyncRead(...) suspends until the I/O
+ *	thread has run the request and evaluates to its IOPLUS_xxx result.
+ *
+ *	The coroutine resumes on the I/O thread, so it must not block there
+ *	(no ioplusAsyncWait(), no sleeping) or hand itself over to an executor
+ *	of its own before doing so.
+ *
+ *	Copyright (c) 2016-2023 Sequent Microsystem
+ *	<http://www.sequentmicrosystem.com>
+ ***********************************************************************
+ */
+#ifndef IOPLUSASYNC_HPP_
+#define IOPLUSASYNC_HPP_
+
+#include <coroutine>
+#include <cstdint>
+
+#include "libioplus.h"
+
+namespace ioplus
+{
+
+class AsyncOp
+{
+public:
+	AsyncOp(IoplusAsyncType &q, IoplusBoardType &board, int op, int add,
+		uint8_t *buf, int size) noexcept
+		: q_(q)
+	{
+		ioplusAsyncReqInit(&req_, &board, op, add, buf, size);
+		req_.cb = &AsyncOp::done;
+		req_.ctx = this;
+	}
+
+	AsyncOp(const AsyncOp&) = delete;
+	AsyncOp& operator=(const AsyncOp&) = delete;
+
+	bool await_ready() const noexcept
+	{
+		return false;
+	}
+
+	// not suspended when the request is refused, await_resume() reports why;
+	// once submitted the I/O thread may resume the coroutine and free this
+	// frame before ioplusAsyncSubmit() returns, so *this is not touched again
+	bool await_suspend(std::coroutine_handle<> h) noexcept
+	{
+		int ret;
+
+		handle_ = h;
+		ret = ioplusAsyncSubmit(&q_, &req_);
+		if (ret != IOPLUS_OK)
+		{
+			submitted_ = ret;
+			return false;
+		}
+		return true;
+	}
+
+	int await_resume() const noexcept
+	{
+		return (submitted_ == IOPLUS_OK) ? req_.result : submitted_;
+	}
+
+private:
+	static void done(IoplusAsyncReqType *req)
+	{
+		static_cast<AsyncOp*>(req->ctx)->handle_.resume();
+	}
+
+	IoplusAsyncType &q_;
+	IoplusAsyncReqType req_;
+	std::coroutine_handle<> handle_;
+	int submitted_ = IOPLUS_OK;
+};
+
+inline AsyncOp asyncRead(IoplusAsyncType &q, IoplusBoardType &board, int add,
+	uint8_t *buf, int size) noexcept
+{
+	return AsyncOp(q, board, IOPLUS_ASYNC_READ, add, buf, size);
+}
+
+inline AsyncOp asyncWrite(IoplusAsyncType &q, IoplusBoardType &board, int add,
+	const uint8_t *buf, int size) noexcept
+{
+	// the write request only reads from buf
+	return AsyncOp(q, board, IOPLUS_ASYNC_WRITE, add, const_cast<uint8_t*>(buf),
+		size);
+}
+
+} // namespace ioplus
+
+#endif //IOPLUSASYNC_HPP_
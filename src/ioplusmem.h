@@ -0,0 +1,342 @@
+/*
+ * ioplusmem.h:
+ *	Register map of the IO-PLUS card firmware, shared by the command line
+ *	tool, the C library and the C++ layer (ioplus.hpp).
+ *	Generated by regmap/regmap.py from regmap/ioplus.map, do not edit,
+ *	change the map and run "make regmap".
+ *
+ *	Copyright (c) 2016-2023 Sequent Microsystem
+ *	<http://www.sequentmicrosystem.com>
+ ***********************************************************************
+ */
+#ifndef IOPLUSMEM_H_
+#define IOPLUSMEM_H_
+
+#include <stdint.h>
+#include <string.h>
+
+#define ADC_CH_NO	8
+#define DAC_CH_NO	4
+#define OD_CH_NO	4
+#define ADC_RAW_VAL_SIZE	2
+#define DAC_MV_VAL_SIZE	2
+#define OPTO_CH_NO	8
+#define GPIO_CH_NO	4
+#define COUNTER_SIZE	4
+#define OWB_TEMP_SIZE_B	2
+#define OWB_SENS_CNT	8
+
+typedef enum
+{
+	I2C_MEM_RELAY_VAL_ADD = 0, // relay states, bit 0 is relay 1
+	I2C_MEM_RELAY_SET_ADD = 1, // turn relay <value> on
+	I2C_MEM_RELAY_CLR_ADD = 2, // turn relay <value> off
+	I2C_MEM_OPTO_IN_ADD = 3, // opto input states
+	I2C_MEM_GPIO_VAL_ADD = 4, // gpio states
+	I2C_MEM_GPIO_SET_ADD = 5, // turn gpio <value> on
+	I2C_MEM_GPIO_CLR_ADD = 6, // turn gpio <value> off
+	I2C_MEM_GPIO_DIR_ADD = 7, // 1 for input
+	I2C_MEM_ADC_VAL_RAW_ADD = 8, // ADC counts
+	I2C_MEM_ADC_VAL_MV_ADD = 24, // mV
+	I2C_MEM_DAC_VAL_MV_ADD = 40, // mV
+	I2C_MEM_OD_PWM_VAL_RAW_ADD = 48, // fill factor 0..10000
+	I2C_MEM_OPTO_IT_RISING_ADD = 56, // count rising edges
+	I2C_MEM_OPTO_IT_FALLING_ADD = 57, // count falling edges
+	I2C_MEM_GPIO_EXT_IT_RISING_ADD = 58,
+	I2C_MEM_GPIO_EXT_IT_FALLING_ADD = 59,
+	I2C_MEM_OPTO_CNT_RST_ADD = 60, // reset counter <value>
+	I2C_MEM_GPIO_CNT_RST_ADD = 61,
+	I2C_MEM_DIAG_TEMPERATURE_ADD = 62, // degC
+	I2C_MEM_DIAG_3V3_MV_ADD = 63, // mV
+	I2C_MEM_DIAG_3V3_MV_ADD1 = 64,
+	I2C_MEM_CALIB_VALUE = 65, // mV
+	I2C_MEM_CALIB_CHANNEL = 67, // ADC 1..8, DAC 9..12
+	I2C_MEM_CALIB_KEY = 68, // 0xaa set point, 0x55 reset
+	I2C_MEM_CALIB_STATUS = 69,
+	I2C_MEM_OPTO_ENC_ENABLE_ADD = 70,
+	I2C_MEM_GPIO_ENC_ENABLE_ADD = 71,
+	I2C_MEM_OPTO_ENC_CNT_RST_ADD = 72,
+	I2C_MEM_GPIO_ENC_CNT_RST_ADD = 73,
+	I2C_MEM_OD_PULSE_CNT_SET = 74, // pulses left to send
+	I2C_MEM_OD_PULSE_CNT_SET_END_ADD = 90,
+	I2C_MEM_OD_PWM_FREQUENCY_CH1 = 90, // Hz
+	I2C_MEM_OD_PWM_FREQUENCY_CH2 = 92,
+	I2C_MEM_OD_PWM_FREQUENCY_CH3 = 94,
+	I2C_MEM_OD_PWM_FREQUENCY_CH4 = 96,
+	I2C_MEM_RELAY_DEFAULT = 98, // relay states at power up
+	I2C_MEM_OD_DEFAULT = 99,
+	I2C_MEM_WDT_RESET_ADD = 100, // 0xca reloads the watchdog
+	I2C_MEM_WDT_INTERVAL_SET_ADD = 101, // s
+	I2C_MEM_WDT_INTERVAL_GET_ADD = 103, // s
+	I2C_MEM_WDT_INIT_INTERVAL_SET_ADD = 105, // s
+	I2C_MEM_WDT_INIT_INTERVAL_GET_ADD = 107, // s
+	I2C_MEM_WDT_RESET_COUNT_ADD = 109,
+	I2C_MEM_WDT_CLEAR_RESET_COUNT_ADD = 111,
+	I2C_MEM_WDT_POWER_OFF_INTERVAL_SET_ADD = 112, // s
+	I2C_MEM_WDT_POWER_OFF_INTERVAL_GET_ADD = 116, // s
+	I2C_MEM_REVISION_HW_MAJOR_ADD = 120, // hw major, minor, fw major, minor
+	I2C_MEM_REVISION_HW_MINOR_ADD = 121,
+	I2C_MEM_REVISION_MAJOR_ADD = 122,
+	I2C_MEM_REVISION_MINOR_ADD = 123,
+	I2C_DBG_FIFO_SIZE = 124,
+	I2C_DBG_FIFO_ADD = 126,
+	I2C_DBG_CMD = 127,
+	I2C_MEM_OPTO_EDGE_COUNT_ADD = 128,
+	I2C_MEM_OPTO_EDGE_COUNT_END_ADD = 160,
+	I2C_MEM_OD_PWM_FREQUENCY = 161, // Hz, all channels
+	I2C_MEM_MIN_MAX_SAMPLES = 163,
+	I2C_MEM_OD_P_SET_VALUE = 164,
+	I2C_MEM_OD_P_SET_CMD = 168, // channel, +4 for reverse
+	I2C_MEM_ADD_RESERVED = 170,
+	I2C_MEM_GPIO_EDGE_COUNT_ADD = 171,
+	I2C_MEM_PULSE_COUNTER_SET = 171, // pulses on an output per input edge
+	I2C_MEM_OD_CH_SET = 175,
+	I2C_MEM_OPTO_CH_SET = 176,
+	I2C_MEM_OPTO_ENC_COUNT_ADD = 187,
+	I2C_MEM_GPIO_ENC_COUNT_ADD = 203,
+	I2C_MEM_GPIO_ENC_COUNT_END_ADD = 211,
+	I2C_MEM_1WB_DEV = 211, // sensors found
+	I2C_MEM_1WB_ROM_CODE_IDX = 212,
+	I2C_MEM_1WB_ROM_CODE = 213,
+	I2C_MEM_1WB_ROM_CODE_END = 220,
+	I2C_MEM_1WB_START_SEARCH = 221,
+	I2C_MEM_1WB_T1 = 222, // 0.01 degC
+	I2C_MEM_1WB_T_END = 238,
+	I2C_MEM_ADC_MAX = 238, // mV, hardware 3 and up
+	I2C_MEM_ADC_MIN = 246, // mV
+	I2C_MEM_ODP_ACC = 238, // pulses/s/s, firmware with motion
+	I2C_MEM_ODP_DEC = 240, // pulses/s/s
+	I2C_MEM_ODP_MAXS = 242, // pulses/s
+	I2C_MEM_ODP_MINS = 244, // pulses/s
+	I2C_MEM_ODP_CMD = 246, // apply to channel <value>
+	SLAVE_BUFF_SIZE = 255,
+} I2C_MEM_ADD;
+
+/* X(name, address) for each named address, sorted, for the I2C trace */
+#define IOPLUS_MEM_NAMES(X) \
+	X("RELAY_VAL", I2C_MEM_RELAY_VAL_ADD) \
+	X("RELAY_SET", I2C_MEM_RELAY_SET_ADD) \
+	X("RELAY_CLR", I2C_MEM_RELAY_CLR_ADD) \
+	X("OPTO_IN", I2C_MEM_OPTO_IN_ADD) \
+	X("GPIO_VAL", I2C_MEM_GPIO_VAL_ADD) \
+	X("GPIO_SET", I2C_MEM_GPIO_SET_ADD) \
+	X("GPIO_CLR", I2C_MEM_GPIO_CLR_ADD) \
+	X("GPIO_DIR", I2C_MEM_GPIO_DIR_ADD) \
+	X("ADC_VAL_RAW", I2C_MEM_ADC_VAL_RAW_ADD) \
+	X("ADC_VAL_MV", I2C_MEM_ADC_VAL_MV_ADD) \
+	X("DAC_VAL_MV", I2C_MEM_DAC_VAL_MV_ADD) \
+	X("OD_PWM_VAL_RAW", I2C_MEM_OD_PWM_VAL_RAW_ADD) \
+	X("OPTO_IT_RISING", I2C_MEM_OPTO_IT_RISING_ADD) \
+	X("OPTO_IT_FALLING", I2C_MEM_OPTO_IT_FALLING_ADD) \
+	X("GPIO_EXT_IT_RISING", I2C_MEM_GPIO_EXT_IT_RISING_ADD) \
+	X("GPIO_EXT_IT_FALLING", I2C_MEM_GPIO_EXT_IT_FALLING_ADD) \
+	X("OPTO_CNT_RST", I2C_MEM_OPTO_CNT_RST_ADD) \
+	X("GPIO_CNT_RST", I2C_MEM_GPIO_CNT_RST_ADD) \
+	X("DIAG_TEMPERATURE", I2C_MEM_DIAG_TEMPERATURE_ADD) \
+	X("DIAG_3V3_MV", I2C_MEM_DIAG_3V3_MV_ADD) \
+	X("CALIB_VALUE", I2C_MEM_CALIB_VALUE) \
+	X("CALIB_CHANNEL", I2C_MEM_CALIB_CHANNEL) \
+	X("CALIB_KEY", I2C_MEM_CALIB_KEY) \
+	X("CALIB_STATUS", I2C_MEM_CALIB_STATUS) \
+	X("OPTO_ENC_ENABLE", I2C_MEM_OPTO_ENC_ENABLE_ADD) \
+	X("GPIO_ENC_ENABLE", I2C_MEM_GPIO_ENC_ENABLE_ADD) \
+	X("OPTO_ENC_CNT_RST", I2C_MEM_OPTO_ENC_CNT_RST_ADD) \
+	X("GPIO_ENC_CNT_RST", I2C_MEM_GPIO_ENC_CNT_RST_ADD) \
+	X("OD_PULSE_CNT_SET", I2C_MEM_OD_PULSE_CNT_SET) \
+	X("OD_PWM_FREQUENCY_CH1", I2C_MEM_OD_PWM_FREQUENCY_CH1) \
+	X("OD_PWM_FREQUENCY_CH2", I2C_MEM_OD_PWM_FREQUENCY_CH2) \
+	X("OD_PWM_FREQUENCY_CH3", I2C_MEM_OD_PWM_FREQUENCY_CH3) \
+	X("OD_PWM_FREQUENCY_CH4", I2C_MEM_OD_PWM_FREQUENCY_CH4) \
+	X("RELAY_DEFAULT", I2C_MEM_RELAY_DEFAULT) \
+	X("OD_DEFAULT", I2C_MEM_OD_DEFAULT) \
+	X("WDT_RESET", I2C_MEM_WDT_RESET_ADD) \
+	X("WDT_INTERVAL_SET", I2C_MEM_WDT_INTERVAL_SET_ADD) \
+	X("WDT_INTERVAL_GET", I2C_MEM_WDT_INTERVAL_GET_ADD) \
+	X("WDT_INIT_INTERVAL_SET", I2C_MEM_WDT_INIT_INTERVAL_SET_ADD) \
+	X("WDT_INIT_INTERVAL_GET", I2C_MEM_WDT_INIT_INTERVAL_GET_ADD) \
+	X("WDT_RESET_COUNT", I2C_MEM_WDT_RESET_COUNT_ADD) \
+	X("WDT_CLEAR_RESET_COUNT", I2C_MEM_WDT_CLEAR_RESET_COUNT_ADD) \
+	X("WDT_POWER_OFF_INTERVAL_SET", I2C_MEM_WDT_POWER_OFF_INTERVAL_SET_ADD) \
+	X("WDT_POWER_OFF_INTERVAL_GET", I2C_MEM_WDT_POWER_OFF_INTERVAL_GET_ADD) \
+	X("REVISION_HW_MAJOR", I2C_MEM_REVISION_HW_MAJOR_ADD) \
+	X("REVISION_HW_MINOR", I2C_MEM_REVISION_HW_MINOR_ADD) \
+	X("REVISION_MAJOR", I2C_MEM_REVISION_MAJOR_ADD) \
+	X("REVISION_MINOR", I2C_MEM_REVISION_MINOR_ADD) \
+	X("DBG_FIFO_SIZE", I2C_DBG_FIFO_SIZE) \
+	X("DBG_FIFO", I2C_DBG_FIFO_ADD) \
+	X("DBG_CMD", I2C_DBG_CMD) \
+	X("OPTO_EDGE_COUNT", I2C_MEM_OPTO_EDGE_COUNT_ADD) \
+	X("OD_PWM_FREQUENCY", I2C_MEM_OD_PWM_FREQUENCY) \
+	X("MIN_MAX_SAMPLES", I2C_MEM_MIN_MAX_SAMPLES) \
+	X("OD_P_SET_VALUE", I2C_MEM_OD_P_SET_VALUE) \
+	X("OD_P_SET_CMD", I2C_MEM_OD_P_SET_CMD) \
+	X("ADD_RESERVED", I2C_MEM_ADD_RESERVED) \
+	X("GPIO_EDGE_COUNT", I2C_MEM_GPIO_EDGE_COUNT_ADD) \
+	X("OPTO_ENC_COUNT", I2C_MEM_OPTO_ENC_COUNT_ADD) \
+	X("GPIO_ENC_COUNT", I2C_MEM_GPIO_ENC_COUNT_ADD) \
+	X("1WB_DEV", I2C_MEM_1WB_DEV) \
+	X("1WB_ROM_CODE_IDX", I2C_MEM_1WB_ROM_CODE_IDX) \
+	X("1WB_ROM_CODE", I2C_MEM_1WB_ROM_CODE) \
+	X("1WB_START_SEARCH", I2C_MEM_1WB_START_SEARCH) \
+	X("1WB_T1", I2C_MEM_1WB_T1) \
+	X("ADC_MAX", I2C_MEM_ADC_MAX) \
+	X("ADC_MIN", I2C_MEM_ADC_MIN)
+
+/* Typed values out of an image of the map read from imgAdd, channels
+ * are 1 based: IOPLUS_MEM_ADC_MV(buff, I2C_MEM_RELAY_VAL_ADD, 2) */
+static inline uint8_t ioplusMemU8(const uint8_t *p)
+{
+	return (uint8_t)p[0];
+}
+
+static inline int8_t ioplusMemS8(const uint8_t *p)
+{
+	return (int8_t)p[0];
+}
+
+static inline uint16_t ioplusMemU16(const uint8_t *p)
+{
+	uint16_t v;
+
+	memcpy(&v, p, sizeof(v));
+	return v;
+}
+
+static inline int16_t ioplusMemS16(const uint8_t *p)
+{
+	int16_t v;
+
+	memcpy(&v, p, sizeof(v));
+	return v;
+}
+
+static inline uint32_t ioplusMemU32(const uint8_t *p)
+{
+	uint32_t v;
+
+	memcpy(&v, p, sizeof(v));
+	return v;
+}
+
+static inline int32_t ioplusMemS32(const uint8_t *p)
+{
+	int32_t v;
+
+	memcpy(&v, p, sizeof(v));
+	return v;
+}
+
+static inline uint64_t ioplusMemU64(const uint8_t *p)
+{
+	uint64_t v;
+
+	memcpy(&v, p, sizeof(v));
+	return v;
+}
+
+#define IOPLUS_MEM_RELAY(img, imgAdd) \
+	ioplusMemU8( (img) + I2C_MEM_RELAY_VAL_ADD - (imgAdd))
+#define IOPLUS_MEM_OPTO(img, imgAdd) \
+	ioplusMemU8( (img) + I2C_MEM_OPTO_IN_ADD - (imgAdd))
+#define IOPLUS_MEM_GPIO(img, imgAdd) \
+	ioplusMemU8( (img) + I2C_MEM_GPIO_VAL_ADD - (imgAdd))
+#define IOPLUS_MEM_GPIO_DIR(img, imgAdd) \
+	ioplusMemU8( (img) + I2C_MEM_GPIO_DIR_ADD - (imgAdd))
+#define IOPLUS_MEM_ADC_RAW_CH_NO	ADC_CH_NO
+#define IOPLUS_MEM_ADC_RAW(img, imgAdd, ch) \
+	ioplusMemU16( (img) + I2C_MEM_ADC_VAL_RAW_ADD - (imgAdd) + 2 * ( (ch) - 1))
+#define IOPLUS_MEM_ADC_MV_CH_NO	ADC_CH_NO
+#define IOPLUS_MEM_ADC_MV(img, imgAdd, ch) \
+	ioplusMemU16( (img) + I2C_MEM_ADC_VAL_MV_ADD - (imgAdd) + 2 * ( (ch) - 1))
+#define IOPLUS_MEM_DAC_MV_CH_NO	DAC_CH_NO
+#define IOPLUS_MEM_DAC_MV(img, imgAdd, ch) \
+	ioplusMemU16( (img) + I2C_MEM_DAC_VAL_MV_ADD - (imgAdd) + 2 * ( (ch) - 1))
+#define IOPLUS_MEM_OD_PWM_CH_NO	OD_CH_NO
+#define IOPLUS_MEM_OD_PWM(img, imgAdd, ch) \
+	ioplusMemU16( (img) + I2C_MEM_OD_PWM_VAL_RAW_ADD - (imgAdd) + 2 * ( (ch) - 1))
+#define IOPLUS_MEM_OPTO_RISING(img, imgAdd) \
+	ioplusMemU8( (img) + I2C_MEM_OPTO_IT_RISING_ADD - (imgAdd))
+#define IOPLUS_MEM_OPTO_FALLING(img, imgAdd) \
+	ioplusMemU8( (img) + I2C_MEM_OPTO_IT_FALLING_ADD - (imgAdd))
+#define IOPLUS_MEM_GPIO_RISING(img, imgAdd) \
+	ioplusMemU8( (img) + I2C_MEM_GPIO_EXT_IT_RISING_ADD - (imgAdd))
+#define IOPLUS_MEM_GPIO_FALLING(img, imgAdd) \
+	ioplusMemU8( (img) + I2C_MEM_GPIO_EXT_IT_FALLING_ADD - (imgAdd))
+#define IOPLUS_MEM_DIAG_TEMP(img, imgAdd) \
+	ioplusMemU8( (img) + I2C_MEM_DIAG_TEMPERATURE_ADD - (imgAdd))
+#define IOPLUS_MEM_DIAG_3V3(img, imgAdd) \
+	ioplusMemU16( (img) + I2C_MEM_DIAG_3V3_MV_ADD - (imgAdd))
+#define IOPLUS_MEM_CALIB_STATUS(img, imgAdd) \
+	ioplusMemU8( (img) + I2C_MEM_CALIB_STATUS - (imgAdd))
+#define IOPLUS_MEM_OPTO_ENC_ENABLE(img, imgAdd) \
+	ioplusMemU8( (img) + I2C_MEM_OPTO_ENC_ENABLE_ADD - (imgAdd))
+#define IOPLUS_MEM_GPIO_ENC_ENABLE(img, imgAdd) \
+	ioplusMemU8( (img) + I2C_MEM_GPIO_ENC_ENABLE_ADD - (imgAdd))
+#define IOPLUS_MEM_OD_PULSES_CH_NO	OD_CH_NO
+#define IOPLUS_MEM_OD_PULSES(img, imgAdd, ch) \
+	ioplusMemU32( (img) + I2C_MEM_OD_PULSE_CNT_SET - (imgAdd) + 4 * ( (ch) - 1))
+#define IOPLUS_MEM_OD_PWM_FREQ_CH_NO	OD_CH_NO
+#define IOPLUS_MEM_OD_PWM_FREQ(img, imgAdd, ch) \
+	ioplusMemU16( (img) + I2C_MEM_OD_PWM_FREQUENCY_CH1 - (imgAdd) + 2 * ( (ch) - 1))
+#define IOPLUS_MEM_RELAY_DEFAULT(img, imgAdd) \
+	ioplusMemU8( (img) + I2C_MEM_RELAY_DEFAULT - (imgAdd))
+#define IOPLUS_MEM_OD_DEFAULT(img, imgAdd) \
+	ioplusMemU8( (img) + I2C_MEM_OD_DEFAULT - (imgAdd))
+#define IOPLUS_MEM_WDT_PERIOD(img, imgAdd) \
+	ioplusMemU16( (img) + I2C_MEM_WDT_INTERVAL_GET_ADD - (imgAdd))
+#define IOPLUS_MEM_WDT_INIT_PERIOD(img, imgAdd) \
+	ioplusMemU16( (img) + I2C_MEM_WDT_INIT_INTERVAL_GET_ADD - (imgAdd))
+#define IOPLUS_MEM_WDT_RESET_COUNT(img, imgAdd) \
+	ioplusMemU16( (img) + I2C_MEM_WDT_RESET_COUNT_ADD - (imgAdd))
+#define IOPLUS_MEM_WDT_OFF_PERIOD(img, imgAdd) \
+	ioplusMemU32( (img) + I2C_MEM_WDT_POWER_OFF_INTERVAL_GET_ADD - (imgAdd))
+#define IOPLUS_MEM_REVISION_CH_NO	4
+#define IOPLUS_MEM_REVISION(img, imgAdd, ch) \
+	ioplusMemU8( (img) + I2C_MEM_REVISION_HW_MAJOR_ADD - (imgAdd) + 1 * ( (ch) - 1))
+#define IOPLUS_MEM_DBG_FIFO_SIZE(img, imgAdd) \
+	ioplusMemU16( (img) + I2C_DBG_FIFO_SIZE - (imgAdd))
+#define IOPLUS_MEM_DBG_FIFO(img, imgAdd) \
+	ioplusMemU8( (img) + I2C_DBG_FIFO_ADD - (imgAdd))
+#define IOPLUS_MEM_OPTO_COUNT_CH_NO	OPTO_CH_NO
+#define IOPLUS_MEM_OPTO_COUNT(img, imgAdd, ch) \
+	ioplusMemU32( (img) + I2C_MEM_OPTO_EDGE_COUNT_ADD - (imgAdd) + 4 * ( (ch) - 1))
+#define IOPLUS_MEM_OD_PWM_FREQ_ALL(img, imgAdd) \
+	ioplusMemU16( (img) + I2C_MEM_OD_PWM_FREQUENCY - (imgAdd))
+#define IOPLUS_MEM_MIN_MAX_SAMPLES(img, imgAdd) \
+	ioplusMemU8( (img) + I2C_MEM_MIN_MAX_SAMPLES - (imgAdd))
+#define IOPLUS_MEM_GPIO_COUNT_CH_NO	GPIO_CH_NO
+#define IOPLUS_MEM_GPIO_COUNT(img, imgAdd, ch) \
+	ioplusMemU32( (img) + I2C_MEM_GPIO_EDGE_COUNT_ADD - (imgAdd) + 4 * ( (ch) - 1))
+#define IOPLUS_MEM_OPTO_ENC_COUNT_CH_NO	4
+#define IOPLUS_MEM_OPTO_ENC_COUNT(img, imgAdd, ch) \
+	ioplusMemS32( (img) + I2C_MEM_OPTO_ENC_COUNT_ADD - (imgAdd) + 4 * ( (ch) - 1))
+#define IOPLUS_MEM_GPIO_ENC_COUNT_CH_NO	2
+#define IOPLUS_MEM_GPIO_ENC_COUNT(img, imgAdd, ch) \
+	ioplusMemS32( (img) + I2C_MEM_GPIO_ENC_COUNT_ADD - (imgAdd) + 4 * ( (ch) - 1))
+#define IOPLUS_MEM_OWB_COUNT(img, imgAdd) \
+	ioplusMemU8( (img) + I2C_MEM_1WB_DEV - (imgAdd))
+#define IOPLUS_MEM_OWB_ROM_IDX(img, imgAdd) \
+	ioplusMemU8( (img) + I2C_MEM_1WB_ROM_CODE_IDX - (imgAdd))
+#define IOPLUS_MEM_OWB_ROM(img, imgAdd) \
+	ioplusMemU64( (img) + I2C_MEM_1WB_ROM_CODE - (imgAdd))
+#define IOPLUS_MEM_OWB_TEMP_CH_NO	OWB_SENS_CNT
+#define IOPLUS_MEM_OWB_TEMP(img, imgAdd, ch) \
+	ioplusMemS16( (img) + I2C_MEM_1WB_T1 - (imgAdd) + 2 * ( (ch) - 1))
+#define IOPLUS_MEM_ADC_MAX_CH_NO	4
+#define IOPLUS_MEM_ADC_MAX(img, imgAdd, ch) \
+	ioplusMemU16( (img) + I2C_MEM_ADC_MAX - (imgAdd) + 2 * ( (ch) - 1))
+#define IOPLUS_MEM_ADC_MIN_CH_NO	4
+#define IOPLUS_MEM_ADC_MIN(img, imgAdd, ch) \
+	ioplusMemU16( (img) + I2C_MEM_ADC_MIN - (imgAdd) + 2 * ( (ch) - 1))
+
+/* Block reads decoded with the macros above */
+#define IOPLUS_MEM_LAYOUT_SNAP_LOW_ADD	0
+#define IOPLUS_MEM_LAYOUT_SNAP_LOW_SIZE	65
+#define IOPLUS_MEM_LAYOUT_SNAP_HIGH_ADD	128
+#define IOPLUS_MEM_LAYOUT_SNAP_HIGH_SIZE	110
+#define IOPLUS_MEM_LAYOUT_COUNTERS_ADD	128
+#define IOPLUS_MEM_LAYOUT_COUNTERS_SIZE	83
+#define IOPLUS_MEM_LAYOUT_OWB_ADD	211
+#define IOPLUS_MEM_LAYOUT_OWB_SIZE	27
+
+#endif //IOPLUSMEM_H_
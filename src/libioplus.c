@@ -0,0 +1,2260 @@
+/*
+ * libioplus.c:
+ *	Reentrant, non printing access functions for the IO-PLUS card,
+ *	built as libioplus.so for applications and language bindings
+ *
+ *	Copyright (c) 2016-2023 Sequent Microsystem
+ *	<http://www.sequentmicrosystem.com>
+ ***********************************************************************
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+#include <fcntl.h>
+#include <semaphore.h>
+
+#include "ioplus.h"
+#include "comm.h"
+#include "libioplus.h"
+#include "i2cerr.h"
+
+#define I2C_BUS_NO	1
+#define SINGLE_TRANSFER
+
+#define PWM_FREQ_MIN	10
+#define PWM_FREQ_MAX	65500
+#define MIN_MAX_SAMPLES_MIN	5
+#define MIN_MAX_SAMPLES_MAX	250
+#define MAX_ACC 60000
+#define MAX_SPEED 60000
+#define MIN_SPEED 10
+#define OWB_START_SEARCH_KEY	0xaa
+#define CAL_FIRST_POLL_MS	5 // let the firmware pick up the key
+#define CAL_POLL_MS	2
+// a done or error status read sooner, with no in progress seen before it,
+// may be the one left by the previous calibration
+#define CAL_SETTLE_MS	100
+#define TX_BLOCK_MAX	31 // i2cMem8Write() limit
+#define TX_BYTES(ADD, SIZE)	( ( (1ULL << (SIZE)) - 1) << (ADD))
+#define VERIFY_READ_MAX	32 // bytes per read back transfer
+#define REG_READ_MAX	32 // bytes per raw read transfer
+
+static int checkBoard(IoplusBoardType *board)
+{
+	if ( (NULL == board) || (board->dev < 0))
+	{
+		return IOPLUS_ERR_ARG;
+	}
+	return IOPLUS_OK;
+}
+
+static int readBlock(IoplusBoardType *board, int add, u8 *buff, int size)
+{
+	return i2cErrToIoplus(i2cMem8Read(board->dev, add, buff, size));
+}
+
+static int readBlockAS(IoplusBoardType *board, int add, u8 *buff, int size,
+	int width)
+{
+	return i2cErrToIoplus(i2cMemReadAS(board->dev, add, buff, size, width));
+}
+
+static int writeBlock(IoplusBoardType *board, int add, u8 *buff, int size)
+{
+	return i2cErrToIoplus(i2cMem8Write(board->dev, add, buff, size));
+}
+
+static int checkHw3(IoplusBoardType *board)
+{
+	if (board->hwMajor < 3)
+	{
+		return IOPLUS_ERR_NOT_SUPPORTED;
+	}
+	return IOPLUS_OK;
+}
+
+static int readBit(IoplusBoardType *board, int add, int ch, int *state)
+{
+	u8 val = 0;
+	int ret;
+
+	ret = readBlockAS(board, add, &val, 1, 1);
+	if (ret != IOPLUS_OK)
+	{
+		return ret;
+	}
+	*state = (val & (1 << (ch - 1))) ? 1 : 0;
+	return IOPLUS_OK;
+}
+
+/* read-modify-write of one bit for registers without set / clear companions */
+static int writeBit(IoplusBoardType *board, int add, int ch, int state)
+{
+	u8 val = 0;
+	int ret;
+
+	ret = readBlockAS(board, add, &val, 1, 1);
+	if (ret != IOPLUS_OK)
+	{
+		return ret;
+	}
+	if (state)
+	{
+		val |= 1 << (ch - 1);
+	}
+	else
+	{
+		val &= ~ (1 << (ch - 1));
+	}
+	return writeBlock(board, add, &val, 1);
+}
+
+/* rising / falling enable registers are adjacent, edge bit 0 rising, bit 1 falling */
+static int edgeGet(IoplusBoardType *board, int add, int ch, u8 *edge)
+{
+	u8 buff[2];
+	int ret;
+
+	ret = readBlockAS(board, add, buff, 2, 1);
+	if (ret != IOPLUS_OK)
+	{
+		return ret;
+	}
+	*edge = (buff[0] & (1 << (ch - 1))) ? IOPLUS_EDGE_RISING : 0;
+	*edge |= (buff[1] & (1 << (ch - 1))) ? IOPLUS_EDGE_FALLING : 0;
+	return IOPLUS_OK;
+}
+
+static int edgeSet(IoplusBoardType *board, int add, int ch, u8 edge)
+{
+	u8 buff[2];
+	int i;
+	int ret;
+
+	ret = readBlock(board, add, buff, 2);
+	if (ret != IOPLUS_OK)
+	{
+		return ret;
+	}
+	for (i = 0; i < 2; i++)
+	{
+		if (edge & (1 << i))
+		{
+			buff[i] |= 1 << (ch - 1);
+		}
+		else
+		{
+			buff[i] &= ~ (1 << (ch - 1));
+		}
+	}
+	return writeBlock(board, add, buff, 2);
+}
+
+static int calWrite(IoplusBoardType *board, int calCh, u16 mV, u8 key)
+{
+	u8 buff[4];
+
+	memcpy(buff, &mV, 2);
+	buff[2] = (u8)calCh;
+	buff[3] = key;
+	return writeBlock(board, I2C_MEM_CALIB_VALUE, buff, 4);
+}
+
+static uint64_t nowUs(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+static uint64_t nowMs(void)
+{
+	return nowUs() / 1000;
+}
+
+static void sleepMs(int ms)
+{
+	struct timespec ts;
+
+	ts.tv_sec = ms / 1000;
+	ts.tv_nsec = (long) (ms % 1000) * 1000000;
+	nanosleep(&ts, NULL);
+}
+
+/* 1 when the output shadow can be used, reloading it when stale or invalid */
+static int shadowReady(IoplusBoardType *board)
+{
+	if (!board->shadowOn)
+	{
+		return 0;
+	}
+	if (board->shadowValid && (board->shadowPeriodMs != 0)
+		&& (nowMs() - board->shadowSyncMs >= board->shadowPeriodMs))
+	{
+		board->shadowValid = 0;
+	}
+	if (!board->shadowValid && (IOPLUS_OK != ioplusShadowSync(board)))
+	{
+		return 0;
+	}
+	return 1;
+}
+
+static void shadowDone(IoplusBoardType *board, int ret)
+{
+	if (ret == IOPLUS_OK)
+	{
+		board->shadowStats.issued++;
+	}
+	else
+	{
+		board->shadowStats.errors++;
+		board->shadowValid = 0;
+	}
+}
+
+/* read back [add, add + size), the gpio direction in the same transfer as
+ * the gpio value to leave the input pins out of mask */
+static int verifyRead(IoplusBoardType *board, int add, u8 *cur, u8 *mask,
+	int size)
+{
+	int gpio = (add <= I2C_MEM_GPIO_VAL_ADD) && (add + size > I2C_MEM_GPIO_VAL_ADD);
+	int end = add + size;
+	int pos;
+	int n;
+	int ret;
+
+	if (gpio && (end <= I2C_MEM_GPIO_DIR_ADD))
+	{
+		end = I2C_MEM_GPIO_DIR_ADD + 1;
+	}
+	for (pos = add; pos < end; pos += n)
+	{
+		n = (end - pos > VERIFY_READ_MAX) ? VERIFY_READ_MAX : end - pos;
+		ret = readBlock(board, pos, cur + pos - add, n);
+		if (ret != IOPLUS_OK)
+		{
+			return ret;
+		}
+	}
+	if (gpio)
+	{
+		mask[I2C_MEM_GPIO_VAL_ADD - add] &= ~cur[I2C_MEM_GPIO_DIR_ADD - add];
+	}
+	return IOPLUS_OK;
+}
+
+/* write again every run of verified registers holding a mismatch, only the
+ * bits in mask are taken from exp */
+static void verifyRewrite(IoplusBoardType *board, int add, u8 *cur,
+	const u8 *exp, const u8 *mask, int size)
+{
+	int i = 0;
+	int n;
+	int bad;
+
+	while (i < size)
+	{
+		if (0 == mask[i])
+		{
+			i++;
+			continue;
+		}
+		for (n = 0, bad = 0; (i + n < size) && (0 != mask[i + n]) && (n < TX_BLOCK_MAX);
+			n++)
+		{
+			bad |= (cur[i + n] ^ exp[i + n]) & mask[i + n];
+			cur[i + n] = (cur[i + n] & ~mask[i + n]) | (exp[i + n] & mask[i + n]);
+		}
+		if (bad)
+		{
+			board->verifyStats.retries++;
+			writeBlock(board, add + i, cur + i, n);
+		}
+		i += n;
+	}
+}
+
+/* Check the outputs just written at add against exp as the board policy
+ * says; mask NULL compares every bit. startMs is the time of the first write. */
+static int verifyOut(IoplusBoardType *board, int add, const u8 *exp,
+	const u8 *expMask, int size, uint64_t startMs)
+{
+	IoplusVerifyType *v = &board->verify;
+	u8 cur[IOPLUS_TX_IMG_SIZE];
+	u8 mask[IOPLUS_TX_IMG_SIZE];
+	int tries = 0;
+	int bad;
+	int ret;
+	int i;
+
+	if (v->mode == IOPLUS_VERIFY_NONE)
+	{
+		return IOPLUS_OK;
+	}
+	for (;;)
+	{
+		if (NULL == expMask)
+		{
+			memset(mask, 0xff, size);
+		}
+		else
+		{
+			memcpy(mask, expMask, size);
+		}
+		board->verifyStats.checks++;
+		ret = verifyRead(board, add, cur, mask, size);
+		for (i = 0, bad = 0; (ret == IOPLUS_OK) && (i < size); i++)
+		{
+			bad |= (cur[i] ^ exp[i]) & mask[i];
+		}
+		if ( (ret == IOPLUS_OK) && !bad)
+		{
+			return IOPLUS_OK;
+		}
+		if (ret == IOPLUS_OK)
+		{
+			board->verifyStats.mismatches++;
+		}
+		if ( (v->mode != IOPLUS_VERIFY_UNTIL) || (tries >= v->retries)
+			|| ( (v->deadlineMs != 0) && (nowMs() - startMs >= v->deadlineMs)))
+		{
+			board->verifyStats.failures++;
+			return (ret == IOPLUS_OK) ? IOPLUS_ERR_VERIFY : ret;
+		}
+		tries++;
+		if (ret == IOPLUS_OK)
+		{
+			verifyRewrite(board, add, cur, exp, mask, size);
+		}
+	}
+}
+
+/* write an output register unless its shadow copy (cache) already holds val */
+static int shadowWrite(IoplusBoardType *board, int add, void *cache, void *val,
+	int size)
+{
+	uint64_t start = nowMs();
+	int ready = shadowReady(board);
+	int ret;
+
+	if (ready && (0 == memcmp(cache, val, size)))
+	{
+		board->shadowStats.suppressed++;
+		return IOPLUS_OK;
+	}
+	ret = writeBlock(board, add, val, size);
+	if (ret == IOPLUS_OK)
+	{
+		ret = verifyOut(board, add, val, NULL, size, start);
+	}
+	shadowDone(board, ret);
+	if (ready && (ret == IOPLUS_OK))
+	{
+		memcpy(cache, val, size);
+	}
+	return ret;
+}
+
+/* one channel of a bitmap output with set / clear registers, verified on
+ * the value register valAdd */
+static int shadowBitWrite(IoplusBoardType *board, int valAdd, int setAdd,
+	int clrAdd, u8 *cache, int ch, int state)
+{
+	uint64_t start = nowMs();
+	int ready = shadowReady(board);
+	u8 mask = 1 << (ch - 1);
+	u8 val = (u8)ch;
+	u8 exp = state ? mask : 0;
+	int ret;
+
+	if (ready && ( ( (*cache & mask) != 0) == (state != 0)))
+	{
+		board->shadowStats.suppressed++;
+		return IOPLUS_OK;
+	}
+	ret = writeBlock(board, state ? setAdd : clrAdd, &val, 1);
+	if (ret == IOPLUS_OK)
+	{
+		ret = verifyOut(board, valAdd, &exp, &mask, 1, start);
+	}
+	shadowDone(board, ret);
+	if (ready && (ret == IOPLUS_OK))
+	{
+		*cache = state ? (*cache | mask) : (*cache & ~mask);
+	}
+	return ret;
+}
+
+int ioplusAbiVersion(void)
+{
+	return IOPLUS_ABI_VERSION;
+}
+
+const char* ioplusErrStr(int err)
+{
+	switch (err)
+	{
+	case IOPLUS_OK:
+		return "OK";
+	case IOPLUS_ERR_IO:
+		return "I2C transfer failed";
+	case IOPLUS_ERR_ARG:
+		return "Invalid argument";
+	case IOPLUS_ERR_SPURIOUS:
+		return "Spurious read detected";
+	case IOPLUS_ERR_NO_BOARD:
+		return "IO-PLUS card not detected";
+	case IOPLUS_ERR_NOT_SUPPORTED:
+		return "Feature available on hardware versions 3.0 and up";
+	case IOPLUS_ERR_TIMEOUT:
+		return "Timeout";
+	case IOPLUS_ERR_VERIFY:
+		return "Output read back does not match";
+	case IOPLUS_ERR_FULL:
+		return "Queue full";
+	case IOPLUS_ERR_OPEN:
+		return "Card skipped after repeated I2C errors";
+	default:
+		break;
+	}
+	return "Unknown error";
+}
+
+int ioplusOpen(IoplusBoardType *board, int stack)
+{
+	u8 buff[4];
+
+	if (NULL == board)
+	{
+		return IOPLUS_ERR_ARG;
+	}
+	memset(board, 0, sizeof(IoplusBoardType));
+	board->dev = -1;
+	if ( (stack < 0) || (stack >= IOPLUS_STACK_MAX))
+	{
+		return IOPLUS_ERR_ARG;
+	}
+	board->stack = stack;
+	board->dev = i2cOpen(I2C_BUS_NO, SLAVE_OWN_ADDRESS_BASE + stack);
+	if (board->dev < 0)
+	{
+		return IOPLUS_ERR_IO;
+	}
+	if (OK != i2cMem8Read(board->dev, I2C_MEM_REVISION_HW_MAJOR_ADD, buff, 4))
+	{
+		i2cClose(board->dev);
+		board->dev = -1;
+		return IOPLUS_ERR_NO_BOARD;
+	}
+	board->hwMajor = buff[0];
+	board->hwMinor = buff[1];
+	board->fwMajor = buff[2];
+	board->fwMinor = buff[3];
+	return IOPLUS_OK;
+}
+
+void ioplusClose(IoplusBoardType *board)
+{
+	if ( (NULL != board) && (board->dev >= 0))
+	{
+		i2cClose(board->dev);
+		board->dev = -1;
+	}
+}
+
+//------------------------------------------------------------------ raw registers
+static int checkReg(IoplusBoardType *board, int add, const uint8_t *buf,
+	int size)
+{
+	if ( (IOPLUS_OK != checkBoard(board)) || (NULL == buf) || (add < 0)
+		|| (size < 1) || (add + size > SLAVE_BUFF_SIZE + 1))
+	{
+		return IOPLUS_ERR_ARG;
+	}
+	return IOPLUS_OK;
+}
+
+int ioplusRegRead(IoplusBoardType *board, int add, uint8_t *buf, int size)
+{
+	int ret = checkReg(board, add, buf, size);
+	int n;
+
+	while ( (ret == IOPLUS_OK) && (size > 0))
+	{
+		n = (size > REG_READ_MAX) ? REG_READ_MAX : size;
+		ret = readBlock(board, add, buf, n);
+		add += n;
+		buf += n;
+		size -= n;
+	}
+	return ret;
+}
+
+int ioplusRegWrite(IoplusBoardType *board, int add, const uint8_t *buf,
+	int size)
+{
+	u8 block[TX_BLOCK_MAX];
+	int ret = checkReg(board, add, buf, size);
+	int n;
+
+	if (ret != IOPLUS_OK)
+	{
+		return ret;
+	}
+	// the shadow can not tell which outputs changed, reload it on next use
+	board->shadowValid = 0;
+	while ( (ret == IOPLUS_OK) && (size > 0))
+	{
+		n = (size > TX_BLOCK_MAX) ? TX_BLOCK_MAX : size;
+		memcpy(block, buf, n);
+		ret = writeBlock(board, add, block, n);
+		add += n;
+		buf += n;
+		size -= n;
+	}
+	return ret;
+}
+
+int ioplusBreakerSet(const IoplusBreakerType *cfg)
+{
+	if (NULL == cfg)
+	{
+		i2cBreakerSet(0, 0, 0);
+		return IOPLUS_OK;
+	}
+	if (cfg->errors < 0)
+	{
+		return IOPLUS_ERR_ARG;
+	}
+	i2cBreakerSet(cfg->errors, cfg->probeMs, cfg->probeMaxMs);
+	return IOPLUS_OK;
+}
+
+int ioplusHealthGet(IoplusBoardType *board, IoplusHealthType *health)
+{
+	I2cHealthType h;
+
+	if ( (IOPLUS_OK != checkBoard(board)) || (NULL == health)
+		|| (OK != i2cHealthGet(board->dev, &h)))
+	{
+		return IOPLUS_ERR_ARG;
+	}
+	health->state = h.state;
+	health->errors = h.errors;
+	health->trips = h.trips;
+	health->probes = h.probes;
+	health->skipped = h.skipped;
+	health->backoffMs = h.backoffMs;
+	return IOPLUS_OK;
+}
+
+void ioplusHealthReset(IoplusBoardType *board)
+{
+	if (IOPLUS_OK == checkBoard(board))
+	{
+		i2cHealthReset(board->dev);
+	}
+}
+
+int ioplusRegReadLast(IoplusBoardType *board, int add, uint8_t *buf, int size,
+	uint32_t *ageMs)
+{
+	int ret = checkReg(board, add, buf, size);
+	uint32_t age;
+	int n;
+
+	if ( (ret != IOPLUS_OK) || (NULL == ageMs))
+	{
+		return IOPLUS_ERR_ARG;
+	}
+	*ageMs = 0;
+	while (size > 0)
+	{
+		n = (size > REG_READ_MAX) ? REG_READ_MAX : size;
+		ret = i2cMem8ReadLast(board->dev, add, buf, n, &age);
+		if (ret < 0)
+		{
+			return i2cErrToIoplus(ret);
+		}
+		if (age > *ageMs)
+		{
+			*ageMs = age;
+		}
+		add += n;
+		buf += n;
+		size -= n;
+	}
+	return IOPLUS_OK;
+}
+
+int ioplusBusRecoverSet(const IoplusRecoverType *cfg)
+{
+	if (NULL == cfg)
+	{
+		i2cRecoverSet(0, I2C_RECOVER_OFF);
+		return IOPLUS_OK;
+	}
+	if ( (cfg->errors < 0) || (cfg->step < IOPLUS_RECOVER_REOPEN)
+		|| (cfg->step > IOPLUS_RECOVER_REBIND))
+	{
+		return IOPLUS_ERR_ARG;
+	}
+	i2cRecoverSet(cfg->errors, cfg->step);
+	return IOPLUS_OK;
+}
+
+int ioplusBusRecover(int step)
+{
+	if ( (step < IOPLUS_RECOVER_REOPEN) || (step > IOPLUS_RECOVER_REBIND))
+	{
+		return IOPLUS_ERR_ARG;
+	}
+	if (OK != i2cRecover(I2C_BUS_NO, step))
+	{
+		return IOPLUS_ERR_IO;
+	}
+	return IOPLUS_OK;
+}
+
+void ioplusBusRecoverStatsGet(IoplusRecoverStatsType *stats)
+{
+	I2cRecoverStatType st;
+
+	if (NULL == stats)
+	{
+		return;
+	}
+	i2cRecoverStatsGet(&st);
+	stats->wedges = st.wedges;
+	stats->recovered = st.recovered;
+	stats->failed = st.failed;
+	stats->lastUs = st.lastUs;
+	stats->maxUs = st.maxUs;
+	stats->lastStep = st.lastStep;
+}
+
+//------------------------------------------------------------------ output shadow
+int ioplusShadowEnable(IoplusBoardType *board, uint32_t periodMs)
+{
+	if (IOPLUS_OK != checkBoard(board))
+	{
+		return IOPLUS_ERR_ARG;
+	}
+	board->shadowOn = 1;
+	board->shadowPeriodMs = periodMs;
+	return ioplusShadowSync(board);
+}
+
+void ioplusShadowDisable(IoplusBoardType *board)
+{
+	if (NULL != board)
+	{
+		board->shadowOn = 0;
+		board->shadowValid = 0;
+	}
+}
+
+/* reload the output registers, 2 block reads (4 on hardware 3.x) */
+int ioplusShadowSync(IoplusBoardType *board)
+{
+	IoplusOutputsType out;
+	u8 buff[I2C_MEM_GPIO_VAL_ADD + 1];
+	int ret;
+
+	if (IOPLUS_OK != checkBoard(board))
+	{
+		return IOPLUS_ERR_ARG;
+	}
+	board->shadowValid = 0;
+	memset(&out, 0, sizeof(out));
+	ret = readBlock(board, I2C_MEM_RELAY_VAL_ADD, buff, sizeof(buff));
+	if (ret != IOPLUS_OK)
+	{
+		return ret;
+	}
+	out.relay = buff[I2C_MEM_RELAY_VAL_ADD];
+	out.gpio = buff[I2C_MEM_GPIO_VAL_ADD];
+	// dac and open drain pwm registers are contiguous
+	ret = readBlock(board, I2C_MEM_DAC_VAL_MV_ADD, (u8*)out.dacMv,
+		sizeof(out.dacMv) + sizeof(out.odPwm));
+	if (ret != IOPLUS_OK)
+	{
+		return ret;
+	}
+	if (IOPLUS_OK == checkHw3(board))
+	{
+		ret = readBlock(board, I2C_MEM_OD_PWM_FREQUENCY_CH1, (u8*)out.odChFreq,
+			sizeof(out.odChFreq));
+		if (ret == IOPLUS_OK)
+		{
+			ret = readBlock(board, I2C_MEM_OD_PWM_FREQUENCY, (u8*)&out.odFreq, 2);
+		}
+		if (ret != IOPLUS_OK)
+		{
+			return ret;
+		}
+	}
+	board->shadow = out;
+	board->shadowValid = 1;
+	board->shadowSyncMs = nowMs();
+	board->shadowStats.resyncs++;
+	return IOPLUS_OK;
+}
+
+int ioplusShadowGet(IoplusBoardType *board, IoplusOutputsType *out)
+{
+	if ( (IOPLUS_OK != checkBoard(board)) || (NULL == out) || !board->shadowOn)
+	{
+		return IOPLUS_ERR_ARG;
+	}
+	if (!shadowReady(board))
+	{
+		return IOPLUS_ERR_IO;
+	}
+	*out = board->shadow;
+	return IOPLUS_OK;
+}
+
+int ioplusShadowStatsGet(IoplusBoardType *board, IoplusShadowStatsType *stats)
+{
+	if ( (NULL == board) || (NULL == stats))
+	{
+		return IOPLUS_ERR_ARG;
+	}
+	*stats = board->shadowStats;
+	return IOPLUS_OK;
+}
+
+void ioplusShadowStatsReset(IoplusBoardType *board)
+{
+	if (NULL != board)
+	{
+		memset(&board->shadowStats, 0, sizeof(board->shadowStats));
+	}
+}
+
+//------------------------------------------------------------------ output verification
+int ioplusVerifySet(IoplusBoardType *board, const IoplusVerifyType *verify)
+{
+	if ( (IOPLUS_OK != checkBoard(board)) || (NULL == verify)
+		|| (verify->mode < IOPLUS_VERIFY_NONE)
+		|| (verify->mode > IOPLUS_VERIFY_UNTIL) || (verify->retries < 0))
+	{
+		return IOPLUS_ERR_ARG;
+	}
+	board->verify = *verify;
+	return IOPLUS_OK;
+}
+
+int ioplusVerifyGet(IoplusBoardType *board, IoplusVerifyType *verify)
+{
+	if ( (IOPLUS_OK != checkBoard(board)) || (NULL == verify))
+	{
+		return IOPLUS_ERR_ARG;
+	}
+	*verify = board->verify;
+	return IOPLUS_OK;
+}
+
+int ioplusVerifyParse(const char *spec, IoplusVerifyType *verify)
+{
+	const char *arg;
+	char *end;
+	long retries = RETRY_TIMES;
+	unsigned long deadline = 0;
+
+	if ( (NULL == spec) || (NULL == verify))
+	{
+		return IOPLUS_ERR_ARG;
+	}
+	memset(verify, 0, sizeof(IoplusVerifyType));
+	if (0 == strcmp(spec, "none"))
+	{
+		return IOPLUS_OK;
+	}
+	if (0 == strcmp(spec, "once"))
+	{
+		verify->mode = IOPLUS_VERIFY_ONCE;
+		return IOPLUS_OK;
+	}
+	if (0 != strncmp(spec, "until", 5))
+	{
+		return IOPLUS_ERR_ARG;
+	}
+	end = (char*)spec + 5;
+	if (*end == ':')
+	{
+		arg = end + 1;
+		retries = strtol(arg, &end, 10);
+		if ( (end == arg) || (retries < 0) || (retries > INT32_MAX))
+		{
+			return IOPLUS_ERR_ARG;
+		}
+	}
+	if (*end == ':')
+	{
+		arg = end + 1;
+		deadline = strtoul(arg, &end, 10);
+		if ( (end == arg) || (deadline > UINT32_MAX))
+		{
+			return IOPLUS_ERR_ARG;
+		}
+	}
+	if (*end != 0)
+	{
+		return IOPLUS_ERR_ARG;
+	}
+	verify->mode = IOPLUS_VERIFY_UNTIL;
+	verify->retries = (int)retries;
+	verify->deadlineMs = (uint32_t)deadline;
+	return IOPLUS_OK;
+}
+
+int ioplusVerifyStatsGet(IoplusBoardType *board, IoplusVerifyStatsType *stats)
+{
+	if ( (IOPLUS_OK != checkBoard(board)) || (NULL == stats))
+	{
+		return IOPLUS_ERR_ARG;
+	}
+	*stats = board->verifyStats;
+	return IOPLUS_OK;
+}
+
+void ioplusVerifyStatsReset(IoplusBoardType *board)
+{
+	if (NULL != board)
+	{
+		memset(&board->verifyStats, 0, sizeof(board->verifyStats));
+	}
+}
+
+//------------------------------------------------------------------ output transaction
+static int checkTx(IoplusTxType *tx)
+{
+	if (NULL == tx)
+	{
+		return IOPLUS_ERR_ARG;
+	}
+	return checkBoard(tx->board);
+}
+
+static void txStage(IoplusTxType *tx, int add, void *val, int size)
+{
+	memcpy(&tx->img[add], val, size);
+	tx->dirty |= TX_BYTES(add, size);
+}
+
+static void txStageBit(IoplusTxType *tx, int add, u8 *mask, int ch, int state)
+{
+	u8 bit = 1 << (ch - 1);
+
+	tx->img[add] = state ? (tx->img[add] | bit) : (tx->img[add] & ~bit);
+	*mask |= bit;
+	tx->dirty |= TX_BYTES(add, 1);
+}
+
+/* output registers as the shadow knows them, in transaction image layout */
+static void txShadowImage(IoplusBoardType *board, u8 *cur)
+{
+	memset(cur, 0, IOPLUS_TX_IMG_SIZE);
+	cur[I2C_MEM_RELAY_VAL_ADD] = board->shadow.relay;
+	cur[I2C_MEM_GPIO_VAL_ADD] = board->shadow.gpio;
+	memcpy(&cur[I2C_MEM_DAC_VAL_MV_ADD], board->shadow.dacMv,
+		sizeof(board->shadow.dacMv));
+	memcpy(&cur[I2C_MEM_OD_PWM_VAL_RAW_ADD], board->shadow.odPwm,
+		sizeof(board->shadow.odPwm));
+}
+
+/* complete the relay / gpio bitmaps where only some channels are staged */
+static int txMergeBits(IoplusTxType *tx, int shadow)
+{
+	u8 cur[IOPLUS_TX_IMG_SIZE];
+	u8 gpioAll = (1 << IOPLUS_GPIO_CH_NO) - 1;
+	int relayPart = (tx->relayMask != 0) && (tx->relayMask != 0xff);
+	int gpioPart = (tx->gpioMask != 0) && ( (tx->gpioMask & gpioAll) != gpioAll);
+	int ret;
+
+	if (!relayPart && !gpioPart)
+	{
+		return IOPLUS_OK;
+	}
+	if (shadow)
+	{
+		txShadowImage(tx->board, cur);
+	}
+	else
+	{
+		ret = readBlock(tx->board, I2C_MEM_RELAY_VAL_ADD, cur,
+			I2C_MEM_GPIO_VAL_ADD + 1);
+		if (ret != IOPLUS_OK)
+		{
+			return ret;
+		}
+	}
+	if (relayPart)
+	{
+		tx->img[I2C_MEM_RELAY_VAL_ADD] = (tx->img[I2C_MEM_RELAY_VAL_ADD]
+			& tx->relayMask) | (cur[I2C_MEM_RELAY_VAL_ADD] & ~tx->relayMask);
+	}
+	if (gpioPart)
+	{
+		tx->img[I2C_MEM_GPIO_VAL_ADD] = (tx->img[I2C_MEM_GPIO_VAL_ADD]
+			& tx->gpioMask) | (cur[I2C_MEM_GPIO_VAL_ADD] & ~tx->gpioMask);
+	}
+	return IOPLUS_OK;
+}
+
+/* drop the staged outputs the card already holds, then stage the unchanged
+ * dac / od words lying between two staged ones so they share a block write */
+static int txShadowFilter(IoplusTxType *tx)
+{
+	u8 cur[IOPLUS_TX_IMG_SIZE];
+	int suppressed = 0;
+	int first = -1;
+	int last = -1;
+	int add;
+	int size;
+
+	txShadowImage(tx->board, cur);
+	for (add = 0; add < IOPLUS_TX_IMG_SIZE; add += size)
+	{
+		size = (add < I2C_MEM_DAC_VAL_MV_ADD) ? 1 : 2;
+		if ( (tx->dirty & TX_BYTES(add, size))
+			&& (0 == memcmp(&tx->img[add], &cur[add], size)))
+		{
+			tx->dirty &= ~TX_BYTES(add, size);
+			suppressed++;
+		}
+	}
+	for (add = I2C_MEM_DAC_VAL_MV_ADD; add < IOPLUS_TX_IMG_SIZE; add += 2)
+	{
+		if (tx->dirty & TX_BYTES(add, 2))
+		{
+			if (first < 0)
+			{
+				first = add;
+			}
+			last = add;
+		}
+	}
+	for (add = first + 2; (first >= 0) && (add < last); add += 2)
+	{
+		if (0 == (tx->dirty & TX_BYTES(add, 2)))
+		{
+			txStage(tx, add, &cur[add], 2);
+		}
+	}
+	return suppressed;
+}
+
+static void txShadowUpdate(IoplusTxType *tx)
+{
+	IoplusBoardType *board = tx->board;
+	int add;
+
+	if (tx->dirty & TX_BYTES(I2C_MEM_RELAY_VAL_ADD, 1))
+	{
+		board->shadow.relay = tx->img[I2C_MEM_RELAY_VAL_ADD];
+	}
+	if (tx->dirty & TX_BYTES(I2C_MEM_GPIO_VAL_ADD, 1))
+	{
+		board->shadow.gpio = tx->img[I2C_MEM_GPIO_VAL_ADD];
+	}
+	for (add = I2C_MEM_DAC_VAL_MV_ADD; add < IOPLUS_TX_IMG_SIZE; add += 2)
+	{
+		if (0 == (tx->dirty & TX_BYTES(add, 2)))
+		{
+			continue;
+		}
+		if (add < I2C_MEM_OD_PWM_VAL_RAW_ADD)
+		{
+			memcpy(&board->shadow.dacMv[ (add - I2C_MEM_DAC_VAL_MV_ADD) / 2],
+				&tx->img[add], 2);
+		}
+		else
+		{
+			memcpy(&board->shadow.odPwm[ (add - I2C_MEM_OD_PWM_VAL_RAW_ADD) / 2],
+				&tx->img[add], 2);
+		}
+	}
+}
+
+/* one read back of the span of staged registers, only the staged channels
+ * of the relay and gpio bitmaps are compared */
+static int txVerify(IoplusTxType *tx, uint64_t startMs)
+{
+	u8 mask[IOPLUS_TX_IMG_SIZE];
+	int first = -1;
+	int last = -1;
+	int add;
+
+	if ( (tx->board->verify.mode == IOPLUS_VERIFY_NONE) || (tx->dirty == 0))
+	{
+		return IOPLUS_OK;
+	}
+	for (add = 0; add < IOPLUS_TX_IMG_SIZE; add++)
+	{
+		mask[add] = (tx->dirty & TX_BYTES(add, 1)) ? 0xff : 0;
+		if (mask[add])
+		{
+			first = (first < 0) ? add : first;
+			last = add;
+		}
+	}
+	if (tx->relayMask != 0)
+	{
+		mask[I2C_MEM_RELAY_VAL_ADD] &= tx->relayMask;
+	}
+	if (tx->gpioMask != 0)
+	{
+		mask[I2C_MEM_GPIO_VAL_ADD] &= tx->gpioMask;
+	}
+	return verifyOut(tx->board, first, &tx->img[first], &mask[first],
+		last - first + 1, startMs);
+}
+
+void ioplusBusLockHeld(int held)
+{
+	i2cBusLockHeld(held);
+}
+
+int ioplusTxBegin(IoplusBoardType *board, IoplusTxType *tx)
+{
+	if ( (IOPLUS_OK != checkBoard(board)) || (NULL == tx))
+	{
+		return IOPLUS_ERR_ARG;
+	}
+	memset(tx, 0, sizeof(IoplusTxType));
+	tx->board = board;
+	return IOPLUS_OK;
+}
+
+int ioplusTxRelaySet(IoplusTxType *tx, uint8_t val)
+{
+	if (IOPLUS_OK != checkTx(tx))
+	{
+		return IOPLUS_ERR_ARG;
+	}
+	tx->relayMask = 0xff;
+	txStage(tx, I2C_MEM_RELAY_VAL_ADD, &val, 1);
+	return IOPLUS_OK;
+}
+
+int ioplusTxRelayChSet(IoplusTxType *tx, int ch, int state)
+{
+	if ( (IOPLUS_OK != checkTx(tx)) || (ch < CHANNEL_NR_MIN)
+		|| (ch > RELAY_CH_NR_MAX))
+	{
+		return IOPLUS_ERR_ARG;
+	}
+	txStageBit(tx, I2C_MEM_RELAY_VAL_ADD, &tx->relayMask, ch, state);
+	return IOPLUS_OK;
+}
+
+int ioplusTxGpioSet(IoplusTxType *tx, uint8_t val)
+{
+	if (IOPLUS_OK != checkTx(tx))
+	{
+		return IOPLUS_ERR_ARG;
+	}
+	tx->gpioMask = 0xff;
+	txStage(tx, I2C_MEM_GPIO_VAL_ADD, &val, 1);
+	return IOPLUS_OK;
+}
+
+int ioplusTxGpioChSet(IoplusTxType *tx, int ch, int state)
+{
+	if ( (IOPLUS_OK != checkTx(tx)) || (ch < CHANNEL_NR_MIN)
+		|| (ch > GPIO_CH_NR_MAX))
+	{
+		return IOPLUS_ERR_ARG;
+	}
+	txStageBit(tx, I2C_MEM_GPIO_VAL_ADD, &tx->gpioMask, ch, state);
+	return IOPLUS_OK;
+}
+
+int ioplusTxDacSet(IoplusTxType *tx, int ch, uint16_t mV)
+{
+	if ( (IOPLUS_OK != checkTx(tx)) || (ch < CHANNEL_NR_MIN)
+		|| (ch > DAC_CH_NR_MAX))
+	{
+		return IOPLUS_ERR_ARG;
+	}
+	if (mV > 10 * VOLT_TO_MILIVOLT)
+	{
+		mV = 10 * VOLT_TO_MILIVOLT;
+	}
+	txStage(tx, I2C_MEM_DAC_VAL_MV_ADD + DAC_MV_VAL_SIZE * (ch - 1), &mV,
+		DAC_MV_VAL_SIZE);
+	return IOPLUS_OK;
+}
+
+int ioplusTxOdPwmSet(IoplusTxType *tx, int ch, uint16_t raw)
+{
+	if ( (IOPLUS_OK != checkTx(tx)) || (ch < CHANNEL_NR_MIN)
+		|| (ch > OD_CH_NR_MAX))
+	{
+		return IOPLUS_ERR_ARG;
+	}
+	if (raw > OD_PWM_VAL_MAX)
+	{
+		raw = OD_PWM_VAL_MAX;
+	}
+	txStage(tx, I2C_MEM_OD_PWM_VAL_RAW_ADD + 2 * (ch - 1), &raw, 2);
+	return IOPLUS_OK;
+}
+
+int ioplusTxCommit(IoplusTxType *tx, IoplusTxReportType *report)
+{
+	IoplusTxReportType rep;
+	IoplusBoardType *board;
+	sem_t *sem;
+	uint64_t start;
+	uint64_t first = 0;
+	uint64_t startMs;
+	uint64_t t;
+	int shadow;
+	int add = 0;
+	int size;
+	int ret;
+
+	if (IOPLUS_OK != checkTx(tx))
+	{
+		return IOPLUS_ERR_ARG;
+	}
+	board = tx->board;
+	memset(&rep, 0, sizeof(rep));
+	start = nowUs();
+	startMs = start / 1000;
+	sem = i2cBusLock();
+	shadow = shadowReady(board);
+	ret = txMergeBits(tx, shadow);
+	if ( (ret == IOPLUS_OK) && shadow)
+	{
+		rep.suppressed = txShadowFilter(tx);
+		board->shadowStats.suppressed += rep.suppressed;
+	}
+	// every run of staged registers in one block write, nothing in between
+	while ( (ret == IOPLUS_OK) && (add < IOPLUS_TX_IMG_SIZE))
+	{
+		if (0 == (tx->dirty & TX_BYTES(add, 1)))
+		{
+			add++;
+			continue;
+		}
+		size = 1;
+		while ( (add + size < IOPLUS_TX_IMG_SIZE) && (size < TX_BLOCK_MAX)
+			&& (tx->dirty & TX_BYTES(add + size, 1)))
+		{
+			size++;
+		}
+		ret = writeBlock(board, add, &tx->img[add], size);
+		shadowDone(board, ret);
+		if (ret == IOPLUS_OK)
+		{
+			t = nowUs();
+			if (rep.writes == 0)
+			{
+				first = t;
+			}
+			rep.skewUs = (uint32_t)(t - first);
+			rep.writes++;
+			rep.bytes += size;
+		}
+		add += size;
+	}
+	if (ret == IOPLUS_OK)
+	{
+		ret = txVerify(tx, startMs);
+		if (ret != IOPLUS_OK)
+		{
+			shadowDone(board, ret);
+		}
+	}
+	i2cBusUnlock(sem);
+	if ( (ret == IOPLUS_OK) && shadow && board->shadowValid)
+	{
+		txShadowUpdate(tx);
+	}
+	rep.durationUs = (uint32_t)(nowUs() - start);
+	tx->dirty = 0;
+	tx->relayMask = 0;
+	tx->gpioMask = 0;
+	if (NULL != report)
+	{
+		*report = rep;
+	}
+	return ret;
+}
+
+//------------------------------------------------------------------ relays
+int ioplusRelayGet(IoplusBoardType *board, uint8_t *val)
+{
+	if ( (IOPLUS_OK != checkBoard(board)) || (NULL == val))
+	{
+		return IOPLUS_ERR_ARG;
+	}
+	return readBlockAS(board, I2C_MEM_RELAY_VAL_ADD, val, 1, 1);
+}
+
+int ioplusRelaySet(IoplusBoardType *board, uint8_t val)
+{
+	if (IOPLUS_OK != checkBoard(board))
+	{
+		return IOPLUS_ERR_ARG;
+	}
+	return shadowWrite(board, I2C_MEM_RELAY_VAL_ADD, &board->shadow.relay, &val,
+		1);
+}
+
+int ioplusRelayChSet(IoplusBoardType *board, int ch, int state)
+{
+	if ( (IOPLUS_OK != checkBoard(board)) || (ch < CHANNEL_NR_MIN)
+		|| (ch > RELAY_CH_NR_MAX))
+	{
+		return IOPLUS_ERR_ARG;
+	}
+	// set / clear registers change one channel in a single transfer
+	return shadowBitWrite(board, I2C_MEM_RELAY_VAL_ADD, I2C_MEM_RELAY_SET_ADD,
+		I2C_MEM_RELAY_CLR_ADD, &board->shadow.relay, ch, state);
+}
+
+int ioplusRelayChGet(IoplusBoardType *board, int ch, int *state)
+{
+	if ( (IOPLUS_OK != checkBoard(board)) || (NULL == state)
+		|| (ch < CHANNEL_NR_MIN) || (ch > RELAY_CH_NR_MAX))
+	{
+		return IOPLUS_ERR_ARG;
+	}
+	return readBit(board, I2C_MEM_RELAY_VAL_ADD, ch, state);
+}
+
+int ioplusRelayDefaultGet(IoplusBoardType *board, uint8_t *val)
+{
+	if ( (IOPLUS_OK != checkBoard(board)) || (NULL == val))
+	{
+		return IOPLUS_ERR_ARG;
+	}
+	return readBlockAS(board, I2C_MEM_RELAY_DEFAULT, val, 1, 1);
+}
+
+int ioplusRelayDefaultSet(IoplusBoardType *board, uint8_t val)
+{
+	if (IOPLUS_OK != checkBoard(board))
+	{
+		return IOPLUS_ERR_ARG;
+	}
+	return writeBlock(board, I2C_MEM_RELAY_DEFAULT, &val, 1);
+}
+
+//------------------------------------------------------------------ digital inputs
+int ioplusOptoGet(IoplusBoardType *board, uint8_t *val)
+{
+	if ( (IOPLUS_OK != checkBoard(board)) || (NULL == val))
+	{
+		return IOPLUS_ERR_ARG;
+	}
+	return readBlockAS(board, I2C_MEM_OPTO_IN_ADD, val, 1, 1);
+}
+
+int ioplusOptoCountGet(IoplusBoardType *board, int ch, uint32_t *val)
+{
+	if ( (IOPLUS_OK != checkBoard(board)) || (NULL == val)
+		|| (ch < CHANNEL_NR_MIN) || (ch > OPTO_IN_CH_NR_MAX))
+	{
+		return IOPLUS_ERR_ARG;
+	}
+	return readBlockAS(board,
+		I2C_MEM_OPTO_EDGE_COUNT_ADD + COUNTER_SIZE * (ch - 1), (u8*)val,
+		COUNTER_SIZE, COUNTER_SIZE);
+}
+
+int ioplusOptoCountGetAll(IoplusBoardType *board, uint32_t *val)
+{
+	if ( (IOPLUS_OK != checkBoard(board)) || (NULL == val))
+	{
+		return IOPLUS_ERR_ARG;
+	}
+	return readBlockAS(board, I2C_MEM_OPTO_EDGE_COUNT_ADD, (u8*)val,
+		COUNTER_SIZE * OPTO_CH_NO, COUNTER_SIZE);
+}
+
+int ioplusGpioGet(IoplusBoardType *board, uint8_t *val)
+{
+	if ( (IOPLUS_OK != checkBoard(board)) || (NULL == val))
+	{
+		return IOPLUS_ERR_ARG;
+	}
+	return readBlockAS(board, I2C_MEM_GPIO_VAL_ADD, val, 1, 1);
+}
+
+int ioplusGpioSet(IoplusBoardType *board, uint8_t val)
+{
+	if (IOPLUS_OK != checkBoard(board))
+	{
+		return IOPLUS_ERR_ARG;
+	}
+	return shadowWrite(board, I2C_MEM_GPIO_VAL_ADD, &board->shadow.gpio, &val, 1);
+}
+
+int ioplusGpioChSet(IoplusBoardType *board, int ch, int state)
+{
+	if ( (IOPLUS_OK != checkBoard(board)) || (ch < CHANNEL_NR_MIN)
+		|| (ch > GPIO_CH_NR_MAX))
+	{
+		return IOPLUS_ERR_ARG;
+	}
+	return shadowBitWrite(board, I2C_MEM_GPIO_VAL_ADD, I2C_MEM_GPIO_SET_ADD,
+		I2C_MEM_GPIO_CLR_ADD, &board->shadow.gpio, ch, state);
+}
+
+int ioplusGpioDirSet(IoplusBoardType *board, uint8_t val)
+{
+	if (IOPLUS_OK != checkBoard(board))
+	{
+		return IOPLUS_ERR_ARG;
+	}
+	return writeBlock(board, I2C_MEM_GPIO_DIR_ADD, &val, 1);
+}
+
+int ioplusGpioCountGetAll(IoplusBoardType *board, uint32_t *val)
+{
+	if ( (IOPLUS_OK != checkBoard(board)) || (NULL == val))
+	{
+		return IOPLUS_ERR_ARG;
+	}
+	return readBlockAS(board, I2C_MEM_GPIO_EDGE_COUNT_ADD, (u8*)val,
+		COUNTER_SIZE * GPIO_CH_NO, COUNTER_SIZE);
+}
+
+int ioplusOptoChGet(IoplusBoardType *board, int ch, int *state)
+{
+	if ( (IOPLUS_OK != checkBoard(board)) || (NULL == state)
+		|| (ch < CHANNEL_NR_MIN) || (ch > OPTO_IN_CH_NR_MAX))
+	{
+		return IOPLUS_ERR_ARG;
+	}
+	return readBit(board, I2C_MEM_OPTO_IN_ADD, ch, state);
+}
+
+int ioplusOptoEdgeGet(IoplusBoardType *board, int ch, uint8_t *edge)
+{
+	if ( (IOPLUS_OK != checkBoard(board)) || (NULL == edge)
+		|| (ch < CHANNEL_NR_MIN) || (ch > OPTO_IN_CH_NR_MAX))
+	{
+		return IOPLUS_ERR_ARG;
+	}
+	return edgeGet(board, I2C_MEM_OPTO_IT_RISING_ADD, ch, edge);
+}
+
+int ioplusOptoEdgeSet(IoplusBoardType *board, int ch, uint8_t edge)
+{
+	if ( (IOPLUS_OK != checkBoard(board)) || (ch < CHANNEL_NR_MIN)
+		|| (ch > OPTO_IN_CH_NR_MAX))
+	{
+		return IOPLUS_ERR_ARG;
+	}
+	return edgeSet(board, I2C_MEM_OPTO_IT_RISING_ADD, ch, edge);
+}
+
+int ioplusOptoCountReset(IoplusBoardType *board, int ch)
+{
+	u8 val = (u8)ch;
+
+	if ( (IOPLUS_OK != checkBoard(board)) || (ch < CHANNEL_NR_MIN)
+		|| (ch > OPTO_IN_CH_NR_MAX))
+	{
+		return IOPLUS_ERR_ARG;
+	}
+	return writeBlock(board, I2C_MEM_OPTO_CNT_RST_ADD, &val, 1);
+}
+
+int ioplusOptoEncEnableGet(IoplusBoardType *board, int ch, int *en)
+{
+	if ( (IOPLUS_OK != checkBoard(board)) || (NULL == en)
+		|| (ch < CHANNEL_NR_MIN) || (ch > OPTO_IN_CH_NR_MAX / 2))
+	{
+		return IOPLUS_ERR_ARG;
+	}
+	return readBit(board, I2C_MEM_OPTO_ENC_ENABLE_ADD, ch, en);
+}
+
+int ioplusOptoEncEnableSet(IoplusBoardType *board, int ch, int en)
+{
+	if ( (IOPLUS_OK != checkBoard(board)) || (ch < CHANNEL_NR_MIN)
+		|| (ch > OPTO_IN_CH_NR_MAX / 2))
+	{
+		return IOPLUS_ERR_ARG;
+	}
+	return writeBit(board, I2C_MEM_OPTO_ENC_ENABLE_ADD, ch, en);
+}
+
+int ioplusOptoEncCountGet(IoplusBoardType *board, int ch, int32_t *val)
+{
+	if ( (IOPLUS_OK != checkBoard(board)) || (NULL == val)
+		|| (ch < CHANNEL_NR_MIN) || (ch > OPTO_IN_CH_NR_MAX / 2))
+	{
+		return IOPLUS_ERR_ARG;
+	}
+	return readBlockAS(board,
+		I2C_MEM_OPTO_ENC_COUNT_ADD + COUNTER_SIZE * (ch - 1), (u8*)val,
+		COUNTER_SIZE, COUNTER_SIZE);
+}
+
+int ioplusOptoEncCountReset(IoplusBoardType *board, int ch)
+{
+	u8 val = (u8)ch;
+
+	if ( (IOPLUS_OK != checkBoard(board)) || (ch < CHANNEL_NR_MIN)
+		|| (ch > OPTO_IN_CH_NR_MAX / 2))
+	{
+		return IOPLUS_ERR_ARG;
+	}
+	return writeBlock(board, I2C_MEM_OPTO_ENC_CNT_RST_ADD, &val, 1);
+}
+
+int ioplusGpioChGet(IoplusBoardType *board, int ch, int *state)
+{
+	if ( (IOPLUS_OK != checkBoard(board)) || (NULL == state)
+		|| (ch < CHANNEL_NR_MIN) || (ch > GPIO_CH_NR_MAX))
+	{
+		return IOPLUS_ERR_ARG;
+	}
+	return readBit(board, I2C_MEM_GPIO_VAL_ADD, ch, state);
+}
+
+int ioplusGpioDirGet(IoplusBoardType *board, uint8_t *val)
+{
+	if ( (IOPLUS_OK != checkBoard(board)) || (NULL == val))
+	{
+		return IOPLUS_ERR_ARG;
+	}
+	return readBlockAS(board, I2C_MEM_GPIO_DIR_ADD, val, 1, 1);
+}
+
+int ioplusGpioChDirSet(IoplusBoardType *board, int ch, int input)
+{
+	if ( (IOPLUS_OK != checkBoard(board)) || (ch < CHANNEL_NR_MIN)
+		|| (ch > GPIO_CH_NR_MAX))
+	{
+		return IOPLUS_ERR_ARG;
+	}
+	return writeBit(board, I2C_MEM_GPIO_DIR_ADD, ch, input);
+}
+
+int ioplusGpioEdgeGet(IoplusBoardType *board, int ch, uint8_t *edge)
+{
+	if ( (IOPLUS_OK != checkBoard(board)) || (NULL == edge)
+		|| (ch < CHANNEL_NR_MIN) || (ch > GPIO_CH_NR_MAX))
+	{
+		return IOPLUS_ERR_ARG;
+	}
+	return edgeGet(board, I2C_MEM_GPIO_EXT_IT_RISING_ADD, ch, edge);
+}
+
+int ioplusGpioEdgeSet(IoplusBoardType *board, int ch, uint8_t edge)
+{
+	if ( (IOPLUS_OK != checkBoard(board)) || (ch < CHANNEL_NR_MIN)
+		|| (ch > GPIO_CH_NR_MAX))
+	{
+		return IOPLUS_ERR_ARG;
+	}
+	return edgeSet(board, I2C_MEM_GPIO_EXT_IT_RISING_ADD, ch, edge);
+}
+
+int ioplusGpioCountGet(IoplusBoardType *board, int ch, uint32_t *val)
+{
+	if ( (IOPLUS_OK != checkBoard(board)) || (NULL == val)
+		|| (ch < CHANNEL_NR_MIN) || (ch > GPIO_CH_NR_MAX))
+	{
+		return IOPLUS_ERR_ARG;
+	}
+	return readBlockAS(board,
+		I2C_MEM_GPIO_EDGE_COUNT_ADD + COUNTER_SIZE * (ch - 1), (u8*)val,
+		COUNTER_SIZE, COUNTER_SIZE);
+}
+
+int ioplusGpioCountReset(IoplusBoardType *board, int ch)
+{
+	u8 val = (u8)ch;
+
+	if ( (IOPLUS_OK != checkBoard(board)) || (ch < CHANNEL_NR_MIN)
+		|| (ch > GPIO_CH_NR_MAX))
+	{
+		return IOPLUS_ERR_ARG;
+	}
+	return writeBlock(board, I2C_MEM_GPIO_CNT_RST_ADD, &val, 1);
+}
+
+int ioplusGpioEncCountGet(IoplusBoardType *board, int32_t *val)
+{
+	if ( (IOPLUS_OK != checkBoard(board)) || (NULL == val))
+	{
+		return IOPLUS_ERR_ARG;
+	}
+	return readBlockAS(board, I2C_MEM_GPIO_ENC_COUNT_ADD, (u8*)val,
+		COUNTER_SIZE, COUNTER_SIZE);
+}
+
+int ioplusGpioEncCountReset(IoplusBoardType *board)
+{
+	u8 val = 1;
+
+	if (IOPLUS_OK != checkBoard(board))
+	{
+		return IOPLUS_ERR_ARG;
+	}
+	return writeBlock(board, I2C_MEM_GPIO_ENC_CNT_RST_ADD, &val, 1);
+}
+
+int ioplusCountersGetAll(IoplusBoardType *board, uint32_t *val)
+{
+	int ret;
+
+	if ( (IOPLUS_OK != checkBoard(board)) || (NULL == val))
+	{
+		return IOPLUS_ERR_ARG;
+	}
+	ret = readBlockAS(board, I2C_MEM_OPTO_EDGE_COUNT_ADD,
+		(u8*) (val + IOPLUS_CNT_OPTO), COUNTER_SIZE * OPTO_CH_NO, COUNTER_SIZE);
+	// gpio edge counters and opto encoders are contiguous
+	if (ret == IOPLUS_OK)
+	{
+		ret = readBlockAS(board, I2C_MEM_GPIO_EDGE_COUNT_ADD,
+			(u8*) (val + IOPLUS_CNT_GPIO), COUNTER_SIZE * (GPIO_CH_NO + OPTO_CH_NO / 2),
+			COUNTER_SIZE);
+	}
+	if (ret == IOPLUS_OK)
+	{
+		ret = readBlockAS(board, I2C_MEM_GPIO_ENC_COUNT_ADD,
+			(u8*) (val + IOPLUS_CNT_GPIO_ENC), COUNTER_SIZE, COUNTER_SIZE);
+	}
+	if (ret == IOPLUS_OK)
+	{
+		ret = readBlock(board, I2C_MEM_OD_PULSE_CNT_SET,
+			(u8*) (val + IOPLUS_CNT_OD), COUNTER_SIZE * OD_CH_NO);
+	}
+	return ret;
+}
+
+int ioplusSnapshotPartGet(IoplusBoardType *board, IoplusSnapshotType *snap,
+	int parts)
+{
+	u8 buff[I2C_MEM_OPTO_IT_RISING_ADD - I2C_MEM_ADC_VAL_MV_ADD];
+	int ret = IOPLUS_OK;
+
+	if ( (IOPLUS_OK != checkBoard(board)) || (NULL == snap))
+	{
+		return IOPLUS_ERR_ARG;
+	}
+	if (parts & IOPLUS_SNAP_DIGITAL)
+	{
+		ret = readBlock(board, I2C_MEM_RELAY_VAL_ADD, buff,
+			I2C_MEM_GPIO_DIR_ADD - I2C_MEM_RELAY_VAL_ADD);
+		if (ret != IOPLUS_OK)
+		{
+			return ret;
+		}
+		snap->relay = IOPLUS_MEM_RELAY(buff, I2C_MEM_RELAY_VAL_ADD);
+		snap->opto = IOPLUS_MEM_OPTO(buff, I2C_MEM_RELAY_VAL_ADD);
+		snap->gpio = IOPLUS_MEM_GPIO(buff, I2C_MEM_RELAY_VAL_ADD);
+	}
+	if (parts & IOPLUS_SNAP_ANALOG)
+	{
+		// adc, dac and open drain pwm values are contiguous
+		ret = readBlock(board, I2C_MEM_ADC_VAL_MV_ADD, buff, sizeof(buff));
+		if (ret != IOPLUS_OK)
+		{
+			return ret;
+		}
+		memcpy(snap->adcMv, buff, sizeof(snap->adcMv));
+		memcpy(snap->dacMv, buff + I2C_MEM_DAC_VAL_MV_ADD - I2C_MEM_ADC_VAL_MV_ADD,
+			sizeof(snap->dacMv));
+		memcpy(snap->odPwm,
+			buff + I2C_MEM_OD_PWM_VAL_RAW_ADD - I2C_MEM_ADC_VAL_MV_ADD,
+			sizeof(snap->odPwm));
+	}
+	if (parts & IOPLUS_SNAP_DIAG)
+	{
+		ret = ioplusDiagGet(board, &snap->cpuTemp, &snap->v3v3Mv);
+	}
+	if ( (ret == IOPLUS_OK) && (parts & IOPLUS_SNAP_COUNTERS))
+	{
+		ret = ioplusCountersGetAll(board, snap->cnt);
+	}
+	if ( (ret == IOPLUS_OK) && (parts & IOPLUS_SNAP_OWB))
+	{
+		memset(snap->owbTemp, 0, sizeof(snap->owbTemp));
+		ret = ioplusOwbTempGetAll(board, snap->owbTemp, &snap->owbCnt);
+	}
+	return ret;
+}
+
+int ioplusSnapshotGet(IoplusBoardType *board, IoplusSnapshotType *snap)
+{
+	if (NULL != snap)
+	{
+		memset(snap, 0, sizeof(IoplusSnapshotType));
+	}
+	return ioplusSnapshotPartGet(board, snap, IOPLUS_SNAP_ALL);
+}
+
+int ioplusInCmdSet(IoplusBoardType *board, int inCh, int outCh, uint32_t count,
+	int enable)
+{
+	u8 buff[6];
+
+	if ( (IOPLUS_OK != checkBoard(board)) || (inCh < CHANNEL_NR_MIN)
+		|| (inCh > OPTO_CH_NO) || (outCh < 0) || (outCh > OD_CH_NO))
+	{
+		return IOPLUS_ERR_ARG;
+	}
+	memcpy(buff, &count, sizeof(u32));
+	buff[4] = enable ? (u8)outCh : 0;
+	buff[5] = (u8)inCh;
+	return writeBlock(board, I2C_MEM_PULSE_COUNTER_SET, buff, 6);
+}
+
+//------------------------------------------------------------------ analog
+int ioplusAdcGet(IoplusBoardType *board, int ch, uint16_t *mV)
+{
+	if ( (IOPLUS_OK != checkBoard(board)) || (NULL == mV)
+		|| (ch < CHANNEL_NR_MIN) || (ch > ADC_CH_NR_MAX))
+	{
+		return IOPLUS_ERR_ARG;
+	}
+	return readBlockAS(board, I2C_MEM_ADC_VAL_MV_ADD + ADC_RAW_VAL_SIZE * (ch - 1),
+		(u8*)mV, ADC_RAW_VAL_SIZE, ADC_RAW_VAL_SIZE);
+}
+
+int ioplusAdcGetAll(IoplusBoardType *board, uint16_t *mV)
+{
+	if ( (IOPLUS_OK != checkBoard(board)) || (NULL == mV))
+	{
+		return IOPLUS_ERR_ARG;
+	}
+	return readBlockAS(board, I2C_MEM_ADC_VAL_MV_ADD, (u8*)mV,
+		ADC_RAW_VAL_SIZE * ADC_CH_NO, ADC_RAW_VAL_SIZE);
+}
+
+int ioplusAdcRawGetAll(IoplusBoardType *board, uint16_t *raw)
+{
+	if ( (IOPLUS_OK != checkBoard(board)) || (NULL == raw))
+	{
+		return IOPLUS_ERR_ARG;
+	}
+	return readBlockAS(board, I2C_MEM_ADC_VAL_RAW_ADD, (u8*)raw,
+		ADC_RAW_VAL_SIZE * ADC_CH_NO, ADC_RAW_VAL_SIZE);
+}
+
+int ioplusDacGetAll(IoplusBoardType *board, uint16_t *mV)
+{
+	if ( (IOPLUS_OK != checkBoard(board)) || (NULL == mV))
+	{
+		return IOPLUS_ERR_ARG;
+	}
+	return readBlockAS(board, I2C_MEM_DAC_VAL_MV_ADD, (u8*)mV,
+		DAC_MV_VAL_SIZE * DAC_CH_NO, DAC_MV_VAL_SIZE);
+}
+
+int ioplusDacSet(IoplusBoardType *board, int ch, uint16_t mV)
+{
+	if ( (IOPLUS_OK != checkBoard(board)) || (ch < CHANNEL_NR_MIN)
+		|| (ch > DAC_CH_NR_MAX))
+	{
+		return IOPLUS_ERR_ARG;
+	}
+	if (mV > 10 * VOLT_TO_MILIVOLT)
+	{
+		mV = 10 * VOLT_TO_MILIVOLT;
+	}
+	return shadowWrite(board, I2C_MEM_DAC_VAL_MV_ADD + DAC_MV_VAL_SIZE * (ch - 1),
+		&board->shadow.dacMv[ch - 1], &mV, DAC_MV_VAL_SIZE);
+}
+
+int ioplusOdPwmGetAll(IoplusBoardType *board, uint16_t *raw)
+{
+	if ( (IOPLUS_OK != checkBoard(board)) || (NULL == raw))
+	{
+		return IOPLUS_ERR_ARG;
+	}
+	return readBlockAS(board, I2C_MEM_OD_PWM_VAL_RAW_ADD, (u8*)raw,
+		2 * OD_CH_NO, 2);
+}
+
+int ioplusOdPwmSet(IoplusBoardType *board, int ch, uint16_t raw)
+{
+	if ( (IOPLUS_OK != checkBoard(board)) || (ch < CHANNEL_NR_MIN)
+		|| (ch > OD_CH_NR_MAX))
+	{
+		return IOPLUS_ERR_ARG;
+	}
+	if (raw > OD_PWM_VAL_MAX)
+	{
+		raw = OD_PWM_VAL_MAX;
+	}
+	return shadowWrite(board, I2C_MEM_OD_PWM_VAL_RAW_ADD + 2 * (ch - 1),
+		&board->shadow.odPwm[ch - 1], &raw, 2);
+}
+
+int ioplusDacGet(IoplusBoardType *board, int ch, uint16_t *mV)
+{
+	if ( (IOPLUS_OK != checkBoard(board)) || (NULL == mV)
+		|| (ch < CHANNEL_NR_MIN) || (ch > DAC_CH_NR_MAX))
+	{
+		return IOPLUS_ERR_ARG;
+	}
+	return readBlockAS(board, I2C_MEM_DAC_VAL_MV_ADD + DAC_MV_VAL_SIZE * (ch - 1),
+		(u8*)mV, DAC_MV_VAL_SIZE, DAC_MV_VAL_SIZE);
+}
+
+int ioplusAdcMaxGet(IoplusBoardType *board, int ch, uint16_t *mV)
+{
+	if ( (IOPLUS_OK != checkBoard(board)) || (NULL == mV)
+		|| (ch < CHANNEL_NR_MIN) || (ch > ADC_CH_NR_MAX / 2))
+	{
+		return IOPLUS_ERR_ARG;
+	}
+	return readBlockAS(board, I2C_MEM_ADC_MAX + ADC_RAW_VAL_SIZE * (ch - 1),
+		(u8*)mV, ADC_RAW_VAL_SIZE, ADC_RAW_VAL_SIZE);
+}
+
+int ioplusAdcMinGet(IoplusBoardType *board, int ch, uint16_t *mV)
+{
+	if ( (IOPLUS_OK != checkBoard(board)) || (NULL == mV)
+		|| (ch < CHANNEL_NR_MIN) || (ch > ADC_CH_NR_MAX / 2))
+	{
+		return IOPLUS_ERR_ARG;
+	}
+	return readBlockAS(board, I2C_MEM_ADC_MIN + ADC_RAW_VAL_SIZE * (ch - 1),
+		(u8*)mV, ADC_RAW_VAL_SIZE, ADC_RAW_VAL_SIZE);
+}
+
+int ioplusAdcMinMaxGetAll(IoplusBoardType *board, uint16_t *minMv,
+	uint16_t *maxMv)
+{
+	u16 buff[2 * IOPLUS_ADC_MINMAX_CH_NO];
+	int ret;
+
+	if ( (IOPLUS_OK != checkBoard(board)) || (NULL == minMv) || (NULL == maxMv))
+	{
+		return IOPLUS_ERR_ARG;
+	}
+	if (IOPLUS_OK != checkHw3(board))
+	{
+		return IOPLUS_ERR_NOT_SUPPORTED;
+	}
+	// max registers are followed by the min ones
+	ret = readBlockAS(board, I2C_MEM_ADC_MAX, (u8*)buff, sizeof(buff),
+		ADC_RAW_VAL_SIZE);
+	if (ret != IOPLUS_OK)
+	{
+		return ret;
+	}
+	memcpy(maxMv, buff, IOPLUS_ADC_MINMAX_CH_NO * sizeof(u16));
+	memcpy(minMv, &buff[IOPLUS_ADC_MINMAX_CH_NO],
+		IOPLUS_ADC_MINMAX_CH_NO * sizeof(u16));
+	return IOPLUS_OK;
+}
+
+int ioplusMinMaxSamplesGet(IoplusBoardType *board, uint8_t *val)
+{
+	if ( (IOPLUS_OK != checkBoard(board)) || (NULL == val))
+	{
+		return IOPLUS_ERR_ARG;
+	}
+	if (IOPLUS_OK != checkHw3(board))
+	{
+		return IOPLUS_ERR_NOT_SUPPORTED;
+	}
+	return readBlockAS(board, I2C_MEM_MIN_MAX_SAMPLES, val, 1, 1);
+}
+
+int ioplusMinMaxSamplesSet(IoplusBoardType *board, uint8_t val)
+{
+	if ( (IOPLUS_OK != checkBoard(board)) || (val < MIN_MAX_SAMPLES_MIN)
+		|| (val > MIN_MAX_SAMPLES_MAX))
+	{
+		return IOPLUS_ERR_ARG;
+	}
+	if (IOPLUS_OK != checkHw3(board))
+	{
+		return IOPLUS_ERR_NOT_SUPPORTED;
+	}
+	return writeBlock(board, I2C_MEM_MIN_MAX_SAMPLES, &val, 1);
+}
+
+//------------------------------------------------------------------ calibration
+int ioplusAdcCalSet(IoplusBoardType *board, int ch, uint16_t mV)
+{
+	if ( (IOPLUS_OK != checkBoard(board)) || (ch < CHANNEL_NR_MIN)
+		|| (ch > ADC_CH_NR_MAX) || (mV > 3300))
+	{
+		return IOPLUS_ERR_ARG;
+	}
+	return calWrite(board, ch, mV, CALIBRATION_KEY);
+}
+
+int ioplusAdcCalReset(IoplusBoardType *board, int ch)
+{
+	if ( (IOPLUS_OK != checkBoard(board)) || (ch < CHANNEL_NR_MIN)
+		|| (ch > ADC_CH_NR_MAX))
+	{
+		return IOPLUS_ERR_ARG;
+	}
+	return calWrite(board, ch, 0, RESET_CALIBRATION_KEY);
+}
+
+// DAC calibration channels follow the ADC ones
+int ioplusDacCalSet(IoplusBoardType *board, int ch, uint16_t mV)
+{
+	if ( (IOPLUS_OK != checkBoard(board)) || (ch < CHANNEL_NR_MIN)
+		|| (ch > DAC_CH_NR_MAX) || (mV > 10 * VOLT_TO_MILIVOLT))
+	{
+		return IOPLUS_ERR_ARG;
+	}
+	return calWrite(board, ch + ADC_CH_NR_MAX, mV, CALIBRATION_KEY);
+}
+
+int ioplusDacCalReset(IoplusBoardType *board, int ch)
+{
+	if ( (IOPLUS_OK != checkBoard(board)) || (ch < CHANNEL_NR_MIN)
+		|| (ch > DAC_CH_NR_MAX))
+	{
+		return IOPLUS_ERR_ARG;
+	}
+	return calWrite(board, ch + ADC_CH_NR_MAX, 0, RESET_CALIBRATION_KEY);
+}
+
+int ioplusCalStatusGet(IoplusBoardType *board, int *status)
+{
+	u8 val = 0;
+	int ret;
+
+	if ( (IOPLUS_OK != checkBoard(board)) || (NULL == status))
+	{
+		return IOPLUS_ERR_ARG;
+	}
+	ret = readBlockAS(board, I2C_MEM_CALIB_STATUS, &val, 1, 1);
+	*status = val;
+	return ret;
+}
+
+int ioplusCalWait(IoplusBoardType *board, int timeoutMs, int *status)
+{
+	uint64_t start;
+	uint64_t end;
+	int val = IOPLUS_CAL_IN_PROGRESS;
+	int busySeen = 0;
+	int ret;
+
+	if ( (IOPLUS_OK != checkBoard(board)) || (timeoutMs < 0))
+	{
+		return IOPLUS_ERR_ARG;
+	}
+	start = nowMs();
+	end = start + timeoutMs;
+	sleepMs(CAL_FIRST_POLL_MS);
+	while (1)
+	{
+		ret = ioplusCalStatusGet(board, &val);
+		if (NULL != status)
+		{
+			*status = val;
+		}
+		if (ret != IOPLUS_OK)
+		{
+			return ret;
+		}
+		if (val == IOPLUS_CAL_IN_PROGRESS)
+		{
+			busySeen = 1;
+		}
+		else if (busySeen || (nowMs() >= start + CAL_SETTLE_MS))
+		{
+			return IOPLUS_OK;
+		}
+		if (nowMs() >= end)
+		{
+			return IOPLUS_ERR_TIMEOUT;
+		}
+		sleepMs(CAL_POLL_MS);
+	}
+}
+
+//------------------------------------------------------------------ open drain
+int ioplusOdPwmGet(IoplusBoardType *board, int ch, uint16_t *raw)
+{
+	if ( (IOPLUS_OK != checkBoard(board)) || (NULL == raw)
+		|| (ch < CHANNEL_NR_MIN) || (ch > OD_CH_NR_MAX))
+	{
+		return IOPLUS_ERR_ARG;
+	}
+	return readBlockAS(board, I2C_MEM_OD_PWM_VAL_RAW_ADD + 2 * (ch - 1),
+		(u8*)raw, 2, 2);
+}
+
+int ioplusOdDefaultGet(IoplusBoardType *board, uint8_t *val)
+{
+	if ( (IOPLUS_OK != checkBoard(board)) || (NULL == val))
+	{
+		return IOPLUS_ERR_ARG;
+	}
+	return readBlockAS(board, I2C_MEM_OD_DEFAULT, val, 1, 1);
+}
+
+int ioplusOdDefaultSet(IoplusBoardType *board, uint8_t val)
+{
+	if (IOPLUS_OK != checkBoard(board))
+	{
+		return IOPLUS_ERR_ARG;
+	}
+	return writeBlock(board, I2C_MEM_OD_DEFAULT, &val, 1);
+}
+
+int ioplusOdPwmFreqGet(IoplusBoardType *board, uint16_t *hz)
+{
+	if ( (IOPLUS_OK != checkBoard(board)) || (NULL == hz))
+	{
+		return IOPLUS_ERR_ARG;
+	}
+	if (IOPLUS_OK != checkHw3(board))
+	{
+		return IOPLUS_ERR_NOT_SUPPORTED;
+	}
+	return readBlockAS(board, I2C_MEM_OD_PWM_FREQUENCY, (u8*)hz, 2, 2);
+}
+
+int ioplusOdPwmFreqSet(IoplusBoardType *board, uint16_t hz)
+{
+	if ( (IOPLUS_OK != checkBoard(board)) || (hz < PWM_FREQ_MIN)
+		|| (hz > PWM_FREQ_MAX))
+	{
+		return IOPLUS_ERR_ARG;
+	}
+	if (IOPLUS_OK != checkHw3(board))
+	{
+		return IOPLUS_ERR_NOT_SUPPORTED;
+	}
+	return shadowWrite(board, I2C_MEM_OD_PWM_FREQUENCY, &board->shadow.odFreq, &hz,
+		2);
+}
+
+int ioplusOdPwmChFreqSet(IoplusBoardType *board, int ch, uint16_t hz)
+{
+	if ( (IOPLUS_OK != checkBoard(board)) || (ch < CHANNEL_NR_MIN)
+		|| (ch > OD_CH_NR_MAX) || (hz < PWM_FREQ_MIN) || (hz > PWM_FREQ_MAX))
+	{
+		return IOPLUS_ERR_ARG;
+	}
+	if (IOPLUS_OK != checkHw3(board))
+	{
+		return IOPLUS_ERR_NOT_SUPPORTED;
+	}
+	return shadowWrite(board, I2C_MEM_OD_PWM_FREQUENCY_CH1 + 2 * (ch - 1),
+		&board->shadow.odChFreq[ch - 1], &hz, 2);
+}
+
+int ioplusOdPulsesSet(IoplusBoardType *board, int ch, uint32_t val)
+{
+	u8 buff[5];
+	int ret;
+
+	if ( (IOPLUS_OK != checkBoard(board)) || (ch < CHANNEL_NR_MIN)
+		|| (ch > 2 * OD_CH_NR_MAX))
+	{
+		return IOPLUS_ERR_ARG;
+	}
+	memcpy(buff, &val, 4);
+#ifdef SINGLE_TRANSFER
+	// value and command registers are adjacent
+	buff[4] = (u8)ch;
+	ret = writeBlock(board, I2C_MEM_OD_P_SET_VALUE, buff, 5);
+#else
+	ret = writeBlock(board, I2C_MEM_OD_P_SET_VALUE, buff, 4);
+	if (ret == IOPLUS_OK)
+	{
+		buff[0] = (u8)ch;
+		ret = writeBlock(board, I2C_MEM_OD_P_SET_CMD, buff, 1);
+	}
+#endif
+	return ret;
+}
+
+int ioplusOdPulsesGet(IoplusBoardType *board, int ch, uint32_t *val)
+{
+	if ( (IOPLUS_OK != checkBoard(board)) || (NULL == val)
+		|| (ch < CHANNEL_NR_MIN) || (ch > OD_CH_NR_MAX))
+	{
+		return IOPLUS_ERR_ARG;
+	}
+	return readBlock(board, I2C_MEM_OD_PULSE_CNT_SET + COUNTER_SIZE * (ch - 1),
+		(u8*)val, COUNTER_SIZE);
+}
+
+int ioplusOdPulsesGetAll(IoplusBoardType *board, uint32_t *val)
+{
+	if ( (IOPLUS_OK != checkBoard(board)) || (NULL == val))
+	{
+		return IOPLUS_ERR_ARG;
+	}
+	return readBlock(board, I2C_MEM_OD_PULSE_CNT_SET, (u8*)val,
+		COUNTER_SIZE * OD_CH_NO);
+}
+
+int ioplusOdMoveSet(IoplusBoardType *board, int ch, int acc, int dec,
+	int minSpd, int maxSpd)
+{
+	u16 prof[4];
+	u8 cmd = (u8)ch;
+	int ret;
+
+	if ( (IOPLUS_OK != checkBoard(board)) || (ch < CHANNEL_NR_MIN)
+		|| (ch > OD_CH_NR_MAX) || (acc < 0) || (acc > MAX_ACC) || (dec < 0)
+		|| (dec > MAX_ACC) || (maxSpd < MIN_SPEED) || (maxSpd > MAX_SPEED)
+		|| (minSpd < MIN_SPEED) || (minSpd > maxSpd))
+	{
+		return IOPLUS_ERR_ARG;
+	}
+	if (IOPLUS_OK != checkHw3(board))
+	{
+		return IOPLUS_ERR_NOT_SUPPORTED;
+	}
+	prof[0] = (u16)acc;
+	prof[1] = (u16)dec;
+	prof[2] = (u16)maxSpd;
+	prof[3] = (u16)minSpd;
+	ret = writeBlock(board, I2C_MEM_ODP_ACC, (u8*)prof, sizeof(prof));
+	if (ret != IOPLUS_OK)
+	{
+		return ret;
+	}
+	return writeBlock(board, I2C_MEM_ODP_CMD, &cmd, 1);
+}
+
+//------------------------------------------------------------------ one wire bus
+int ioplusOwbTempGetAll(IoplusBoardType *board, int16_t *temp, int *cnt)
+{
+	u8 buff[I2C_MEM_1WB_T_END - I2C_MEM_1WB_DEV];
+	int ret;
+	int nr;
+
+	if ( (IOPLUS_OK != checkBoard(board)) || (NULL == temp) || (NULL == cnt))
+	{
+		return IOPLUS_ERR_ARG;
+	}
+	ret = readBlock(board, I2C_MEM_1WB_DEV, buff, sizeof(buff));
+	if (ret != IOPLUS_OK)
+	{
+		return ret;
+	}
+	nr = buff[0];
+	if (nr > OWB_SENS_CNT)
+	{
+		nr = OWB_SENS_CNT;
+	}
+	memcpy(temp, &buff[I2C_MEM_1WB_T1 - I2C_MEM_1WB_DEV], nr * OWB_TEMP_SIZE_B);
+	*cnt = nr;
+	return IOPLUS_OK;
+}
+
+int ioplusOwbSensCountGet(IoplusBoardType *board, int *cnt)
+{
+	u8 val = 0;
+	int ret;
+
+	if ( (IOPLUS_OK != checkBoard(board)) || (NULL == cnt))
+	{
+		return IOPLUS_ERR_ARG;
+	}
+	ret = readBlock(board, I2C_MEM_1WB_DEV, &val, 1);
+	*cnt = val;
+	return ret;
+}
+
+int ioplusOwbTempGet(IoplusBoardType *board, int ch, int16_t *temp)
+{
+	int16_t val = -1;
+	int cnt = 0;
+	int retry = 4;
+	int ret;
+
+	if ( (IOPLUS_OK != checkBoard(board)) || (NULL == temp)
+		|| (ch < CHANNEL_NR_MIN) || (ch > OWB_SENS_CNT))
+	{
+		return IOPLUS_ERR_ARG;
+	}
+	ret = ioplusOwbSensCountGet(board, &cnt);
+	if (ret != IOPLUS_OK)
+	{
+		return ret;
+	}
+	if (ch > cnt)
+	{
+		return IOPLUS_ERR_ARG;
+	}
+	// -1 is returned by the card while the conversion is in progress
+	while ( (val == -1) && (retry > 0))
+	{
+		ret = readBlock(board, I2C_MEM_1WB_T1 + OWB_TEMP_SIZE_B * (ch - 1),
+			(u8*)&val, OWB_TEMP_SIZE_B);
+		if (ret != IOPLUS_OK)
+		{
+			return ret;
+		}
+		retry--;
+	}
+	if (val == -1)
+	{
+		return IOPLUS_ERR_SPURIOUS;
+	}
+	*temp = val;
+	return IOPLUS_OK;
+}
+
+int ioplusOwbRomGet(IoplusBoardType *board, int ch, uint64_t *rom)
+{
+	u8 idx = (u8)(ch - 1);
+	int cnt = 0;
+	int ret;
+
+	if ( (IOPLUS_OK != checkBoard(board)) || (NULL == rom)
+		|| (ch < CHANNEL_NR_MIN) || (ch > OWB_SENS_CNT))
+	{
+		return IOPLUS_ERR_ARG;
+	}
+	ret = writeBlock(board, I2C_MEM_1WB_ROM_CODE_IDX, &idx, 1);
+	if (ret != IOPLUS_OK)
+	{
+		return ret;
+	}
+	ret = ioplusOwbSensCountGet(board, &cnt);
+	if (ret != IOPLUS_OK)
+	{
+		return ret;
+	}
+	if (ch > cnt)
+	{
+		return IOPLUS_ERR_ARG;
+	}
+	return readBlock(board, I2C_MEM_1WB_ROM_CODE, (u8*)rom, 8);
+}
+
+int ioplusOwbScan(IoplusBoardType *board)
+{
+	u8 val = OWB_START_SEARCH_KEY;
+
+	if (IOPLUS_OK != checkBoard(board))
+	{
+		return IOPLUS_ERR_ARG;
+	}
+	return writeBlock(board, I2C_MEM_1WB_START_SEARCH, &val, 1);
+}
+
+//------------------------------------------------------------------ watchdog
+int ioplusWdtReload(IoplusBoardType *board)
+{
+	u8 val = WDT_RESET_SIGNATURE;
+
+	if (IOPLUS_OK != checkBoard(board))
+	{
+		return IOPLUS_ERR_ARG;
+	}
+	return writeBlock(board, I2C_MEM_WDT_RESET_ADD, &val, 1);
+}
+
+int ioplusWdtPeriodGet(IoplusBoardType *board, uint16_t *sec)
+{
+	if ( (IOPLUS_OK != checkBoard(board)) || (NULL == sec))
+	{
+		return IOPLUS_ERR_ARG;
+	}
+	return readBlockAS(board, I2C_MEM_WDT_INTERVAL_GET_ADD, (u8*)sec, 2, 2);
+}
+
+int ioplusWdtPeriodSet(IoplusBoardType *board, uint16_t sec)
+{
+	if ( (IOPLUS_OK != checkBoard(board)) || (0 == sec))
+	{
+		return IOPLUS_ERR_ARG;
+	}
+	return writeBlock(board, I2C_MEM_WDT_INTERVAL_SET_ADD, (u8*)&sec, 2);
+}
+
+int ioplusWdtInitPeriodGet(IoplusBoardType *board, uint16_t *sec)
+{
+	if ( (IOPLUS_OK != checkBoard(board)) || (NULL == sec))
+	{
+		return IOPLUS_ERR_ARG;
+	}
+	return readBlockAS(board, I2C_MEM_WDT_INIT_INTERVAL_GET_ADD, (u8*)sec, 2, 2);
+}
+
+int ioplusWdtInitPeriodSet(IoplusBoardType *board, uint16_t sec)
+{
+	if ( (IOPLUS_OK != checkBoard(board)) || (0 == sec))
+	{
+		return IOPLUS_ERR_ARG;
+	}
+	return writeBlock(board, I2C_MEM_WDT_INIT_INTERVAL_SET_ADD, (u8*)&sec, 2);
+}
+
+int ioplusWdtOffPeriodGet(IoplusBoardType *board, uint32_t *sec)
+{
+	if ( (IOPLUS_OK != checkBoard(board)) || (NULL == sec))
+	{
+		return IOPLUS_ERR_ARG;
+	}
+	return readBlockAS(board, I2C_MEM_WDT_POWER_OFF_INTERVAL_GET_ADD, (u8*)sec, 4,
+		4);
+}
+
+int ioplusWdtOffPeriodSet(IoplusBoardType *board, uint32_t sec)
+{
+	if ( (IOPLUS_OK != checkBoard(board)) || (0 == sec)
+		|| (sec > WDT_MAX_OFF_INTERVAL_S))
+	{
+		return IOPLUS_ERR_ARG;
+	}
+	return writeBlock(board, I2C_MEM_WDT_POWER_OFF_INTERVAL_SET_ADD, (u8*)&sec,
+		4);
+}
+
+int ioplusWdtResetCountGet(IoplusBoardType *board, uint16_t *count)
+{
+	if ( (IOPLUS_OK != checkBoard(board)) || (NULL == count))
+	{
+		return IOPLUS_ERR_ARG;
+	}
+	return readBlockAS(board, I2C_MEM_WDT_RESET_COUNT_ADD, (u8*)count, 2, 2);
+}
+
+//------------------------------------------------------------------ diagnose
+int ioplusDiagGet(IoplusBoardType *board, int *temp, uint16_t *mV)
+{
+	u8 buff[3];
+	int ret;
+
+	if (IOPLUS_OK != checkBoard(board))
+	{
+		return IOPLUS_ERR_ARG;
+	}
+	ret = readBlock(board, I2C_MEM_DIAG_TEMPERATURE_ADD, buff, 3);
+	if (ret != IOPLUS_OK)
+	{
+		return ret;
+	}
+	if (NULL != temp)
+	{
+		*temp = buff[0];
+	}
+	if (NULL != mV)
+	{
+		memcpy(mV, &buff[1], 2);
+	}
+	return IOPLUS_OK;
+}
@@ -0,0 +1,1025 @@
+/*
+ * libioplus.h:
+ *	Public C interface of the IO-PLUS card library (libioplus.so)
+ *	All functions return IOPLUS_OK (0) or a negative IoplusErrType code and
+ *	never print. Multi channel readers fill caller owned arrays.
+ *
+ *	Copyright (c) 2016-2023 Sequent Microsystem
+ *	<http://www.sequentmicrosystem.com>
+ ***********************************************************************
+ */
+#ifndef LIBIOPLUS_H_
+#define LIBIOPLUS_H_
+
+#include <stdint.h>
+#include <pthread.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#if defined(__GNUC__)
+#define IOPLUS_API __attribute__((visibility("default")))
+#else
+#define IOPLUS_API
+#endif
+
+/* bumped on every incompatible change of the functions or structures below */
+#define IOPLUS_ABI_VERSION	3
+
+#define IOPLUS_STACK_MAX	8
+#define IOPLUS_RELAY_CH_NO	8
+#define IOPLUS_OPTO_CH_NO	8
+#define IOPLUS_GPIO_CH_NO	4
+#define IOPLUS_ADC_CH_NO	8
+#define IOPLUS_DAC_CH_NO	4
+#define IOPLUS_OD_CH_NO		4
+#define IOPLUS_OWB_SENS_NO	8
+#define IOPLUS_OD_PWM_MAX	10000
+
+typedef enum
+{
+	IOPLUS_OK = 0,
+	IOPLUS_ERR_IO = -1, // I2C transfer failed
+	IOPLUS_ERR_ARG = -2, // invalid channel, value or pointer
+	IOPLUS_ERR_SPURIOUS = -3, // value not stable after anti-spurious retries
+	IOPLUS_ERR_NO_BOARD = -4, // no card answering on this stack level
+	IOPLUS_ERR_NOT_SUPPORTED = -5, // feature needs a newer hardware revision
+	IOPLUS_ERR_TIMEOUT = -6, // card still busy when the wait expired
+	IOPLUS_ERR_VERIFY = -7, // output read back different from the value written
+	IOPLUS_ERR_FULL = -8, // no room left in a queue
+	IOPLUS_ERR_OPEN = -9, // card skipped after repeated errors, see ioplusBreakerSet()
+} IoplusErrType;
+
+/* input edges counted, ioplusOptoEdgeSet() / ioplusGpioEdgeSet() */
+#define IOPLUS_EDGE_NONE	0
+#define IOPLUS_EDGE_RISING	1
+#define IOPLUS_EDGE_FALLING	2
+#define IOPLUS_EDGE_BOTH	3
+
+/* ioplusCalStatusGet() values */
+#define IOPLUS_CAL_IN_PROGRESS	0
+#define IOPLUS_CAL_DONE	1
+#define IOPLUS_CAL_ERROR	2
+
+/* host copy of the card output registers, see ioplusShadowEnable() */
+typedef struct
+{
+	uint8_t relay;
+	uint8_t gpio;
+	uint16_t dacMv[IOPLUS_DAC_CH_NO];
+	uint16_t odPwm[IOPLUS_OD_CH_NO];
+	uint16_t odFreq; // hardware 3.0 and up
+	uint16_t odChFreq[IOPLUS_OD_CH_NO]; // hardware 3.0 and up
+} IoplusOutputsType;
+
+typedef struct
+{
+	uint32_t issued; // output writes sent to the card
+	uint32_t suppressed; // output writes skipped, the card already has the value
+	uint32_t resyncs; // shadow reloads from the card
+	uint32_t errors; // failed output writes, each one forces a reload
+} IoplusShadowStatsType;
+
+/* output write verification, see ioplusVerifySet() */
+#define IOPLUS_VERIFY_NONE	0 // write only
+#define IOPLUS_VERIFY_ONCE	1 // read back once, a mismatch is an error
+#define IOPLUS_VERIFY_UNTIL	2 // write again until the read back matches
+
+typedef struct
+{
+	int mode;
+	int retries; // writes repeated at most, IOPLUS_VERIFY_UNTIL
+	uint32_t deadlineMs; // from the first write, 0 for no limit
+} IoplusVerifyType;
+
+typedef struct
+{
+	uint32_t checks; // read backs
+	uint32_t mismatches;
+	uint32_t retries; // writes repeated
+	uint32_t failures; // IOPLUS_ERR_VERIFY returned
+} IoplusVerifyStatsType;
+
+typedef struct
+{
+	int dev; // I2C file descriptor, -1 when closed
+	int stack;
+	uint8_t hwMajor;
+	uint8_t hwMinor;
+	uint8_t fwMajor;
+	uint8_t fwMinor;
+	// output shadow, private to the library
+	int shadowOn;
+	int shadowValid;
+	uint32_t shadowPeriodMs;
+	uint64_t shadowSyncMs;
+	IoplusOutputsType shadow;
+	IoplusShadowStatsType shadowStats;
+	// output verification, private to the library
+	IoplusVerifyType verify;
+	IoplusVerifyStatsType verifyStats;
+} IoplusBoardType;
+
+/* circuit breaker, see ioplusBreakerSet() */
+#define IOPLUS_BRK_CLOSED	0 // transfers go to the card
+#define IOPLUS_BRK_OPEN	1 // transfers fail with IOPLUS_ERR_OPEN
+#define IOPLUS_BRK_HALF_OPEN	2 // one probe transfer on the bus
+
+typedef struct
+{
+	int errors; // failed transfers in a row that open the circuit, 0 for off
+	uint32_t probeMs; // wait before the first probe
+	uint32_t probeMaxMs; // the wait doubles after a failed probe, up to this
+} IoplusBreakerType;
+
+typedef struct
+{
+	int state; // IOPLUS_BRK_xxx
+	uint32_t errors; // failed transfers in a row
+	uint32_t trips; // times the circuit opened
+	uint32_t probes; // transfers let through to test the card
+	uint32_t skipped; // transfers failed fast while open
+	uint32_t backoffMs; // wait before the next probe
+} IoplusHealthType;
+
+/* bus wedge recovery, see ioplusBusRecoverSet() */
+#define IOPLUS_RECOVER_REOPEN	1 // reopen the I2C adapter
+#define IOPLUS_RECOVER_REBIND	2 // then rebind the adapter driver, needs root
+
+typedef struct
+{
+	int errors; // EIO / ETIMEDOUT failures in a row that start it, 0 for off
+	int step; // IOPLUS_RECOVER_xxx, the last step tried
+} IoplusRecoverType;
+
+typedef struct
+{
+	uint32_t wedges; // stuck bus detected
+	uint32_t recovered; // a card answered after the recovery
+	uint32_t failed;
+	uint32_t lastUs; // duration of the last recovery
+	uint32_t maxUs;
+	int lastStep; // IOPLUS_RECOVER_xxx that ended the last recovery
+} IoplusRecoverStatsType;
+
+/* staged output image: registers 0 (relays) to 55 (last open drain pwm) */
+#define IOPLUS_TX_IMG_SIZE	56
+
+/* output transaction, see ioplusTxBegin() */
+typedef struct
+{
+	IoplusBoardType *board;
+	uint64_t dirty; // staged bytes of img
+	uint8_t relayMask; // relay channels staged
+	uint8_t gpioMask; // gpio channels staged
+	uint8_t img[IOPLUS_TX_IMG_SIZE];
+} IoplusTxType;
+
+typedef struct
+{
+	int writes; // block writes issued
+	int bytes; // register bytes written
+	int suppressed; // staged outputs already set on the card (output shadow)
+	uint32_t skewUs; // from the end of the first write to the end of the last
+	uint32_t durationUs; // whole commit, bus lock included
+} IoplusTxReportType;
+
+/* host side ADC filter pipeline, see ioplusFilterParse() */
+#define IOPLUS_FILTER_STAGES_MAX	6
+#define IOPLUS_FILTER_WIN_MAX	32
+
+typedef enum
+{
+	IOPLUS_FILTER_AVG = 1, // moving average over n samples
+	IOPLUS_FILTER_MEDIAN, // median of the last n samples
+	IOPLUS_FILTER_IIR, // first order low pass, y += k * (x - y)
+	IOPLUS_FILTER_DECIM, // pass one sample out of n
+	IOPLUS_FILTER_DEADBAND, // hold the output until the input moves by k
+} IoplusFilterKindType;
+
+/* every stage keeps its history as [slot][channel] so the per sample loops
+ * run over contiguous channels */
+typedef struct
+{
+	int kind;
+	int n;
+	float k;
+	int pos;
+	int fill;
+	float hist[IOPLUS_FILTER_WIN_MAX][IOPLUS_ADC_CH_NO];
+	float state[IOPLUS_ADC_CH_NO];
+} IoplusFilterStageType;
+
+typedef struct
+{
+	int stages;
+	IoplusFilterStageType stage[IOPLUS_FILTER_STAGES_MAX];
+	float out[IOPLUS_ADC_CH_NO]; // last value out of the pipeline
+} IoplusFilterType;
+
+/* rolling ADC statistics, see ioplusAdcStatsSample() */
+#define IOPLUS_ADC_MINMAX_CH_NO	4 // channels with firmware min / max tracking
+#define IOPLUS_STATS_BUCKETS_MAX	60
+
+typedef enum
+{
+	IOPLUS_STATS_1S = 0,
+	IOPLUS_STATS_1MIN,
+	IOPLUS_STATS_1H,
+	IOPLUS_STATS_WIN_NO,
+} IoplusStatsWinType;
+
+/* one window as a ring of time buckets, [bucket][channel] */
+typedef struct
+{
+	uint32_t bucketMs;
+	int buckets;
+	int64_t slot[IOPLUS_STATS_BUCKETS_MAX]; // bucket start / bucketMs, -1 empty
+	uint32_t count[IOPLUS_STATS_BUCKETS_MAX];
+	float min[IOPLUS_STATS_BUCKETS_MAX][IOPLUS_ADC_CH_NO];
+	float max[IOPLUS_STATS_BUCKETS_MAX][IOPLUS_ADC_CH_NO];
+	double sum[IOPLUS_STATS_BUCKETS_MAX][IOPLUS_ADC_CH_NO];
+	double sumSq[IOPLUS_STATS_BUCKETS_MAX][IOPLUS_ADC_CH_NO];
+} IoplusStatsRingType;
+
+typedef struct
+{
+	uint64_t lastMs; // time of the last sample
+	IoplusStatsRingType ring[IOPLUS_STATS_WIN_NO];
+} IoplusAdcStatsType;
+
+/* statistics of one window in mV */
+typedef struct
+{
+	uint32_t samples;
+	float min[IOPLUS_ADC_CH_NO];
+	float max[IOPLUS_ADC_CH_NO];
+	float mean[IOPLUS_ADC_CH_NO];
+	float stddev[IOPLUS_ADC_CH_NO];
+} IoplusAdcWindowType;
+
+/* card counters in one array, see ioplusCountersGetAll() */
+#define IOPLUS_CNT_OPTO	0 // 8 opto edge counters
+#define IOPLUS_CNT_GPIO	8 // 4 gpio edge counters
+#define IOPLUS_CNT_OPTO_ENC	12 // 4 opto encoders, signed
+#define IOPLUS_CNT_GPIO_ENC	16 // gpio encoder, signed
+#define IOPLUS_CNT_OD	17 // 4 open drain pulses left to generate
+#define IOPLUS_CNT_NO	21
+
+/* register groups read by ioplusSnapshotPartGet() */
+#define IOPLUS_SNAP_DIGITAL	0x01 // relay, opto, gpio: one transfer
+#define IOPLUS_SNAP_ANALOG	0x02 // adc, dac, open drain pwm: one transfer
+#define IOPLUS_SNAP_DIAG	0x04 // cpu temperature, 3.3V rail
+#define IOPLUS_SNAP_COUNTERS	0x08
+#define IOPLUS_SNAP_OWB	0x10 // 1-wire temperatures
+#define IOPLUS_SNAP_ALL	0x1f
+
+/* every input and output of the card, see ioplusSnapshotGet() */
+typedef struct
+{
+	uint8_t relay;
+	uint8_t opto;
+	uint8_t gpio;
+	uint16_t adcMv[IOPLUS_ADC_CH_NO];
+	uint16_t dacMv[IOPLUS_DAC_CH_NO];
+	uint16_t odPwm[IOPLUS_OD_CH_NO];
+	int cpuTemp; // degC
+	uint16_t v3v3Mv;
+	uint32_t cnt[IOPLUS_CNT_NO];
+	int owbCnt;
+	int16_t owbTemp[IOPLUS_OWB_SENS_NO]; // 0.01 degC, 0 past owbCnt
+} IoplusSnapshotType;
+
+/* columnar recorder, see ioplusRecOpen() */
+#define IOPLUS_REC_CHUNK_SAMPLES	512
+#define IOPLUS_REC_COL_NO	68 // time first, then one column per signal
+
+typedef struct
+{
+	int fd;
+	int stack;
+	uint32_t flushMs;
+	uint64_t size; // file size
+	uint32_t samples; // in the chunk being filled
+	int64_t time[IOPLUS_REC_CHUNK_SAMPLES]; // ms since the epoch
+	uint32_t val[IOPLUS_REC_COL_NO - 1][IOPLUS_REC_CHUNK_SAMPLES];
+	uint32_t chunks; // written since open
+	uint64_t bytes;
+	uint64_t total; // samples written since open
+} IoplusRecorderType;
+
+typedef struct
+{
+	const uint8_t *map;
+	uint64_t size;
+	int stack;
+} IoplusRecReaderType;
+
+typedef struct
+{
+	uint32_t chunks;
+	uint64_t samples;
+	int64_t firstMs;
+	int64_t lastMs;
+	uint64_t bytes; // file size
+} IoplusRecInfoType;
+
+/* one point of a query, min = max = avg for raw samples */
+typedef struct
+{
+	int64_t t; // ms since the epoch, bucket start when downsampling
+	int64_t min;
+	int64_t max;
+	double avg;
+	uint32_t count;
+} IoplusRecPointType;
+
+/* return non 0 to stop the query */
+typedef int (*IoplusRecCbType)(void *ctx, const IoplusRecPointType *p);
+
+/* counter journal, see ioplusCntJournalOpen() */
+#define IOPLUS_JOURNAL_PATH_MAX	256
+#define IOPLUS_JOURNAL_BUF_SIZE	4096
+
+typedef struct
+{
+	uint32_t samples;
+	uint32_t records; // samples with at least one counter changed
+	uint32_t bytes; // journal bytes written
+	uint32_t syncs;
+	uint32_t checkpoints;
+	uint32_t resets; // counters found restarted from 0
+	uint32_t wraps; // 32 bit counters rolled over
+	uint32_t replayed; // records recovered by ioplusCntJournalOpen()
+	uint32_t dropped; // torn bytes cut from the journal end on open
+} IoplusJournalStatsType;
+
+typedef struct
+{
+	char path[IOPLUS_JOURNAL_PATH_MAX];
+	int fd;
+	uint32_t gen; // checkpoint generation the journal continues
+	uint32_t syncMs;
+	uint32_t checkpointMs;
+	uint32_t checkpointBytes;
+	uint64_t syncedMs; // time of the last fsync
+	uint64_t checkpointedMs;
+	uint32_t size; // journal file size
+	int valid; // raw holds a card sample
+	uint32_t raw[IOPLUS_CNT_NO]; // last card values
+	int64_t total[IOPLUS_CNT_NO];
+	IoplusJournalStatsType stats;
+	uint32_t used;
+	uint8_t buff[IOPLUS_JOURNAL_BUF_SIZE]; // records not written yet
+} IoplusCntJournalType;
+
+/* open drain motion queue, see ioplusMotionInit() */
+#define IOPLUS_MOTION_QUEUE_MAX	16
+#define IOPLUS_MOTION_POLL_US	2000
+#define IOPLUS_MOTION_ARM_US	3000
+
+/* segment events passed to IoplusMoveCbType */
+#define IOPLUS_MOVE_DONE	0 // every pulse sent
+#define IOPLUS_MOVE_FAILED	1 // the card refused the segment, the queue is dropped
+#define IOPLUS_MOVE_CANCELLED	2 // dropped by ioplusMotionStop() or a failure
+
+typedef struct
+{
+	uint32_t pulses;
+	int reverse; // pulses sent on channel + 4
+	uint16_t acc; // movement profile (hardware 3.0 and up), all 0 keeps the
+	uint16_t dec; // profile in use
+	uint16_t minSpd;
+	uint16_t maxSpd;
+	uint32_t tag; // caller data
+} IoplusMoveType;
+
+typedef struct
+{
+	uint32_t queued;
+	uint32_t done;
+	uint32_t failed;
+	uint32_t cancelled;
+	uint32_t polls;
+	uint32_t transitions; // segments started right after the previous one
+	uint32_t late; // transitions the armed poll missed
+	uint32_t gapMinUs; // from the last poll with pulses left to the next write
+	uint32_t gapMaxUs;
+	uint64_t gapSumUs;
+} IoplusMotionStatsType;
+
+typedef struct
+{
+	IoplusMoveType q[IOPLUS_MOTION_QUEUE_MAX];
+	int head;
+	int count; // queued segments, the running one included
+	int running;
+	int armed; // polled back to back until the segment ends
+	int latched; // pulses left seen non zero since the segment was written
+	uint32_t left; // pulses left at the last poll
+	uint64_t seenUs; // time of the last poll with pulses left
+	float rate; // pulses per second, 0 until measured
+	uint16_t prof[4]; // acc, dec, minSpd, maxSpd sent to the card
+	IoplusMotionStatsType stats;
+} IoplusMotionChType;
+
+typedef void (*IoplusMoveCbType)(void *ctx, int ch, const IoplusMoveType *mv,
+	int event);
+
+typedef struct
+{
+	IoplusMotionChType ch[IOPLUS_OD_CH_NO];
+	uint32_t pollUs;
+	uint32_t armUs;
+	IoplusMoveCbType cb;
+	void *ctx;
+} IoplusMotionType;
+
+/* interlock rules, see ioplusRulesCompile() */
+#define IOPLUS_RULES_OPS_MAX	512
+#define IOPLUS_RULES_STACK_MAX	16
+/* output bits of ioplusRulesEval() */
+#define IOPLUS_RULE_OUT_RELAY	0 // relays 1..8
+#define IOPLUS_RULE_OUT_GPIO	8 // gpio 1..4
+#define IOPLUS_RULE_OUT_OD	12 // open drain 1..4, pwm 0 or 100%
+#define IOPLUS_RULE_OUT_NO	16
+
+typedef struct
+{
+	uint8_t op;
+	uint8_t arg; // input channel or output bit
+	uint8_t state; // comparator output, kept for the hysteresis
+	int32_t on; // comparator threshold, raw units
+	int32_t off; // threshold back once on
+} IoplusRuleOpType;
+
+typedef struct
+{
+	uint32_t cycles;
+	uint32_t evals; // cycles with the inputs read
+	uint32_t changes; // cycles that wrote at least one output
+	uint32_t writes; // outputs written
+	uint32_t errors; // failed reads or commits
+	uint32_t evalNsMin;
+	uint32_t evalNsMax;
+	uint64_t evalNsSum;
+	uint32_t reactUsMin; // from the input read to the end of the output write
+	uint32_t reactUsMax;
+	uint64_t reactUsSum;
+} IoplusRulesStatsType;
+
+typedef struct
+{
+	IoplusRuleOpType op[IOPLUS_RULES_OPS_MAX];
+	int ops;
+	int rules;
+	int parts; // IOPLUS_SNAP_xxx groups the rules read
+	uint32_t driven; // IOPLUS_RULE_OUT_xxx bits assigned by a rule
+	uint32_t out; // outputs at the last commit
+	int valid; // out is on the card
+	IoplusSnapshotType in; // last inputs read
+	IoplusRulesStatsType stats;
+	int errLine; // compile error, line from 1
+	char err[64];
+} IoplusRulesType;
+
+/* attention line, see ioplusAttnOpen() */
+typedef struct
+{
+	uint32_t events; // edges reported by the kernel
+	uint32_t edgeReads; // card reads triggered by an edge
+	uint32_t fallbackReads; // card reads after fallbackMs without an edge
+	uint32_t missed; // fallback reads that found the inputs changed
+	uint32_t latencyUsMax; // from the first edge to the end of the card read
+	uint64_t latencyUsSum;
+} IoplusAttnStatsType;
+
+typedef struct
+{
+	int fd; // line request, -1 when closed
+	uint32_t fallbackMs;
+	uint64_t readMs; // time of the last card read
+	int valid; // last holds a card read
+	IoplusSnapshotType last;
+	IoplusAttnStatsType stats;
+} IoplusAttnType;
+
+/* asynchronous register access, see ioplusAsyncStart() */
+#define IOPLUS_ASYNC_READ	0
+#define IOPLUS_ASYNC_WRITE	1
+#define IOPLUS_ASYNC_SIZE_MAX	31 // bytes per request
+#define IOPLUS_ASYNC_MERGE_MAX	32 // bytes per merged read transfer
+#define IOPLUS_ASYNC_BATCH_MAX	64 // requests taken from the queue at once
+
+typedef struct IoplusAsyncReq IoplusAsyncReqType;
+typedef void (*IoplusAsyncCbType)(IoplusAsyncReqType *req);
+
+/* caller owned, must stay valid until the request is done */
+struct IoplusAsyncReq
+{
+	IoplusBoardType *board;
+	int op; // IOPLUS_ASYNC_READ or IOPLUS_ASYNC_WRITE
+	int add; // register address
+	int size; // bytes, 1 .. IOPLUS_ASYNC_SIZE_MAX
+	uint8_t *buf; // read into or written from
+	IoplusAsyncCbType cb; // called on the I/O thread, NULL for none
+	void *ctx;
+	int efd; // eventfd incremented once done, -1 for none
+	int result; // IOPLUS_xxx, valid once done
+	// private to the library
+	int done;
+	uint64_t submitUs;
+	IoplusAsyncReqType *next;
+};
+
+typedef struct
+{
+	uint32_t submitted;
+	uint32_t completed;
+	uint32_t errors; // requests done with a result other than IOPLUS_OK
+	uint32_t batches; // wake ups of the I/O thread with work
+	uint32_t transfers; // I2C transfers done
+	uint32_t merged; // reads served by the transfer of an earlier read
+	uint32_t latencyUsMax; // from submit to done
+	uint64_t latencyUsSum;
+} IoplusAsyncStatsType;
+
+typedef struct
+{
+	IoplusAsyncReqType stub;
+	IoplusAsyncReqType *head; // last submitted, producers
+	IoplusAsyncReqType *tail; // next to run, I/O thread
+	int wakeFd;
+	int idle;
+	int stop;
+	int running;
+	int waiters;
+	pthread_t thread;
+	pthread_mutex_t lock;
+	pthread_cond_t cond;
+	IoplusAsyncStatsType stats;
+} IoplusAsyncType;
+
+/* read planner, see ioplusPlanMake() */
+#define IOPLUS_MAP_SIZE	256 // register map bytes
+#define IOPLUS_PLAN_XFER_MAX	32 // bytes per planned read transfer
+#define IOPLUS_PLAN_READS_MAX	(IOPLUS_MAP_SIZE / 2 \
+	+ IOPLUS_MAP_SIZE / IOPLUS_PLAN_XFER_MAX) // every other byte wanted
+#define IOPLUS_PLAN_CACHE_NO	8
+
+/* wanted bytes of the map, bit n of the set for the byte at address n */
+typedef struct
+{
+	uint32_t mask[IOPLUS_MAP_SIZE / 32];
+} IoplusFieldSetType;
+
+/* predicted time of a read transfer: txUs + size * byteUs */
+typedef struct
+{
+	float txUs;
+	float byteUs;
+} IoplusCostType;
+
+typedef struct
+{
+	uint8_t add;
+	uint8_t size;
+} IoplusSpanType;
+
+typedef struct
+{
+	IoplusFieldSetType fields;
+	IoplusSpanType read[IOPLUS_PLAN_READS_MAX]; // in address order
+	int reads;
+	int bytes; // read per run, the gaps between the fields included
+	float costUs; // predicted time of a run
+} IoplusPlanType;
+
+typedef struct
+{
+	IoplusCostType cost;
+	IoplusPlanType plan[IOPLUS_PLAN_CACHE_NO];
+	uint32_t used[IOPLUS_PLAN_CACHE_NO]; // tick of the last use
+	uint32_t tick;
+	int plans;
+	uint32_t hits;
+	uint32_t misses;
+} IoplusPlanCacheType;
+
+IOPLUS_API int ioplusAbiVersion(void);
+IOPLUS_API const char* ioplusErrStr(int err);
+
+IOPLUS_API int ioplusOpen(IoplusBoardType *board, int stack);
+IOPLUS_API void ioplusClose(IoplusBoardType *board);
+
+/* Raw access to size bytes of the register map from add, split in as many
+ * transfers as needed. Writes bypass the output verification and mark the
+ * output shadow stale. */
+IOPLUS_API int ioplusRegRead(IoplusBoardType *board, int add, uint8_t *buf,
+	int size);
+IOPLUS_API int ioplusRegWrite(IoplusBoardType *board, int add,
+	const uint8_t *buf, int size);
+
+/* Circuit breaker, one per stack level and shared by every board handle of
+ * the process: after cfg->errors failed transfers in a row the card is
+ * skipped, every call fails at once with IOPLUS_ERR_OPEN instead of waiting
+ * for the I2C NACK or timeout. One transfer is let through after probeMs to
+ * test the card; the wait doubles after each failed probe, up to probeMaxMs,
+ * and the first good transfer closes the circuit. Off by default, NULL or
+ * errors 0 turns it off. */
+IOPLUS_API int ioplusBreakerSet(const IoplusBreakerType *cfg);
+IOPLUS_API int ioplusHealthGet(IoplusBoardType *board, IoplusHealthType *health);
+/* close the circuit, forget the counters and the last values */
+IOPLUS_API void ioplusHealthReset(IoplusBoardType *board);
+/* ioplusRegRead() that, while the breaker is on, falls back on the last
+ * values read from the card when the read fails or the card is skipped.
+ * ageMs is 0 for a fresh read, else the age of the oldest byte (1 at least);
+ * the error is returned when a byte was never read. */
+IOPLUS_API int ioplusRegReadLast(IoplusBoardType *board, int add, uint8_t *buf,
+	int size, uint32_t *ageMs);
+
+/* Bus wedge recovery: a slave holding SDA low fails every transfer to every
+ * card. After cfg->errors EIO or ETIMEDOUT failures in a row, from two cards
+ * at least when more than one is open, the library reopens the I2C adapter
+ * under the board handles of the process and probes a card. A lone failing
+ * card is left to the circuit breaker. With IOPLUS_RECOVER_REBIND, if the bus is still stuck, it also
+ * unbinds and binds the adapter driver. A recovery takes at most one second
+ * plus one transfer timeout. After a failed recovery the next one waits
+ * twice as long, from 100 ms up to 10 s. Off by default, NULL or errors 0
+ * turns it off. ioplusBusRecover() recovers now. */
+IOPLUS_API int ioplusBusRecoverSet(const IoplusRecoverType *cfg);
+IOPLUS_API int ioplusBusRecover(int step);
+IOPLUS_API void ioplusBusRecoverStatsGet(IoplusRecoverStatsType *stats);
+
+/* Output shadow: the relay, gpio, dac, open drain pwm and pwm frequency setters
+ * skip the I2C write when the card already holds the value. The shadow is
+ * loaded from the card when enabled, after every failed write and, when
+ * periodMs is not 0, again once it is older than periodMs to pick up changes
+ * made by other processes. Disabled after ioplusOpen(). */
+IOPLUS_API int ioplusShadowEnable(IoplusBoardType *board, uint32_t periodMs);
+IOPLUS_API void ioplusShadowDisable(IoplusBoardType *board);
+IOPLUS_API int ioplusShadowSync(IoplusBoardType *board);
+IOPLUS_API int ioplusShadowGet(IoplusBoardType *board, IoplusOutputsType *out);
+IOPLUS_API int ioplusShadowStatsGet(IoplusBoardType *board,
+	IoplusShadowStatsType *stats);
+IOPLUS_API void ioplusShadowStatsReset(IoplusBoardType *board);
+
+/* Output verification: every relay, gpio, dac, open drain pwm and pwm
+ * frequency write, transactions included, is read back in one transfer and
+ * compared (gpio pins set as inputs excepted). IOPLUS_VERIFY_UNTIL writes the
+ * registers that differ again until they match, retries times at most and
+ * not past deadlineMs. IOPLUS_VERIFY_NONE after ioplusOpen(). */
+IOPLUS_API int ioplusVerifySet(IoplusBoardType *board,
+	const IoplusVerifyType *verify);
+IOPLUS_API int ioplusVerifyGet(IoplusBoardType *board, IoplusVerifyType *verify);
+/* "none", "once" or "until[:<retries>[:<deadline ms>]]" */
+IOPLUS_API int ioplusVerifyParse(const char *spec, IoplusVerifyType *verify);
+IOPLUS_API int ioplusVerifyStatsGet(IoplusBoardType *board,
+	IoplusVerifyStatsType *stats);
+IOPLUS_API void ioplusVerifyStatsReset(IoplusBoardType *board);
+
+/* Output transaction: stage any relay, gpio, dac and open drain pwm changes
+ * then ioplusTxCommit() writes them with the fewest block writes, back to back
+ * while holding the I2C bus semaphore shared with the ioplus command. Partial
+ * relay / gpio updates are merged with the output shadow, or with one read of
+ * the card when the shadow is off. The transaction is empty again after the
+ * commit; report may be NULL. A process holding a semaphore token itself
+ * declares it with ioplusBusLockHeld() first, or the commit may wait on it
+ * forever. */
+IOPLUS_API int ioplusTxBegin(IoplusBoardType *board, IoplusTxType *tx);
+IOPLUS_API int ioplusTxRelaySet(IoplusTxType *tx, uint8_t val);
+IOPLUS_API int ioplusTxRelayChSet(IoplusTxType *tx, int ch, int state);
+IOPLUS_API int ioplusTxGpioSet(IoplusTxType *tx, uint8_t val);
+IOPLUS_API int ioplusTxGpioChSet(IoplusTxType *tx, int ch, int state);
+IOPLUS_API int ioplusTxDacSet(IoplusTxType *tx, int ch, uint16_t mV);
+IOPLUS_API int ioplusTxOdPwmSet(IoplusTxType *tx, int ch, uint16_t raw);
+IOPLUS_API int ioplusTxCommit(IoplusTxType *tx, IoplusTxReportType *report);
+/* held != 0 when the process already owns the bus semaphore for its whole
+ * run (the ioplus command does), commits then do not wait for it again */
+IOPLUS_API void ioplusBusLockHeld(int held);
+
+IOPLUS_API int ioplusRelayGet(IoplusBoardType *board, uint8_t *val);
+IOPLUS_API int ioplusRelaySet(IoplusBoardType *board, uint8_t val);
+IOPLUS_API int ioplusRelayChSet(IoplusBoardType *board, int ch, int state);
+IOPLUS_API int ioplusRelayChGet(IoplusBoardType *board, int ch, int *state);
+/* relays state loaded at power up */
+IOPLUS_API int ioplusRelayDefaultGet(IoplusBoardType *board, uint8_t *val);
+IOPLUS_API int ioplusRelayDefaultSet(IoplusBoardType *board, uint8_t val);
+
+IOPLUS_API int ioplusOptoGet(IoplusBoardType *board, uint8_t *val);
+IOPLUS_API int ioplusOptoCountGet(IoplusBoardType *board, int ch, uint32_t *val);
+IOPLUS_API int ioplusOptoCountGetAll(IoplusBoardType *board, uint32_t *val);
+IOPLUS_API int ioplusOptoChGet(IoplusBoardType *board, int ch, int *state);
+IOPLUS_API int ioplusOptoEdgeGet(IoplusBoardType *board, int ch, uint8_t *edge);
+IOPLUS_API int ioplusOptoEdgeSet(IoplusBoardType *board, int ch, uint8_t edge);
+IOPLUS_API int ioplusOptoCountReset(IoplusBoardType *board, int ch);
+/* quadrature encoders on opto channel pairs, ch [1..4] */
+IOPLUS_API int ioplusOptoEncEnableGet(IoplusBoardType *board, int ch, int *en);
+IOPLUS_API int ioplusOptoEncEnableSet(IoplusBoardType *board, int ch, int en);
+IOPLUS_API int ioplusOptoEncCountGet(IoplusBoardType *board, int ch,
+	int32_t *val);
+IOPLUS_API int ioplusOptoEncCountReset(IoplusBoardType *board, int ch);
+
+IOPLUS_API int ioplusGpioGet(IoplusBoardType *board, uint8_t *val);
+IOPLUS_API int ioplusGpioSet(IoplusBoardType *board, uint8_t val);
+IOPLUS_API int ioplusGpioChSet(IoplusBoardType *board, int ch, int state);
+IOPLUS_API int ioplusGpioDirSet(IoplusBoardType *board, uint8_t val);
+IOPLUS_API int ioplusGpioCountGetAll(IoplusBoardType *board, uint32_t *val);
+IOPLUS_API int ioplusGpioChGet(IoplusBoardType *board, int ch, int *state);
+/* direction bitmap, 1 = input */
+IOPLUS_API int ioplusGpioDirGet(IoplusBoardType *board, uint8_t *val);
+IOPLUS_API int ioplusGpioChDirSet(IoplusBoardType *board, int ch, int input);
+IOPLUS_API int ioplusGpioEdgeGet(IoplusBoardType *board, int ch, uint8_t *edge);
+IOPLUS_API int ioplusGpioEdgeSet(IoplusBoardType *board, int ch, uint8_t edge);
+IOPLUS_API int ioplusGpioCountGet(IoplusBoardType *board, int ch, uint32_t *val);
+IOPLUS_API int ioplusGpioCountReset(IoplusBoardType *board, int ch);
+IOPLUS_API int ioplusGpioEncCountGet(IoplusBoardType *board, int32_t *val);
+IOPLUS_API int ioplusGpioEncCountReset(IoplusBoardType *board);
+/* every counter of the card in four transfers, val[IOPLUS_CNT_NO] indexed
+ * with IOPLUS_CNT_xxx */
+IOPLUS_API int ioplusCountersGetAll(IoplusBoardType *board, uint32_t *val);
+/* load count pulses on the open drain channel outCh at every edge of the
+ * opto input inCh */
+IOPLUS_API int ioplusInCmdSet(IoplusBoardType *board, int inCh, int outCh,
+	uint32_t count, int enable);
+
+/* analog values in millivolts */
+IOPLUS_API int ioplusAdcGet(IoplusBoardType *board, int ch, uint16_t *mV);
+IOPLUS_API int ioplusAdcGetAll(IoplusBoardType *board, uint16_t *mV);
+IOPLUS_API int ioplusAdcRawGetAll(IoplusBoardType *board, uint16_t *raw);
+IOPLUS_API int ioplusDacGetAll(IoplusBoardType *board, uint16_t *mV);
+IOPLUS_API int ioplusDacSet(IoplusBoardType *board, int ch, uint16_t mV);
+IOPLUS_API int ioplusDacGet(IoplusBoardType *board, int ch, uint16_t *mV);
+/* ADC filter pipeline over the 8 channels, no allocation after init.
+ * spec is a comma separated list of stages applied in order:
+ * avg:<n>, median:<n>, iir:<k>, decim:<n>, deadband:<mV>, e.g. "median:5,avg:8" */
+IOPLUS_API int ioplusFilterInit(IoplusFilterType *f);
+IOPLUS_API int ioplusFilterAdd(IoplusFilterType *f, int kind, float param);
+IOPLUS_API int ioplusFilterParse(IoplusFilterType *f, const char *spec);
+IOPLUS_API void ioplusFilterReset(IoplusFilterType *f);
+/* number of input samples until the output covers full windows */
+IOPLUS_API int ioplusFilterSettle(IoplusFilterType *f);
+/* feed one sample of every channel, returns 1 when out (may be NULL) has a
+ * new value, 0 when a decimation stage dropped the sample */
+IOPLUS_API int ioplusFilterRun(IoplusFilterType *f, const float *in, float *out);
+/* one block read of the ADC channels (mV) pushed through the filter */
+IOPLUS_API int ioplusAdcFilterRead(IoplusBoardType *board, IoplusFilterType *f,
+	float *mV, int *fresh);
+
+/* Rolling min / max / mean / stddev of the 8 ADC channels over the last
+ * second, minute and hour, kept in fixed rings of time buckets. Every
+ * ioplusAdcStatsSample() reads the current values and, on hardware 3.x, the
+ * firmware min / max of channels 1..4 so peaks between two polls are kept.
+ * Mean and stddev come from the polled values. */
+IOPLUS_API int ioplusAdcStatsInit(IoplusAdcStatsType *st);
+IOPLUS_API int ioplusAdcStatsSample(IoplusBoardType *board,
+	IoplusAdcStatsType *st);
+/* feed one sample taken at ms (monotonic), minMv / maxMv may be NULL */
+IOPLUS_API int ioplusAdcStatsAdd(IoplusAdcStatsType *st, uint64_t ms,
+	const uint16_t *mV, const uint16_t *minMv, const uint16_t *maxMv);
+IOPLUS_API int ioplusAdcStatsGet(IoplusAdcStatsType *st, int win,
+	IoplusAdcWindowType *out);
+
+/* one pass over the card registers, values read once without anti-spurious
+ * checks */
+IOPLUS_API int ioplusSnapshotGet(IoplusBoardType *board,
+	IoplusSnapshotType *snap);
+/* only the IOPLUS_SNAP_xxx groups in parts, the other fields are left as
+ * they are */
+IOPLUS_API int ioplusSnapshotPartGet(IoplusBoardType *board,
+	IoplusSnapshotType *snap, int parts);
+
+/* Columnar recorder: card snapshots appended to path in chunks of up to
+ * IOPLUS_REC_CHUNK_SAMPLES, written when full or flushMs after their first
+ * sample. Every chunk starts with its time range and the offset of each
+ * column. Relays, opto and gpio are one bit columns, analog values are delta
+ * encoded and counters and time delta-of-delta encoded. Recording appends to
+ * an existing file, dropping a chunk cut by a power loss. */
+IOPLUS_API int ioplusRecOpen(IoplusRecorderType *rec, const char *path,
+	int stack, uint32_t flushMs);
+IOPLUS_API int ioplusRecSample(IoplusBoardType *board, IoplusRecorderType *rec);
+/* add one snapshot taken at ms since the epoch; IOPLUS_ERR_IO, the sample
+ * dropped, while a full chunk can not be written */
+IOPLUS_API int ioplusRecAdd(IoplusRecorderType *rec, int64_t ms,
+	const IoplusSnapshotType *snap);
+IOPLUS_API int ioplusRecFlush(IoplusRecorderType *rec);
+IOPLUS_API int ioplusRecClose(IoplusRecorderType *rec);
+/* column names: time, adc1..8, dac1..4, od1..4, cputemp, v3v3, owb1..8,
+ * relay1..8, opto1..8, gpio1..4, optocnt1..8, gpiocnt1..4, optoenc1..4,
+ * gpioenc, odcnt1..4 */
+IOPLUS_API const char* ioplusRecColName(int col);
+IOPLUS_API int ioplusRecColFind(const char *name);
+/* Memory mapped queries: only the chunks overlapping [fromMs, toMs] are
+ * visited and only the time and col columns decoded. stepMs 0 returns every
+ * sample, otherwise min / avg / max per step aligned bucket. */
+IOPLUS_API int ioplusRecReaderOpen(IoplusRecReaderType *r, const char *path);
+IOPLUS_API void ioplusRecReaderClose(IoplusRecReaderType *r);
+/* walks the chunk headers only */
+IOPLUS_API int ioplusRecInfo(IoplusRecReaderType *r, IoplusRecInfoType *info);
+IOPLUS_API int ioplusRecQuery(IoplusRecReaderType *r, int col, int64_t fromMs,
+	int64_t toMs, int64_t stepMs, IoplusRecCbType cb, void *ctx);
+
+/* Counter journal: 64 bit totals of the card counters kept across card
+ * resets, counter wraps and power loss. Every sample appends the deltas of
+ * the changed counters to an append only journal at path, written and synced
+ * at most every syncMs. Every checkpointMs, or once the journal reaches
+ * checkpointBytes, the totals are saved to path.ckp and the journal restarts
+ * empty. Open recovers the totals from both files, cutting a torn record at
+ * the journal end. Edge counters and open drain pulses sent only grow, the
+ * encoders are signed positions. */
+IOPLUS_API int ioplusCntJournalOpen(IoplusCntJournalType *j, const char *path,
+	uint32_t syncMs, uint32_t checkpointMs, uint32_t checkpointBytes);
+IOPLUS_API int ioplusCntJournalSample(IoplusBoardType *board,
+	IoplusCntJournalType *j);
+/* feed one set of raw counter values read at ms (monotonic) */
+IOPLUS_API int ioplusCntJournalAdd(IoplusCntJournalType *j, uint64_t ms,
+	const uint32_t *raw);
+IOPLUS_API int ioplusCntJournalTotals(IoplusCntJournalType *j, int64_t *total);
+IOPLUS_API int ioplusCntJournalSync(IoplusCntJournalType *j);
+IOPLUS_API int ioplusCntJournalCheckpoint(IoplusCntJournalType *j);
+/* sync, checkpoint and close the files */
+IOPLUS_API int ioplusCntJournalClose(IoplusCntJournalType *j);
+
+/* min / max over the last n samples, ch [1..4] */
+IOPLUS_API int ioplusAdcMaxGet(IoplusBoardType *board, int ch, uint16_t *mV);
+IOPLUS_API int ioplusAdcMinGet(IoplusBoardType *board, int ch, uint16_t *mV);
+/* firmware min / max of channels 1..4 in one transfer, hardware 3.0 and up */
+IOPLUS_API int ioplusAdcMinMaxGetAll(IoplusBoardType *board, uint16_t *minMv,
+	uint16_t *maxMv);
+IOPLUS_API int ioplusMinMaxSamplesGet(IoplusBoardType *board, uint8_t *val);
+IOPLUS_API int ioplusMinMaxSamplesSet(IoplusBoardType *board, uint8_t val);
+
+/* calibration points must be at least 2V apart, check the result with
+ * ioplusCalStatusGet() */
+IOPLUS_API int ioplusAdcCalSet(IoplusBoardType *board, int ch, uint16_t mV);
+IOPLUS_API int ioplusAdcCalReset(IoplusBoardType *board, int ch);
+IOPLUS_API int ioplusDacCalSet(IoplusBoardType *board, int ch, uint16_t mV);
+IOPLUS_API int ioplusDacCalReset(IoplusBoardType *board, int ch);
+IOPLUS_API int ioplusCalStatusGet(IoplusBoardType *board, int *status);
+/* poll the calibration status until the card leaves IOPLUS_CAL_IN_PROGRESS,
+ * IOPLUS_ERR_TIMEOUT after timeoutMs, status may be NULL. A final status is
+ * taken once in progress was seen, or 100 ms after the call, so the status
+ * of the previous calibration is not mistaken for this one. */
+IOPLUS_API int ioplusCalWait(IoplusBoardType *board, int timeoutMs, int *status);
+
+/* open drain pwm in 0.01% [0..IOPLUS_OD_PWM_MAX] */
+IOPLUS_API int ioplusOdPwmGetAll(IoplusBoardType *board, uint16_t *raw);
+IOPLUS_API int ioplusOdPwmSet(IoplusBoardType *board, int ch, uint16_t raw);
+IOPLUS_API int ioplusOdPwmGet(IoplusBoardType *board, int ch, uint16_t *raw);
+IOPLUS_API int ioplusOdDefaultGet(IoplusBoardType *board, uint8_t *val);
+IOPLUS_API int ioplusOdDefaultSet(IoplusBoardType *board, uint8_t val);
+/* pwm frequency in Hz [10..65500], hardware 3.0 and up */
+IOPLUS_API int ioplusOdPwmFreqGet(IoplusBoardType *board, uint16_t *hz);
+IOPLUS_API int ioplusOdPwmFreqSet(IoplusBoardType *board, uint16_t hz);
+IOPLUS_API int ioplusOdPwmChFreqSet(IoplusBoardType *board, int ch, uint16_t hz);
+/* pulses to generate, ch [5..8] drive channels 1..4 in the opposite direction */
+IOPLUS_API int ioplusOdPulsesSet(IoplusBoardType *board, int ch, uint32_t val);
+IOPLUS_API int ioplusOdPulsesGet(IoplusBoardType *board, int ch, uint32_t *val);
+/* pulses left on the 4 channels in one transfer */
+IOPLUS_API int ioplusOdPulsesGetAll(IoplusBoardType *board, uint32_t *val);
+/* pulse train movement profile, hardware 3.0 and up */
+IOPLUS_API int ioplusOdMoveSet(IoplusBoardType *board, int ch, int acc, int dec,
+	int minSpd, int maxSpd);
+
+/* Motion queue: segments queued per open drain channel [1..4] are sent one
+ * after the other. ioplusMotionPoll() reads the pulses left on the busy
+ * channels in one transfer every pollUs and, once a segment is expected to
+ * end within armUs, on every call so the next segment is written as soon as
+ * the card runs out of pulses. The callback runs from ioplusMotionPoll()
+ * after the next segment is started and may queue more segments. pollUs /
+ * armUs 0 select IOPLUS_MOTION_POLL_US / IOPLUS_MOTION_ARM_US. */
+IOPLUS_API int ioplusMotionInit(IoplusMotionType *m, uint32_t pollUs,
+	uint32_t armUs, IoplusMoveCbType cb, void *ctx);
+/* IOPLUS_ERR_FULL when IOPLUS_MOTION_QUEUE_MAX segments are pending */
+IOPLUS_API int ioplusMotionQueue(IoplusMotionType *m, int ch,
+	const IoplusMoveType *mv);
+/* one pass, waitUs (may be NULL) gets the time until the next call is due */
+IOPLUS_API int ioplusMotionPoll(IoplusBoardType *board, IoplusMotionType *m,
+	uint32_t *waitUs);
+/* poll until every queue is empty, IOPLUS_ERR_TIMEOUT after timeoutMs
+ * (0 waits forever) */
+IOPLUS_API int ioplusMotionRun(IoplusBoardType *board, IoplusMotionType *m,
+	uint32_t timeoutMs);
+/* stop the pulses and cancel the queue of ch, every channel for ch 0 */
+IOPLUS_API int ioplusMotionStop(IoplusBoardType *board, IoplusMotionType *m,
+	int ch);
+/* segments pending on ch, the running one included, all channels for ch 0 */
+IOPLUS_API int ioplusMotionPending(IoplusMotionType *m, int ch);
+IOPLUS_API int ioplusMotionStatsGet(IoplusMotionType *m, int ch,
+	IoplusMotionStatsType *stats);
+IOPLUS_API void ioplusMotionStatsReset(IoplusMotionType *m);
+
+/* Interlock rules: one rule per line, "<output> = <condition>", with # for
+ * comments. Outputs are relay<n>, gpio<n> and od<n> (pwm 0 or 100%).
+ * Conditions combine opto<n>, gpio<n>, relay<n>, 0, 1 and comparisons
+ * adc<n> > / < <V> and owb<n> > / < <degC>, with an optional hysteresis
+ * "~ <delta>", using ! & | and parentheses. The rules are compiled into one
+ * flat table of stack machine ops evaluated in a single pass. On failure
+ * IOPLUS_ERR_ARG is returned with errLine and err set. */
+IOPLUS_API int ioplusRulesCompile(IoplusRulesType *r, const char *text);
+/* compile the rules of a file of up to 65535 bytes, a larger one fails */
+IOPLUS_API int ioplusRulesLoad(IoplusRulesType *r, const char *path);
+/* evaluate the rules on in, out gets the IOPLUS_RULE_OUT_xxx bits */
+IOPLUS_API int ioplusRulesEval(IoplusRulesType *r, const IoplusSnapshotType *in,
+	uint32_t *out);
+/* read the inputs the rules use, evaluate them and write the outputs that
+ * changed in one transaction, changed (may be NULL) gets the written bits */
+IOPLUS_API int ioplusRulesStep(IoplusBoardType *board, IoplusRulesType *r,
+	uint32_t *changed);
+IOPLUS_API int ioplusRulesStatsGet(IoplusRulesType *r,
+	IoplusRulesStatsType *stats);
+IOPLUS_API void ioplusRulesStatsReset(IoplusRulesType *r);
+
+/* Attention line: a Raspberry Pi GPIO that changes with the card inputs, a
+ * field signal wired in parallel with an opto input or a card output driven
+ * from them, requested with edge events through the gpio character device.
+ * ioplusAttnWait() sleeps until an edge, or until fallbackMs after the last
+ * read to catch the changes the line does not signal, then reads the parts
+ * (IOPLUS_SNAP_xxx) of the card into snap. Edges queued while reading are
+ * merged into the next read. chip is a gpiochip number, name or path, edge
+ * an IOPLUS_EDGE_xxx value and debounceUs 0 to keep the kernel default. */
+IOPLUS_API int ioplusAttnOpen(IoplusAttnType *a, const char *chip, int line,
+	int edge, uint32_t debounceUs, uint32_t fallbackMs);
+/* edge (may be NULL) is 1 when the read was triggered by the line */
+IOPLUS_API int ioplusAttnWait(IoplusBoardType *board, IoplusAttnType *a,
+	IoplusSnapshotType *snap, int parts, int *edge);
+IOPLUS_API void ioplusAttnClose(IoplusAttnType *a);
+IOPLUS_API int ioplusAttnStatsGet(IoplusAttnType *a,
+	IoplusAttnStatsType *stats);
+
+/* Asynchronous register access: any thread submits requests without
+ * blocking (lock free, in submit order), one I/O thread per queue runs them
+ * under the bus semaphore. Consecutive reads of adjacent or overlapping
+ * registers of one card are done in a single transfer. A request completes,
+ * once the batch released the semaphore, through its callback, its eventfd,
+ * ioplusAsyncDone() or ioplusAsyncWait().
+ * The request is marked done before the callback runs, so a callback may
+ * submit it again but must not be combined with a wait on it. The boards
+ * must not be used directly by other threads while the queue runs. */
+IOPLUS_API int ioplusAsyncStart(IoplusAsyncType *q);
+/* runs the requests already submitted, then ends the I/O thread */
+IOPLUS_API int ioplusAsyncStop(IoplusAsyncType *q);
+/* fill req for a read or a write, no callback and no eventfd */
+IOPLUS_API int ioplusAsyncReqInit(IoplusAsyncReqType *req,
+	IoplusBoardType *board, int op, int add, uint8_t *buf, int size);
+IOPLUS_API int ioplusAsyncSubmit(IoplusAsyncType *q, IoplusAsyncReqType *req);
+/* 1 once req is done, its result and buffer are then valid */
+IOPLUS_API int ioplusAsyncDone(IoplusAsyncReqType *req);
+/* block until req is done, returns its result */
+IOPLUS_API int ioplusAsyncWait(IoplusAsyncType *q, IoplusAsyncReqType *req);
+IOPLUS_API int ioplusAsyncStatsGet(IoplusAsyncType *q,
+	IoplusAsyncStatsType *stats);
+IOPLUS_API void ioplusAsyncStatsReset(IoplusAsyncType *q);
+
+/* Read planner: the bytes of a field set are read with the block transfers
+ * of lowest predicted time, merging fields across the gaps between them
+ * when one transfer more costs more than the gap bytes. The cost model is
+ * the 100 kHz bus default or measured with ioplusCostCalibrate(), which
+ * times reads of several sizes. ioplusPlanRun() reads the fields into img,
+ * an image of the whole map (IOPLUS_MAP_SIZE bytes), each byte at its
+ * address: decode it with the IOPLUS_MEM_xxx(img, 0, ...) accessors. */
+IOPLUS_API void ioplusFieldClear(IoplusFieldSetType *set);
+IOPLUS_API int ioplusFieldAdd(IoplusFieldSetType *set, int add, int size);
+IOPLUS_API void ioplusCostDefault(IoplusCostType *cost);
+IOPLUS_API int ioplusCostCalibrate(IoplusBoardType *board,
+	IoplusCostType *cost);
+IOPLUS_API int ioplusPlanMake(IoplusPlanType *plan, const IoplusCostType *cost,
+	const IoplusFieldSetType *set);
+IOPLUS_API int ioplusPlanRun(IoplusBoardType *board, const IoplusPlanType *plan,
+	uint8_t *img);
+/* the default cost model when cost is NULL */
+IOPLUS_API void ioplusPlanCacheInit(IoplusPlanCacheType *cache,
+	const IoplusCostType *cost);
+/* the plan of set, made on the first use; it stays valid until
+ * IOPLUS_PLAN_CACHE_NO other sets are asked for */
+IOPLUS_API int ioplusPlanCacheGet(IoplusPlanCacheType *cache,
+	const IoplusFieldSetType *set, const IoplusPlanType **plan);
+
+/* watchdog periods in seconds */
+IOPLUS_API int ioplusWdtReload(IoplusBoardType *board);
+IOPLUS_API int ioplusWdtPeriodGet(IoplusBoardType *board, uint16_t *sec);
+IOPLUS_API int ioplusWdtPeriodSet(IoplusBoardType *board, uint16_t sec);
+IOPLUS_API int ioplusWdtInitPeriodGet(IoplusBoardType *board, uint16_t *sec);
+IOPLUS_API int ioplusWdtInitPeriodSet(IoplusBoardType *board, uint16_t sec);
+IOPLUS_API int ioplusWdtOffPeriodGet(IoplusBoardType *board, uint32_t *sec);
+IOPLUS_API int ioplusWdtOffPeriodSet(IoplusBoardType *board, uint32_t sec);
+/* card resets done by the watchdog */
+IOPLUS_API int ioplusWdtResetCountGet(IoplusBoardType *board, uint16_t *count);
+
+/* processor temperature in degC and 3.3V rail in millivolts */
+IOPLUS_API int ioplusDiagGet(IoplusBoardType *board, int *temp, uint16_t *mV);
+
+/* one wire bus temperatures in 0.01 degC, returns the number of sensors in cnt */
+IOPLUS_API int ioplusOwbTempGetAll(IoplusBoardType *board, int16_t *temp,
+	int *cnt);
+IOPLUS_API int ioplusOwbSensCountGet(IoplusBoardType *board, int *cnt);
+IOPLUS_API int ioplusOwbTempGet(IoplusBoardType *board, int ch, int16_t *temp);
+IOPLUS_API int ioplusOwbRomGet(IoplusBoardType *board, int ch, uint64_t *rom);
+IOPLUS_API int ioplusOwbScan(IoplusBoardType *board);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif //LIBIOPLUS_H_
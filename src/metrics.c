@@ -0,0 +1,702 @@
+/*
+ * metrics.c:
+ *	Prometheus exporter for all the cards found on the bus. A poller thread
+ *	reads the cards every period and renders the whole page in a back
+ *	buffer swapped in when complete; a scrape only copies the last page, it
+ *	never waits for the bus and costs the same whatever the number of cards.
+ *
+ *	Copyright (c) 2016-2023 Sequent Microsystem
+ *	<http://www.sequentmicrosystem.com>
+ ***********************************************************************
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdarg.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <signal.h>
+#include <unistd.h>
+#include <poll.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+#include "ioplus.h"
+#include "libioplus.h"
+#include "comm.h"
+
+#define MET_ADDRESS	"127.0.0.1"
+#define MET_PORT	9712
+#define MET_PERIOD_MS	1000
+#define MET_PAGE_SIZE	(128 * 1024)
+#define MET_REQ_MAX	1024
+#define MET_IO_TIMEOUT_MS	2000
+// a card failing 3 transfers in a row is skipped, probed after 2s then up to
+// every minute, so it can not slow down the polls of the other cards
+#define MET_BRK_ERRORS	3
+#define MET_BRK_PROBE_MS	2000
+#define MET_BRK_PROBE_MAX_MS	60000
+// EIO / ETIMEDOUT on 3 transfers in a row from two cards or more is a stuck
+// bus; a lone card failing is left to its breaker
+#define MET_RECOVER_ERRORS	3
+
+typedef struct
+{
+	int present;
+	IoplusBoardType board;
+	int up; // last poll complete
+	IoplusSnapshotType snap;
+	uint16_t wdtResets;
+	uint32_t polls;
+	uint32_t errors;
+	uint32_t pollUs; // last poll
+	IoplusHealthType health;
+} MetBoardType;
+
+typedef struct
+{
+	char *buff;
+	int len;
+} MetPageType;
+
+typedef struct
+{
+	MetBoardType board[IOPLUS_STACK_MAX];
+	uint32_t periodMs;
+	pthread_mutex_t lock;
+	MetPageType page[2];
+	MetPageType *front; // served, swapped under lock
+	MetPageType *back; // rendered by the poller
+	uint64_t renderMs; // when front was rendered
+	uint32_t renderUs;
+	uint32_t scrapes;
+} MetServerType;
+
+typedef double (*MetValueType)(const MetBoardType *b, int ch);
+
+static uint64_t metNowUs(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+static void pageAdd(MetPageType *p, const char *fmt, ...)
+{
+	va_list args;
+	int n;
+
+	va_start(args, fmt);
+	n = vsnprintf(p->buff + p->len, MET_PAGE_SIZE - p->len, fmt, args);
+	va_end(args);
+	if ( (n > 0) && (p->len + n < MET_PAGE_SIZE))
+	{
+		p->len += n;
+	}
+}
+
+static void pageFamily(MetPageType *p, const char *name, const char *type,
+	const char *help)
+{
+	pageAdd(p, "# HELP ioplus_%s %s\n# TYPE ioplus_%s %s\n", name, help, name,
+		type);
+}
+
+/* one family with a sample per channel of every card up, no channel label
+ * when chNo is 1 */
+static void pageChannels(MetPageType *p, MetServerType *m, const char *name,
+	const char *type, const char *help, const char *label, int chNo,
+	MetValueType val)
+{
+	const MetBoardType *b;
+	int s;
+	int ch;
+
+	pageFamily(p, name, type, help);
+	for (s = 0; s < IOPLUS_STACK_MAX; s++)
+	{
+		b = &m->board[s];
+		if (!b->present || !b->up)
+		{
+			continue;
+		}
+		for (ch = 0; ch < chNo; ch++)
+		{
+			if (chNo == 1)
+			{
+				pageAdd(p, "ioplus_%s{stack=\"%d\"} %.10g\n", name, s, val(b, ch));
+			}
+			else
+			{
+				pageAdd(p, "ioplus_%s{stack=\"%d\",%s=\"%d\"} %.10g\n", name, s, label,
+					ch + 1, val(b, ch));
+			}
+		}
+	}
+}
+
+static double valCpuTemp(const MetBoardType *b, int ch)
+{
+	(void)ch;
+	return b->snap.cpuTemp;
+}
+
+static double valV3v3(const MetBoardType *b, int ch)
+{
+	(void)ch;
+	return b->snap.v3v3Mv / 1000.0;
+}
+
+static double valWdtResets(const MetBoardType *b, int ch)
+{
+	(void)ch;
+	return b->wdtResets;
+}
+
+static double valAdc(const MetBoardType *b, int ch)
+{
+	return b->snap.adcMv[ch] / 1000.0;
+}
+
+static double valDac(const MetBoardType *b, int ch)
+{
+	return b->snap.dacMv[ch] / 1000.0;
+}
+
+static double valOd(const MetBoardType *b, int ch)
+{
+	return (double)b->snap.odPwm[ch] / IOPLUS_OD_PWM_MAX;
+}
+
+static double valRelay(const MetBoardType *b, int ch)
+{
+	return (b->snap.relay >> ch) & 1;
+}
+
+static double valOpto(const MetBoardType *b, int ch)
+{
+	return (b->snap.opto >> ch) & 1;
+}
+
+static double valGpio(const MetBoardType *b, int ch)
+{
+	return (b->snap.gpio >> ch) & 1;
+}
+
+static double valOptoCnt(const MetBoardType *b, int ch)
+{
+	return b->snap.cnt[IOPLUS_CNT_OPTO + ch];
+}
+
+static double valGpioCnt(const MetBoardType *b, int ch)
+{
+	return b->snap.cnt[IOPLUS_CNT_GPIO + ch];
+}
+
+static double valOptoEnc(const MetBoardType *b, int ch)
+{
+	return (int32_t)b->snap.cnt[IOPLUS_CNT_OPTO_ENC + ch];
+}
+
+static double valGpioEnc(const MetBoardType *b, int ch)
+{
+	(void)ch;
+	return (int32_t)b->snap.cnt[IOPLUS_CNT_GPIO_ENC];
+}
+
+static double valOdPulses(const MetBoardType *b, int ch)
+{
+	return b->snap.cnt[IOPLUS_CNT_OD + ch];
+}
+
+static void pageBoards(MetPageType *p, MetServerType *m)
+{
+	const MetBoardType *b;
+	int s;
+	int i;
+
+	pageFamily(p, "up", "gauge", "1 if the last poll of the card succeeded");
+	for (s = 0; s < IOPLUS_STACK_MAX; s++)
+	{
+		if (m->board[s].present)
+		{
+			pageAdd(p, "ioplus_up{stack=\"%d\"} %d\n", s, m->board[s].up);
+		}
+	}
+	pageFamily(p, "info", "gauge", "Card hardware and firmware versions");
+	for (s = 0; s < IOPLUS_STACK_MAX; s++)
+	{
+		b = &m->board[s];
+		if (b->present)
+		{
+			pageAdd(p, "ioplus_info{stack=\"%d\",hardware=\"%d.%d\",firmware=\"%d.%02d\"} 1\n",
+				s, b->board.hwMajor, b->board.hwMinor, b->board.fwMajor,
+				b->board.fwMinor);
+		}
+	}
+	pageFamily(p, "polls_total", "counter", "Polls of the card");
+	for (s = 0; s < IOPLUS_STACK_MAX; s++)
+	{
+		if (m->board[s].present)
+		{
+			pageAdd(p, "ioplus_polls_total{stack=\"%d\"} %u\n", s, m->board[s].polls);
+		}
+	}
+	pageFamily(p, "poll_errors_total", "counter", "Polls of the card that failed");
+	for (s = 0; s < IOPLUS_STACK_MAX; s++)
+	{
+		if (m->board[s].present)
+		{
+			pageAdd(p, "ioplus_poll_errors_total{stack=\"%d\"} %u\n", s,
+				m->board[s].errors);
+		}
+	}
+	pageFamily(p, "poll_duration_seconds", "gauge", "Duration of the last poll");
+	for (s = 0; s < IOPLUS_STACK_MAX; s++)
+	{
+		if (m->board[s].present)
+		{
+			pageAdd(p, "ioplus_poll_duration_seconds{stack=\"%d\"} %.6f\n", s,
+				m->board[s].pollUs / 1e6);
+		}
+	}
+	pageFamily(p, "breaker_state", "gauge",
+		"Card circuit breaker, 0 closed, 1 open (card skipped), 2 probing");
+	for (s = 0; s < IOPLUS_STACK_MAX; s++)
+	{
+		if (m->board[s].present)
+		{
+			pageAdd(p, "ioplus_breaker_state{stack=\"%d\"} %d\n", s,
+				m->board[s].health.state);
+		}
+	}
+	pageFamily(p, "breaker_trips_total", "counter",
+		"Times the card was skipped after repeated I2C errors");
+	for (s = 0; s < IOPLUS_STACK_MAX; s++)
+	{
+		if (m->board[s].present)
+		{
+			pageAdd(p, "ioplus_breaker_trips_total{stack=\"%d\"} %u\n", s,
+				m->board[s].health.trips);
+		}
+	}
+	pageFamily(p, "breaker_skipped_total", "counter",
+		"I2C transfers to the card failed at once, circuit open");
+	for (s = 0; s < IOPLUS_STACK_MAX; s++)
+	{
+		if (m->board[s].present)
+		{
+			pageAdd(p, "ioplus_breaker_skipped_total{stack=\"%d\"} %u\n", s,
+				m->board[s].health.skipped);
+		}
+	}
+	pageChannels(p, m, "cpu_temperature_celsius", "gauge",
+		"Card processor temperature", NULL, 1, valCpuTemp);
+	pageChannels(p, m, "supply_3v3_volts", "gauge", "Card 3.3V rail", NULL, 1,
+		valV3v3);
+	pageChannels(p, m, "wdt_resets_total", "counter",
+		"Raspberry Pi power cycles done by the watchdog", NULL, 1, valWdtResets);
+	pageChannels(p, m, "adc_volts", "gauge", "Analog input", "channel",
+		IOPLUS_ADC_CH_NO, valAdc);
+	pageChannels(p, m, "dac_volts", "gauge", "Analog output", "channel",
+		IOPLUS_DAC_CH_NO, valDac);
+	pageChannels(p, m, "od_pwm_ratio", "gauge", "Open drain output duty cycle",
+		"channel", IOPLUS_OD_CH_NO, valOd);
+	pageChannels(p, m, "relay_state", "gauge", "Relay, 1 when energized",
+		"channel", IOPLUS_RELAY_CH_NO, valRelay);
+	pageChannels(p, m, "opto_state", "gauge", "Optocoupled input",
+		"channel", IOPLUS_OPTO_CH_NO, valOpto);
+	pageChannels(p, m, "gpio_state", "gauge", "GPIO pin level", "channel",
+		IOPLUS_GPIO_CH_NO, valGpio);
+	pageChannels(p, m, "opto_edges_total", "counter",
+		"Optocoupled input edge counter, restarts with the card", "channel",
+		IOPLUS_OPTO_CH_NO, valOptoCnt);
+	pageChannels(p, m, "gpio_edges_total", "counter",
+		"GPIO edge counter, restarts with the card", "channel",
+		IOPLUS_GPIO_CH_NO, valGpioCnt);
+	pageChannels(p, m, "opto_encoder_count", "gauge",
+		"Optocoupled inputs quadrature encoder", "encoder", IOPLUS_OPTO_CH_NO / 2, valOptoEnc);
+	pageChannels(p, m, "gpio_encoder_count", "gauge",
+		"GPIO quadrature encoder", NULL, 1, valGpioEnc);
+	pageChannels(p, m, "od_pulses_pending", "gauge",
+		"Open drain pulses left to generate", "channel", IOPLUS_OD_CH_NO,
+		valOdPulses);
+	pageFamily(p, "owb_temperature_celsius", "gauge", "1-Wire bus temperature");
+	for (s = 0; s < IOPLUS_STACK_MAX; s++)
+	{
+		b = &m->board[s];
+		for (i = 0; b->present && b->up && (i < b->snap.owbCnt)
+			&& (i < IOPLUS_OWB_SENS_NO); i++)
+		{
+			pageAdd(p, "ioplus_owb_temperature_celsius{stack=\"%d\",sensor=\"%d\"} %.2f\n",
+				s, i + 1, b->snap.owbTemp[i] / 100.0);
+		}
+	}
+}
+
+static void pageBus(MetPageType *p)
+{
+	static const char *opName[I2C_OP_NO] = {"read", "write"};
+	I2cStatType st[I2C_OP_NO];
+	IoplusRecoverStatsType rec;
+	int op;
+
+	for (op = 0; op < I2C_OP_NO; op++)
+	{
+		i2cStatsGet(op, &st[op]);
+	}
+	pageFamily(p, "i2c_transactions_total", "counter",
+		"I2C transactions of this process");
+	for (op = 0; op < I2C_OP_NO; op++)
+	{
+		pageAdd(p, "ioplus_i2c_transactions_total{op=\"%s\"} %u\n", opName[op],
+			st[op].count);
+	}
+	pageFamily(p, "i2c_errors_total", "counter", "I2C transactions that failed");
+	for (op = 0; op < I2C_OP_NO; op++)
+	{
+		pageAdd(p, "ioplus_i2c_errors_total{op=\"%s\"} %u\n", opName[op],
+			st[op].errors);
+	}
+	pageFamily(p, "i2c_bytes_total", "counter", "I2C payload bytes transferred");
+	for (op = 0; op < I2C_OP_NO; op++)
+	{
+		pageAdd(p, "ioplus_i2c_bytes_total{op=\"%s\"} %llu\n", opName[op],
+			(unsigned long long)st[op].bytes);
+	}
+	pageFamily(p, "i2c_latency_seconds", "summary", "I2C transaction duration");
+	for (op = 0; op < I2C_OP_NO; op++)
+	{
+		pageAdd(p, "ioplus_i2c_latency_seconds{op=\"%s\",quantile=\"0.5\"} %.6f\n",
+			opName[op], st[op].p50Us / 1e6);
+		pageAdd(p, "ioplus_i2c_latency_seconds{op=\"%s\",quantile=\"0.99\"} %.6f\n",
+			opName[op], st[op].p99Us / 1e6);
+		pageAdd(p, "ioplus_i2c_latency_seconds_sum{op=\"%s\"} %.6f\n", opName[op],
+			st[op].totalUs / 1e6);
+		pageAdd(p, "ioplus_i2c_latency_seconds_count{op=\"%s\"} %u\n", opName[op],
+			st[op].count);
+	}
+	pageFamily(p, "i2c_latency_max_seconds", "gauge",
+		"Longest I2C transaction since start");
+	for (op = 0; op < I2C_OP_NO; op++)
+	{
+		pageAdd(p, "ioplus_i2c_latency_max_seconds{op=\"%s\"} %.6f\n", opName[op],
+			st[op].maxUs / 1e6);
+	}
+	pageFamily(p, "i2c_antispurious_retries_total", "counter",
+		"Reads repeated because two copies of a value did not match");
+	pageAdd(p, "ioplus_i2c_antispurious_retries_total %u\n", st[0].asRetries);
+	ioplusBusRecoverStatsGet(&rec);
+	pageFamily(p, "i2c_bus_recoveries_total", "counter",
+		"Stuck I2C bus recoveries, by result");
+	pageAdd(p, "ioplus_i2c_bus_recoveries_total{result=\"ok\"} %u\n",
+		rec.recovered);
+	pageAdd(p, "ioplus_i2c_bus_recoveries_total{result=\"failed\"} %u\n",
+		rec.failed);
+	pageFamily(p, "i2c_bus_recovery_seconds", "gauge",
+		"Duration of the last stuck I2C bus recovery");
+	pageAdd(p, "ioplus_i2c_bus_recovery_seconds %.6f\n", rec.lastUs / 1e6);
+	pageFamily(p, "i2c_bus_recovery_max_seconds", "gauge",
+		"Longest stuck I2C bus recovery since start");
+	pageAdd(p, "ioplus_i2c_bus_recovery_max_seconds %.6f\n", rec.maxUs / 1e6);
+}
+
+static void boardPoll(MetBoardType *b)
+{
+	uint64_t start = metNowUs();
+	int ret;
+
+	b->polls++;
+	ret = ioplusSnapshotGet(&b->board, &b->snap);
+	if (ret == IOPLUS_OK)
+	{
+		ret = ioplusWdtResetCountGet(&b->board, &b->wdtResets);
+	}
+	b->up = (ret == IOPLUS_OK);
+	if (!b->up)
+	{
+		b->errors++;
+	}
+	ioplusHealthGet(&b->board, &b->health);
+	b->pollUs = (uint32_t) (metNowUs() - start);
+}
+
+/* poll every card, render the page and make it the one served */
+static void metRound(MetServerType *m)
+{
+	MetPageType *p;
+	uint64_t start = metNowUs();
+	int s;
+
+	for (s = 0; s < IOPLUS_STACK_MAX; s++)
+	{
+		if (m->board[s].present)
+		{
+			boardPoll(&m->board[s]);
+		}
+	}
+	m->back->len = 0;
+	pageBoards(m->back, m);
+	pageBus(m->back);
+	pthread_mutex_lock(&m->lock);
+	p = m->front;
+	m->front = m->back;
+	m->back = p;
+	m->renderMs = metNowUs() / 1000;
+	m->renderUs = (uint32_t) (metNowUs() - start);
+	pthread_mutex_unlock(&m->lock);
+}
+
+static void* metPoller(void *arg)
+{
+	MetServerType *m = arg;
+	struct timespec next;
+
+	clock_gettime(CLOCK_MONOTONIC, &next);
+	while (!gRunStop)
+	{
+		next.tv_nsec += (long) (m->periodMs % 1000) * 1000000;
+		next.tv_sec += m->periodMs / 1000 + next.tv_nsec / 1000000000;
+		next.tv_nsec %= 1000000000;
+		clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, NULL);
+		metRound(m);
+	}
+	return NULL;
+}
+
+static int sendAll(int fd, const char *buff, int len)
+{
+	int n;
+
+	while (len > 0)
+	{
+		n = (int)send(fd, buff, len, MSG_NOSIGNAL);
+		if (n <= 0)
+		{
+			return ERROR;
+		}
+		buff += n;
+		len -= n;
+	}
+	return OK;
+}
+
+static void httpReply(int fd, const char *status, const char *body, int len)
+{
+	char hdr[256];
+	int n;
+
+	n = snprintf(hdr, sizeof(hdr), "HTTP/1.1 %s\r\n"
+		"Content-Type: text/plain; version=0.0.4; charset=utf-8\r\n"
+		"Content-Length: %d\r\nConnection: close\r\n\r\n", status, len);
+	if (OK == sendAll(fd, hdr, n))
+	{
+		sendAll(fd, body, len);
+	}
+}
+
+/* one request per connection, only the request line is looked at */
+static void httpServe(MetServerType *m, int fd, char *page)
+{
+	char req[MET_REQ_MAX];
+	struct timeval tv;
+	int len = 0;
+	int n;
+
+	tv.tv_sec = MET_IO_TIMEOUT_MS / 1000;
+	tv.tv_usec = (MET_IO_TIMEOUT_MS % 1000) * 1000;
+	setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+	setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+	while (len < MET_REQ_MAX - 1)
+	{
+		n = (int)recv(fd, req + len, MET_REQ_MAX - 1 - len, 0);
+		if (n <= 0)
+		{
+			return;
+		}
+		len += n;
+		req[len] = 0;
+		if (NULL != strstr(req, "\r\n\r\n"))
+		{
+			break;
+		}
+	}
+	if (0 != strncmp(req, "GET ", 4))
+	{
+		httpReply(fd, "405 Method Not Allowed", "", 0);
+		return;
+	}
+	if ( (0 == strncmp(req + 4, "/metrics ", 9))
+		|| (0 == strncmp(req + 4, "/metrics?", 9)))
+	{
+		pthread_mutex_lock(&m->lock);
+		len = m->front->len;
+		memcpy(page, m->front->buff, len);
+		n = (int) (metNowUs() / 1000 - m->renderMs);
+		m->scrapes++;
+		pthread_mutex_unlock(&m->lock);
+		len += snprintf(page + len, MET_REQ_MAX,
+			"# HELP ioplus_cache_age_seconds Time since the page was rendered\n"
+			"# TYPE ioplus_cache_age_seconds gauge\n"
+			"ioplus_cache_age_seconds %.3f\n", n / 1000.0);
+		httpReply(fd, "200 OK", page, len);
+		return;
+	}
+	if (0 == strncmp(req + 4, "/ ", 2))
+	{
+		httpReply(fd, "200 OK", "ioplus exporter, metrics at /metrics\n", 37);
+		return;
+	}
+	httpReply(fd, "404 Not Found", "", 0);
+}
+
+static int metListen(const char *address, int port)
+{
+	struct sockaddr_in add;
+	int one = 1;
+	int fd;
+
+	memset(&add, 0, sizeof(add));
+	add.sin_family = AF_INET;
+	add.sin_port = htons((uint16_t)port);
+	if (1 != inet_pton(AF_INET, address, &add.sin_addr))
+	{
+		errno = EINVAL;
+		return -1;
+	}
+	fd = socket(AF_INET, SOCK_STREAM, 0);
+	if (fd < 0)
+	{
+		return -1;
+	}
+	setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+	if ( (0 != bind(fd, (struct sockaddr*)&add, sizeof(add)))
+		|| (0 != listen(fd, 8)))
+	{
+		close(fd);
+		return -1;
+	}
+	return fd;
+}
+
+int doMetrics(int argc, char *argv[])
+{
+	static MetServerType m;
+	static char page[MET_PAGE_SIZE + MET_REQ_MAX];
+	char address[64] = MET_ADDRESS;
+	IoplusBreakerType brk;
+	IoplusRecoverType rec;
+	struct pollfd pfd;
+	pthread_t poller;
+	char *sep;
+	int port = MET_PORT;
+	int boards = 0;
+	int fd;
+	int s;
+
+	if (argc > 4)
+	{
+		return ARG_CNT_ERR;
+	}
+	memset(&m, 0, sizeof(m));
+	m.periodMs = MET_PERIOD_MS;
+	if (argc > 2)
+	{
+		// [<address>:]<port>
+		sep = strrchr(argv[2], ':');
+		if ( (NULL != sep) && (sep - argv[2] < (int)sizeof(address)))
+		{
+			memcpy(address, argv[2], sep - argv[2]);
+			address[sep - argv[2]] = 0;
+		}
+		port = atoi( (NULL != sep) ? sep + 1 : argv[2]);
+	}
+	if (argc > 3)
+	{
+		m.periodMs = (uint32_t)atoi(argv[3]);
+	}
+	if ( (port < 1) || (port > 65535) || (m.periodMs < 1))
+	{
+		printf("Invalid port or poll period!\n");
+		return ARG_ERR;
+	}
+	for (s = 0; s < IOPLUS_STACK_MAX; s++)
+	{
+		m.board[s].present = (IOPLUS_OK == ioplusOpen(&m.board[s].board, s));
+		boards += m.board[s].present;
+	}
+	brk.errors = MET_BRK_ERRORS;
+	brk.probeMs = MET_BRK_PROBE_MS;
+	brk.probeMaxMs = MET_BRK_PROBE_MAX_MS;
+	ioplusBreakerSet(&brk);
+	rec.errors = MET_RECOVER_ERRORS;
+	rec.step = IOPLUS_RECOVER_REOPEN;
+	ioplusBusRecoverSet(&rec);
+	if (boards == 0)
+	{
+		printf("No IO-PLUS card detected!\n");
+		return ERROR;
+	}
+	pfd.fd = metListen(address, port);
+	if (pfd.fd < 0)
+	{
+		printf("Fail to listen on %s:%d: %s!\n", address, port, strerror(errno));
+		return ERROR;
+	}
+	m.page[0].buff = malloc(MET_PAGE_SIZE);
+	m.page[1].buff = malloc(MET_PAGE_SIZE);
+	if ( (NULL == m.page[0].buff) || (NULL == m.page[1].buff))
+	{
+		close(pfd.fd);
+		return ERROR;
+	}
+	m.front = &m.page[0];
+	m.back = &m.page[1];
+	pthread_mutex_init(&m.lock, NULL);
+	// the poller owns the bus from here on, the first page is ready before
+	// the first scrape
+	i2cStatsEnable(1);
+	metRound(&m);
+	busTokenRelease();
+	if (0 != pthread_create(&poller, NULL, metPoller, &m))
+	{
+		close(pfd.fd);
+		return ERROR;
+	}
+	signal(SIGINT, runStop);
+	signal(SIGTERM, runStop);
+	signal(SIGPIPE, SIG_IGN);
+	printf("Serving %d card(s) on http://%s:%d/metrics\n", boards, address, port);
+	fflush(stdout);
+
+	pfd.events = POLLIN;
+	while (!gRunStop)
+	{
+		// poll() is never restarted, a signal ends the wait
+		if (poll(&pfd, 1, -1) <= 0)
+		{
+			continue;
+		}
+		fd = accept(pfd.fd, NULL, NULL);
+		if (fd >= 0)
+		{
+			httpServe(&m, fd, page);
+			close(fd);
+		}
+	}
+	pthread_join(poller, NULL);
+	close(pfd.fd);
+	for (s = 0; s < IOPLUS_STACK_MAX; s++)
+	{
+		ioplusClose(&m.board[s].board);
+	}
+	printf("%u scrapes, last page %d bytes rendered in %u us\n", m.scrapes,
+		m.front->len, m.renderUs);
+	free(m.page[0].buff);
+	free(m.page[1].buff);
+	return OK;
+}
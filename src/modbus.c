@@ -0,0 +1,821 @@
+/*
+ * modbus.c:
+ *	Modbus TCP server for one card. Reads are answered from a snapshot of
+ *	the card refreshed every period, writes from all the clients served in
+ *	one pass of the event loop are staged in a single output transaction and
+ *	acknowledged once it is committed.
+ *
+ *	Copyright (c) 2016-2023 Sequent Microsystem
+ *	<http://www.sequentmicrosystem.com>
+ ***********************************************************************
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <signal.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <sys/epoll.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+
+#include "ioplus.h"
+#include "libioplus.h"
+
+#define MB_PORT	502
+#define MB_REFRESH_MS	50
+#define MB_CLIENT_MAX	64
+#define MB_EVENTS_MAX	16
+#define MB_BACKLOG	16
+#define MB_RX_SIZE	1024
+#define MB_TX_SIZE	4096
+#define MB_HDR_SIZE	7 // MBAP: transaction, protocol, length, unit
+#define MB_FRAME_MAX	260 // MBAP and the longest PDU
+#define MB_WRITE_ACK_SIZE	12 // MBAP, function, address and value / quantity
+
+#define MB_FC_READ_COILS	1
+#define MB_FC_READ_DISCRETE	2
+#define MB_FC_READ_HOLDING	3
+#define MB_FC_READ_INPUT	4
+#define MB_FC_WRITE_COIL	5
+#define MB_FC_WRITE_REG	6
+#define MB_FC_WRITE_COILS	15
+#define MB_FC_WRITE_REGS	16
+
+#define MB_EX_FUNCTION	1
+#define MB_EX_ADDRESS	2
+#define MB_EX_VALUE	3
+#define MB_EX_DEVICE	4
+
+#define MB_BITS_READ_MAX	2000
+#define MB_BITS_WRITE_MAX	1968
+#define MB_REGS_READ_MAX	125
+#define MB_REGS_WRITE_MAX	123
+
+/* coils and discrete inputs: relays / opto 1..8 then gpio 1..4 */
+#define MB_COIL_GPIO	8
+#define MB_COIL_NO	12
+#define MB_DISC_NO	12
+
+/* input registers */
+#define MB_IR_ADC	0 // 8 x mV
+#define MB_IR_CPU_TEMP	8 // degC
+#define MB_IR_V3V3	9 // mV
+#define MB_IR_OWB_CNT	10
+#define MB_IR_OWB	11 // 8 x 0.01 degC, signed
+#define MB_IR_CNT	20 // IOPLUS_CNT_NO x 32 bits, high word first
+#define MB_IR_NO	(MB_IR_CNT + 2 * IOPLUS_CNT_NO)
+
+/* holding registers */
+#define MB_HR_DAC	0 // 4 x mV
+#define MB_HR_OD	4 // 4 x 0.01%
+#define MB_HR_NO	8
+
+typedef struct
+{
+	int fd;
+	uint8_t in[MB_RX_SIZE];
+	int inLen;
+	uint8_t out[MB_TX_SIZE];
+	int outLen;
+	uint32_t events; // epoll interest
+	int pending; // write staged, ack held until the commit
+	uint8_t ack[MB_WRITE_ACK_SIZE];
+} MbClientType;
+
+typedef struct
+{
+	uint32_t connections;
+	uint32_t rejected; // no client slot left
+	uint32_t requests;
+	uint32_t exceptions;
+	uint32_t commits;
+	uint32_t writes; // requests acknowledged by the commits
+	uint32_t refreshes;
+	uint32_t refreshErrors;
+} MbStatsType;
+
+typedef struct
+{
+	IoplusBoardType *board;
+	int listenFd;
+	int epollFd;
+	uint32_t refreshMs;
+	uint64_t refreshDue;
+	int cacheValid;
+	IoplusSnapshotType cache;
+	IoplusTxType tx; // writes of the pass, committed even when their client left
+	MbClientType client[MB_CLIENT_MAX];
+	MbStatsType stats;
+} MbServerType;
+
+static uint64_t mbNowMs(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+static uint16_t get16(const uint8_t *buff)
+{
+	return (uint16_t) ( (buff[0] << 8) | buff[1]);
+}
+
+static void put16(uint8_t *buff, uint16_t val)
+{
+	buff[0] = (uint8_t) (val >> 8);
+	buff[1] = (uint8_t)val;
+}
+
+static int coilGet(const IoplusSnapshotType *s, int add)
+{
+	if (add < MB_COIL_GPIO)
+	{
+		return (s->relay >> add) & 1;
+	}
+	return (s->gpio >> (add - MB_COIL_GPIO)) & 1;
+}
+
+static int discreteGet(const IoplusSnapshotType *s, int add)
+{
+	if (add < MB_COIL_GPIO)
+	{
+		return (s->opto >> add) & 1;
+	}
+	return (s->gpio >> (add - MB_COIL_GPIO)) & 1;
+}
+
+static uint16_t inputGet(const IoplusSnapshotType *s, int add)
+{
+	int cnt;
+
+	if (add < MB_IR_CPU_TEMP)
+	{
+		return s->adcMv[add - MB_IR_ADC];
+	}
+	if (add == MB_IR_CPU_TEMP)
+	{
+		return (uint16_t)s->cpuTemp;
+	}
+	if (add == MB_IR_V3V3)
+	{
+		return s->v3v3Mv;
+	}
+	if (add == MB_IR_OWB_CNT)
+	{
+		return (uint16_t)s->owbCnt;
+	}
+	if (add < MB_IR_OWB + IOPLUS_OWB_SENS_NO)
+	{
+		return (uint16_t)s->owbTemp[add - MB_IR_OWB];
+	}
+	if (add < MB_IR_CNT)
+	{
+		return 0; // reserved
+	}
+	cnt = (add - MB_IR_CNT) / 2;
+	if ( (add - MB_IR_CNT) % 2 == 0)
+	{
+		return (uint16_t) (s->cnt[cnt] >> 16);
+	}
+	return (uint16_t)s->cnt[cnt];
+}
+
+static uint16_t holdingGet(const IoplusSnapshotType *s, int add)
+{
+	if (add < MB_HR_OD)
+	{
+		return s->dacMv[add - MB_HR_DAC];
+	}
+	return s->odPwm[add - MB_HR_OD];
+}
+
+/* stage one coil in the transaction and in the cache, reads that follow
+ * in the same pass see the new value */
+static void coilStage(MbServerType *mb, int add, int state)
+{
+	if (add < MB_COIL_GPIO)
+	{
+		ioplusTxRelayChSet(&mb->tx, add + 1, state);
+		mb->cache.relay = (uint8_t) ( (mb->cache.relay & ~(1 << add))
+			| (state << add));
+	}
+	else
+	{
+		add -= MB_COIL_GPIO;
+		ioplusTxGpioChSet(&mb->tx, add + 1, state);
+		mb->cache.gpio = (uint8_t) ( (mb->cache.gpio & ~(1 << add))
+			| (state << add));
+	}
+}
+
+static int holdingCheck(int add, uint16_t val)
+{
+	if (add < MB_HR_OD)
+	{
+		return (val > 10 * VOLT_TO_MILIVOLT) ? MB_EX_VALUE : 0;
+	}
+	return (val > IOPLUS_OD_PWM_MAX) ? MB_EX_VALUE : 0;
+}
+
+static void holdingStage(MbServerType *mb, int add, uint16_t val)
+{
+	if (add < MB_HR_OD)
+	{
+		ioplusTxDacSet(&mb->tx, add - MB_HR_DAC + 1, val);
+		mb->cache.dacMv[add - MB_HR_DAC] = val;
+	}
+	else
+	{
+		ioplusTxOdPwmSet(&mb->tx, add - MB_HR_OD + 1, val);
+		mb->cache.odPwm[add - MB_HR_OD] = val;
+	}
+}
+
+/* bit and register reads, the response PDU is built in rsp */
+static int readBits(MbServerType *mb, const uint8_t *req, uint8_t *rsp, int *len)
+{
+	int add = get16(req + 1);
+	int qty = get16(req + 3);
+	int no = (req[0] == MB_FC_READ_COILS) ? MB_COIL_NO : MB_DISC_NO;
+	int val;
+	int i;
+
+	if ( (qty < 1) || (qty > MB_BITS_READ_MAX))
+	{
+		return MB_EX_VALUE;
+	}
+	if (add + qty > no)
+	{
+		return MB_EX_ADDRESS;
+	}
+	if (!mb->cacheValid)
+	{
+		return MB_EX_DEVICE;
+	}
+	rsp[1] = (uint8_t) ( (qty + 7) / 8);
+	memset(rsp + 2, 0, rsp[1]);
+	for (i = 0; i < qty; i++)
+	{
+		val = (req[0] == MB_FC_READ_COILS) ? coilGet(&mb->cache, add + i) :
+			discreteGet(&mb->cache, add + i);
+		rsp[2 + i / 8] |= (uint8_t) (val << (i % 8));
+	}
+	*len = 2 + rsp[1];
+	return 0;
+}
+
+static int readRegs(MbServerType *mb, const uint8_t *req, uint8_t *rsp, int *len)
+{
+	int add = get16(req + 1);
+	int qty = get16(req + 3);
+	int no = (req[0] == MB_FC_READ_HOLDING) ? MB_HR_NO : MB_IR_NO;
+	uint16_t val;
+	int i;
+
+	if ( (qty < 1) || (qty > MB_REGS_READ_MAX))
+	{
+		return MB_EX_VALUE;
+	}
+	if (add + qty > no)
+	{
+		return MB_EX_ADDRESS;
+	}
+	if (!mb->cacheValid)
+	{
+		return MB_EX_DEVICE;
+	}
+	rsp[1] = (uint8_t) (2 * qty);
+	for (i = 0; i < qty; i++)
+	{
+		val = (req[0] == MB_FC_READ_HOLDING) ? holdingGet(&mb->cache, add + i) :
+			inputGet(&mb->cache, add + i);
+		put16(rsp + 2 + 2 * i, val);
+	}
+	*len = 2 + rsp[1];
+	return 0;
+}
+
+/* every write is checked before anything is staged, a request is applied
+ * whole or not at all */
+static int writeStage(MbServerType *mb, const uint8_t *req, int pduLen)
+{
+	int add = get16(req + 1);
+	int qty = get16(req + 3);
+	int i;
+
+	switch (req[0])
+	{
+	case MB_FC_WRITE_COIL:
+		if ( (qty != 0xff00) && (qty != 0))
+		{
+			return MB_EX_VALUE;
+		}
+		if (add >= MB_COIL_NO)
+		{
+			return MB_EX_ADDRESS;
+		}
+		coilStage(mb, add, qty != 0);
+		return 0;
+	case MB_FC_WRITE_REG:
+		if (add >= MB_HR_NO)
+		{
+			return MB_EX_ADDRESS;
+		}
+		if (0 != holdingCheck(add, (uint16_t)qty))
+		{
+			return MB_EX_VALUE;
+		}
+		holdingStage(mb, add, (uint16_t)qty);
+		return 0;
+	case MB_FC_WRITE_COILS:
+		if ( (pduLen < 6) || (qty < 1) || (qty > MB_BITS_WRITE_MAX)
+			|| (req[5] != (qty + 7) / 8) || (pduLen != 6 + req[5]))
+		{
+			return MB_EX_VALUE;
+		}
+		if (add + qty > MB_COIL_NO)
+		{
+			return MB_EX_ADDRESS;
+		}
+		for (i = 0; i < qty; i++)
+		{
+			coilStage(mb, add + i, (req[6 + i / 8] >> (i % 8)) & 1);
+		}
+		return 0;
+	case MB_FC_WRITE_REGS:
+		if ( (pduLen < 6) || (qty < 1) || (qty > MB_REGS_WRITE_MAX)
+			|| (req[5] != 2 * qty) || (pduLen != 6 + req[5]))
+		{
+			return MB_EX_VALUE;
+		}
+		if (add + qty > MB_HR_NO)
+		{
+			return MB_EX_ADDRESS;
+		}
+		for (i = 0; i < qty; i++)
+		{
+			if (0 != holdingCheck(add + i, get16(req + 6 + 2 * i)))
+			{
+				return MB_EX_VALUE;
+			}
+		}
+		for (i = 0; i < qty; i++)
+		{
+			holdingStage(mb, add + i, get16(req + 6 + 2 * i));
+		}
+		return 0;
+	default:
+		break;
+	}
+	return MB_EX_FUNCTION;
+}
+
+static void clientReply(MbClientType *c, const uint8_t *hdr, const uint8_t *pdu,
+	int pduLen)
+{
+	uint8_t *p = c->out + c->outLen;
+
+	memcpy(p, hdr, 4);
+	put16(p + 4, (uint16_t) (pduLen + 1));
+	p[6] = hdr[6];
+	memcpy(p + MB_HDR_SIZE, pdu, pduLen);
+	c->outLen += MB_HDR_SIZE + pduLen;
+}
+
+static void clientException(MbServerType *mb, MbClientType *c,
+	const uint8_t *hdr, uint8_t fc, int ex)
+{
+	uint8_t pdu[2];
+
+	pdu[0] = (uint8_t) (fc | 0x80);
+	pdu[1] = (uint8_t)ex;
+	clientReply(c, hdr, pdu, 2);
+	mb->stats.exceptions++;
+}
+
+static void clientClose(MbServerType *mb, MbClientType *c)
+{
+	epoll_ctl(mb->epollFd, EPOLL_CTL_DEL, c->fd, NULL);
+	close(c->fd);
+	c->fd = -1;
+}
+
+/* answer the complete frames received, stops at a staged write so the
+ * replies keep the order of the requests */
+static int clientProcess(MbServerType *mb, MbClientType *c)
+{
+	uint8_t rsp[MB_FRAME_MAX];
+	uint8_t *frame;
+	int pos = 0;
+	int frameLen;
+	int rspLen;
+	int ret;
+
+	while (!c->pending && (c->inLen - pos >= MB_HDR_SIZE + 1)
+		&& (c->outLen + MB_FRAME_MAX <= MB_TX_SIZE))
+	{
+		frame = c->in + pos;
+		frameLen = get16(frame + 4);
+		if ( (get16(frame + 2) != 0) || (frameLen < 2)
+			|| (frameLen > MB_FRAME_MAX - MB_HDR_SIZE + 1))
+		{
+			return IOPLUS_ERR_ARG; // not Modbus, drop the connection
+		}
+		frameLen += MB_HDR_SIZE - 1;
+		if (c->inLen - pos < frameLen)
+		{
+			break;
+		}
+		pos += frameLen;
+		mb->stats.requests++;
+		rsp[0] = frame[MB_HDR_SIZE];
+		if ( (rsp[0] != MB_FC_WRITE_COILS) && (rsp[0] != MB_FC_WRITE_REGS)
+			&& (frameLen != MB_HDR_SIZE + 5))
+		{
+			clientException(mb, c, frame, rsp[0],
+				(rsp[0] > MB_FC_WRITE_REG) ? MB_EX_FUNCTION : MB_EX_VALUE);
+			continue;
+		}
+		switch (rsp[0])
+		{
+		case MB_FC_READ_COILS:
+		case MB_FC_READ_DISCRETE:
+			ret = readBits(mb, frame + MB_HDR_SIZE, rsp, &rspLen);
+			break;
+		case MB_FC_READ_HOLDING:
+		case MB_FC_READ_INPUT:
+			ret = readRegs(mb, frame + MB_HDR_SIZE, rsp, &rspLen);
+			break;
+		default:
+			ret = writeStage(mb, frame + MB_HDR_SIZE, frameLen - MB_HDR_SIZE);
+			if (ret == 0)
+			{
+				memcpy(c->ack, frame, MB_WRITE_ACK_SIZE);
+				c->pending = 1;
+				continue;
+			}
+			break;
+		}
+		if (ret != 0)
+		{
+			clientException(mb, c, frame, rsp[0], ret);
+		}
+		else
+		{
+			clientReply(c, frame, rsp, rspLen);
+		}
+	}
+	memmove(c->in, c->in + pos, c->inLen - pos);
+	c->inLen -= pos;
+	return IOPLUS_OK;
+}
+
+/* wait for input only while there is room for it, for output only while
+ * replies are queued */
+static void clientPoll(MbServerType *mb, MbClientType *c)
+{
+	struct epoll_event ev;
+
+	ev.events = ( (c->inLen < MB_RX_SIZE) ? EPOLLIN : 0)
+		| ( (c->outLen > 0) ? EPOLLOUT : 0);
+	if (ev.events != c->events)
+	{
+		c->events = ev.events;
+		ev.data.ptr = c;
+		epoll_ctl(mb->epollFd, EPOLL_CTL_MOD, c->fd, &ev);
+	}
+}
+
+static void clientFlush(MbServerType *mb, MbClientType *c)
+{
+	int n;
+
+	while (c->outLen > 0)
+	{
+		n = (int)send(c->fd, c->out, c->outLen, MSG_NOSIGNAL);
+		if (n <= 0)
+		{
+			if ( (n < 0) && ( (errno == EAGAIN) || (errno == EWOULDBLOCK)))
+			{
+				break;
+			}
+			clientClose(mb, c);
+			return;
+		}
+		memmove(c->out, c->out + n, c->outLen - n);
+		c->outLen -= n;
+	}
+	clientPoll(mb, c);
+}
+
+static void clientRead(MbServerType *mb, MbClientType *c)
+{
+	int n;
+
+	while (c->inLen < MB_RX_SIZE)
+	{
+		n = (int)recv(c->fd, c->in + c->inLen, MB_RX_SIZE - c->inLen, 0);
+		if (n < 0 && ( (errno == EAGAIN) || (errno == EWOULDBLOCK)))
+		{
+			break;
+		}
+		if (n <= 0)
+		{
+			clientClose(mb, c);
+			return;
+		}
+		c->inLen += n;
+	}
+	if (IOPLUS_OK != clientProcess(mb, c))
+	{
+		clientClose(mb, c);
+		return;
+	}
+	clientPoll(mb, c);
+}
+
+static void serverAccept(MbServerType *mb)
+{
+	struct epoll_event ev;
+	MbClientType *c = NULL;
+	int one = 1;
+	int fd;
+	int i;
+
+	while ( (fd = accept(mb->listenFd, NULL, NULL)) >= 0)
+	{
+		fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+		for (i = 0; (i < MB_CLIENT_MAX) && (NULL == c); i++)
+		{
+			c = (mb->client[i].fd < 0) ? &mb->client[i] : NULL;
+		}
+		if (NULL == c)
+		{
+			close(fd);
+			mb->stats.rejected++;
+			continue;
+		}
+		setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+		memset(c, 0, sizeof(MbClientType));
+		c->fd = fd;
+		c->events = EPOLLIN;
+		ev.events = EPOLLIN;
+		ev.data.ptr = c;
+		if (0 != epoll_ctl(mb->epollFd, EPOLL_CTL_ADD, fd, &ev))
+		{
+			close(fd);
+			c->fd = -1;
+		}
+		else
+		{
+			mb->stats.connections++;
+		}
+		c = NULL;
+	}
+}
+
+static int txStaged(const IoplusTxType *tx)
+{
+	return (tx->dirty != 0) || (tx->relayMask != 0) || (tx->gpioMask != 0);
+}
+
+/* one commit for every write staged in this pass, then the clients held
+ * by a write go on with the requests they have queued */
+static void serverCommit(MbServerType *mb)
+{
+	MbClientType *c;
+	int ret;
+	int i;
+
+	while (txStaged(&mb->tx))
+	{
+		ret = ioplusTxCommit(&mb->tx, NULL);
+		mb->stats.commits++;
+		if (ret != IOPLUS_OK)
+		{
+			// the cache holds values the card never got
+			mb->cacheValid = 0;
+			mb->refreshDue = 0;
+		}
+		ioplusTxBegin(mb->board, &mb->tx);
+		for (i = 0; i < MB_CLIENT_MAX; i++)
+		{
+			c = &mb->client[i];
+			if ( (c->fd < 0) || !c->pending)
+			{
+				continue;
+			}
+			c->pending = 0;
+			if (ret == IOPLUS_OK)
+			{
+				clientReply(c, c->ack, c->ack + MB_HDR_SIZE,
+					MB_WRITE_ACK_SIZE - MB_HDR_SIZE);
+				mb->stats.writes++;
+			}
+			else
+			{
+				clientException(mb, c, c->ack, c->ack[MB_HDR_SIZE], MB_EX_DEVICE);
+			}
+			if (IOPLUS_OK != clientProcess(mb, c))
+			{
+				clientClose(mb, c);
+			}
+		}
+	}
+}
+
+static void serverRefresh(MbServerType *mb)
+{
+	uint64_t now = mbNowMs();
+
+	if (now < mb->refreshDue)
+	{
+		return;
+	}
+	mb->refreshDue = now + mb->refreshMs;
+	mb->stats.refreshes++;
+	if (IOPLUS_OK == ioplusSnapshotGet(mb->board, &mb->cache))
+	{
+		mb->cacheValid = 1;
+	}
+	else
+	{
+		mb->cacheValid = 0;
+		mb->stats.refreshErrors++;
+	}
+}
+
+static int serverListen(int port)
+{
+	struct sockaddr_in add;
+	int one = 1;
+	int fd;
+
+	fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK, 0);
+	if (fd < 0)
+	{
+		return -1;
+	}
+	setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+	memset(&add, 0, sizeof(add));
+	add.sin_family = AF_INET;
+	add.sin_addr.s_addr = htonl(INADDR_ANY);
+	add.sin_port = htons((uint16_t)port);
+	if ( (0 != bind(fd, (struct sockaddr*)&add, sizeof(add)))
+		|| (0 != listen(fd, MB_BACKLOG)))
+	{
+		close(fd);
+		return -1;
+	}
+	return fd;
+}
+
+static void serverRun(MbServerType *mb)
+{
+	struct epoll_event ev[MB_EVENTS_MAX];
+	MbClientType *c;
+	uint64_t now;
+	int wait;
+	int n;
+	int i;
+
+	while (!gRunStop)
+	{
+		now = mbNowMs();
+		wait = (mb->refreshDue > now) ? (int) (mb->refreshDue - now) : 0;
+		n = epoll_wait(mb->epollFd, ev, MB_EVENTS_MAX, wait);
+		for (i = 0; i < n; i++)
+		{
+			c = ev[i].data.ptr;
+			if (NULL == c)
+			{
+				serverAccept(mb);
+				continue;
+			}
+			if (c->fd < 0)
+			{
+				continue;
+			}
+			if (ev[i].events & (EPOLLERR | EPOLLHUP))
+			{
+				clientClose(mb, c);
+				continue;
+			}
+			if (ev[i].events & EPOLLOUT)
+			{
+				clientFlush(mb, c);
+				// replies drained, go on with the requests left behind
+				if ( (c->fd >= 0) && (IOPLUS_OK != clientProcess(mb, c)))
+				{
+					clientClose(mb, c);
+				}
+			}
+			if ( (c->fd >= 0) && (ev[i].events & EPOLLIN))
+			{
+				clientRead(mb, c);
+			}
+		}
+		serverCommit(mb);
+		for (i = 0; i < MB_CLIENT_MAX; i++)
+		{
+			if (mb->client[i].fd >= 0)
+			{
+				clientFlush(mb, &mb->client[i]);
+			}
+		}
+		serverRefresh(mb);
+	}
+}
+
+int doModbus(int argc, char *argv[])
+{
+	static MbServerType mb;
+	struct epoll_event ev;
+	int port = MB_PORT;
+	int dev;
+	IoplusVerifyStatsType vst;
+	int i;
+
+	if ( (argc < 3) || (argc > 5))
+	{
+		return ARG_CNT_ERR;
+	}
+	memset(&mb, 0, sizeof(mb));
+	mb.refreshMs = MB_REFRESH_MS;
+	if (argc > 3)
+	{
+		port = atoi(argv[3]);
+	}
+	if (argc > 4)
+	{
+		mb.refreshMs = (uint32_t)atoi(argv[4]);
+	}
+	if ( (port < 1) || (port > 65535) || (mb.refreshMs < 1))
+	{
+		printf("Invalid port or refresh period!\n");
+		return ARG_ERR;
+	}
+	dev = doBoardInit(atoi(argv[1]));
+	if (dev <= 0)
+	{
+		return ERROR;
+	}
+	mb.board = boardHandle(dev);
+	// the commits only write the outputs a client actually changed
+	ioplusShadowEnable(mb.board, mb.refreshMs);
+	ioplusTxBegin(mb.board, &mb.tx);
+	serverRefresh(&mb);
+	for (i = 0; i < MB_CLIENT_MAX; i++)
+	{
+		mb.client[i].fd = -1;
+	}
+	mb.listenFd = serverListen(port);
+	if (mb.listenFd < 0)
+	{
+		printf("Fail to listen on port %d: %s!\n", port, strerror(errno));
+		return ERROR;
+	}
+	mb.epollFd = epoll_create1(0);
+	ev.events = EPOLLIN;
+	ev.data.ptr = NULL;
+	if ( (mb.epollFd < 0)
+		|| (0 != epoll_ctl(mb.epollFd, EPOLL_CTL_ADD, mb.listenFd, &ev)))
+	{
+		printf("Fail to create the event loop!\n");
+		close(mb.listenFd);
+		return ERROR;
+	}
+	signal(SIGINT, runStop);
+	signal(SIGTERM, runStop);
+	signal(SIGPIPE, SIG_IGN);
+	busTokenRelease();
+	printf("Modbus TCP server for Board #%d on port %d\n", atoi(argv[1]), port);
+	fflush(stdout);
+
+	serverRun(&mb);
+
+	for (i = 0; i < MB_CLIENT_MAX; i++)
+	{
+		if (mb.client[i].fd >= 0)
+		{
+			clientClose(&mb, &mb.client[i]);
+		}
+	}
+	close(mb.epollFd);
+	close(mb.listenFd);
+	printf("%u connections (%u rejected), %u requests, %u exceptions\n",
+		mb.stats.connections, mb.stats.rejected, mb.stats.requests,
+		mb.stats.exceptions);
+	printf("%u writes in %u commits, %u refreshes (%u failed)\n", mb.stats.writes,
+		mb.stats.commits, mb.stats.refreshes, mb.stats.refreshErrors);
+	ioplusVerifyStatsGet(mb.board, &vst);
+	printf("%u verify checks, %u mismatches, %u rewrites, %u failed\n",
+		vst.checks, vst.mismatches, vst.retries, vst.failures);
+	return OK;
+}
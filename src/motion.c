@@ -0,0 +1,412 @@
+/*
+ * motion.c:
+ *	Host side motion queue for the open drain pulse outputs. The card runs
+ *	one pulse train per channel, the queue keeps the next segments and
+ *	writes each one as soon as the card reports no pulses left. The polls
+ *	get dense near the predicted end of a segment so the dead time between
+ *	two segments stays close to one I2C transfer.
+ *
+ *	Copyright (c) 2016-2023 Sequent Microsystem
+ *	<http://www.sequentmicrosystem.com>
+ ***********************************************************************
+ */
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+
+#include "libioplus.h"
+
+#define MOTION_ACC_MAX	60000
+#define MOTION_SPEED_MIN	10
+#define MOTION_SPEED_MAX	60000
+/* a 0 pulses left read sooner after the write may predate the new count,
+ * unless the count was seen non zero already */
+#define MOTION_SETTLE_US	1000
+
+static uint64_t motNowUs(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+static void motSleepUs(uint32_t us)
+{
+	struct timespec ts;
+
+	ts.tv_sec = us / 1000000;
+	ts.tv_nsec = (long) (us % 1000000) * 1000;
+	nanosleep(&ts, NULL);
+}
+
+static int motProfileSet(const IoplusMoveType *mv)
+{
+	return (mv->acc | mv->dec | mv->minSpd | mv->maxSpd) != 0;
+}
+
+// drop the whole queue of channel i, the first segment gets event
+static void motFlush(IoplusMotionType *m, int i, int event)
+{
+	IoplusMotionChType *c = &m->ch[i];
+	IoplusMoveType mv;
+
+	c->running = 0;
+	c->armed = 0;
+	while (c->count > 0)
+	{
+		mv = c->q[c->head];
+		c->head = (c->head + 1) % IOPLUS_MOTION_QUEUE_MAX;
+		c->count--;
+		if (event == IOPLUS_MOVE_FAILED)
+		{
+			c->stats.failed++;
+		}
+		else
+		{
+			c->stats.cancelled++;
+		}
+		if (m->cb)
+		{
+			m->cb(m->ctx, i + 1, &mv, event);
+		}
+		event = IOPLUS_MOVE_CANCELLED;
+	}
+}
+
+// write the segment at the queue head, transition when it follows a segment
+// that just ended
+static int motStart(IoplusBoardType *board, IoplusMotionChType *c, int i,
+	int transition)
+{
+	const IoplusMoveType *mv = &c->q[c->head];
+	uint16_t prof[4];
+	uint64_t now;
+	uint32_t gap;
+	int ret = IOPLUS_OK;
+
+	if (motProfileSet(mv))
+	{
+		prof[0] = mv->acc;
+		prof[1] = mv->dec;
+		prof[2] = mv->minSpd;
+		prof[3] = mv->maxSpd;
+		if (memcmp(prof, c->prof, sizeof(prof)) != 0)
+		{
+			ret = ioplusOdMoveSet(board, i + 1, mv->acc, mv->dec, mv->minSpd,
+				mv->maxSpd);
+			if (ret == IOPLUS_OK)
+			{
+				memcpy(c->prof, prof, sizeof(prof));
+			}
+		}
+	}
+	if (ret == IOPLUS_OK)
+	{
+		ret = ioplusOdPulsesSet(board,
+			i + 1 + (mv->reverse ? IOPLUS_OD_CH_NO : 0), mv->pulses);
+	}
+	if (ret != IOPLUS_OK)
+	{
+		return ret;
+	}
+	now = motNowUs();
+	if (transition)
+	{
+		gap = (uint32_t) (now - c->seenUs);
+		if ( (c->stats.transitions == 0) || (gap < c->stats.gapMinUs))
+		{
+			c->stats.gapMinUs = gap;
+		}
+		if (gap > c->stats.gapMaxUs)
+		{
+			c->stats.gapMaxUs = gap;
+		}
+		c->stats.gapSumUs += gap;
+		c->stats.transitions++;
+	}
+	c->running = 1;
+	c->armed = 0;
+	c->latched = 0;
+	c->left = mv->pulses;
+	c->seenUs = now;
+	c->rate = 0;
+	return IOPLUS_OK;
+}
+
+// the running segment of channel i is over, start the next one
+static int motDone(IoplusBoardType *board, IoplusMotionType *m, int i)
+{
+	IoplusMotionChType *c = &m->ch[i];
+	IoplusMoveType mv = c->q[c->head];
+	int ret = IOPLUS_OK;
+
+	c->head = (c->head + 1) % IOPLUS_MOTION_QUEUE_MAX;
+	c->count--;
+	c->running = 0;
+	c->stats.done++;
+	if (c->count > 0)
+	{
+		if (!c->armed)
+		{
+			c->stats.late++;
+		}
+		ret = motStart(board, c, i, 1);
+	}
+	c->armed = 0;
+	if (m->cb)
+	{
+		m->cb(m->ctx, i + 1, &mv, IOPLUS_MOVE_DONE);
+	}
+	if (ret != IOPLUS_OK)
+	{
+		motFlush(m, i, IOPLUS_MOVE_FAILED);
+	}
+	return ret;
+}
+
+// time until channel i must be polled again, 0 once it is armed
+static uint32_t motWait(IoplusMotionType *m, IoplusMotionChType *c,
+	uint32_t wait)
+{
+	float rate = c->rate;
+	float endUs;
+
+	if (!c->running)
+	{
+		return wait;
+	}
+	if (rate <= 0)
+	{
+		// not measured yet, assume the fastest train the profile allows
+		rate = c->prof[3] ? c->prof[3] : MOTION_SPEED_MAX;
+	}
+	endUs = (float)c->left * 1000000 / rate;
+	if (endUs <= m->armUs)
+	{
+		c->armed = 1;
+		return 0;
+	}
+	if (endUs - m->armUs < wait)
+	{
+		wait = (uint32_t) (endUs - m->armUs);
+	}
+	return wait;
+}
+
+int ioplusMotionInit(IoplusMotionType *m, uint32_t pollUs, uint32_t armUs,
+	IoplusMoveCbType cb, void *ctx)
+{
+	if (NULL == m)
+	{
+		return IOPLUS_ERR_ARG;
+	}
+	memset(m, 0, sizeof(IoplusMotionType));
+	m->pollUs = pollUs ? pollUs : IOPLUS_MOTION_POLL_US;
+	m->armUs = armUs ? armUs : IOPLUS_MOTION_ARM_US;
+	m->cb = cb;
+	m->ctx = ctx;
+	return IOPLUS_OK;
+}
+
+int ioplusMotionQueue(IoplusMotionType *m, int ch, const IoplusMoveType *mv)
+{
+	IoplusMotionChType *c;
+
+	if ( (NULL == m) || (NULL == mv) || (ch < 1) || (ch > IOPLUS_OD_CH_NO)
+		|| (mv->pulses == 0))
+	{
+		return IOPLUS_ERR_ARG;
+	}
+	if (motProfileSet(mv)
+		&& ( (mv->acc > MOTION_ACC_MAX) || (mv->dec > MOTION_ACC_MAX)
+			|| (mv->maxSpd < MOTION_SPEED_MIN) || (mv->maxSpd > MOTION_SPEED_MAX)
+			|| (mv->minSpd < MOTION_SPEED_MIN) || (mv->minSpd > mv->maxSpd)))
+	{
+		return IOPLUS_ERR_ARG;
+	}
+	c = &m->ch[ch - 1];
+	if (c->count >= IOPLUS_MOTION_QUEUE_MAX)
+	{
+		return IOPLUS_ERR_FULL;
+	}
+	c->q[(c->head + c->count) % IOPLUS_MOTION_QUEUE_MAX] = *mv;
+	c->count++;
+	c->stats.queued++;
+	return IOPLUS_OK;
+}
+
+int ioplusMotionPoll(IoplusBoardType *board, IoplusMotionType *m,
+	uint32_t *waitUs)
+{
+	uint32_t left[IOPLUS_OD_CH_NO];
+	uint32_t wait;
+	IoplusMotionChType *c;
+	uint64_t now = 0;
+	float rate;
+	int busy = 0;
+	int ret = IOPLUS_OK;
+	int err;
+	int i;
+
+	if ( (NULL == board) || (NULL == m))
+	{
+		return IOPLUS_ERR_ARG;
+	}
+	for (i = 0; i < IOPLUS_OD_CH_NO; i++)
+	{
+		busy |= m->ch[i].running;
+	}
+	if (busy)
+	{
+		ret = ioplusOdPulsesGetAll(board, left);
+		now = motNowUs();
+	}
+	wait = m->pollUs;
+	for (i = 0; i < IOPLUS_OD_CH_NO; i++)
+	{
+		c = &m->ch[i];
+		err = IOPLUS_OK;
+		if (c->running && (ret == IOPLUS_OK))
+		{
+			c->stats.polls++;
+			if (left[i] == 0)
+			{
+				// seenUs is still the write time while not latched
+				if (c->latched || (now - c->seenUs >= MOTION_SETTLE_US))
+				{
+					err = motDone(board, m, i);
+				}
+			}
+			else
+			{
+				c->latched = 1;
+				if ( (left[i] < c->left) && (now > c->seenUs))
+				{
+					rate = (float) (c->left - left[i]) * 1000000 / (now - c->seenUs);
+					c->rate = (c->rate > 0) ? (c->rate + rate) / 2 : rate;
+				}
+				c->left = left[i];
+				c->seenUs = now;
+			}
+		}
+		else if (!c->running && (c->count > 0))
+		{
+			err = motStart(board, c, i, 0);
+			if (err != IOPLUS_OK)
+			{
+				motFlush(m, i, IOPLUS_MOVE_FAILED);
+			}
+		}
+		if (ret == IOPLUS_OK)
+		{
+			ret = err;
+		}
+		wait = motWait(m, c, wait);
+	}
+	if (waitUs)
+	{
+		*waitUs = wait;
+	}
+	return ret;
+}
+
+int ioplusMotionRun(IoplusBoardType *board, IoplusMotionType *m,
+	uint32_t timeoutMs)
+{
+	uint64_t start = motNowUs();
+	uint32_t wait;
+	int ret;
+
+	while (ioplusMotionPending(m, 0) > 0)
+	{
+		ret = ioplusMotionPoll(board, m, &wait);
+		if (ret != IOPLUS_OK)
+		{
+			return ret;
+		}
+		if ( (timeoutMs != 0) && (motNowUs() - start >= (uint64_t)timeoutMs * 1000))
+		{
+			return IOPLUS_ERR_TIMEOUT;
+		}
+		if (wait != 0)
+		{
+			motSleepUs(wait);
+		}
+	}
+	return IOPLUS_OK;
+}
+
+int ioplusMotionStop(IoplusBoardType *board, IoplusMotionType *m, int ch)
+{
+	int ret = IOPLUS_OK;
+	int err;
+	int i;
+
+	if ( (NULL == board) || (NULL == m) || (ch < 0) || (ch > IOPLUS_OD_CH_NO))
+	{
+		return IOPLUS_ERR_ARG;
+	}
+	for (i = 0; i < IOPLUS_OD_CH_NO; i++)
+	{
+		if ( (ch != 0) && (ch != i + 1))
+		{
+			continue;
+		}
+		if (m->ch[i].running)
+		{
+			err = ioplusOdPulsesSet(board, i + 1, 0);
+			if (ret == IOPLUS_OK)
+			{
+				ret = err;
+			}
+		}
+		motFlush(m, i, IOPLUS_MOVE_CANCELLED);
+	}
+	return ret;
+}
+
+int ioplusMotionPending(IoplusMotionType *m, int ch)
+{
+	int count = 0;
+	int i;
+
+	if ( (NULL == m) || (ch < 0) || (ch > IOPLUS_OD_CH_NO))
+	{
+		return IOPLUS_ERR_ARG;
+	}
+	if (ch != 0)
+	{
+		return m->ch[ch - 1].count;
+	}
+	for (i = 0; i < IOPLUS_OD_CH_NO; i++)
+	{
+		count += m->ch[i].count;
+	}
+	return count;
+}
+
+int ioplusMotionStatsGet(IoplusMotionType *m, int ch,
+	IoplusMotionStatsType *stats)
+{
+	if ( (NULL == m) || (NULL == stats) || (ch < 1) || (ch > IOPLUS_OD_CH_NO))
+	{
+		return IOPLUS_ERR_ARG;
+	}
+	*stats = m->ch[ch - 1].stats;
+	return IOPLUS_OK;
+}
+
+void ioplusMotionStatsReset(IoplusMotionType *m)
+{
+	int i;
+
+	if (NULL == m)
+	{
+		return;
+	}
+	for (i = 0; i < IOPLUS_OD_CH_NO; i++)
+	{
+		memset(&m->ch[i].stats, 0, sizeof(IoplusMotionStatsType));
+	}
+}
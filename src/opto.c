@@ -9,7 +9,7 @@
 
 int optoChGet(int dev, u8 channel, OutStateEnumType *state)
 {
-	u8 buff[2];
+	int val = 0;
 
 	if (NULL == state)
 	{
@@ -21,46 +21,32 @@ int optoChGet(int dev, u8 channel, OutStateEnumType *state)
 		printf("Invalid opto channel nr!\n");
 		return ERROR;
 	}
-
-	if (FAIL == i2cReadByteAS(dev, I2C_MEM_OPTO_IN_ADD, buff))
+	if (IOPLUS_OK != ioplusOptoChGet(boardHandle(dev), channel, &val))
 	{
 		return ERROR;
 	}
-
-	if (buff[0] & (1 << (channel - 1)))
-	{
-		*state = ON;
-	}
-	else
-	{
-		*state = OFF;
-	}
+	*state = val ? ON : OFF;
 	return OK;
 }
 
 int optoGet(int dev, int *val)
 {
-	u8 buff[2];
+	u8 buff = 0;
 
 	if (NULL == val)
 	{
 		return ERROR;
 	}
-
-	if (FAIL == i2cReadByteAS(dev, I2C_MEM_OPTO_IN_ADD, buff))
+	if (IOPLUS_OK != ioplusOptoGet(boardHandle(dev), &buff))
 	{
 		return ERROR;
 	}
-	*val = buff[0];
+	*val = buff;
 	return OK;
 }
 
 int optoEdgeGet(int dev, u8 channel, u8 *val)
 {
-	u8 buff[2];
-	u8 rising = 0;
-	u8 falling = 0;
-
 	if (NULL == val)
 	{
 		return ERROR;
@@ -71,52 +57,16 @@ int optoEdgeGet(int dev, u8 channel, u8 *val)
 		printf("Invalid opto channel nr!\n");
 		return ERROR;
 	}
-	if (FAIL == i2cMem8Read(dev, I2C_MEM_OPTO_IT_RISING_ADD, buff, 2))
+	if (IOPLUS_OK != ioplusOptoEdgeGet(boardHandle(dev), channel, val))
 	{
 		return ERROR;
 	}
-	rising = buff[0];
-	falling = buff[1];
-	*val = ( ( (1 << (channel - 1)) & rising) == 0 ? 0 : 1);
-	*val += ( ( (1 << (channel - 1)) & falling) == 0 ? 0 : 2);
 	return OK;
 }
 
 int optoEdgeSet(int dev, u8 channel, u8 val)
 {
-	u8 buff[2];
-	u8 rising = 0;
-	u8 falling = 0;
-
-	if ( (channel < CHANNEL_NR_MIN) || (channel > OPTO_IN_CH_NR_MAX))
-	{
-		return ERROR;
-	}
-	if (FAIL == i2cMem8Read(dev, I2C_MEM_OPTO_IT_RISING_ADD, buff, 2))
-	{
-		return ERROR;
-	}
-	rising = buff[0];
-	falling = buff[1];
-	if (val & 0x01) //check rising
-	{
-		rising |= 1 << (channel - 1);
-	}
-	else
-	{
-		rising &= ~ (1 << (channel - 1));
-	}
-	if (val & 0x02) //check falling
-	{
-		falling |= 1 << (channel - 1);
-	}
-	else
-	{
-		falling &= ~ (1 << (channel - 1));
-	}
-	buff[0] = rising;
-	buff[1] = falling;
-	if (FAIL == i2cMem8Write(dev, I2C_MEM_OPTO_IT_RISING_ADD, buff, 2))
+	if (IOPLUS_OK != ioplusOptoEdgeSet(boardHandle(dev), channel, val))
 	{
 		return ERROR;
 	}
@@ -125,15 +75,7 @@ int optoEdgeSet(int dev, u8 channel, u8 val)
 
 int optoCountGet(int dev, u8 channel, u32 *val)
 {
-	if ( (channel < CHANNEL_NR_MIN) || (channel > OPTO_IN_CH_NR_MAX)
-		|| (NULL == val))
-	{
-		return ERROR;
-	}
-
-	if (OK
-		!= i2cReadDWordAS(dev,
-			I2C_MEM_OPTO_EDGE_COUNT_ADD + COUNTER_SIZE * (channel - 1), (uint32_t *)val))
+	if (IOPLUS_OK != ioplusOptoCountGet(boardHandle(dev), channel, val))
 	{
 		return ERROR;
 	}
@@ -142,12 +84,7 @@ int optoCountGet(int dev, u8 channel, u32 *val)
 
 int optoCountReset(int dev, u8 channel)
 {
-
-	if ( (channel < CHANNEL_NR_MIN) || (channel > OPTO_IN_CH_NR_MAX))
-	{
-		return ERROR;
-	}
-	if (FAIL == i2cMem8Write(dev, I2C_MEM_OPTO_CNT_RST_ADD, &channel, 1))
+	if (IOPLUS_OK != ioplusOptoCountReset(boardHandle(dev), channel))
 	{
 		return ERROR;
 	}
@@ -156,27 +93,7 @@ int optoCountReset(int dev, u8 channel)
 
 int optoEncStateWrite(int dev, u8 channel, u8 val)
 {
-	u8 aux = 0;
-
-	if ( (channel < CHANNEL_NR_MIN) || (channel > OPTO_IN_CH_NR_MAX / 2))
-	{
-		return ERROR;
-	}
-	if (FAIL == i2cMem8Read(dev, I2C_MEM_OPTO_ENC_ENABLE_ADD, &aux, 1))
-	{
-		return ERROR;
-	}
-
-	if (val != 0)
-	{
-		aux |= (1 << (channel - 1));
-	}
-	else
-	{
-		aux &= ~ (1 << (channel - 1));
-	}
-
-	if (FAIL == i2cMem8Write(dev, I2C_MEM_OPTO_ENC_ENABLE_ADD, &aux, 1))
+	if (IOPLUS_OK != ioplusOptoEncEnableSet(boardHandle(dev), channel, val))
 	{
 		return ERROR;
 	}
@@ -185,35 +102,24 @@ int optoEncStateWrite(int dev, u8 channel, u8 val)
 
 int optoEncStateRead(int dev, u8 channel, u8 *val)
 {
-	u8 aux = 0;
-	if ( (channel < CHANNEL_NR_MIN) || (channel > OPTO_IN_CH_NR_MAX / 2)
-		|| (NULL == val))
+	int en = 0;
+
+	if (NULL == val)
 	{
 		return ERROR;
 	}
-	if (OK != i2cReadByteAS(dev, I2C_MEM_OPTO_ENC_ENABLE_ADD, &aux))
+	if (IOPLUS_OK != ioplusOptoEncEnableGet(boardHandle(dev), channel, &en))
 	{
 		return ERROR;
 	}
-	*val = 0;
-	if ( (1 << (channel - 1)) & aux)
-	{
-		*val = 1;
-	}
+	*val = (u8)en;
 	return OK;
 }
 
 int optoEncGetCnt(int dev, u8 channel, int *val)
 {
-	if ( (channel < CHANNEL_NR_MIN) || (channel > OPTO_IN_CH_NR_MAX / 2)
-		|| (NULL == val))
-	{
-		return ERROR;
-	}
-
-	if (OK
-		!= i2cReadIntAS(dev,
-			I2C_MEM_OPTO_ENC_COUNT_ADD + COUNTER_SIZE * (channel - 1), val))
+	if (IOPLUS_OK
+		!= ioplusOptoEncCountGet(boardHandle(dev), channel, (int32_t*)val))
 	{
 		return ERROR;
 	}
@@ -222,11 +128,7 @@ int optoEncGetCnt(int dev, u8 channel, int *val)
 
 int optoEncRstCnt(int dev, u8 channel)
 {
-	if ( (channel < CHANNEL_NR_MIN) || (channel > OPTO_IN_CH_NR_MAX / 2))
-	{
-		return ERROR;
-	}
-	if (FAIL == i2cMem8Write(dev, I2C_MEM_OPTO_ENC_CNT_RST_ADD, &channel, 1))
+	if (IOPLUS_OK != ioplusOptoEncCountReset(boardHandle(dev), channel))
 	{
 		return ERROR;
 	}
@@ -0,0 +1,341 @@
+/*
+ * readplan.c:
+ *	Read planner. The wanted bytes of the register map are read with the
+ *	set of block transfers of lowest predicted time, after a cost model of
+ *	one transfer and of one byte measured on the bus: two fields close to
+ *	each other are read together with the bytes between them, fields far
+ *	apart with a transfer each. Plans are cached per set of fields.
+ *
+ *	Copyright (c) 2016-2023 Sequent Microsystem
+ *	<http://www.sequentmicrosystem.com>
+ ***********************************************************************
+ */
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+
+#include "comm.h"
+#include "libioplus.h"
+#include "ioplusmem.h"
+#include "i2cerr.h"
+
+#define CAL_REPEAT	8 // reads of each size, the fastest one is kept
+#define RUNS_MAX	(IOPLUS_MAP_SIZE / 2) // every other byte wanted
+
+static const int gCalSizes[] = {1, 2, 4, 8, 16, 24, IOPLUS_PLAN_XFER_MAX};
+#define CAL_SIZES	(int)(sizeof(gCalSizes) / sizeof(gCalSizes[0]))
+
+/* registers whose read has a side effect, read only when wanted and never as
+ * a gap: a span may not run over them */
+static const int gBarriers[] = {I2C_DBG_FIFO_ADD}; // pops a debug FIFO byte
+#define BARRIERS	(int)(sizeof(gBarriers) / sizeof(gBarriers[0]))
+
+typedef struct
+{
+	int add;
+	int end; // first byte after the run
+} RunType;
+
+static uint64_t planNowNs(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static int fieldIsSet(const IoplusFieldSetType *set, int add)
+{
+	return (set->mask[add / 32] >> (add % 32)) & 1;
+}
+
+// 1 when a barrier lies in the gap [add, end)
+static int gapHasBarrier(int add, int end)
+{
+	int i;
+
+	for (i = 0; i < BARRIERS; i++)
+	{
+		if ( (gBarriers[i] >= add) && (gBarriers[i] < end))
+		{
+			return 1;
+		}
+	}
+	return 0;
+}
+
+static int planXfers(int size)
+{
+	return (size + IOPLUS_PLAN_XFER_MAX - 1) / IOPLUS_PLAN_XFER_MAX;
+}
+
+static float planSpanCost(const IoplusCostType *cost, int size)
+{
+	return planXfers(size) * cost->txUs + size * cost->byteUs;
+}
+
+void ioplusFieldClear(IoplusFieldSetType *set)
+{
+	if (NULL != set)
+	{
+		memset(set, 0, sizeof(IoplusFieldSetType));
+	}
+}
+
+int ioplusFieldAdd(IoplusFieldSetType *set, int add, int size)
+{
+	int i;
+
+	if ( (NULL == set) || (add < 0) || (size < 1)
+		|| (add + size > IOPLUS_MAP_SIZE))
+	{
+		return IOPLUS_ERR_ARG;
+	}
+	for (i = add; i < add + size; i++)
+	{
+		set->mask[i / 32] |= 1u << (i % 32);
+	}
+	return IOPLUS_OK;
+}
+
+void ioplusCostDefault(IoplusCostType *cost)
+{
+	if (NULL != cost)
+	{
+		// 100 kHz bus: address, register, restart and address, then 9 bits a byte
+		cost->txUs = 300;
+		cost->byteUs = 90;
+	}
+}
+
+int ioplusCostCalibrate(IoplusBoardType *board, IoplusCostType *cost)
+{
+	uint8_t buf[IOPLUS_PLAN_XFER_MAX];
+	double best[CAL_SIZES];
+	double sx = 0;
+	double sy = 0;
+	double sxx = 0;
+	double sxy = 0;
+	double us;
+	double b;
+	uint64_t t0;
+	int i;
+	int j;
+
+	if ( (NULL == board) || (board->dev < 0) || (NULL == cost))
+	{
+		return IOPLUS_ERR_ARG;
+	}
+	for (i = 0; i < CAL_SIZES; i++)
+	{
+		best[i] = 0;
+		for (j = 0; j < CAL_REPEAT; j++)
+		{
+			// reading the first bytes of the map has no side effect
+			t0 = planNowNs();
+			if (0 != i2cMem8Read(board->dev, I2C_MEM_RELAY_VAL_ADD, buf,
+				gCalSizes[i]))
+			{
+				return IOPLUS_ERR_IO;
+			}
+			us = (planNowNs() - t0) / 1000.0;
+			if ( (j == 0) || (us < best[i]))
+			{
+				best[i] = us;
+			}
+		}
+	}
+	// least squares line through (size, time)
+	for (i = 0; i < CAL_SIZES; i++)
+	{
+		sx += gCalSizes[i];
+		sy += best[i];
+		sxx += (double)gCalSizes[i] * gCalSizes[i];
+		sxy += gCalSizes[i] * best[i];
+	}
+	b = (CAL_SIZES * sxy - sx * sy) / (CAL_SIZES * sxx - sx * sx);
+	if (b < 0)
+	{
+		b = 0;
+	}
+	cost->byteUs = (float)b;
+	cost->txUs = (float) ( (sy - b * sx) / CAL_SIZES);
+	if (cost->txUs < 0)
+	{
+		cost->txUs = 0;
+	}
+	return IOPLUS_OK;
+}
+
+int ioplusPlanMake(IoplusPlanType *plan, const IoplusCostType *cost,
+	const IoplusFieldSetType *set)
+{
+	RunType run[RUNS_MAX];
+	float best[RUNS_MAX + 1];
+	int from[RUNS_MAX + 1];
+	int group[RUNS_MAX];
+	float c;
+	int runs = 0;
+	int groups = 0;
+	int add;
+	int end;
+	int size;
+	int i;
+	int j;
+
+	if ( (NULL == plan) || (NULL == cost) || (NULL == set))
+	{
+		return IOPLUS_ERR_ARG;
+	}
+	memset(plan, 0, sizeof(IoplusPlanType));
+	plan->fields = *set;
+	for (add = 0; add < IOPLUS_MAP_SIZE; add = end)
+	{
+		for (end = add; (end < IOPLUS_MAP_SIZE) && fieldIsSet(set, end); end++)
+			;
+		if (end > add)
+		{
+			run[runs].add = add;
+			run[runs].end = end;
+			runs++;
+		}
+		else
+		{
+			end++;
+		}
+	}
+	if (runs == 0)
+	{
+		return IOPLUS_ERR_ARG;
+	}
+	/* best[j]: lowest cost of the first j runs, the last group of runs read
+	 * as one span from run from[j] to run j - 1, gaps included; a group
+	 * stops at the first gap holding a barrier */
+	best[0] = 0;
+	for (j = 1; j <= runs; j++)
+	{
+		best[j] = -1;
+		for (i = j - 1; i >= 0; i--)
+		{
+			if ( (i < j - 1) && gapHasBarrier(run[i].end, run[i + 1].add))
+			{
+				break;
+			}
+			c = best[i] + planSpanCost(cost, run[j - 1].end - run[i].add);
+			if ( (best[j] < 0) || (c < best[j]))
+			{
+				best[j] = c;
+				from[j] = i;
+			}
+		}
+	}
+	for (j = runs; j > 0; j = from[j])
+	{
+		group[groups++] = from[j];
+	}
+	// groups were found last first
+	for (i = groups - 1; i >= 0; i--)
+	{
+		j = (i > 0) ? group[i - 1] : runs;
+		add = run[group[i]].add;
+		end = run[j - 1].end;
+		while (add < end)
+		{
+			size = end - add;
+			if (size > IOPLUS_PLAN_XFER_MAX)
+			{
+				size = IOPLUS_PLAN_XFER_MAX;
+			}
+			plan->read[plan->reads].add = (uint8_t)add;
+			plan->read[plan->reads].size = (uint8_t)size;
+			plan->reads++;
+			plan->bytes += size;
+			add += size;
+		}
+	}
+	plan->costUs = best[runs];
+	return IOPLUS_OK;
+}
+
+int ioplusPlanRun(IoplusBoardType *board, const IoplusPlanType *plan,
+	uint8_t *img)
+{
+	int ret;
+	int i;
+
+	if ( (NULL == board) || (board->dev < 0) || (NULL == plan) || (NULL == img))
+	{
+		return IOPLUS_ERR_ARG;
+	}
+	for (i = 0; i < plan->reads; i++)
+	{
+		ret = i2cErrToIoplus(i2cMem8Read(board->dev, plan->read[i].add,
+			img + plan->read[i].add, plan->read[i].size));
+		if (ret != IOPLUS_OK)
+		{
+			return ret;
+		}
+	}
+	return IOPLUS_OK;
+}
+
+void ioplusPlanCacheInit(IoplusPlanCacheType *cache, const IoplusCostType *cost)
+{
+	if (NULL == cache)
+	{
+		return;
+	}
+	memset(cache, 0, sizeof(IoplusPlanCacheType));
+	if (NULL != cost)
+	{
+		cache->cost = *cost;
+	}
+	else
+	{
+		ioplusCostDefault(&cache->cost);
+	}
+}
+
+int ioplusPlanCacheGet(IoplusPlanCacheType *cache, const IoplusFieldSetType *set,
+	const IoplusPlanType **plan)
+{
+	IoplusPlanType p;
+	int victim = 0;
+	int ret;
+	int i;
+
+	if ( (NULL == cache) || (NULL == set) || (NULL == plan))
+	{
+		return IOPLUS_ERR_ARG;
+	}
+	cache->tick++;
+	for (i = 0; i < cache->plans; i++)
+	{
+		if (0 == memcmp(&cache->plan[i].fields, set, sizeof(IoplusFieldSetType)))
+		{
+			cache->used[i] = cache->tick;
+			cache->hits++;
+			*plan = &cache->plan[i];
+			return IOPLUS_OK;
+		}
+		if (cache->used[i] < cache->used[victim])
+		{
+			victim = i;
+		}
+	}
+	// planned aside, a set that can not be planned leaves the cache as it is
+	ret = ioplusPlanMake(&p, &cache->cost, set);
+	if (ret != IOPLUS_OK)
+	{
+		return ret;
+	}
+	if (cache->plans < IOPLUS_PLAN_CACHE_NO)
+	{
+		victim = cache->plans++;
+	}
+	cache->plan[victim] = p;
+	cache->used[victim] = cache->tick;
+	cache->misses++;
+	*plan = &cache->plan[victim];
+	return IOPLUS_OK;
+}
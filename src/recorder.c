@@ -0,0 +1,683 @@
+/*
+ * recorder.c:
+ *	Compact columnar log of the card signals and range queries over it.
+ *
+ *	file:	header {"IOPR", u16 version, u16 columns, u8 stack, u8 pad[3],
+ *		u32 chunk samples} followed by chunks
+ *	chunk:	header {"IOPK", u32 size, u32 samples, u32 pad, i64 first time,
+ *		i64 last time, u32 column offset[]} then the columns:
+ *		time	varint(zigzag(delta of delta)) from the second sample
+ *		delta	varint(zigzag(32 bit delta)), the first from 0
+ *		dod	varint(zigzag(32 bit delta of delta)), first value and
+ *			delta from 0
+ *		bit	one bit per sample, LSB first
+ *	The columns are synced before the chunk header is written, a chunk with
+ *	a header is always complete.
+ *
+ *	Copyright (c) 2016-2023 Sequent Microsystem
+ *	<http://www.sequentmicrosystem.com>
+ ***********************************************************************
+ */
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "libioplus.h"
+#include "varint.h"
+
+#define REC_VERSION	1
+#define REC_FILE_HDR_SIZE	16
+#define REC_CHUNK_HDR_SIZE	(32 + 4 * IOPLUS_REC_COL_NO)
+#define REC_COL_BUFF_SIZE	(IOPLUS_REC_CHUNK_SAMPLES * VARINT_MAX)
+
+typedef enum
+{
+	REC_TIME = 0,
+	REC_DELTA,
+	REC_DOD,
+	REC_BIT,
+} RecEncType;
+
+typedef struct
+{
+	const char *name;
+	int enc;
+	int isSigned;
+} RecColType;
+
+static const RecColType gRecCol[IOPLUS_REC_COL_NO] = {
+	{"time", REC_TIME, 1},
+	{"adc1", REC_DELTA, 0}, {"adc2", REC_DELTA, 0}, {"adc3", REC_DELTA, 0},
+	{"adc4", REC_DELTA, 0}, {"adc5", REC_DELTA, 0}, {"adc6", REC_DELTA, 0},
+	{"adc7", REC_DELTA, 0}, {"adc8", REC_DELTA, 0},
+	{"dac1", REC_DELTA, 0}, {"dac2", REC_DELTA, 0}, {"dac3", REC_DELTA, 0},
+	{"dac4", REC_DELTA, 0},
+	{"od1", REC_DELTA, 0}, {"od2", REC_DELTA, 0}, {"od3", REC_DELTA, 0},
+	{"od4", REC_DELTA, 0},
+	{"cputemp", REC_DELTA, 1}, {"v3v3", REC_DELTA, 0},
+	{"owb1", REC_DELTA, 1}, {"owb2", REC_DELTA, 1}, {"owb3", REC_DELTA, 1},
+	{"owb4", REC_DELTA, 1}, {"owb5", REC_DELTA, 1}, {"owb6", REC_DELTA, 1},
+	{"owb7", REC_DELTA, 1}, {"owb8", REC_DELTA, 1},
+	{"relay1", REC_BIT, 0}, {"relay2", REC_BIT, 0}, {"relay3", REC_BIT, 0},
+	{"relay4", REC_BIT, 0}, {"relay5", REC_BIT, 0}, {"relay6", REC_BIT, 0},
+	{"relay7", REC_BIT, 0}, {"relay8", REC_BIT, 0},
+	{"opto1", REC_BIT, 0}, {"opto2", REC_BIT, 0}, {"opto3", REC_BIT, 0},
+	{"opto4", REC_BIT, 0}, {"opto5", REC_BIT, 0}, {"opto6", REC_BIT, 0},
+	{"opto7", REC_BIT, 0}, {"opto8", REC_BIT, 0},
+	{"gpio1", REC_BIT, 0}, {"gpio2", REC_BIT, 0}, {"gpio3", REC_BIT, 0},
+	{"gpio4", REC_BIT, 0},
+	{"optocnt1", REC_DOD, 0}, {"optocnt2", REC_DOD, 0}, {"optocnt3", REC_DOD, 0},
+	{"optocnt4", REC_DOD, 0}, {"optocnt5", REC_DOD, 0}, {"optocnt6", REC_DOD, 0},
+	{"optocnt7", REC_DOD, 0}, {"optocnt8", REC_DOD, 0},
+	{"gpiocnt1", REC_DOD, 0}, {"gpiocnt2", REC_DOD, 0}, {"gpiocnt3", REC_DOD, 0},
+	{"gpiocnt4", REC_DOD, 0},
+	{"optoenc1", REC_DOD, 1}, {"optoenc2", REC_DOD, 1}, {"optoenc3", REC_DOD, 1},
+	{"optoenc4", REC_DOD, 1},
+	{"gpioenc", REC_DOD, 1},
+	{"odcnt1", REC_DOD, 0}, {"odcnt2", REC_DOD, 0}, {"odcnt3", REC_DOD, 0},
+	{"odcnt4", REC_DOD, 0},
+};
+
+// first column of each group in gRecCol
+#define COL_ADC	1
+#define COL_DAC	9
+#define COL_OD	13
+#define COL_CPU_TEMP	17
+#define COL_V3V3	18
+#define COL_OWB	19
+#define COL_RELAY	27
+#define COL_OPTO	35
+#define COL_GPIO	43
+#define COL_CNT	47
+
+// values of a signal column, time has its own array
+#define COL_VAL(REC, COL)	((REC)->val[(COL) - 1])
+
+static int64_t recNowMs(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_REALTIME, &ts);
+	return (int64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+const char* ioplusRecColName(int col)
+{
+	if ( (col < 0) || (col >= IOPLUS_REC_COL_NO))
+	{
+		return NULL;
+	}
+	return gRecCol[col].name;
+}
+
+int ioplusRecColFind(const char *name)
+{
+	int col;
+
+	for (col = 0; (NULL != name) && (col < IOPLUS_REC_COL_NO); col++)
+	{
+		if (0 == strcmp(name, gRecCol[col].name))
+		{
+			return col;
+		}
+	}
+	return IOPLUS_ERR_ARG;
+}
+
+//---------------------------------------------------------------------- writer
+static int fileHdrCheck(const uint8_t *hdr, int *stack)
+{
+	uint16_t val16;
+	uint32_t val32;
+
+	memcpy(&val16, hdr + 6, 2);
+	memcpy(&val32, hdr + 12, 4);
+	if ( (0 != memcmp(hdr, "IOPR", 4)) || (val16 != IOPLUS_REC_COL_NO)
+		|| (val32 != IOPLUS_REC_CHUNK_SAMPLES))
+	{
+		return IOPLUS_ERR_ARG;
+	}
+	*stack = hdr[8];
+	return IOPLUS_OK;
+}
+
+/* the column offsets of a chunk header go up from the end of the header
+ * and stay inside the chunk */
+static int chunkOffsetsOk(const uint8_t *hdr, uint32_t size)
+{
+	uint32_t prev = REC_CHUNK_HDR_SIZE;
+	uint32_t off;
+	int col;
+
+	for (col = 0; col < IOPLUS_REC_COL_NO; col++)
+	{
+		memcpy(&off, hdr + 32 + 4 * col, 4);
+		if ( (off < prev) || (off > size))
+		{
+			return 0;
+		}
+		prev = off;
+	}
+	return 1;
+}
+
+/* end of the last complete chunk, the file is cut there when a power loss
+ * interrupted the chunk after it */
+static uint64_t chunksEnd(int fd, uint64_t size)
+{
+	uint8_t hdr[REC_CHUNK_HDR_SIZE];
+	uint64_t pos = REC_FILE_HDR_SIZE;
+	uint32_t chunk;
+
+	while (pos + REC_CHUNK_HDR_SIZE <= size)
+	{
+		if ( (sizeof(hdr) != pread(fd, hdr, sizeof(hdr), pos))
+			|| (0 != memcmp(hdr, "IOPK", 4)))
+		{
+			break;
+		}
+		memcpy(&chunk, hdr + 4, 4);
+		if ( (chunk < REC_CHUNK_HDR_SIZE) || (pos + chunk > size)
+			|| !chunkOffsetsOk(hdr, chunk))
+		{
+			break;
+		}
+		pos += chunk;
+	}
+	return pos;
+}
+
+int ioplusRecOpen(IoplusRecorderType *rec, const char *path, int stack,
+	uint32_t flushMs)
+{
+	uint8_t hdr[REC_FILE_HDR_SIZE];
+	uint16_t val16;
+	uint32_t val32;
+	struct stat st;
+	int fileStack;
+
+	if ( (NULL == rec) || (NULL == path) || (stack < 0)
+		|| (stack >= IOPLUS_STACK_MAX))
+	{
+		return IOPLUS_ERR_ARG;
+	}
+	memset(rec, 0, sizeof(IoplusRecorderType));
+	rec->stack = stack;
+	rec->flushMs = flushMs;
+	rec->fd = open(path, O_RDWR | O_CREAT, 0644);
+	if (rec->fd < 0)
+	{
+		return IOPLUS_ERR_IO;
+	}
+	if (0 != fstat(rec->fd, &st))
+	{
+		goto ioErr;
+	}
+	if (st.st_size >= REC_FILE_HDR_SIZE)
+	{
+		if ( (REC_FILE_HDR_SIZE != pread(rec->fd, hdr, REC_FILE_HDR_SIZE, 0))
+			|| (IOPLUS_OK != fileHdrCheck(hdr, &fileStack)) || (fileStack != stack))
+		{
+			// not a log of this card, keep it untouched
+			close(rec->fd);
+			rec->fd = -1;
+			return IOPLUS_ERR_ARG;
+		}
+		rec->size = chunksEnd(rec->fd, st.st_size);
+		if ( (rec->size != (uint64_t)st.st_size)
+			&& (0 != ftruncate(rec->fd, rec->size)))
+		{
+			goto ioErr;
+		}
+		return IOPLUS_OK;
+	}
+	memset(hdr, 0, sizeof(hdr));
+	memcpy(hdr, "IOPR", 4);
+	val16 = REC_VERSION;
+	memcpy(hdr + 4, &val16, 2);
+	val16 = IOPLUS_REC_COL_NO;
+	memcpy(hdr + 6, &val16, 2);
+	hdr[8] = (uint8_t)stack;
+	val32 = IOPLUS_REC_CHUNK_SAMPLES;
+	memcpy(hdr + 12, &val32, 4);
+	if ( (0 != ftruncate(rec->fd, 0))
+		|| (REC_FILE_HDR_SIZE != pwrite(rec->fd, hdr, REC_FILE_HDR_SIZE, 0)))
+	{
+		goto ioErr;
+	}
+	rec->size = REC_FILE_HDR_SIZE;
+	return IOPLUS_OK;
+
+ioErr:
+	close(rec->fd);
+	rec->fd = -1;
+	return IOPLUS_ERR_IO;
+}
+
+static int colEncode(const IoplusRecorderType *rec, int col, uint8_t *buff)
+{
+	const uint32_t *v = (col > 0) ? COL_VAL(rec, col) : NULL;
+	int64_t delta;
+	int64_t prev = 0;
+	int len = 0;
+	int i;
+
+	switch (gRecCol[col].enc)
+	{
+	case REC_TIME:
+		for (i = 1; i < (int)rec->samples; i++)
+		{
+			delta = rec->time[i] - rec->time[i - 1];
+			len += varintPut(buff + len, zigzag(delta - prev));
+			prev = delta;
+		}
+		break;
+	case REC_BIT:
+		len = (rec->samples + 7) / 8;
+		memset(buff, 0, len);
+		for (i = 0; i < (int)rec->samples; i++)
+		{
+			buff[i / 8] |= (v[i] & 1) << (i % 8);
+		}
+		break;
+	case REC_DELTA:
+		for (i = 0; i < (int)rec->samples; i++)
+		{
+			len += varintPut(buff + len,
+				zigzag((int32_t) (v[i] - (i ? v[i - 1] : 0))));
+		}
+		break;
+	default:
+		for (i = 0; i < (int)rec->samples; i++)
+		{
+			delta = (int32_t) (v[i] - (i ? v[i - 1] : 0));
+			len += varintPut(buff + len, zigzag((int32_t) (delta - prev)));
+			prev = delta;
+		}
+		break;
+	}
+	return len;
+}
+
+int ioplusRecFlush(IoplusRecorderType *rec)
+{
+	uint8_t hdr[REC_CHUNK_HDR_SIZE];
+	uint8_t buff[REC_COL_BUFF_SIZE];
+	uint32_t off = REC_CHUNK_HDR_SIZE;
+	uint32_t val32;
+	int len;
+	int col;
+
+	if ( (NULL == rec) || (rec->fd < 0))
+	{
+		return IOPLUS_ERR_ARG;
+	}
+	if (rec->samples == 0)
+	{
+		return IOPLUS_OK;
+	}
+	memset(hdr, 0, sizeof(hdr));
+	for (col = 0; col < IOPLUS_REC_COL_NO; col++)
+	{
+		memcpy(hdr + 32 + 4 * col, &off, 4);
+		len = colEncode(rec, col, buff);
+		if ( (len > 0) && (len != pwrite(rec->fd, buff, len, rec->size + off)))
+		{
+			return IOPLUS_ERR_IO;
+		}
+		off += len;
+	}
+	if (0 != fdatasync(rec->fd))
+	{
+		return IOPLUS_ERR_IO;
+	}
+	memcpy(hdr, "IOPK", 4);
+	memcpy(hdr + 4, &off, 4);
+	val32 = rec->samples;
+	memcpy(hdr + 8, &val32, 4);
+	memcpy(hdr + 16, &rec->time[0], 8);
+	memcpy(hdr + 24, &rec->time[rec->samples - 1], 8);
+	if ( (REC_CHUNK_HDR_SIZE != pwrite(rec->fd, hdr, REC_CHUNK_HDR_SIZE,
+		rec->size)) || (0 != fdatasync(rec->fd)))
+	{
+		return IOPLUS_ERR_IO;
+	}
+	rec->size += off;
+	rec->bytes += off;
+	rec->total += rec->samples;
+	rec->chunks++;
+	rec->samples = 0;
+	return IOPLUS_OK;
+}
+
+int ioplusRecAdd(IoplusRecorderType *rec, int64_t ms,
+	const IoplusSnapshotType *snap)
+{
+	int n;
+	int i;
+
+	if ( (NULL == rec) || (NULL == snap) || (rec->fd < 0))
+	{
+		return IOPLUS_ERR_ARG;
+	}
+	// a full chunk whose flush failed is tried again, no sample taken before
+	if ( (rec->samples >= IOPLUS_REC_CHUNK_SAMPLES)
+		&& (IOPLUS_OK != ioplusRecFlush(rec)))
+	{
+		return IOPLUS_ERR_IO;
+	}
+	n = rec->samples;
+	rec->time[n] = ms;
+	for (i = 0; i < IOPLUS_ADC_CH_NO; i++)
+	{
+		COL_VAL(rec, COL_ADC + i)[n] = snap->adcMv[i];
+	}
+	for (i = 0; i < IOPLUS_DAC_CH_NO; i++)
+	{
+		COL_VAL(rec, COL_DAC + i)[n] = snap->dacMv[i];
+	}
+	for (i = 0; i < IOPLUS_OD_CH_NO; i++)
+	{
+		COL_VAL(rec, COL_OD + i)[n] = snap->odPwm[i];
+	}
+	COL_VAL(rec, COL_CPU_TEMP)[n] = (uint32_t)snap->cpuTemp;
+	COL_VAL(rec, COL_V3V3)[n] = snap->v3v3Mv;
+	for (i = 0; i < IOPLUS_OWB_SENS_NO; i++)
+	{
+		COL_VAL(rec, COL_OWB + i)[n] = (uint32_t) (int32_t)snap->owbTemp[i];
+	}
+	for (i = 0; i < IOPLUS_RELAY_CH_NO; i++)
+	{
+		COL_VAL(rec, COL_RELAY + i)[n] = (snap->relay >> i) & 1;
+	}
+	for (i = 0; i < IOPLUS_OPTO_CH_NO; i++)
+	{
+		COL_VAL(rec, COL_OPTO + i)[n] = (snap->opto >> i) & 1;
+	}
+	for (i = 0; i < IOPLUS_GPIO_CH_NO; i++)
+	{
+		COL_VAL(rec, COL_GPIO + i)[n] = (snap->gpio >> i) & 1;
+	}
+	for (i = 0; i < IOPLUS_CNT_NO; i++)
+	{
+		COL_VAL(rec, COL_CNT + i)[n] = snap->cnt[i];
+	}
+	rec->samples++;
+	if ( (rec->samples == IOPLUS_REC_CHUNK_SAMPLES)
+		|| (ms - rec->time[0] >= (int64_t)rec->flushMs))
+	{
+		return ioplusRecFlush(rec);
+	}
+	return IOPLUS_OK;
+}
+
+int ioplusRecSample(IoplusBoardType *board, IoplusRecorderType *rec)
+{
+	IoplusSnapshotType snap;
+	int ret;
+
+	ret = ioplusSnapshotGet(board, &snap);
+	if (ret != IOPLUS_OK)
+	{
+		return ret;
+	}
+	return ioplusRecAdd(rec, recNowMs(), &snap);
+}
+
+int ioplusRecClose(IoplusRecorderType *rec)
+{
+	int ret;
+
+	if ( (NULL == rec) || (rec->fd < 0))
+	{
+		return IOPLUS_ERR_ARG;
+	}
+	ret = ioplusRecFlush(rec);
+	close(rec->fd);
+	rec->fd = -1;
+	return ret;
+}
+
+//---------------------------------------------------------------------- reader
+int ioplusRecReaderOpen(IoplusRecReaderType *r, const char *path)
+{
+	struct stat st;
+	void *map;
+	int fd;
+
+	if ( (NULL == r) || (NULL == path))
+	{
+		return IOPLUS_ERR_ARG;
+	}
+	memset(r, 0, sizeof(IoplusRecReaderType));
+	fd = open(path, O_RDONLY);
+	if (fd < 0)
+	{
+		return IOPLUS_ERR_IO;
+	}
+	if ( (0 != fstat(fd, &st)) || (st.st_size < REC_FILE_HDR_SIZE))
+	{
+		close(fd);
+		return IOPLUS_ERR_IO;
+	}
+	map = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);
+	if (MAP_FAILED == map)
+	{
+		return IOPLUS_ERR_IO;
+	}
+	r->map = map;
+	r->size = st.st_size;
+	if (IOPLUS_OK != fileHdrCheck(r->map, &r->stack))
+	{
+		ioplusRecReaderClose(r);
+		return IOPLUS_ERR_ARG;
+	}
+	return IOPLUS_OK;
+}
+
+void ioplusRecReaderClose(IoplusRecReaderType *r)
+{
+	if ( (NULL == r) || (NULL == r->map))
+	{
+		return;
+	}
+	munmap((void*)r->map, r->size);
+	r->map = NULL;
+}
+
+int ioplusRecInfo(IoplusRecReaderType *r, IoplusRecInfoType *info)
+{
+	uint64_t pos = REC_FILE_HDR_SIZE;
+	uint32_t size;
+	uint32_t samples;
+
+	if ( (NULL == r) || (NULL == r->map) || (NULL == info))
+	{
+		return IOPLUS_ERR_ARG;
+	}
+	memset(info, 0, sizeof(IoplusRecInfoType));
+	info->bytes = r->size;
+	while (pos + REC_CHUNK_HDR_SIZE <= r->size)
+	{
+		memcpy(&size, r->map + pos + 4, 4);
+		if ( (0 != memcmp(r->map + pos, "IOPK", 4))
+			|| (size < REC_CHUNK_HDR_SIZE) || (pos + size > r->size))
+		{
+			break;
+		}
+		memcpy(&samples, r->map + pos + 8, 4);
+		if (info->chunks == 0)
+		{
+			memcpy(&info->firstMs, r->map + pos + 16, 8);
+		}
+		memcpy(&info->lastMs, r->map + pos + 24, 8);
+		info->samples += samples;
+		info->chunks++;
+		pos += size;
+	}
+	return IOPLUS_OK;
+}
+
+/* decode the time and one value column of a chunk, 0 when a column is
+ * damaged */
+static int chunkDecode(const uint8_t *chunk, uint32_t size, int col,
+	int64_t *t, int64_t *val)
+{
+	const uint8_t *p;
+	const uint8_t *end;
+	uint32_t samples;
+	uint32_t off[2];
+	uint64_t u;
+	uint32_t v = 0;
+	int64_t delta = 0;
+	uint32_t i;
+	int n;
+
+	memcpy(&samples, chunk + 8, 4);
+	memcpy(&t[0], chunk + 16, 8);
+	if ( (samples == 0) || (samples > IOPLUS_REC_CHUNK_SAMPLES)
+		|| !chunkOffsetsOk(chunk, size))
+	{
+		return 0;
+	}
+	memcpy(off, chunk + 32, 4);
+	memcpy(off + 1, chunk + 32 + 4 * 1, 4);
+	p = chunk + off[0];
+	end = chunk + off[1];
+	for (i = 1; i < samples; i++)
+	{
+		n = varintGet(p, end, &u);
+		if (n == 0)
+		{
+			return 0;
+		}
+		p += n;
+		delta += unzigzag(u);
+		t[i] = t[i - 1] + delta;
+	}
+	memcpy(off, chunk + 32 + 4 * col, 4);
+	off[1] = size;
+	if (col + 1 < IOPLUS_REC_COL_NO)
+	{
+		memcpy(off + 1, chunk + 32 + 4 * (col + 1), 4);
+	}
+	p = chunk + off[0];
+	end = chunk + off[1];
+	delta = 0;
+	for (i = 0; i < samples; i++)
+	{
+		if (gRecCol[col].enc == REC_BIT)
+		{
+			if (p + i / 8 >= end)
+			{
+				return 0;
+			}
+			val[i] = (p[i / 8] >> (i % 8)) & 1;
+			continue;
+		}
+		n = varintGet(p, end, &u);
+		if (n == 0)
+		{
+			return 0;
+		}
+		p += n;
+		if (gRecCol[col].enc == REC_DELTA)
+		{
+			v += (uint32_t)unzigzag(u);
+		}
+		else
+		{
+			delta = (int32_t) (delta + unzigzag(u));
+			v += (uint32_t)delta;
+		}
+		val[i] = gRecCol[col].isSigned ? (int64_t) (int32_t)v : (int64_t)v;
+	}
+	return 1;
+}
+
+static int bucketEmit(IoplusRecPointType *b, IoplusRecCbType cb, void *ctx)
+{
+	int stop = 0;
+
+	if (b->count > 0)
+	{
+		b->avg /= b->count;
+		stop = cb(ctx, b);
+	}
+	b->count = 0;
+	return stop;
+}
+
+int ioplusRecQuery(IoplusRecReaderType *r, int col, int64_t fromMs,
+	int64_t toMs, int64_t stepMs, IoplusRecCbType cb, void *ctx)
+{
+	int64_t t[IOPLUS_REC_CHUNK_SAMPLES];
+	int64_t val[IOPLUS_REC_CHUNK_SAMPLES];
+	IoplusRecPointType b;
+	uint64_t pos = REC_FILE_HDR_SIZE;
+	uint32_t size;
+	uint32_t samples;
+	int64_t t0;
+	int64_t t1;
+	int64_t slot;
+	uint32_t i;
+
+	if ( (NULL == r) || (NULL == r->map) || (NULL == cb) || (col < 1)
+		|| (col >= IOPLUS_REC_COL_NO) || (stepMs < 0))
+	{
+		return IOPLUS_ERR_ARG;
+	}
+	memset(&b, 0, sizeof(b));
+	while (pos + REC_CHUNK_HDR_SIZE <= r->size)
+	{
+		memcpy(&size, r->map + pos + 4, 4);
+		if ( (0 != memcmp(r->map + pos, "IOPK", 4))
+			|| (size < REC_CHUNK_HDR_SIZE) || (pos + size > r->size))
+		{
+			break;
+		}
+		memcpy(&samples, r->map + pos + 8, 4);
+		memcpy(&t0, r->map + pos + 16, 8);
+		memcpy(&t1, r->map + pos + 24, 8);
+		if ( (t1 < fromMs) || (t0 > toMs))
+		{
+			pos += size;
+			continue;
+		}
+		if (!chunkDecode(r->map + pos, size, col, t, val))
+		{
+			return IOPLUS_ERR_IO;
+		}
+		for (i = 0; i < samples; i++)
+		{
+			if ( (t[i] < fromMs) || (t[i] > toMs))
+			{
+				continue;
+			}
+			slot = (stepMs > 0) ? t[i] - ( (t[i] % stepMs) + stepMs) % stepMs : t[i];
+			if ( (b.count > 0) && (slot != b.t) && bucketEmit(&b, cb, ctx))
+			{
+				return IOPLUS_OK;
+			}
+			if (b.count == 0)
+			{
+				b.t = slot;
+				b.min = b.max = val[i];
+				b.avg = 0;
+			}
+			b.min = (val[i] < b.min) ? val[i] : b.min;
+			b.max = (val[i] > b.max) ? val[i] : b.max;
+			b.avg += val[i];
+			b.count++;
+		}
+		pos += size;
+	}
+	bucketEmit(&b, cb, ctx);
+	return IOPLUS_OK;
+}
@@ -0,0 +1,625 @@
+/*
+ * rules.c:
+ *	Host side interlock rules. Every rule is compiled into postfix ops of a
+ *	small boolean stack machine and all the rules share one flat table, so
+ *	an evaluation is a single pass with no allocation and no branching on
+ *	the rule text. Only the card registers the rules read are polled and
+ *	only the outputs that changed are written.
+ *
+ *	Copyright (c) 2016-2023 Sequent Microsystem
+ *	<http://www.sequentmicrosystem.com>
+ ***********************************************************************
+ */
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <time.h>
+
+#include "libioplus.h"
+
+#define RULES_FILE_MAX	65536
+#define RULES_LINE_MAX	256
+
+enum
+{
+	OP_CONST = 0,
+	OP_RELAY, // arg: channel - 1
+	OP_OPTO,
+	OP_GPIO,
+	OP_ADC_GT, // arg: channel - 1, thresholds in mV
+	OP_ADC_LT,
+	OP_OWB_GT, // thresholds in 0.01 degC
+	OP_OWB_LT,
+	OP_NOT,
+	OP_AND,
+	OP_OR,
+	OP_OUT, // arg: IOPLUS_RULE_OUT_xxx bit
+};
+
+typedef struct
+{
+	IoplusRulesType *r;
+	const char *p;
+	int depth;
+	const char *err;
+} RuleParseType;
+
+static uint64_t rulesNowNs(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static void ruleSkip(RuleParseType *ps)
+{
+	while (isspace((unsigned char)*ps->p))
+	{
+		ps->p++;
+	}
+}
+
+static int ruleEmit(RuleParseType *ps, int op, int arg, int32_t on, int32_t off)
+{
+	IoplusRuleOpType *o;
+
+	if (ps->r->ops >= IOPLUS_RULES_OPS_MAX)
+	{
+		ps->err = "too many rules";
+		return -1;
+	}
+	if (op <= OP_OWB_LT)
+	{
+		ps->depth++;
+	}
+	else if (op != OP_NOT)
+	{
+		ps->depth--;
+	}
+	if (ps->depth > IOPLUS_RULES_STACK_MAX)
+	{
+		ps->err = "condition nested too deep";
+		return -1;
+	}
+	o = &ps->r->op[ps->r->ops++];
+	o->op = (uint8_t)op;
+	o->arg = (uint8_t)arg;
+	o->state = 0;
+	o->on = on;
+	o->off = off;
+	return 0;
+}
+
+// <letters><channel>, returns the channel or -1
+static int ruleName(RuleParseType *ps, char *name, int size)
+{
+	int n = 0;
+	char *end;
+	long ch;
+
+	ruleSkip(ps);
+	while (isalpha((unsigned char)*ps->p) && (n < size - 1))
+	{
+		name[n++] = *ps->p++;
+	}
+	name[n] = 0;
+	if ( (n == 0) || !isdigit((unsigned char)*ps->p))
+	{
+		return -1;
+	}
+	ch = strtol(ps->p, &end, 10);
+	ps->p = end;
+	return (int)ch;
+}
+
+static int ruleNumber(RuleParseType *ps, float *val)
+{
+	char *end;
+
+	ruleSkip(ps);
+	*val = strtof(ps->p, &end);
+	if (end == ps->p)
+	{
+		ps->err = "number expected";
+		return -1;
+	}
+	ps->p = end;
+	return 0;
+}
+
+// adc<n> / owb<n> followed by > or < <threshold> [~ <hysteresis>]
+static int ruleCompare(RuleParseType *ps, int gtOp, int ch, float scale)
+{
+	float thr;
+	float hyst = 0;
+	int gt;
+	int32_t on;
+	int32_t off;
+
+	ruleSkip(ps);
+	if ( (*ps->p != '>') && (*ps->p != '<'))
+	{
+		ps->err = "> or < expected";
+		return -1;
+	}
+	gt = *ps->p++ == '>';
+	if (ruleNumber(ps, &thr) != 0)
+	{
+		return -1;
+	}
+	ruleSkip(ps);
+	if (*ps->p == '~')
+	{
+		ps->p++;
+		if (ruleNumber(ps, &hyst) != 0)
+		{
+			return -1;
+		}
+		if (hyst < 0)
+		{
+			ps->err = "negative hysteresis";
+			return -1;
+		}
+	}
+	on = (int32_t) (thr * scale + (thr < 0 ? -0.5f : 0.5f));
+	off = (int32_t) (hyst * scale + 0.5f);
+	off = gt ? on - off : on + off;
+	return ruleEmit(ps, gt ? gtOp : gtOp + 1, ch - 1, on, off);
+}
+
+static int ruleOr(RuleParseType *ps);
+
+static int ruleUnary(RuleParseType *ps)
+{
+	char name[8];
+	int ch;
+
+	ruleSkip(ps);
+	if (*ps->p == '!')
+	{
+		ps->p++;
+		if (ruleUnary(ps) != 0)
+		{
+			return -1;
+		}
+		return ruleEmit(ps, OP_NOT, 0, 0, 0);
+	}
+	if (*ps->p == '(')
+	{
+		ps->p++;
+		if (ruleOr(ps) != 0)
+		{
+			return -1;
+		}
+		ruleSkip(ps);
+		if (*ps->p != ')')
+		{
+			ps->err = ") expected";
+			return -1;
+		}
+		ps->p++;
+		return 0;
+	}
+	if ( (*ps->p == '0' || *ps->p == '1') && !isalnum((unsigned char)ps->p[1]))
+	{
+		return ruleEmit(ps, OP_CONST, *ps->p++ - '0', 0, 0);
+	}
+	ch = ruleName(ps, name, sizeof(name));
+	if ( (strcmp(name, "opto") == 0) && (ch >= 1) && (ch <= IOPLUS_OPTO_CH_NO))
+	{
+		ps->r->parts |= IOPLUS_SNAP_DIGITAL;
+		return ruleEmit(ps, OP_OPTO, ch - 1, 0, 0);
+	}
+	if ( (strcmp(name, "gpio") == 0) && (ch >= 1) && (ch <= IOPLUS_GPIO_CH_NO))
+	{
+		ps->r->parts |= IOPLUS_SNAP_DIGITAL;
+		return ruleEmit(ps, OP_GPIO, ch - 1, 0, 0);
+	}
+	if ( (strcmp(name, "relay") == 0) && (ch >= 1)
+		&& (ch <= IOPLUS_RELAY_CH_NO))
+	{
+		ps->r->parts |= IOPLUS_SNAP_DIGITAL;
+		return ruleEmit(ps, OP_RELAY, ch - 1, 0, 0);
+	}
+	if ( (strcmp(name, "adc") == 0) && (ch >= 1) && (ch <= IOPLUS_ADC_CH_NO))
+	{
+		ps->r->parts |= IOPLUS_SNAP_ANALOG;
+		return ruleCompare(ps, OP_ADC_GT, ch, 1000);
+	}
+	if ( (strcmp(name, "owb") == 0) && (ch >= 1) && (ch <= IOPLUS_OWB_SENS_NO))
+	{
+		ps->r->parts |= IOPLUS_SNAP_OWB;
+		return ruleCompare(ps, OP_OWB_GT, ch, 100);
+	}
+	ps->err = "unknown input";
+	return -1;
+}
+
+static int ruleAnd(RuleParseType *ps)
+{
+	if (ruleUnary(ps) != 0)
+	{
+		return -1;
+	}
+	for (;;)
+	{
+		ruleSkip(ps);
+		if (*ps->p != '&')
+		{
+			return 0;
+		}
+		ps->p++;
+		if ( (ruleUnary(ps) != 0) || (ruleEmit(ps, OP_AND, 0, 0, 0) != 0))
+		{
+			return -1;
+		}
+	}
+}
+
+static int ruleOr(RuleParseType *ps)
+{
+	if (ruleAnd(ps) != 0)
+	{
+		return -1;
+	}
+	for (;;)
+	{
+		ruleSkip(ps);
+		if (*ps->p != '|')
+		{
+			return 0;
+		}
+		ps->p++;
+		if ( (ruleAnd(ps) != 0) || (ruleEmit(ps, OP_OR, 0, 0, 0) != 0))
+		{
+			return -1;
+		}
+	}
+}
+
+// <output> = <condition>
+static int ruleLine(RuleParseType *ps)
+{
+	char name[8];
+	int bit = -1;
+	int ch;
+
+	ch = ruleName(ps, name, sizeof(name));
+	if ( (strcmp(name, "relay") == 0) && (ch >= 1) && (ch <= IOPLUS_RELAY_CH_NO))
+	{
+		bit = IOPLUS_RULE_OUT_RELAY + ch - 1;
+	}
+	else if ( (strcmp(name, "gpio") == 0) && (ch >= 1)
+		&& (ch <= IOPLUS_GPIO_CH_NO))
+	{
+		bit = IOPLUS_RULE_OUT_GPIO + ch - 1;
+	}
+	else if ( (strcmp(name, "od") == 0) && (ch >= 1) && (ch <= IOPLUS_OD_CH_NO))
+	{
+		bit = IOPLUS_RULE_OUT_OD + ch - 1;
+	}
+	if (bit < 0)
+	{
+		ps->err = "unknown output";
+		return -1;
+	}
+	if (ps->r->driven & (1UL << bit))
+	{
+		ps->err = "output already assigned";
+		return -1;
+	}
+	ruleSkip(ps);
+	if (*ps->p++ != '=')
+	{
+		ps->err = "= expected";
+		return -1;
+	}
+	ps->depth = 0;
+	if ( (ruleOr(ps) != 0) || (ruleEmit(ps, OP_OUT, bit, 0, 0) != 0))
+	{
+		return -1;
+	}
+	ruleSkip(ps);
+	if (*ps->p != 0)
+	{
+		ps->err = "unexpected text after the condition";
+		return -1;
+	}
+	ps->r->driven |= 1UL << bit;
+	ps->r->rules++;
+	return 0;
+}
+
+int ioplusRulesCompile(IoplusRulesType *r, const char *text)
+{
+	char line[RULES_LINE_MAX];
+	RuleParseType ps;
+	const char *end;
+	int len;
+	int n;
+
+	if ( (NULL == r) || (NULL == text))
+	{
+		return IOPLUS_ERR_ARG;
+	}
+	memset(r, 0, sizeof(IoplusRulesType));
+	r->stats.evalNsMin = UINT32_MAX;
+	r->stats.reactUsMin = UINT32_MAX;
+	ps.r = r;
+	for (n = 1; *text; n++, text = *end ? end + 1 : end)
+	{
+		end = strchr(text, '\n');
+		if (NULL == end)
+		{
+			end = text + strlen(text);
+		}
+		len = (int) (end - text);
+		if (len >= RULES_LINE_MAX)
+		{
+			r->errLine = n;
+			snprintf(r->err, sizeof(r->err), "line too long");
+			return IOPLUS_ERR_ARG;
+		}
+		memcpy(line, text, len);
+		line[len] = 0;
+		if (strchr(line, '#'))
+		{
+			*strchr(line, '#') = 0;
+		}
+		ps.p = line;
+		ruleSkip(&ps);
+		if (*ps.p == 0)
+		{
+			continue;
+		}
+		ps.err = NULL;
+		if (ruleLine(&ps) != 0)
+		{
+			r->errLine = n;
+			snprintf(r->err, sizeof(r->err), "%s", ps.err);
+			return IOPLUS_ERR_ARG;
+		}
+	}
+	if (r->rules == 0)
+	{
+		snprintf(r->err, sizeof(r->err), "no rule");
+		return IOPLUS_ERR_ARG;
+	}
+	return IOPLUS_OK;
+}
+
+int ioplusRulesLoad(IoplusRulesType *r, const char *path)
+{
+	char *text;
+	FILE *f;
+	size_t size;
+	int err;
+	int ret;
+
+	if ( (NULL == r) || (NULL == path))
+	{
+		return IOPLUS_ERR_ARG;
+	}
+	memset(r, 0, sizeof(IoplusRulesType));
+	f = fopen(path, "r");
+	if (NULL == f)
+	{
+		snprintf(r->err, sizeof(r->err), "can not open the file");
+		return IOPLUS_ERR_IO;
+	}
+	text = malloc(RULES_FILE_MAX);
+	if (NULL == text)
+	{
+		fclose(f);
+		snprintf(r->err, sizeof(r->err), "out of memory");
+		return IOPLUS_ERR_IO;
+	}
+	// one byte more than fits tells a file too large from one that just fits
+	size = fread(text, 1, RULES_FILE_MAX, f);
+	err = ferror(f);
+	fclose(f);
+	if (err)
+	{
+		snprintf(r->err, sizeof(r->err), "can not read the file");
+		ret = IOPLUS_ERR_IO;
+	}
+	else if (size > RULES_FILE_MAX - 1)
+	{
+		// a rule set cut short would run part of the interlocks
+		snprintf(r->err, sizeof(r->err), "file larger than %d bytes",
+			RULES_FILE_MAX - 1);
+		ret = IOPLUS_ERR_ARG;
+	}
+	else
+	{
+		text[size] = 0;
+		ret = ioplusRulesCompile(r, text);
+	}
+	free(text);
+	return ret;
+}
+
+int ioplusRulesEval(IoplusRulesType *r, const IoplusSnapshotType *in,
+	uint32_t *out)
+{
+	uint8_t stack[IOPLUS_RULES_STACK_MAX + 1];
+	IoplusRuleOpType *o;
+	IoplusRuleOpType *end;
+	uint32_t bits = 0;
+	int32_t v;
+	int sp = 0;
+
+	if ( (NULL == r) || (NULL == in) || (NULL == out))
+	{
+		return IOPLUS_ERR_ARG;
+	}
+	for (o = r->op, end = r->op + r->ops; o < end; o++)
+	{
+		switch (o->op)
+		{
+		case OP_CONST:
+			stack[sp++] = o->arg;
+			break;
+		case OP_RELAY:
+			stack[sp++] = (in->relay >> o->arg) & 1;
+			break;
+		case OP_OPTO:
+			stack[sp++] = (in->opto >> o->arg) & 1;
+			break;
+		case OP_GPIO:
+			stack[sp++] = (in->gpio >> o->arg) & 1;
+			break;
+		case OP_ADC_GT:
+		case OP_OWB_GT:
+			v = (o->op == OP_ADC_GT) ? in->adcMv[o->arg] : in->owbTemp[o->arg];
+			o->state = v > (o->state ? o->off : o->on);
+			stack[sp++] = o->state;
+			break;
+		case OP_ADC_LT:
+		case OP_OWB_LT:
+			v = (o->op == OP_ADC_LT) ? in->adcMv[o->arg] : in->owbTemp[o->arg];
+			o->state = v < (o->state ? o->off : o->on);
+			stack[sp++] = o->state;
+			break;
+		case OP_NOT:
+			stack[sp - 1] ^= 1;
+			break;
+		case OP_AND:
+			sp--;
+			stack[sp - 1] &= stack[sp];
+			break;
+		case OP_OR:
+			sp--;
+			stack[sp - 1] |= stack[sp];
+			break;
+		case OP_OUT:
+			bits |= (uint32_t)stack[--sp] << o->arg;
+			break;
+		default:
+			break;
+		}
+	}
+	*out = bits;
+	return IOPLUS_OK;
+}
+
+int ioplusRulesStep(IoplusBoardType *board, IoplusRulesType *r,
+	uint32_t *changed)
+{
+	IoplusTxType tx;
+	uint64_t t0;
+	uint64_t t1;
+	uint32_t out = 0;
+	uint32_t diff;
+	uint32_t ns;
+	uint32_t us;
+	int ret;
+	int i;
+
+	if (changed)
+	{
+		*changed = 0;
+	}
+	if ( (NULL == board) || (NULL == r) || (r->rules == 0))
+	{
+		return IOPLUS_ERR_ARG;
+	}
+	r->stats.cycles++;
+	t0 = rulesNowNs();
+	ret = ioplusSnapshotPartGet(board, &r->in, r->parts);
+	if (ret != IOPLUS_OK)
+	{
+		r->stats.errors++;
+		return ret;
+	}
+	t1 = rulesNowNs();
+	ioplusRulesEval(r, &r->in, &out);
+	ns = (uint32_t) (rulesNowNs() - t1);
+	if (ns < r->stats.evalNsMin)
+	{
+		r->stats.evalNsMin = ns;
+	}
+	if (ns > r->stats.evalNsMax)
+	{
+		r->stats.evalNsMax = ns;
+	}
+	r->stats.evalNsSum += ns;
+	r->stats.evals++;
+
+	diff = r->valid ? (out ^ r->out) & r->driven : r->driven;
+	if (diff == 0)
+	{
+		return IOPLUS_OK;
+	}
+	ioplusTxBegin(board, &tx);
+	for (i = 0; i < IOPLUS_RULE_OUT_NO; i++)
+	{
+		if (0 == (diff & (1UL << i)))
+		{
+			continue;
+		}
+		r->stats.writes++;
+		if (i < IOPLUS_RULE_OUT_GPIO)
+		{
+			ioplusTxRelayChSet(&tx, i - IOPLUS_RULE_OUT_RELAY + 1, (out >> i) & 1);
+		}
+		else if (i < IOPLUS_RULE_OUT_OD)
+		{
+			ioplusTxGpioChSet(&tx, i - IOPLUS_RULE_OUT_GPIO + 1, (out >> i) & 1);
+		}
+		else
+		{
+			ioplusTxOdPwmSet(&tx, i - IOPLUS_RULE_OUT_OD + 1,
+				( (out >> i) & 1) ? IOPLUS_OD_PWM_MAX : 0);
+		}
+	}
+	ret = ioplusTxCommit(&tx, NULL);
+	if (ret != IOPLUS_OK)
+	{
+		r->valid = 0;
+		r->stats.errors++;
+		return ret;
+	}
+	us = (uint32_t) ( (rulesNowNs() - t0) / 1000);
+	if (us < r->stats.reactUsMin)
+	{
+		r->stats.reactUsMin = us;
+	}
+	if (us > r->stats.reactUsMax)
+	{
+		r->stats.reactUsMax = us;
+	}
+	r->stats.reactUsSum += us;
+	r->stats.changes++;
+	r->out = out;
+	r->valid = 1;
+	if (changed)
+	{
+		*changed = diff;
+	}
+	return IOPLUS_OK;
+}
+
+int ioplusRulesStatsGet(IoplusRulesType *r, IoplusRulesStatsType *stats)
+{
+	if ( (NULL == r) || (NULL == stats))
+	{
+		return IOPLUS_ERR_ARG;
+	}
+	*stats = r->stats;
+	return IOPLUS_OK;
+}
+
+void ioplusRulesStatsReset(IoplusRulesType *r)
+{
+	if (NULL == r)
+	{
+		return;
+	}
+	memset(&r->stats, 0, sizeof(IoplusRulesStatsType));
+	r->stats.evalNsMin = UINT32_MAX;
+	r->stats.reactUsMin = UINT32_MAX;
+}
@@ -0,0 +1,58 @@
+/*
+ * varint.h:
+ *	LEB128 varints and zigzag signed mapping shared by the file formats of
+ *	the library (counter journal, signal recorder). Internal, not installed.
+ *
+ *	Copyright (c) 2016-2023 Sequent Microsystem
+ *	<http://www.sequentmicrosystem.com>
+ ***********************************************************************
+ */
+#ifndef VARINT_H_
+#define VARINT_H_
+
+#include <stdint.h>
+
+#define VARINT_MAX	10 // bytes of a 64 bit value
+
+static inline int varintPut(uint8_t *buff, uint64_t val)
+{
+	int n = 0;
+
+	while (val >= 0x80)
+	{
+		buff[n++] = (uint8_t) (val | 0x80);
+		val >>= 7;
+	}
+	buff[n++] = (uint8_t)val;
+	return n;
+}
+
+// bytes used, 0 when the value runs past end
+static inline int varintGet(const uint8_t *buff, const uint8_t *end,
+	uint64_t *val)
+{
+	int n = 0;
+
+	*val = 0;
+	while ( (buff + n < end) && (n < VARINT_MAX))
+	{
+		*val |= (uint64_t) (buff[n] & 0x7f) << (7 * n);
+		if (0 == (buff[n++] & 0x80))
+		{
+			return n;
+		}
+	}
+	return 0;
+}
+
+static inline uint64_t zigzag(int64_t val)
+{
+	return ((uint64_t)val << 1) ^ (uint64_t) (val >> 63);
+}
+
+static inline int64_t unzigzag(uint64_t val)
+{
+	return (int64_t) (val >> 1) ^ -(int64_t) (val & 1);
+}
+
+#endif //VARINT_H_